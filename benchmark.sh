@@ -0,0 +1,224 @@
+#!/usr/bin/env bash
+
+cwd=$(cd $(dirname $0); pwd)
+
+#-------------------------------------------------------------------------------
+# example:
+#-------------------------------------------------------------------------------
+# $ benchmark.sh
+# $ benchmark.sh SIZE=2048 PACKETS="188 192" RUNS=5
+# $ benchmark.sh MODES="raw pes" APIS="1 2" OUTPUT=new.json COMPARE=old.json
+#-------------------------------------------------------------------------------
+# The inputs are generated by ts_gen, and cached in WORKDIR.
+# The results are written as one JSON object per case line.
+# Peak RSS is sampled from /proc (Linux). With strace, all syscalls are counted
+# as "syscalls". Without it, only read/write calls are taken from /proc/<pid>/io
+# as "rw_syscalls", so the two keys are not comparable.
+#-------------------------------------------------------------------------------
+
+BIN_DIR="${cwd}/bin"
+WORK_DIR="${TMPDIR:-/tmp}/mapi_bench"
+OUTPUT_FILE='benchmark.json'
+INPUT_SIZE='256'
+PACKET_SIZES='188'
+MODE_LIST='info raw pes container split gop_list'
+API_LIST='0 1 2 3'
+RUN_NUM='3'
+AUDIO_LIST='mp2,aac'
+SERVICE_NUM='1'
+SEED='1'
+
+# Parse user specified options.
+for opt do
+    optarg="${opt#*=}"
+    case "${opt}" in
+        BINDIR=*)
+            BIN_DIR="${optarg}"
+        ;;
+        WORKDIR=*)
+            WORK_DIR="${optarg}"
+        ;;
+        OUTPUT=*)
+            OUTPUT_FILE="${optarg}"
+        ;;
+        COMPARE=*)
+            COMPARE_FILE="${optarg}"
+        ;;
+        SIZE=*)
+            INPUT_SIZE="${optarg}"
+        ;;
+        PACKETS=*)
+            PACKET_SIZES="${optarg}"
+        ;;
+        MODES=*)
+            MODE_LIST="${optarg}"
+        ;;
+        APIS=*)
+            API_LIST="${optarg}"
+        ;;
+        RUNS=*)
+            RUN_NUM="${optarg}"
+        ;;
+        AUDIO=*)
+            AUDIO_LIST="${optarg}"
+        ;;
+        SERVICES=*)
+            SERVICE_NUM="${optarg}"
+        ;;
+        SEED=*)
+            SEED="${optarg}"
+        ;;
+        *)
+            echo "unknown option: ${opt}"
+            exit 1
+        ;;
+    esac
+done
+
+# compile.sh adds .exe to the binaries unless TARGETOS=Linux is given.
+find_binary() {
+    local name
+    for name in "${BIN_DIR}/$1" "${BIN_DIR}/$1.exe" ; do
+        if [[ -x "${name}" ]] ; then
+            echo "${name}"
+            return 0
+        fi
+    done
+    return 1
+}
+
+TS_PARSER="$(find_binary ts_parser)"
+TS_GEN="$(find_binary ts_gen)"
+
+if [[ -z "${TS_PARSER}" || -z "${TS_GEN}" ]] ; then
+    echo "ts_parser and ts_gen are not found in ${BIN_DIR}, run compile.sh first."
+    exit 1
+fi
+
+# output_mode_type of ts_parser.
+mode_number() {
+    case "$1" in
+        info)       echo 0 ;;
+        raw)        echo 1 ;;
+        pes)        echo 2 ;;
+        container)  echo 3 ;;
+        split)      echo 4 ;;
+        gop_list)   echo 5 ;;
+        *)          echo -1 ;;
+    esac
+}
+
+now() {
+    date +%s.%N
+}
+
+# Run the command, and print "<peak rss kB> <calls> <key of calls>".
+measure_resource() {
+    if type strace >/dev/null 2>&1 ; then
+        local log="${WORK_DIR}/strace.log"
+        strace -f -c -o "${log}" "$@" >/dev/null 2>&1 &
+        local pid=$!
+        local rss=$(sample_proc ${pid} children | cut -d' ' -f1)
+        wait ${pid} 2>/dev/null
+        local calls=$(awk '$1 ~ /^[0-9.]+$/ && $NF != "total" { n += $4 } END { print n + 0 }' "${log}")
+        rm -f "${log}"
+        echo "${rss} ${calls:-0} syscalls"
+    else
+        "$@" >/dev/null 2>&1 &
+        local pid=$!
+        local result=$(sample_proc ${pid})
+        wait ${pid} 2>/dev/null
+        echo "${result} rw_syscalls"
+    fi
+}
+
+# the values are sampled until the exit, so the last ones can be a little short.
+sample_proc() {
+    local pid=$1 rss=0 calls=0 state=''
+    while read -r _ _ state _ 2>/dev/null < "/proc/${pid}/stat" && [[ "${state}" != 'Z' ]] ; do
+        local target=${pid}
+        [[ "$2" == 'children' ]] && target=$(cat /proc/${pid}/task/*/children 2>/dev/null)
+        for t in ${target} ; do
+            local hwm=$(awk '/^VmHWM:/ { print $2 }' "/proc/${t}/status" 2>/dev/null)
+            local io=$(awk '/^sysc[rw]:/ { n += $2 } END { print n }' "/proc/${t}/io" 2>/dev/null)
+            [[ -n "${hwm}" && "${hwm}" -gt "${rss}"   ]] && rss=${hwm}
+            [[ -n "${io}"  && "${io}"  -gt "${calls}" ]] && calls=${io}
+        done
+        sleep 0.01
+    done
+    echo "${rss} ${calls}"
+}
+
+# Prepare the inputs.
+mkdir -p "${WORK_DIR}/out" || exit 1
+
+REVISION=$(cd "${cwd}" && git rev-parse --short HEAD 2>/dev/null || echo 'unknown')
+
+{
+    echo "{\"revision\":\"${REVISION}\",\"date\":\"$(date -u +%Y-%m-%dT%H:%M:%SZ)\",\"host\":\"$(uname -n)\",\"size_mib\":${INPUT_SIZE},\"runs\":${RUN_NUM},\"results\":["
+} > "${OUTPUT_FILE}" || exit 1
+
+separator=''
+for packet_size in ${PACKET_SIZES} ; do
+    input="${WORK_DIR}/ts${packet_size}_${INPUT_SIZE}M_s${SERVICE_NUM}_${AUDIO_LIST//,/-}_${SEED}.ts"
+    if [[ ! -f "${input}" ]] ; then
+        echo "generate: ${input}"
+        "${TS_GEN}" --packet-size ${packet_size} --size ${INPUT_SIZE} --services ${SERVICE_NUM} \
+                    --audio ${AUDIO_LIST} --seed ${SEED} "${input}" >/dev/null 2>&1 || exit 1
+    fi
+    input_bytes=$(wc -c < "${input}")
+    for mode in ${MODE_LIST} ; do
+        mode_num=$(mode_number ${mode})
+        if [[ "${mode_num}" -lt 0 ]] ; then
+            echo "unknown mode: ${mode}"
+            exit 1
+        fi
+        for api in ${API_LIST} ; do
+            cmd=("${TS_PARSER}" --api-type ${api} --output-mode ${mode_num} --sid all)
+            [[ "${mode_num}" != '0' ]] && cmd+=(-o "${WORK_DIR}/out/bench")
+            cmd+=("${input}")
+            # the best of the runs.
+            best=''
+            for (( run = 0; run < RUN_NUM; ++run )) ; do
+                rm -f "${WORK_DIR}"/out/*
+                start=$(now)
+                "${cmd[@]}" >/dev/null 2>&1
+                status=$?
+                end=$(now)
+                best=$(awk -v s=${start} -v e=${end} -v b="${best}" 'BEGIN { t = e - s; if( b != "" && b < t ) t = b; printf "%.6f", t }')
+            done
+            rm -f "${WORK_DIR}"/out/*
+            read rss calls calls_key <<< "$(measure_resource "${cmd[@]}")"
+            rm -f "${WORK_DIR}"/out/*
+            result=$(awk -v t=${best} -v b=${input_bytes} -v p=${packet_size} 'BEGIN { if( t <= 0 ) t = 0.000001; printf "\"seconds\":%.6f,\"mib_per_s\":%.2f,\"packets_per_s\":%.0f", t, b / t / 1048576, b / p / t }')
+            line="{\"input\":\"ts${packet_size}\",\"mode\":\"${mode}\",\"api\":${api},\"status\":${status},${result},\"peak_rss_kb\":${rss},\"${calls_key}\":${calls}}"
+            echo "${separator}${line}" >> "${OUTPUT_FILE}"
+            separator=','
+            echo "${line}"
+        done
+    done
+done
+
+echo ']}' >> "${OUTPUT_FILE}"
+rm -rf "${WORK_DIR}/out"
+
+# Compare with the previous results by the same cases.
+if [[ -n "${COMPARE_FILE}" ]] ; then
+    echo ""
+    echo "[ ${COMPARE_FILE} -> ${OUTPUT_FILE} ]"
+    awk '
+        function value( line, key ) {
+            if( !match( line, "\"" key "\":[^,}]*" ) )
+                return ""
+            v = substr( line, RSTART + length( key ) + 3, RLENGTH - length( key ) - 3 )
+            gsub( /"/, "", v )
+            return v
+        }
+        /"input"/ {
+            id = value( $0, "input" ) " " value( $0, "mode" ) " api:" value( $0, "api" )
+            if( FILENAME == ARGV[1] ) { old[id] = value( $0, "mib_per_s" ); next }
+            new = value( $0, "mib_per_s" )
+            if( id in old && old[id] > 0 )
+                printf "%-28s %10.2f -> %10.2f MiB/s  (%+.1f%%)\n", id, old[id], new, (new / old[id] - 1) * 100
+        }' "${COMPARE_FILE}" "${OUTPUT_FILE}"
+fi
@@ -9,6 +9,7 @@ cwd=$(cd $(dirname $0); pwd)
 # $ compile.sh CFLAGS="-m64" LDFLAGS="-m64"
 # $ compile.sh CROSS=x86_64-w64-mingw32- CFLAGS="-mfpmath=sse -msse2"
 # $ compile.sh CROSS=x86_64-w64-mingw32- BINDIR="../bin/x64" MAKEOPT="-j4"
+# $ compile.sh LOGLEVEL=2
 #-------------------------------------------------------------------------------
 
 BIN_DIR="${cwd}/bin"
@@ -51,6 +52,9 @@ for opt do
         SHARED=*)
             ENABLE_SHARED="${optarg}"
         ;;
+        LOGLEVEL=*)
+            LOG_LEVEL_MAX="${optarg}"
+        ;;
     esac
 done
 
@@ -67,6 +71,7 @@ if [[ "$#" != '0' ]] ; then
     [ -n "${LD_EXE}"         ] && echo "LD       : ${LD_EXE}"         && COMPILERS+=" LD=${LD_EXE}"
     [ -n "${TARGET_OS}"      ] && echo "TARGETOS : ${TARGET_OS}"
     [ -n "${ENABLE_SHARED}"  ] && echo "SHARED   : ${ENABLE_SHARED}"
+    [ -n "${LOG_LEVEL_MAX}"  ] && echo "LOGLEVEL : ${LOG_LEVEL_MAX}"
     echo ""
 fi
 
@@ -90,9 +95,10 @@ fi
 make lib \
     ${COMPILERS} \
     CROSS="${CROSS_PREFIX}" XCFLAGS="${EXTRA_CFLAGS} ${EXTRA_CPPFLAGS}" XLDFLAGS="${EXTRA_LDFLAGS}" \
-    BIN_DIR="${BIN_DIR}" THREAD_LIBS="${THREAD_LIBS}" TARGET_OS="${TARGET_OS}" ${MAKE_OPT}
+    BIN_DIR="${BIN_DIR}" THREAD_LIBS="${THREAD_LIBS}" TARGET_OS="${TARGET_OS}" \
+    LOG_LEVEL_MAX="${LOG_LEVEL_MAX}" ${MAKE_OPT}
 make \
     ${COMPILERS} \
     CROSS="${CROSS_PREFIX}" XCFLAGS="${EXTRA_CFLAGS} ${EXTRA_CPPFLAGS}" XLDFLAGS="${EXTRA_LDFLAGS}" \
     BIN_DIR="${BIN_DIR}" THREAD_LIBS="${THREAD_LIBS}" TARGET_OS="${TARGET_OS}" \
-    ENABLE_SHARED="${ENABLE_SHARED}" ${MAKE_OPT}
+    ENABLE_SHARED="${ENABLE_SHARED}" LOG_LEVEL_MAX="${LOG_LEVEL_MAX}" ${MAKE_OPT}
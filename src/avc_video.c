@@ -0,0 +1,323 @@
+/*****************************************************************************
+ * avc_video.c
+ *****************************************************************************
+ *
+ * Authors: Masaki Tanaka <maki.rxrz@gmail.com>
+ *
+ * NYSL Version 0.9982 (en) (Unofficial)
+ * ----------------------------------------
+ * A. This software is "Everyone'sWare". It means:
+ *   Anybody who has this software can use it as if he/she is
+ *   the author.
+ *
+ *   A-1. Freeware. No fee is required.
+ *   A-2. You can freely redistribute this software.
+ *   A-3. You can freely modify this software. And the source
+ *       may be used in any software with no limitation.
+ *
+ * B. The author is not responsible for any kind of damages or loss
+ *   while using or misusing this software, which is distributed
+ *   "AS IS". No warranty of any kind is expressed or implied.
+ *   You use AT YOUR OWN RISK.
+ *
+ * C. Moral rights of author belong to maki. Copyright is abandoned.
+ *
+ * D. Above three clauses are applied both to source and binary
+ *   form of this software.
+ *
+ ****************************************************************************/
+
+#include "common.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "mpeg_common.h"
+#include "mpeg_video.h"
+#include "avc_video.h"
+
+#define getbits( br, n )        mpeg_bit_reader_get_bits( br, n )
+#define skipbits( br, n )       mpeg_bit_reader_skip_bits( br, n )
+#define getue( br )             mpeg_bit_reader_get_ue( br )
+#define getse( br )             mpeg_bit_reader_get_se( br )
+
+typedef enum {
+    AVC_SLICE_TYPE_P  = 0,
+    AVC_SLICE_TYPE_B  = 1,
+    AVC_SLICE_TYPE_I  = 2,
+    AVC_SLICE_TYPE_SP = 3,
+    AVC_SLICE_TYPE_SI = 4
+} avc_slice_type;
+
+typedef enum {
+    SEI_PAYLOAD_RECOVERY_POINT = 6
+} avc_sei_payload_type;
+
+static void skip_scaling_list( mpeg_bit_reader_t *br, int size_of_scaling_list )
+{
+    int32_t last_scale = 8;
+    int32_t next_scale = 8;
+    for( int i = 0; i < size_of_scaling_list && !br->error; ++i )
+    {
+        if( next_scale )
+            next_scale = (last_scale + getse( br ) + 256) % 256;
+        last_scale = next_scale ? next_scale : last_scale;
+    }
+}
+
+static void read_seq_parameter_set( mpeg_bit_reader_t *br, avc_video_info_t *avc_info )
+{
+    avc_video_sps_t sps = { 0 };
+    sps.profile_idc                = getbits( br, 8 );
+    skipbits( br, 8 );                          /* constraint_set0..5_flag, reserved_zero_2bits */
+    sps.level_idc                  = getbits( br, 8 );
+    uint32_t seq_parameter_set_id  = getue( br );
+    if( seq_parameter_set_id >= AVC_VIDEO_SPS_MAX )
+        return;
+    sps.chroma_format_idc          = 1;
+    switch( sps.profile_idc )
+    {
+        case 100 : case 110 : case 122 : case 244 : case  44 :
+        case  83 : case  86 : case 118 : case 128 : case 138 :
+        case 139 : case 134 : case 135 :
+            sps.chroma_format_idc  = getue( br );
+            if( sps.chroma_format_idc == 3 )
+                sps.separate_colour_plane_flag = getbits( br, 1 );
+            getue( br );                        /* bit_depth_luma_minus8 */
+            getue( br );                        /* bit_depth_chroma_minus8 */
+            skipbits( br, 1 );                  /* qpprime_y_zero_transform_bypass_flag */
+            if( getbits( br, 1 ) )              /* seq_scaling_matrix_present_flag */
+            {
+                int scaling_list_num = (sps.chroma_format_idc != 3) ? 8 : 12;
+                for( int i = 0; i < scaling_list_num; ++i )
+                    if( getbits( br, 1 ) )      /* seq_scaling_list_present_flag */
+                        skip_scaling_list( br, (i < 6) ? 16 : 64 );
+            }
+            break;
+        default :
+            break;
+    }
+    sps.log2_max_frame_num         = getue( br ) + 4;
+    sps.pic_order_cnt_type         = getue( br );
+    if( sps.pic_order_cnt_type == 0 )
+        sps.log2_max_pic_order_cnt_lsb = getue( br ) + 4;
+    else if( sps.pic_order_cnt_type == 1 )
+    {
+        skipbits( br, 1 );                      /* delta_pic_order_always_zero_flag */
+        getse( br );                            /* offset_for_non_ref_pic */
+        getse( br );                            /* offset_for_top_to_bottom_field */
+        uint32_t num_ref_frames_in_pic_order_cnt_cycle = getue( br );
+        for( uint32_t i = 0; i < num_ref_frames_in_pic_order_cnt_cycle && !br->error; ++i )
+            getse( br );                        /* offset_for_ref_frame */
+    }
+    getue( br );                                /* max_num_ref_frames */
+    skipbits( br, 1 );                          /* gaps_in_frame_num_value_allowed_flag */
+    uint32_t pic_width_in_mbs         = getue( br ) + 1;
+    uint32_t pic_height_in_map_units  = getue( br ) + 1;
+    sps.frame_mbs_only_flag        = getbits( br, 1 );
+    sps.width                      = pic_width_in_mbs * 16;
+    sps.height                     = pic_height_in_map_units * 16 * (2 - sps.frame_mbs_only_flag);
+    if( br->error || sps.log2_max_frame_num > 16 || sps.log2_max_pic_order_cnt_lsb > 16 )
+        return;
+    sps.present = 1;
+    avc_info->sps[seq_parameter_set_id] = sps;
+    mapi_log( LOG_LV3, "[debug] AVC SPS id:%u  profile:%u  level:%u  size:%ux%u  poc_type:%u  frame_mbs_only:%u\n"
+                     , seq_parameter_set_id, sps.profile_idc, sps.level_idc, sps.width, sps.height
+                     , sps.pic_order_cnt_type, sps.frame_mbs_only_flag );
+}
+
+static void read_pic_parameter_set( mpeg_bit_reader_t *br, avc_video_info_t *avc_info )
+{
+    uint32_t pic_parameter_set_id = getue( br );
+    uint32_t seq_parameter_set_id = getue( br );
+    if( br->error || pic_parameter_set_id >= AVC_VIDEO_PPS_MAX || seq_parameter_set_id >= AVC_VIDEO_SPS_MAX )
+        return;
+    avc_info->pps[pic_parameter_set_id].present              = 1;
+    avc_info->pps[pic_parameter_set_id].seq_parameter_set_id = seq_parameter_set_id;
+}
+
+static void read_sei( mpeg_bit_reader_t *br, avc_video_info_t *avc_info )
+{
+    uint32_t byte;
+    do
+    {
+        uint32_t payload_type = 0;
+        uint32_t payload_size = 0;
+        while( (byte = getbits( br, 8 )) == 0xFF )
+            payload_type += 255;
+        payload_type += byte;
+        while( (byte = getbits( br, 8 )) == 0xFF )
+            payload_size += 255;
+        payload_size += byte;
+        if( br->error )
+            return;
+        if( payload_type == SEI_PAYLOAD_RECOVERY_POINT )
+        {
+            avc_info->recovery_frame_cnt = getue( br );
+            return;
+        }
+        skipbits( br, (int64_t)payload_size * 8 );
+        /* stop at rbsp_trailing_bits or the next start code. */
+        byte = mpeg_bit_reader_show_bits( br, 8 );
+    }
+    while( !br->error && byte != 0x80 && byte != 0x00 );
+}
+
+static int32_t get_pic_order_cnt( avc_video_info_t *avc_info, avc_video_sps_t *sps )
+{
+    avc_video_slice_header_t *slice = &(avc_info->slice);
+    if( sps->pic_order_cnt_type != 0 )
+        /* output order is regarded as decoding order. */
+        return avc_info->decode_count * 2;
+    int32_t max_pic_order_cnt_lsb = 1 << sps->log2_max_pic_order_cnt_lsb;
+    int32_t pic_order_cnt_lsb     = slice->pic_order_cnt_lsb;
+    if( slice->nal_unit_type == AVC_NAL_IDR_SLICE )
+    {
+        avc_info->prev_pic_order_cnt_msb = 0;
+        avc_info->prev_pic_order_cnt_lsb = 0;
+    }
+    int32_t prev_lsb = avc_info->prev_pic_order_cnt_lsb;
+    int32_t pic_order_cnt_msb = avc_info->prev_pic_order_cnt_msb;
+    if( pic_order_cnt_lsb < prev_lsb && prev_lsb - pic_order_cnt_lsb >= max_pic_order_cnt_lsb / 2 )
+        pic_order_cnt_msb += max_pic_order_cnt_lsb;
+    else if( pic_order_cnt_lsb > prev_lsb && pic_order_cnt_lsb - prev_lsb > max_pic_order_cnt_lsb / 2 )
+        pic_order_cnt_msb -= max_pic_order_cnt_lsb;
+    if( slice->nal_ref_idc )
+    {
+        avc_info->prev_pic_order_cnt_msb = pic_order_cnt_msb;
+        avc_info->prev_pic_order_cnt_lsb = pic_order_cnt_lsb;
+    }
+    return pic_order_cnt_msb + pic_order_cnt_lsb;
+}
+
+static int read_slice_header( mpeg_bit_reader_t *br, uint8_t nal_header, avc_video_info_t *avc_info )
+{
+    avc_video_slice_header_t *slice   = &(avc_info->slice);
+    avc_video_picture_t      *picture = &(avc_info->picture);
+    slice->nal_ref_idc          = (nal_header >> 5) & 0x03;
+    slice->nal_unit_type        =  nal_header       & 0x1F;
+    getue( br );                                /* first_mb_in_slice */
+    slice->slice_type           = getue( br ) % 5;
+    uint32_t pic_parameter_set_id = getue( br );
+    slice->pic_parameter_set_id = (pic_parameter_set_id < AVC_VIDEO_PPS_MAX) ? pic_parameter_set_id : 0;
+    slice->frame_num            = 0;
+    slice->field_pic_flag       = 0;
+    slice->bottom_field_flag    = 0;
+    slice->idr_pic_id           = 0;
+    slice->pic_order_cnt_lsb    = 0;
+    if( br->error )
+        return -1;
+    /* setup picture information. */
+    static const uint8_t picture_coding_type[5] =
+        {
+            MPEG_VIDEO_P_FRAME,     /* P  */
+            MPEG_VIDEO_B_FRAME,     /* B  */
+            MPEG_VIDEO_I_FRAME,     /* I  */
+            MPEG_VIDEO_P_FRAME,     /* SP */
+            MPEG_VIDEO_I_FRAME      /* SI */
+        };
+    picture->picture_coding_type  = picture_coding_type[slice->slice_type];
+    picture->keyframe             = (slice->nal_unit_type == AVC_NAL_IDR_SLICE || avc_info->recovery_frame_cnt >= 0);
+    picture->closed_gop           = (slice->nal_unit_type == AVC_NAL_IDR_SLICE);
+    picture->progressive_sequence = 0;
+    picture->picture_structure    = MPEG_VIDEO_FRAME_STRUCTURE;
+    picture->temporal_reference   = -1;
+    picture->pic_order_cnt        = 0;
+    /* check parameter sets. */
+    avc_video_pps_t *pps = (pic_parameter_set_id < AVC_VIDEO_PPS_MAX) ? &(avc_info->pps[pic_parameter_set_id]) : NULL;
+    if( !pps || !pps->present || !avc_info->sps[pps->seq_parameter_set_id].present )
+        return 0;
+    avc_video_sps_t *sps = &(avc_info->sps[pps->seq_parameter_set_id]);
+    if( sps->separate_colour_plane_flag )
+        skipbits( br, 2 );                      /* colour_plane_id */
+    slice->frame_num                = getbits( br, sps->log2_max_frame_num );
+    if( !sps->frame_mbs_only_flag )
+    {
+        slice->field_pic_flag       = getbits( br, 1 );
+        if( slice->field_pic_flag )
+            slice->bottom_field_flag = getbits( br, 1 );
+    }
+    if( slice->nal_unit_type == AVC_NAL_IDR_SLICE )
+        slice->idr_pic_id           = getue( br );
+    if( sps->pic_order_cnt_type == 0 )
+        slice->pic_order_cnt_lsb    = getbits( br, sps->log2_max_pic_order_cnt_lsb );
+    if( br->error )
+        return -1;
+    /* setup picture order. */
+    picture->progressive_sequence = sps->frame_mbs_only_flag;
+    picture->picture_structure    = !slice->field_pic_flag   ? MPEG_VIDEO_FRAME_STRUCTURE
+                                  :  slice->bottom_field_flag ? MPEG_VIDEO_BOTTOM_FIELD_STRUCTURE
+                                  :                             MPEG_VIDEO_TOP_FIELD_STRUCTURE;
+    if( picture->keyframe )
+        avc_info->decode_count = 0;
+    picture->pic_order_cnt = get_pic_order_cnt( avc_info, sps );
+    if( picture->keyframe )
+        avc_info->key_pic_order_cnt = picture->pic_order_cnt;
+    int32_t temporal_reference = (picture->pic_order_cnt - avc_info->key_pic_order_cnt) / 2;
+    picture->temporal_reference = (temporal_reference > INT16_MAX) ? INT16_MAX
+                                : (temporal_reference < INT16_MIN) ? INT16_MIN
+                                :                                    temporal_reference;
+    ++ avc_info->decode_count;
+    return 0;
+}
+
+extern void avc_video_reset_access_unit( avc_video_info_t *avc_info )
+{
+    avc_info->recovery_frame_cnt = -1;
+}
+
+extern int avc_video_read_nal_unit( mpeg_bit_reader_t *br, uint8_t nal_header, avc_video_info_t *avc_info )
+{
+    /* check forbidden_zero_bit. */
+    if( nal_header & 0x80 )
+        return 0;
+    avc_nal_unit_type nal_unit_type = nal_header & 0x1F;
+    mapi_log( LOG_LV4, "[debug] AVC nal_unit_type:%u\n", nal_unit_type );
+    switch( nal_unit_type )
+    {
+        case AVC_NAL_SLICE :
+        case AVC_NAL_SLICE_DPA :
+        case AVC_NAL_IDR_SLICE :
+            return read_slice_header( br, nal_header, avc_info ) ? 0 : 1;
+        case AVC_NAL_SEI :
+            read_sei( br, avc_info );
+            break;
+        case AVC_NAL_SPS :
+            read_seq_parameter_set( br, avc_info );
+            break;
+        case AVC_NAL_PPS :
+            read_pic_parameter_set( br, avc_info );
+            break;
+        default :
+            break;
+    }
+    return 0;
+}
+
+extern void avc_video_debug_picture_info( avc_video_info_t *avc_info )
+{
+    static const char frame[4] = { '?', 'I', 'P', 'B' };
+    mapi_log( LOG_LV2,
+              "[check] detect AVC Slice.\n"
+              "        nal_unit_type:%u\n"
+              "        slice_type:%u [%c]\n"
+              "        pic_parameter_set_id:%u\n"
+              "        frame_num:%u\n"
+              "        field_pic_flag:%u\n"
+              "        bottom_field_flag:%u\n"
+              "        pic_order_cnt_lsb:%u\n"
+              "        recovery_frame_cnt:%d\n"
+              "        keyframe:%u\n"
+              "        temporal_reference:%d\n"
+              , avc_info->slice.nal_unit_type
+              , avc_info->slice.slice_type, frame[avc_info->picture.picture_coding_type]
+              , avc_info->slice.pic_parameter_set_id
+              , avc_info->slice.frame_num
+              , avc_info->slice.field_pic_flag
+              , avc_info->slice.bottom_field_flag
+              , avc_info->slice.pic_order_cnt_lsb
+              , avc_info->recovery_frame_cnt
+              , avc_info->picture.keyframe
+              , avc_info->picture.temporal_reference );
+}
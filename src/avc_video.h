@@ -0,0 +1,120 @@
+/*****************************************************************************
+ * avc_video.h
+ *****************************************************************************
+ *
+ * Authors: Masaki Tanaka <maki.rxrz@gmail.com>
+ *
+ * NYSL Version 0.9982 (en) (Unofficial)
+ * ----------------------------------------
+ * A. This software is "Everyone'sWare". It means:
+ *   Anybody who has this software can use it as if he/she is
+ *   the author.
+ *
+ *   A-1. Freeware. No fee is required.
+ *   A-2. You can freely redistribute this software.
+ *   A-3. You can freely modify this software. And the source
+ *       may be used in any software with no limitation.
+ *
+ * B. The author is not responsible for any kind of damages or loss
+ *   while using or misusing this software, which is distributed
+ *   "AS IS". No warranty of any kind is expressed or implied.
+ *   You use AT YOUR OWN RISK.
+ *
+ * C. Moral rights of author belong to maki. Copyright is abandoned.
+ *
+ * D. Above three clauses are applied both to source and binary
+ *   form of this software.
+ *
+ ****************************************************************************/
+#ifndef __AVC_VIDEO_H__
+#define __AVC_VIDEO_H__
+
+#include "mpeg_common.h"
+#include "mpeg_video.h"
+
+#define AVC_VIDEO_SPS_MAX               (32)
+#define AVC_VIDEO_PPS_MAX               (256)
+
+typedef enum {
+    AVC_NAL_SLICE           = 1,
+    AVC_NAL_SLICE_DPA       = 2,
+    AVC_NAL_SLICE_DPB       = 3,
+    AVC_NAL_SLICE_DPC       = 4,
+    AVC_NAL_IDR_SLICE       = 5,
+    AVC_NAL_SEI             = 6,
+    AVC_NAL_SPS             = 7,
+    AVC_NAL_PPS             = 8,
+    AVC_NAL_AUD             = 9,
+    AVC_NAL_END_OF_SEQUENCE = 10,
+    AVC_NAL_END_OF_STREAM   = 11,
+    AVC_NAL_FILLER_DATA     = 12
+} avc_nal_unit_type;
+
+typedef struct {
+    uint8_t         present;
+    uint8_t         profile_idc;
+    uint8_t         level_idc;
+    uint8_t         chroma_format_idc;
+    uint8_t         separate_colour_plane_flag;
+    uint8_t         log2_max_frame_num;
+    uint8_t         pic_order_cnt_type;
+    uint8_t         log2_max_pic_order_cnt_lsb;
+    uint8_t         frame_mbs_only_flag;
+    uint16_t        width;
+    uint16_t        height;
+} avc_video_sps_t;
+
+typedef struct {
+    uint8_t         present;
+    uint8_t         seq_parameter_set_id;
+} avc_video_pps_t;
+
+typedef struct {
+    uint8_t         nal_ref_idc;
+    uint8_t         nal_unit_type;
+    uint8_t         slice_type;
+    uint8_t         pic_parameter_set_id;
+    uint16_t        frame_num;
+    uint8_t         field_pic_flag;
+    uint8_t         bottom_field_flag;
+    uint16_t        idr_pic_id;
+    uint32_t        pic_order_cnt_lsb;
+} avc_video_slice_header_t;
+
+typedef struct {
+    uint8_t         picture_coding_type;
+    uint8_t         keyframe;
+    uint8_t         closed_gop;
+    uint8_t         progressive_sequence;
+    uint8_t         picture_structure;
+    int16_t         temporal_reference;
+    int32_t         pic_order_cnt;
+} avc_video_picture_t;
+
+typedef struct {
+    avc_video_sps_t             sps[AVC_VIDEO_SPS_MAX];
+    avc_video_pps_t             pps[AVC_VIDEO_PPS_MAX];
+    avc_video_slice_header_t    slice;
+    avc_video_picture_t         picture;
+    int32_t                     recovery_frame_cnt;
+    int32_t                     prev_pic_order_cnt_msb;
+    int32_t                     prev_pic_order_cnt_lsb;
+    int32_t                     key_pic_order_cnt;
+    int32_t                     decode_count;
+} avc_video_info_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void avc_video_reset_access_unit( avc_video_info_t *avc_info );
+
+extern int avc_video_read_nal_unit( mpeg_bit_reader_t *br, uint8_t nal_header, avc_video_info_t *avc_info );
+
+extern void avc_video_debug_picture_info( avc_video_info_t *avc_info );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AVC_VIDEO_H__ */
@@ -95,9 +95,26 @@ typedef enum {
     LOG_LV_ALL
 } log_level;
 
+typedef void (*mapi_log_cb_t)( void *cb_params, log_level level, const char *message );
+
+/* the levels over MAPI_LOG_LEVEL_MAX are removed at compile time. */
+#ifndef MAPI_LOG_LEVEL_MAX
+#define MAPI_LOG_LEVEL_MAX  LOG_LV_ALL
+#endif
+
 #if   defined( MAPI_INTERNAL_CODE_ENABLED )
-#define mapi_log mapi_debug_log
-extern void mapi_log( log_level level, const char *format, ... );
+extern log_level mapi_debug_log_lv;
+extern void mapi_debug_log( log_level level, const char *format, ... );
+extern int mapi_debug_log_enabled( log_level level );
+/* check the level before the evaluation of the arguments. */
+#define mapi_log( level, ... )                                                  \
+do {                                                                            \
+    if( (level) <= MAPI_LOG_LEVEL_MAX                                           \
+     && (level) <= __atomic_load_n( &mapi_debug_log_lv, __ATOMIC_RELAXED ) )    \
+        mapi_debug_log( level, __VA_ARGS__ );                                   \
+} while( 0 )
+#define mapi_log_enabled( level )                                               \
+( (level) <= MAPI_LOG_LEVEL_MAX && mapi_debug_log_enabled( level ) )
 #elif defined( MAPI_UTILS_CODE_ENABLED )
 #define mapi_log mapi_utils_log
 extern void mapi_log( log_level level, const char *format, ... );
@@ -109,6 +126,44 @@ extern void mapi_log( log_level level, const char *format, ... );
 
 #include <stdio.h>
 
+#if defined( MAPI_INTERNAL_CODE_ENABLED )
+/* log sink: the logs of the bound thread are delivered asynchronously. */
+typedef struct mapi_log_sink_s mapi_log_sink_t;
+extern mapi_log_sink_t *mapi_log_sink_create( log_level level, FILE *output, mapi_log_cb_t callback, void *cb_params );
+/* stop the delivery, the closed sink can be still bound until released. */
+extern void mapi_log_sink_close( mapi_log_sink_t *sink );
+extern void mapi_log_sink_release( mapi_log_sink_t *sink );
+extern mapi_log_sink_t *mapi_log_sink_bind( mapi_log_sink_t *sink );
+
+/* stats: the counters are kept per thread in the bound set, and summed on demand. */
+#include <stdint.h>
+typedef enum {
+    MAPI_STATS_READ_BYTES = 0,
+    MAPI_STATS_READ_CALLS,
+    MAPI_STATS_SEEK_CALLS,
+    MAPI_STATS_CACHE_HITS,
+    MAPI_STATS_CACHE_MISSES,
+    MAPI_STATS_PACKETS_SCANNED,
+    MAPI_STATS_PACKETS_DELIVERED,
+    MAPI_STATS_PES_ASSEMBLED,
+    MAPI_STATS_SAMPLE_ALLOCS,
+    MAPI_STATS_COUNTER_NUM
+} mapi_stats_counter_type;
+typedef struct mapi_stats_set_s mapi_stats_set_t;
+extern __thread uint64_t *mapi_stats_counter;
+extern mapi_stats_set_t *mapi_stats_create( void );
+extern void mapi_stats_release( mapi_stats_set_t *set );
+extern mapi_stats_set_t *mapi_stats_bind( mapi_stats_set_t *set );
+extern void mapi_stats_collect( mapi_stats_set_t *set, uint64_t counter[MAPI_STATS_COUNTER_NUM] );
+/* only the owner thread writes the counter, so the update needs no lock. */
+#define mapi_stats_add( type, value )                                           \
+do {                                                                            \
+    uint64_t *stats_counter_ = mapi_stats_counter;                              \
+    if( stats_counter_ )                                                        \
+        __atomic_store_n( &(stats_counter_[type]), stats_counter_[type] + (value), __ATOMIC_RELAXED ); \
+} while( 0 )
+#endif
+
 #ifndef fseeko
 
 #if defined(__MINGW32__) && defined(__i386__)
@@ -124,6 +179,14 @@ extern void mapi_log( log_level level, const char *format, ... );
 
 #endif
 
+/* trace: the spans are recorded only while the trace file is opened. */
+#if defined( MAPI_INTERNAL_CODE_ENABLED ) || defined( MAPI_UTILS_CODE_ENABLED )
+#define mapi_trace_begin mpeg_api_trace_begin
+#define mapi_trace_end   mpeg_api_trace_end
+MAPI_EXPORT void mapi_trace_begin( const char *name );
+MAPI_EXPORT void mapi_trace_end( void );
+#endif
+
 /* OS depncdent */
 #if defined( MAPI_INTERNAL_CODE_ENABLED ) || defined( MAPI_UTILS_CODE_ENABLED )
 
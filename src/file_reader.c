@@ -54,6 +54,7 @@ typedef struct {
     uint64_t        buffer_size;
     struct {
         uint8_t    *buf;
+        uint64_t    capacity;
         uint64_t    size;
         uint64_t    pos;
     } cache;
@@ -64,6 +65,14 @@ typedef struct {
  *  File Reader functions
  *==========================================================================*/
 
+static inline uint64_t fr_read_cache( file_read_context_t *fr_ctx, uint64_t cache_offset, uint64_t read_size )
+{
+    uint64_t cache_size = fread( &(fr_ctx->cache.buf[cache_offset]), 1, read_size, fr_ctx->fp );
+    mapi_stats_add( MAPI_STATS_READ_CALLS, 1 );
+    mapi_stats_add( MAPI_STATS_READ_BYTES, cache_size );
+    return cache_size;
+}
+
 static int64_t fr_get_file_size( void *ctx )
 {
     if( !ctx )
@@ -102,7 +111,7 @@ static int fr_fread( void *ctx, uint8_t *read_buffer, int64_t read_size, int64_t
     if( fr_ctx->cache.size == 0 )
     {
         /* Read data to cache. */
-        uint64_t cache_size = fread( fr_ctx->cache.buf, 1, fr_ctx->buffer_size, fr_ctx->fp );
+        uint64_t cache_size = fr_read_cache( fr_ctx, 0, fr_ctx->buffer_size );
         if( cache_size == 0 )
             goto fail;
         fr_ctx->cache.size = cache_size;
@@ -127,7 +136,7 @@ static int fr_fread( void *ctx, uint8_t *read_buffer, int64_t read_size, int64_t
             fr_ctx->read_pos += fr_ctx->cache.size;
 
             /* Read data to cache. */
-            uint64_t cache_size = fread( fr_ctx->cache.buf, 1, fr_ctx->buffer_size, fr_ctx->fp );
+            uint64_t cache_size = fr_read_cache( fr_ctx, 0, fr_ctx->buffer_size );
             if( cache_size == 0 )
                 goto fail;
             fr_ctx->cache.size = cache_size;
@@ -190,12 +199,15 @@ static int fr_fseek( void *ctx, int64_t seek_offset, int origin )
     {
         /* Cache hit. */
         fr_ctx->cache.pos = offset;
+        mapi_stats_add( MAPI_STATS_CACHE_HITS, 1 );
     }
     else
     {
         /* No data in cache. */
         int64_t cache_start_pos = position / fr_ctx->buffer_size * fr_ctx->buffer_size;
 
+        mapi_stats_add( MAPI_STATS_CACHE_MISSES, 1 );
+        mapi_stats_add( MAPI_STATS_SEEK_CALLS  , 1 );
         fseeko( fr_ctx->fp, cache_start_pos, SEEK_SET );
         fr_ctx->read_pos   = cache_start_pos;
         fr_ctx->cache.size = 0;
@@ -204,6 +216,77 @@ static int fr_fseek( void *ctx, int64_t seek_offset, int origin )
     return MAPI_SUCCESS;
 }
 
+static int fr_fmap( void *ctx, int64_t position, int64_t map_size, uint8_t **map_data )
+{
+    if( !ctx || !map_data )
+        return MAPI_FAILURE;
+    file_read_context_t *fr_ctx = (file_read_context_t *)ctx;
+    if( fr_ctx->status != FR_STATUS_OPENED )
+        return MAPI_FAILURE;
+
+    *map_data = NULL;
+
+    /* Check map range. */
+    if( position < 0 || map_size <= 0 || fr_ctx->file_size < position + map_size )
+        return MAPI_FAILURE;
+
+    int64_t offset = position - fr_ctx->read_pos;
+    if( offset < 0 || fr_ctx->cache.size < (uint64_t)(offset + map_size) )
+    {
+        if( map_size > READ_BUFFER_SIZE_MAX )
+            return MAPI_FAILURE;
+        mapi_stats_add( MAPI_STATS_CACHE_MISSES, 1 );
+
+        /* The file position is always at the end of cache. */
+        if( 0 <= offset && (uint64_t)offset < fr_ctx->cache.size )
+        {
+            /* Keep the cached head of the map, and continue reading after it. */
+            fr_ctx->cache.size -= offset;
+            memmove( fr_ctx->cache.buf, &(fr_ctx->cache.buf[offset]), fr_ctx->cache.size );
+            fr_ctx->read_pos = position;
+        }
+        else
+        {
+            /* No data in cache. */
+            int64_t cache_start_pos = position / fr_ctx->buffer_size * fr_ctx->buffer_size;
+            if( cache_start_pos != (int64_t)(fr_ctx->read_pos + fr_ctx->cache.size) )
+            {
+                mapi_stats_add( MAPI_STATS_SEEK_CALLS, 1 );
+                if( fseeko( fr_ctx->fp, cache_start_pos, SEEK_SET ) )
+                    return MAPI_FAILURE;
+            }
+            fr_ctx->read_pos   = cache_start_pos;
+            fr_ctx->cache.size = 0;
+        }
+        offset = position - fr_ctx->read_pos;
+
+        /* Read the lack of the map by the multiple of the refill size. */
+        uint64_t read_size = offset + map_size - fr_ctx->cache.size;
+        read_size = (read_size + fr_ctx->buffer_size - 1) / fr_ctx->buffer_size * fr_ctx->buffer_size;
+        if( fr_ctx->cache.capacity < fr_ctx->cache.size + read_size )
+        {
+            /* Extend cache. The refill size of fread/fseek is kept as is. */
+            uint8_t *buffer = (uint8_t *)realloc( fr_ctx->cache.buf, fr_ctx->cache.size + read_size );
+            if( !buffer )
+                return MAPI_FAILURE;
+            fr_ctx->cache.buf      = buffer;
+            fr_ctx->cache.capacity = fr_ctx->cache.size + read_size;
+        }
+        fr_ctx->cache.size += fr_read_cache( fr_ctx, fr_ctx->cache.size, read_size );
+        fr_ctx->cache.pos   = offset;
+        if( fr_ctx->cache.size < (uint64_t)(offset + map_size) )
+            return MAPI_EOF;
+    }
+    else
+        mapi_stats_add( MAPI_STATS_CACHE_HITS, 1 );
+
+    /* Map the data in cache. */
+    *map_data = &(fr_ctx->cache.buf[offset]);
+    fr_ctx->cache.pos = offset + map_size;
+
+    return MAPI_SUCCESS;
+}
+
 static int fr_open( void *ctx, char *file_name, uint64_t buffer_size )
 {
     if( !ctx )
@@ -229,11 +312,12 @@ static int fr_open( void *ctx, char *file_name, uint64_t buffer_size )
 
     /* Set up. */
     memset( fr_ctx, 0, sizeof(file_read_context_t) );
-    fr_ctx->fp          = fp;
-    fr_ctx->file_size   = file_size;
-    fr_ctx->buffer_size = buffer_size;
-    fr_ctx->cache.buf   = buffer;
-    fr_ctx->status      = FR_STATUS_OPENED;
+    fr_ctx->fp             = fp;
+    fr_ctx->file_size      = file_size;
+    fr_ctx->buffer_size    = buffer_size;
+    fr_ctx->cache.buf      = buffer;
+    fr_ctx->cache.capacity = buffer_size;
+    fr_ctx->status         = FR_STATUS_OPENED;
 
     return MAPI_SUCCESS;
 
@@ -297,6 +381,7 @@ file_reader_t file_reader = {
     .ftell    = fr_ftell,
     .fread    = fr_fread,
     .fseek    = fr_fseek,
+    .fmap     = fr_fmap,
     .open     = fr_open,
     .close    = fr_close,
     .init     = fr_init,
@@ -40,6 +40,7 @@ typedef struct  {
     int64_t     (* ftell   )( void *fr_ctx );
     int         (* fread   )( void *fr_ctx, uint8_t *read_buffer, int64_t read_size, int64_t *dest_size );
     int         (* fseek   )( void *fr_ctx, int64_t offset, int origin );
+    int         (* fmap    )( void *fr_ctx, int64_t position, int64_t map_size, uint8_t **map_data );
     int         (* open    )( void *fr_ctx, char *file_name, uint64_t buffer_size );
     void        (* close   )( void *fr_ctx );
     int         (* init    )( void **fr_ctx );
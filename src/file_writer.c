@@ -58,6 +58,7 @@ typedef struct {
         uint64_t    pos;
     } cache;
     fw_status_type  status;
+    file_write_stats_t stats;
 } file_write_context_t;
 
 /*============================================================================
@@ -75,12 +76,23 @@ static int fw_pipe( void *ctx )
     return MAPI_SUCCESS;
 }
 
-static inline void fw_flush_buffer( file_write_context_t *fw_ctx )
+static inline void fw_write_data( file_write_context_t *fw_ctx, uint8_t *buf, int64_t size )
 {
+    if( !size )
+        return;
+    mapi_trace_begin( "file_write" );
     if( fw_ctx->fp )
-        fwrite( fw_ctx->cache.buf, 1, fw_ctx->cache.pos, fw_ctx->fp );
+        fwrite( buf, 1, size, fw_ctx->fp );
     if( fw_ctx->status & FW_STATUS_PIPE )
-        fwrite( fw_ctx->cache.buf, 1, fw_ctx->cache.pos, stdout );
+        fwrite( buf, 1, size, stdout );
+    mapi_trace_end();
+    fw_ctx->stats.write_bytes += size;
+    ++(fw_ctx->stats.write_calls);
+}
+
+static inline void fw_flush_buffer( file_write_context_t *fw_ctx )
+{
+    fw_write_data( fw_ctx, fw_ctx->cache.buf, fw_ctx->cache.pos );
     fw_ctx->cache.pos = 0;
 }
 
@@ -119,10 +131,7 @@ static int fw_fwrite( void *ctx, uint8_t *src_buffer, int64_t src_size, int64_t
         if( size > (int64_t)fw_ctx->buffer_size )
         {
             /* Output the data in source. */
-            if( fw_ctx->fp )
-                fwrite( buf, 1, size, fw_ctx->fp );
-            if( fw_ctx->status & FW_STATUS_PIPE )
-                fwrite( buf, 1, size, stdout );
+            fw_write_data( fw_ctx, buf, size );
             write_size += size;
             size = 0;
         }
@@ -187,6 +196,7 @@ static int fw_fseek( void *ctx, int64_t seek_offset, int origin )
     /* Seek. */
     if( fw_ctx->fp )
         fseeko( fw_ctx->fp, position, SEEK_SET );
+    ++(fw_ctx->stats.seek_calls);
 
     /* Clear cache. */
     fw_ctx->write_pos  = position;
@@ -197,6 +207,15 @@ static int fw_fseek( void *ctx, int64_t seek_offset, int origin )
     return MAPI_SUCCESS;
 }
 
+static int fw_get_stats( void *ctx, file_write_stats_t *stats )
+{
+    if( !ctx || !stats )
+        return MAPI_FAILURE;
+    file_write_context_t *fw_ctx = (file_write_context_t *)ctx;
+    *stats = fw_ctx->stats;
+    return MAPI_SUCCESS;
+}
+
 static int fw_open( void *ctx, char *file_name, uint64_t buffer_size )
 {
     if( !ctx )
@@ -218,7 +237,9 @@ static int fw_open( void *ctx, char *file_name, uint64_t buffer_size )
         goto fail;
 
     /* Set up. */
+    file_write_stats_t stats = fw_ctx->stats;
     memset( fw_ctx, 0, sizeof(file_write_context_t) );
+    fw_ctx->stats       = stats;
     fw_ctx->fp          = fp;
     fw_ctx->buffer_size = buffer_size;
     fw_ctx->cache.buf   = buffer;
@@ -250,7 +271,10 @@ static void fw_close( void *ctx )
     if( fw_ctx->fp )
         fclose( fw_ctx->fp );
 
+    /* Keep the stats until release. */
+    file_write_stats_t stats = fw_ctx->stats;
     memset( fw_ctx, 0, sizeof(file_write_context_t) );
+    fw_ctx->stats  = stats;
     fw_ctx->status = FW_STATUS_CLOSED;
 }
 
@@ -291,6 +315,7 @@ file_writer_t file_writer = {
     .ftell    = fw_ftell,
     .fwrite   = fw_fwrite,
     .fseek    = fw_fseek,
+    .stats    = fw_get_stats,
     .open     = fw_open,
     .close    = fw_close,
     .init     = fw_init,
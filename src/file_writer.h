@@ -35,11 +35,18 @@
  *  Definition
  *==========================================================================*/
 
+typedef struct {
+    uint64_t    write_bytes;
+    uint64_t    write_calls;
+    uint64_t    seek_calls;
+} file_write_stats_t;
+
 typedef struct  {
     int         (* pipe    )( void *fr_ctx );
     int64_t     (* ftell   )( void *fr_ctx );
     int         (* fwrite  )( void *fw_ctx, uint8_t *src_buffer, int64_t src_size, int64_t *dest_size );
     int         (* fseek   )( void *fw_ctx, int64_t offset, int origin );
+    int         (* stats   )( void *fw_ctx, file_write_stats_t *stats );
     int         (* open    )( void *fw_ctx, char *file_name, uint64_t buffer_size );
     void        (* close   )( void *fw_ctx );
     int         (* init    )( void **fw_ctx );
@@ -0,0 +1,275 @@
+/*****************************************************************************
+ * hevc_video.c
+ *****************************************************************************
+ *
+ * Authors: Masaki Tanaka <maki.rxrz@gmail.com>
+ *
+ * NYSL Version 0.9982 (en) (Unofficial)
+ * ----------------------------------------
+ * A. This software is "Everyone'sWare". It means:
+ *   Anybody who has this software can use it as if he/she is
+ *   the author.
+ *
+ *   A-1. Freeware. No fee is required.
+ *   A-2. You can freely redistribute this software.
+ *   A-3. You can freely modify this software. And the source
+ *       may be used in any software with no limitation.
+ *
+ * B. The author is not responsible for any kind of damages or loss
+ *   while using or misusing this software, which is distributed
+ *   "AS IS". No warranty of any kind is expressed or implied.
+ *   You use AT YOUR OWN RISK.
+ *
+ * C. Moral rights of author belong to maki. Copyright is abandoned.
+ *
+ * D. Above three clauses are applied both to source and binary
+ *   form of this software.
+ *
+ ****************************************************************************/
+
+#include "common.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "mpeg_common.h"
+#include "mpeg_video.h"
+#include "hevc_video.h"
+
+#define getbits( br, n )        mpeg_bit_reader_get_bits( br, n )
+#define skipbits( br, n )       mpeg_bit_reader_skip_bits( br, n )
+#define getue( br )             mpeg_bit_reader_get_ue( br )
+
+typedef enum {
+    HEVC_SLICE_TYPE_B = 0,
+    HEVC_SLICE_TYPE_P = 1,
+    HEVC_SLICE_TYPE_I = 2
+} hevc_slice_type;
+
+#define IS_IRAP( nal_unit_type )    ((nal_unit_type) >= HEVC_NAL_BLA_W_LP && (nal_unit_type) <= HEVC_NAL_RSV_IRAP_VCL23)
+#define IS_IDR( nal_unit_type )     ((nal_unit_type) == HEVC_NAL_IDR_W_RADL || (nal_unit_type) == HEVC_NAL_IDR_N_LP)
+#define IS_BLA( nal_unit_type )     ((nal_unit_type) >= HEVC_NAL_BLA_W_LP && (nal_unit_type) <= HEVC_NAL_BLA_N_LP)
+
+static void skip_profile_tier_level( mpeg_bit_reader_t *br, hevc_video_sps_t *sps )
+{
+    uint8_t sub_layer_profile_present_flag[8];
+    uint8_t sub_layer_level_present_flag[8];
+    skipbits( br, 3 );                          /* general_profile_space, general_tier_flag */
+    sps->profile_idc = getbits( br, 5 );
+    skipbits( br, 32 );                         /* general_profile_compatibility_flag[32] */
+    skipbits( br, 48 );                         /* general_progressive_source_flag .. general_inbld_flag */
+    sps->level_idc   = getbits( br, 8 );
+    int sub_layers_minus1 = sps->max_sub_layers - 1;
+    for( int i = 0; i < sub_layers_minus1; ++i )
+    {
+        sub_layer_profile_present_flag[i] = getbits( br, 1 );
+        sub_layer_level_present_flag[i]   = getbits( br, 1 );
+    }
+    if( sub_layers_minus1 > 0 )
+        skipbits( br, 2 * (8 - sub_layers_minus1) );    /* reserved_zero_2bits */
+    for( int i = 0; i < sub_layers_minus1; ++i )
+    {
+        if( sub_layer_profile_present_flag[i] )
+            skipbits( br, 88 );
+        if( sub_layer_level_present_flag[i] )
+            skipbits( br, 8 );
+    }
+}
+
+static void read_seq_parameter_set( mpeg_bit_reader_t *br, hevc_video_info_t *hevc_info )
+{
+    hevc_video_sps_t sps = { 0 };
+    skipbits( br, 4 );                          /* sps_video_parameter_set_id */
+    sps.max_sub_layers             = getbits( br, 3 ) + 1;
+    skipbits( br, 1 );                          /* sps_temporal_id_nesting_flag */
+    if( sps.max_sub_layers > 7 )
+        return;
+    skip_profile_tier_level( br, &sps );
+    uint32_t seq_parameter_set_id  = getue( br );
+    if( seq_parameter_set_id >= HEVC_VIDEO_SPS_MAX )
+        return;
+    sps.chroma_format_idc          = getue( br );
+    if( sps.chroma_format_idc == 3 )
+        sps.separate_colour_plane_flag = getbits( br, 1 );
+    sps.width                      = getue( br );
+    sps.height                     = getue( br );
+    if( getbits( br, 1 ) )                      /* conformance_window_flag */
+    {
+        getue( br );                            /* conf_win_left_offset */
+        getue( br );                            /* conf_win_right_offset */
+        getue( br );                            /* conf_win_top_offset */
+        getue( br );                            /* conf_win_bottom_offset */
+    }
+    getue( br );                                /* bit_depth_luma_minus8 */
+    getue( br );                                /* bit_depth_chroma_minus8 */
+    sps.log2_max_pic_order_cnt_lsb = getue( br ) + 4;
+    if( br->error || sps.log2_max_pic_order_cnt_lsb > 16 )
+        return;
+    sps.present = 1;
+    hevc_info->sps[seq_parameter_set_id] = sps;
+    mapi_log( LOG_LV3, "[debug] HEVC SPS id:%u  profile:%u  level:%u  size:%ux%u  sub_layers:%u\n"
+                     , seq_parameter_set_id, sps.profile_idc, sps.level_idc, sps.width, sps.height
+                     , sps.max_sub_layers );
+}
+
+static void read_pic_parameter_set( mpeg_bit_reader_t *br, hevc_video_info_t *hevc_info )
+{
+    hevc_video_pps_t pps = { 0 };
+    uint32_t pic_parameter_set_id = getue( br );
+    uint32_t seq_parameter_set_id = getue( br );
+    pps.dependent_slice_segments_enabled_flag = getbits( br, 1 );
+    pps.output_flag_present_flag              = getbits( br, 1 );
+    pps.num_extra_slice_header_bits           = getbits( br, 3 );
+    if( br->error || pic_parameter_set_id >= HEVC_VIDEO_PPS_MAX || seq_parameter_set_id >= HEVC_VIDEO_SPS_MAX )
+        return;
+    pps.present              = 1;
+    pps.seq_parameter_set_id = seq_parameter_set_id;
+    hevc_info->pps[pic_parameter_set_id] = pps;
+}
+
+static int32_t get_pic_order_cnt( hevc_video_info_t *hevc_info, hevc_video_sps_t *sps )
+{
+    hevc_video_slice_header_t *slice = &(hevc_info->slice);
+    int32_t max_pic_order_cnt_lsb = 1 << sps->log2_max_pic_order_cnt_lsb;
+    int32_t pic_order_cnt_lsb     = slice->pic_order_cnt_lsb;
+    int32_t pic_order_cnt_msb     = 0;
+    /* IDR, BLA and the CRA which starts a sequence have NoRaslOutputFlag. */
+    if( !(IS_IRAP( slice->nal_unit_type ) && (IS_IDR( slice->nal_unit_type ) || IS_BLA( slice->nal_unit_type ) || !hevc_info->sequence_started)) )
+    {
+        int32_t prev_lsb = hevc_info->prev_tid0_pic_order_cnt & (max_pic_order_cnt_lsb - 1);
+        int32_t prev_msb = hevc_info->prev_tid0_pic_order_cnt - prev_lsb;
+        pic_order_cnt_msb = prev_msb;
+        if( pic_order_cnt_lsb < prev_lsb && prev_lsb - pic_order_cnt_lsb >= max_pic_order_cnt_lsb / 2 )
+            pic_order_cnt_msb += max_pic_order_cnt_lsb;
+        else if( pic_order_cnt_lsb > prev_lsb && pic_order_cnt_lsb - prev_lsb > max_pic_order_cnt_lsb / 2 )
+            pic_order_cnt_msb -= max_pic_order_cnt_lsb;
+    }
+    int32_t pic_order_cnt = pic_order_cnt_msb + pic_order_cnt_lsb;
+    /* update prevTid0Pic, except RADL, RASL and sub-layer non-reference pictures. */
+    if( slice->temporal_id == 0
+     && !(slice->nal_unit_type >= HEVC_NAL_RADL_N && slice->nal_unit_type <= HEVC_NAL_RASL_R)
+     && !(slice->nal_unit_type <= HEVC_NAL_RASL_R && !(slice->nal_unit_type & 1)) )
+        hevc_info->prev_tid0_pic_order_cnt = pic_order_cnt;
+    return pic_order_cnt;
+}
+
+static int read_slice_segment_header( mpeg_bit_reader_t *br, uint8_t nal_unit_type, uint8_t temporal_id, hevc_video_info_t *hevc_info )
+{
+    hevc_video_slice_header_t *slice   = &(hevc_info->slice);
+    hevc_video_picture_t      *picture = &(hevc_info->picture);
+    /* only the first slice segment starts a new picture. */
+    if( !getbits( br, 1 ) )                     /* first_slice_segment_in_pic_flag */
+        return -1;
+    if( IS_IRAP( nal_unit_type ) )
+        skipbits( br, 1 );                      /* no_output_of_prior_pics_flag */
+    uint32_t pic_parameter_set_id = getue( br );
+    slice->nal_unit_type        = nal_unit_type;
+    slice->temporal_id          = temporal_id;
+    slice->slice_type           = HEVC_SLICE_TYPE_I;
+    slice->pic_parameter_set_id = (pic_parameter_set_id < HEVC_VIDEO_PPS_MAX) ? pic_parameter_set_id : 0;
+    slice->pic_order_cnt_lsb    = 0;
+    if( br->error )
+        return -1;
+    /* setup picture information. */
+    picture->picture_coding_type  = IS_IRAP( nal_unit_type ) ? MPEG_VIDEO_I_FRAME : MPEG_VIDEO_UNKNOWN_FRAME;
+    picture->keyframe             = IS_IRAP( nal_unit_type );
+    picture->closed_gop           = IS_IDR( nal_unit_type ) || IS_BLA( nal_unit_type );
+    picture->progressive_sequence = 1;
+    picture->picture_structure    = MPEG_VIDEO_FRAME_STRUCTURE;
+    picture->temporal_id          = temporal_id;
+    picture->temporal_reference   = -1;
+    picture->pic_order_cnt        = 0;
+    /* check parameter sets. */
+    hevc_video_pps_t *pps = (pic_parameter_set_id < HEVC_VIDEO_PPS_MAX) ? &(hevc_info->pps[pic_parameter_set_id]) : NULL;
+    if( !pps || !pps->present || !hevc_info->sps[pps->seq_parameter_set_id].present )
+        return 0;
+    hevc_video_sps_t *sps = &(hevc_info->sps[pps->seq_parameter_set_id]);
+    skipbits( br, pps->num_extra_slice_header_bits );   /* slice_reserved_flag */
+    slice->slice_type               = getue( br );
+    if( pps->output_flag_present_flag )
+        skipbits( br, 1 );                      /* pic_output_flag */
+    if( sps->separate_colour_plane_flag )
+        skipbits( br, 2 );                      /* colour_plane_id */
+    if( !IS_IDR( nal_unit_type ) )
+        slice->pic_order_cnt_lsb    = getbits( br, sps->log2_max_pic_order_cnt_lsb );
+    if( br->error || slice->slice_type > HEVC_SLICE_TYPE_I )
+        return -1;
+    /* setup picture order. */
+    static const uint8_t picture_coding_type[3] =
+        {
+            MPEG_VIDEO_B_FRAME,     /* B */
+            MPEG_VIDEO_P_FRAME,     /* P */
+            MPEG_VIDEO_I_FRAME      /* I */
+        };
+    picture->picture_coding_type = picture_coding_type[slice->slice_type];
+    picture->pic_order_cnt       = get_pic_order_cnt( hevc_info, sps );
+    hevc_info->sequence_started  = 1;
+    if( picture->keyframe )
+        hevc_info->key_pic_order_cnt = picture->pic_order_cnt;
+    int32_t temporal_reference = picture->pic_order_cnt - hevc_info->key_pic_order_cnt;
+    picture->temporal_reference = (temporal_reference > INT16_MAX) ? INT16_MAX
+                                : (temporal_reference < INT16_MIN) ? INT16_MIN
+                                :                                    temporal_reference;
+    return 0;
+}
+
+extern int hevc_video_read_nal_unit( mpeg_bit_reader_t *br, uint8_t nal_header, hevc_video_info_t *hevc_info )
+{
+    /* check forbidden_zero_bit. */
+    if( nal_header & 0x80 )
+        return 0;
+    hevc_nal_unit_type nal_unit_type = (nal_header >> 1) & 0x3F;
+    uint8_t nuh_layer_id_lsb         = getbits( br, 8 );
+    uint8_t nuh_layer_id             = ((nal_header & 0x01) << 5) | (nuh_layer_id_lsb >> 3);
+    uint8_t nuh_temporal_id_plus1    = nuh_layer_id_lsb & 0x07;
+    if( br->error || nuh_layer_id || !nuh_temporal_id_plus1 )
+        return 0;
+    mapi_log( LOG_LV4, "[debug] HEVC nal_unit_type:%u  temporal_id:%u\n", nal_unit_type, nuh_temporal_id_plus1 - 1 );
+    if( nal_unit_type <= HEVC_NAL_RSV_IRAP_VCL23 )
+    {
+        /* skip reserved VCL NAL unit types. */
+        if( (nal_unit_type > HEVC_NAL_RASL_R && nal_unit_type < HEVC_NAL_BLA_W_LP)
+         || nal_unit_type > HEVC_NAL_CRA )
+            return 0;
+        return read_slice_segment_header( br, nal_unit_type, nuh_temporal_id_plus1 - 1, hevc_info ) ? 0 : 1;
+    }
+    switch( nal_unit_type )
+    {
+        case HEVC_NAL_SPS :
+            read_seq_parameter_set( br, hevc_info );
+            break;
+        case HEVC_NAL_PPS :
+            read_pic_parameter_set( br, hevc_info );
+            break;
+        case HEVC_NAL_END_OF_SEQUENCE :
+            hevc_info->sequence_started = 0;
+            break;
+        default :
+            break;
+    }
+    return 0;
+}
+
+extern void hevc_video_debug_picture_info( hevc_video_info_t *hevc_info )
+{
+    static const char frame[4] = { '?', 'I', 'P', 'B' };
+    mapi_log( LOG_LV2,
+              "[check] detect HEVC Slice.\n"
+              "        nal_unit_type:%u\n"
+              "        temporal_id:%u\n"
+              "        slice_type:%u [%c]\n"
+              "        pic_parameter_set_id:%u\n"
+              "        pic_order_cnt_lsb:%u\n"
+              "        keyframe:%u\n"
+              "        closed_gop:%u\n"
+              "        temporal_reference:%d\n"
+              , hevc_info->slice.nal_unit_type
+              , hevc_info->slice.temporal_id
+              , hevc_info->slice.slice_type, frame[hevc_info->picture.picture_coding_type]
+              , hevc_info->slice.pic_parameter_set_id
+              , hevc_info->slice.pic_order_cnt_lsb
+              , hevc_info->picture.keyframe
+              , hevc_info->picture.closed_gop
+              , hevc_info->picture.temporal_reference );
+}
@@ -0,0 +1,128 @@
+/*****************************************************************************
+ * hevc_video.h
+ *****************************************************************************
+ *
+ * Authors: Masaki Tanaka <maki.rxrz@gmail.com>
+ *
+ * NYSL Version 0.9982 (en) (Unofficial)
+ * ----------------------------------------
+ * A. This software is "Everyone'sWare". It means:
+ *   Anybody who has this software can use it as if he/she is
+ *   the author.
+ *
+ *   A-1. Freeware. No fee is required.
+ *   A-2. You can freely redistribute this software.
+ *   A-3. You can freely modify this software. And the source
+ *       may be used in any software with no limitation.
+ *
+ * B. The author is not responsible for any kind of damages or loss
+ *   while using or misusing this software, which is distributed
+ *   "AS IS". No warranty of any kind is expressed or implied.
+ *   You use AT YOUR OWN RISK.
+ *
+ * C. Moral rights of author belong to maki. Copyright is abandoned.
+ *
+ * D. Above three clauses are applied both to source and binary
+ *   form of this software.
+ *
+ ****************************************************************************/
+#ifndef __HEVC_VIDEO_H__
+#define __HEVC_VIDEO_H__
+
+#include "mpeg_common.h"
+#include "mpeg_video.h"
+
+#define HEVC_VIDEO_SPS_MAX              (16)
+#define HEVC_VIDEO_PPS_MAX              (64)
+
+typedef enum {
+    HEVC_NAL_TRAIL_N         = 0,
+    HEVC_NAL_TRAIL_R         = 1,
+    HEVC_NAL_TSA_N           = 2,
+    HEVC_NAL_TSA_R           = 3,
+    HEVC_NAL_STSA_N          = 4,
+    HEVC_NAL_STSA_R          = 5,
+    HEVC_NAL_RADL_N          = 6,
+    HEVC_NAL_RADL_R          = 7,
+    HEVC_NAL_RASL_N          = 8,
+    HEVC_NAL_RASL_R          = 9,
+    HEVC_NAL_BLA_W_LP        = 16,
+    HEVC_NAL_BLA_W_RADL      = 17,
+    HEVC_NAL_BLA_N_LP        = 18,
+    HEVC_NAL_IDR_W_RADL      = 19,
+    HEVC_NAL_IDR_N_LP        = 20,
+    HEVC_NAL_CRA             = 21,
+    HEVC_NAL_RSV_IRAP_VCL23  = 23,
+    HEVC_NAL_VPS             = 32,
+    HEVC_NAL_SPS             = 33,
+    HEVC_NAL_PPS             = 34,
+    HEVC_NAL_AUD             = 35,
+    HEVC_NAL_END_OF_SEQUENCE = 36,
+    HEVC_NAL_END_OF_STREAM   = 37,
+    HEVC_NAL_FILLER_DATA     = 38,
+    HEVC_NAL_PREFIX_SEI      = 39,
+    HEVC_NAL_SUFFIX_SEI      = 40
+} hevc_nal_unit_type;
+
+typedef struct {
+    uint8_t         present;
+    uint8_t         profile_idc;
+    uint8_t         level_idc;
+    uint8_t         max_sub_layers;
+    uint8_t         chroma_format_idc;
+    uint8_t         separate_colour_plane_flag;
+    uint8_t         log2_max_pic_order_cnt_lsb;
+    uint16_t        width;
+    uint16_t        height;
+} hevc_video_sps_t;
+
+typedef struct {
+    uint8_t         present;
+    uint8_t         seq_parameter_set_id;
+    uint8_t         dependent_slice_segments_enabled_flag;
+    uint8_t         output_flag_present_flag;
+    uint8_t         num_extra_slice_header_bits;
+} hevc_video_pps_t;
+
+typedef struct {
+    uint8_t         nal_unit_type;
+    uint8_t         temporal_id;
+    uint8_t         slice_type;
+    uint8_t         pic_parameter_set_id;
+    uint32_t        pic_order_cnt_lsb;
+} hevc_video_slice_header_t;
+
+typedef struct {
+    uint8_t         picture_coding_type;
+    uint8_t         keyframe;
+    uint8_t         closed_gop;
+    uint8_t         progressive_sequence;
+    uint8_t         picture_structure;
+    uint8_t         temporal_id;
+    int16_t         temporal_reference;
+    int32_t         pic_order_cnt;
+} hevc_video_picture_t;
+
+typedef struct {
+    hevc_video_sps_t            sps[HEVC_VIDEO_SPS_MAX];
+    hevc_video_pps_t            pps[HEVC_VIDEO_PPS_MAX];
+    hevc_video_slice_header_t   slice;
+    hevc_video_picture_t        picture;
+    uint8_t                     sequence_started;
+    int32_t                     prev_tid0_pic_order_cnt;
+    int32_t                     key_pic_order_cnt;
+} hevc_video_info_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int hevc_video_read_nal_unit( mpeg_bit_reader_t *br, uint8_t nal_header, hevc_video_info_t *hevc_info );
+
+extern void hevc_video_debug_picture_info( hevc_video_info_t *hevc_info );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HEVC_VIDEO_H__ */
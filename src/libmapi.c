@@ -33,13 +33,177 @@
 
 #include "mpeg_utils.h"
 
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "thread_utils.h"
+
+#define LOG_SINK_RING_SIZE          (1024)
+#define TRACE_CHUNK_EVENTS          (4096)
+#define TRACE_STACK_DEPTH           (16)
+
 static struct {
     log_level   log_lv;
     FILE       *msg_out;
+    uint32_t    sink_num[LOG_LV_ALL + 1];
 } debug_ctrl = { 0 };
 
-extern void mapi_log( log_level level, const char *format, ... )
+/* the highest level of the global setting and the sinks, checked by mapi_log(). */
+log_level mapi_debug_log_lv = LOG_LV0;
+
+struct mapi_log_sink_s {
+    log_level       log_lv;
+    FILE           *msg_out;
+    mapi_log_cb_t   callback;
+    void           *cb_params;
+    void           *ring;
+    void           *thread;
+    int             closed;
+};
+
+typedef struct {
+    log_level       level;
+    char            message[];
+} log_message_t;
+
+static __thread mapi_log_sink_t *bound_sink;
+
+static void update_log_lv( void )
+{
+    log_level log_lv = debug_ctrl.log_lv;
+    for( int lv = LOG_LV_ALL; lv > log_lv && lv >= LOG_LV0; --lv )
+        if( __atomic_load_n( &(debug_ctrl.sink_num[lv]), __ATOMIC_RELAXED ) )
+        {
+            log_lv = lv;
+            break;
+        }
+    __atomic_store_n( &mapi_debug_log_lv, log_lv, __ATOMIC_RELAXED );
+}
+
+static void sink_log( mapi_log_sink_t *sink, log_level level, const char *format, va_list argptr )
+{
+    va_list argcopy;
+    va_copy( argcopy, argptr );
+    int length = vsnprintf( NULL, 0, format, argcopy );
+    va_end( argcopy );
+    if( length < 0 )
+        return;
+    log_message_t *msg = (log_message_t *)malloc( sizeof(log_message_t) + length + 1 );
+    if( !msg )
+        return;
+    msg->level = level;
+    vsnprintf( msg->message, length + 1, format, argptr );
+    if( thread_ring_push_wait( sink->ring, msg ) )
+        free( msg );
+}
+
+static thread_func_ret sink_deliver( void *args )
 {
+    mapi_log_sink_t *sink = (mapi_log_sink_t *)args;
+    void *data;
+    while( !thread_ring_pop_wait( sink->ring, &data ) )
+    {
+        log_message_t *msg = (log_message_t *)data;
+        if( sink->callback )
+            sink->callback( sink->cb_params, msg->level, msg->message );
+        else
+        {
+            FILE *msg_out = (msg->level == LOG_LV_PROGRESS) ? stderr : sink->msg_out;
+            if( msg_out )
+            {
+                fputs( msg->message, msg_out );
+#ifdef DEBUG
+                fflush( msg_out );
+#endif
+            }
+        }
+        free( msg );
+    }
+    return (thread_func_ret)(0);
+}
+
+extern mapi_log_sink_t *mapi_log_sink_create( log_level level, FILE *output, mapi_log_cb_t callback, void *cb_params )
+{
+    if( !output && !callback )
+        return NULL;
+    if( level > LOG_LV_ALL )
+        level = LOG_LV_ALL;
+    mapi_log_sink_t *sink = (mapi_log_sink_t *)calloc( 1, sizeof(mapi_log_sink_t) );
+    if( !sink )
+        return NULL;
+    sink->log_lv    = level;
+    sink->msg_out   = output;
+    sink->callback  = callback;
+    sink->cb_params = cb_params;
+    sink->ring      = thread_ring_create( LOG_SINK_RING_SIZE, THREAD_RING_MPSC );
+    if( !sink->ring )
+        goto fail_create;
+    sink->thread = thread_create( sink_deliver, sink );
+    if( !sink->thread )
+        goto fail_create;
+    if( level >= LOG_LV0 )
+    {
+        __atomic_add_fetch( &(debug_ctrl.sink_num[level]), 1, __ATOMIC_RELAXED );
+        update_log_lv();
+    }
+    return sink;
+fail_create:
+    thread_ring_release( sink->ring );
+    free( sink );
+    return NULL;
+}
+
+extern void mapi_log_sink_close( mapi_log_sink_t *sink )
+{
+    if( !sink || sink->closed )
+        return;
+    __atomic_store_n( &(sink->closed), 1, __ATOMIC_RELAXED );
+    /* deliver the rest of the logs, the later logs are dropped. */
+    thread_ring_close( sink->ring );
+    thread_wait_end( sink->thread, NULL );
+    if( sink->log_lv >= LOG_LV0 )
+    {
+        __atomic_sub_fetch( &(debug_ctrl.sink_num[sink->log_lv]), 1, __ATOMIC_RELAXED );
+        update_log_lv();
+    }
+}
+
+extern void mapi_log_sink_release( mapi_log_sink_t *sink )
+{
+    if( !sink )
+        return;
+    if( bound_sink == sink )
+        bound_sink = NULL;
+    mapi_log_sink_close( sink );
+    /* free the logs pushed while closing. */
+    void *data;
+    while( !thread_ring_pop( sink->ring, &data ) )
+        free( data );
+    thread_ring_release( sink->ring );
+    free( sink );
+}
+
+extern mapi_log_sink_t *mapi_log_sink_bind( mapi_log_sink_t *sink )
+{
+    mapi_log_sink_t *prev_sink = bound_sink;
+    bound_sink = sink;
+    return prev_sink;
+}
+
+extern void mapi_debug_log( log_level level, const char *format, ... )
+{
+    va_list argptr;
+    mapi_log_sink_t *sink = bound_sink;
+    if( sink && level != LOG_LV_OUTPUT )
+    {
+        if( sink->log_lv < level || __atomic_load_n( &(sink->closed), __ATOMIC_RELAXED ) )
+            return;
+        va_start( argptr, format );
+        sink_log( sink, level, format, argptr );
+        va_end( argptr );
+        return;
+    }
     FILE *msg_out = debug_ctrl.msg_out;
     if( level == LOG_LV_OUTPUT )
         msg_out = stdout;
@@ -47,7 +211,6 @@ extern void mapi_log( log_level level, const char *format, ... )
         msg_out = stderr;
     if( debug_ctrl.log_lv < level || !msg_out )
         return;
-    va_list argptr;
     va_start( argptr, format );
     mapi_vfprintf( msg_out, format, argptr );
     va_end( argptr );
@@ -56,10 +219,288 @@ extern void mapi_log( log_level level, const char *format, ... )
 #endif
 }
 
+extern int mapi_debug_log_enabled( log_level level )
+{
+    mapi_log_sink_t *sink = bound_sink;
+    if( sink )
+        return sink->log_lv >= level;
+    return debug_ctrl.log_lv >= level && debug_ctrl.msg_out;
+}
+
+typedef struct mapi_stats_slot_s {
+    struct mapi_stats_slot_s   *next;
+    const void                 *owner;
+    uint64_t                    counter[MAPI_STATS_COUNTER_NUM];
+} mapi_stats_slot_t;
+
+struct mapi_stats_set_s {
+    void               *mutex;
+    mapi_stats_slot_t  *slot;
+    uint32_t            id;
+};
+
+static uint32_t stats_set_id;
+
+/* the address is unique in the living threads, and identifies the owner of the slot. */
+static __thread char     stats_owner;
+static __thread struct {
+    mapi_stats_set_t   *set;
+    uint32_t            id;
+} bound_stats;
+
+__thread uint64_t *mapi_stats_counter;
+
+extern mapi_stats_set_t *mapi_stats_create( void )
+{
+    mapi_stats_set_t *set = (mapi_stats_set_t *)calloc( 1, sizeof(mapi_stats_set_t) );
+    if( !set )
+        return NULL;
+    set->mutex = thread_mutex_create();
+    if( !set->mutex )
+    {
+        free( set );
+        return NULL;
+    }
+    set->id = __atomic_add_fetch( &stats_set_id, 1, __ATOMIC_RELAXED );
+    return set;
+}
+
+extern void mapi_stats_release( mapi_stats_set_t *set )
+{
+    if( !set )
+        return;
+    if( bound_stats.set == set )
+    {
+        bound_stats.set    = NULL;
+        mapi_stats_counter = NULL;
+    }
+    while( set->slot )
+    {
+        mapi_stats_slot_t *next = set->slot->next;
+        free( set->slot );
+        set->slot = next;
+    }
+    thread_mutex_release( set->mutex );
+    free( set );
+}
+
+extern mapi_stats_set_t *mapi_stats_bind( mapi_stats_set_t *set )
+{
+    mapi_stats_set_t *prev_set = bound_stats.set;
+    if( set && set == prev_set && set->id == bound_stats.id )
+        return prev_set;
+    uint64_t *counter = NULL;
+    if( set )
+    {
+        /* search the slot of this thread, and add it at the first bind. */
+        thread_mutex_lock( set->mutex );
+        mapi_stats_slot_t *slot = set->slot;
+        while( slot && slot->owner != &stats_owner )
+            slot = slot->next;
+        if( !slot )
+        {
+            slot = (mapi_stats_slot_t *)calloc( 1, sizeof(mapi_stats_slot_t) );
+            if( slot )
+            {
+                slot->owner = &stats_owner;
+                slot->next  = set->slot;
+                set->slot   = slot;
+            }
+        }
+        thread_mutex_unlock( set->mutex );
+        if( slot )
+            counter = slot->counter;
+    }
+    bound_stats.set    = counter ? set : NULL;
+    bound_stats.id     = counter ? set->id : 0;
+    mapi_stats_counter = counter;
+    return prev_set;
+}
+
+extern void mapi_stats_collect( mapi_stats_set_t *set, uint64_t counter[MAPI_STATS_COUNTER_NUM] )
+{
+    memset( counter, 0, sizeof(uint64_t) * MAPI_STATS_COUNTER_NUM );
+    if( !set )
+        return;
+    thread_mutex_lock( set->mutex );
+    for( mapi_stats_slot_t *slot = set->slot; slot; slot = slot->next )
+        for( int i = 0; i < MAPI_STATS_COUNTER_NUM; ++i )
+            counter[i] += __atomic_load_n( &(slot->counter[i]), __ATOMIC_RELAXED );
+    thread_mutex_unlock( set->mutex );
+}
+
+typedef struct {
+    const char *name;
+    uint64_t    begin;
+    uint64_t    duration;
+} trace_event_t;
+
+typedef struct trace_chunk_s {
+    struct trace_chunk_s   *next;
+    uint32_t                num;
+    trace_event_t           event[TRACE_CHUNK_EVENTS];
+} trace_chunk_t;
+
+typedef struct trace_thread_s {
+    struct trace_thread_s  *next;
+    uint32_t                tid;
+    trace_chunk_t          *head;
+    trace_chunk_t          *tail;
+} trace_thread_t;
+
+static struct {
+    int             active;
+    uint32_t        session;
+    uint32_t        thread_num;
+    uint64_t        base_time;
+    FILE           *output;
+    void           *mutex;
+    trace_thread_t *thread;
+} trace_ctrl = { 0 };
+
+/* the events are appended by the owner thread only, and read at close. */
+static __thread struct {
+    trace_thread_t *thread;
+    uint32_t        session;
+    uint32_t        depth;
+    const char     *name [TRACE_STACK_DEPTH];
+    uint64_t        begin[TRACE_STACK_DEPTH];
+} trace_local;
+
+static trace_thread_t *trace_get_thread( void )
+{
+    uint32_t session = __atomic_load_n( &trace_ctrl.session, __ATOMIC_RELAXED );
+    if( trace_local.session == session )
+        return trace_local.thread;
+    trace_thread_t *thread = (trace_thread_t *)calloc( 1, sizeof(trace_thread_t) );
+    if( thread )
+    {
+        thread_mutex_lock( trace_ctrl.mutex );
+        thread->tid       = ++ trace_ctrl.thread_num;
+        thread->next      = trace_ctrl.thread;
+        trace_ctrl.thread = thread;
+        thread_mutex_unlock( trace_ctrl.mutex );
+    }
+    trace_local.thread  = thread;
+    trace_local.session = session;
+    return thread;
+}
+
+MAPI_EXPORT void mpeg_api_trace_begin( const char *name )
+{
+    uint32_t depth = trace_local.depth ++;
+    if( depth >= TRACE_STACK_DEPTH )
+        return;
+    /* keep the depth balanced even if the trace is not opened. */
+    if( !__atomic_load_n( &trace_ctrl.active, __ATOMIC_ACQUIRE ) )
+        name = NULL;
+    trace_local.name [depth] = name;
+    trace_local.begin[depth] = name ? thread_get_time() : 0;
+}
+
+MAPI_EXPORT void mpeg_api_trace_end( void )
+{
+    if( !trace_local.depth )
+        return;
+    uint32_t depth = -- trace_local.depth;
+    if( depth >= TRACE_STACK_DEPTH || !trace_local.name[depth]
+     || !__atomic_load_n( &trace_ctrl.active, __ATOMIC_ACQUIRE ) )
+        return;
+    uint64_t end_time = thread_get_time();
+    trace_thread_t *thread = trace_get_thread();
+    if( !thread )
+        return;
+    trace_chunk_t *chunk = thread->tail;
+    if( !chunk || chunk->num >= TRACE_CHUNK_EVENTS )
+    {
+        chunk = (trace_chunk_t *)malloc( sizeof(trace_chunk_t) );
+        if( !chunk )
+            return;
+        chunk->next = NULL;
+        chunk->num  = 0;
+        if( thread->tail )
+            thread->tail->next = chunk;
+        else
+            thread->head = chunk;
+        thread->tail = chunk;
+    }
+    trace_event_t *event = &(chunk->event[chunk->num ++]);
+    event->name     = trace_local.name[depth];
+    event->begin    = trace_local.begin[depth];
+    event->duration = end_time - event->begin;
+}
+
+MAPI_EXPORT int mpeg_api_trace_open( const char *file_name )
+{
+    if( !file_name || trace_ctrl.output )
+        return -1;
+    FILE *output = mapi_fopen( file_name, "wb" );
+    if( !output )
+        return -1;
+    trace_ctrl.mutex = thread_mutex_create();
+    if( !trace_ctrl.mutex )
+    {
+        fclose( output );
+        return -1;
+    }
+    trace_ctrl.output     = output;
+    trace_ctrl.thread     = NULL;
+    trace_ctrl.thread_num = 0;
+    trace_ctrl.base_time  = thread_get_time();
+    __atomic_add_fetch( &trace_ctrl.session, 1, __ATOMIC_RELAXED );
+    __atomic_store_n( &trace_ctrl.active, 1, __ATOMIC_RELEASE );
+    return 0;
+}
+
+/* the traced work must be finished before the close. */
+MAPI_EXPORT void mpeg_api_trace_close( void )
+{
+    FILE *output = trace_ctrl.output;
+    if( !output )
+        return;
+    __atomic_store_n( &trace_ctrl.active, 0, __ATOMIC_RELEASE );
+    thread_mutex_lock( trace_ctrl.mutex );
+    trace_thread_t *thread = trace_ctrl.thread;
+    trace_ctrl.thread = NULL;
+    thread_mutex_unlock( trace_ctrl.mutex );
+    const char *separator = "";
+    fprintf( output, "{\"traceEvents\":[" );
+    while( thread )
+    {
+        fprintf( output, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}"
+                       , separator, thread->tid, thread->tid );
+        separator = ",";
+        while( thread->head )
+        {
+            trace_chunk_t *chunk = thread->head;
+            for( uint32_t i = 0; i < chunk->num; ++i )
+            {
+                trace_event_t *event = &(chunk->event[i]);
+                uint64_t begin = event->begin > trace_ctrl.base_time ? event->begin - trace_ctrl.base_time : 0;
+                fprintf( output, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%" PRIu64 ",\"dur\":%" PRIu64 "}"
+                               , event->name, thread->tid, begin, event->duration );
+            }
+            thread->head = chunk->next;
+            free( chunk );
+        }
+        trace_thread_t *next = thread->next;
+        free( thread );
+        thread = next;
+    }
+    fprintf( output, "\n],\"displayTimeUnit\":\"ms\"}\n" );
+    fclose( output );
+    thread_mutex_release( trace_ctrl.mutex );
+    trace_ctrl.mutex  = NULL;
+    trace_ctrl.output = NULL;
+}
+
 MAPI_EXPORT void mpeg_api_setup_log_lv( log_level level, FILE *output )
 {
     if( level != LOG_LV_KEEP )
+    {
         debug_ctrl.log_lv = level;
+        update_log_lv();
+    }
     if( output )
         debug_ctrl.msg_out = output;
 }
@@ -187,6 +187,91 @@ typedef struct {
     int64_t             last_pcr;
 } pcr_info_t;
 
+typedef struct {
+    int64_t             file_position;
+    int64_t             pcr;                /* 27MHz clock */
+    int64_t             arrival_time;       /* 27MHz clock, TTS only */
+    uint8_t             discontinuity;      /* indicated or detected, starts a new segment */
+} pcr_scan_data_t;
+
+typedef struct {
+    uint16_t            pcr_program_id;
+    uint32_t            pcr_num;
+    uint32_t            discontinuity_num;
+    uint32_t            repetition_error_num;   /* interval over 40ms */
+    int64_t             min_interval;           /* 27MHz clock */
+    int64_t             max_interval;           /* 27MHz clock */
+    int64_t             duration;               /* 27MHz clock, sum of continuous segments */
+    double              bitrate;                /* bps */
+    double              jitter_max;             /* ns, against a constant bitrate fit */
+    double              jitter_rms;             /* ns */
+    double              drift;                  /* ppm, PCR against arrival time (TTS only) */
+} pcr_scan_stats_t;
+
+typedef struct {
+    uint16_t            program_id;
+    uint32_t            packet_num;
+    uint32_t            cc_error_num;
+    uint32_t            tei_error_num;              /* transport_error_indicator */
+    uint32_t            section_num;                /* payload_unit_start_indicator */
+    uint32_t            section_interval_error_num; /* interval over 500ms */
+    int64_t             section_interval_max;       /* 27MHz clock */
+    uint32_t            pcr_num;
+    uint32_t            pcr_repetition_error_num;   /* interval over 40ms */
+    uint32_t            pcr_discontinuity_error_num;/* over 100ms or backwards, not indicated */
+    int64_t             pcr_interval_max;           /* 27MHz clock */
+} pid_packet_stats_t;
+
+typedef struct {
+    int64_t             start_position;
+    int64_t             end_position;
+    int64_t             packet_num;
+    uint32_t            cc_error_num;
+    uint32_t            tei_error_num;
+    uint32_t            pat_error_num;
+    uint32_t            pmt_error_num;
+    uint32_t            pcr_repetition_error_num;
+    uint32_t            pcr_discontinuity_error_num;
+    int64_t             pat_interval_max;           /* 27MHz clock */
+    int64_t             pmt_interval_max;           /* 27MHz clock */
+    int64_t             pcr_interval_max;           /* 27MHz clock */
+    uint16_t            pid_stats_num;
+    pid_packet_stats_t *pid_stats;
+} packet_stats_t;
+
+typedef struct {
+    uint64_t            read_bytes;
+    uint64_t            read_calls;                 /* fread() to the cache */
+    uint64_t            seek_calls;                 /* fseeko() */
+    uint64_t            cache_hits;
+    uint64_t            cache_misses;
+    uint64_t            packets_scanned;
+    uint64_t            packets_delivered;          /* payload of the target PID */
+    uint64_t            pes_assembled;
+    uint64_t            sample_allocs;              /* malloc() in the sample fetch */
+} perf_stats_t;
+
+typedef struct {
+    uint16_t            program_id;
+    uint32_t            packet_num;
+    uint32_t           *bucket;                     /* packets of each bucket, bucket_num entries */
+} pid_bitrate_histogram_t;
+
+typedef struct {
+    uint16_t            pcr_program_id;
+    uint8_t             arrival_time_base;          /* 1: TTS arrival time, 0: PCR */
+    int64_t             bucket_duration;            /* 27MHz clock */
+    uint32_t            bucket_num;
+    int64_t             packet_num;
+    uint16_t            pid_num;
+    pid_bitrate_histogram_t *pid;
+} bitrate_histogram_t;
+
+typedef struct {
+    int64_t             file_position;
+    int64_t             arrival_time;       /* 27MHz clock */
+} arrival_time_info_t;
+
 typedef struct {
     uint16_t            service_id;
     uint16_t            pmt_program_id;
@@ -211,6 +296,16 @@ typedef struct {
     uint16_t          pmt_program_id;
 } get_stream_data_cb_ret_t;
 
+typedef struct {
+    uint8_t          *data;
+    uint32_t          size;
+} sample_span_t;
+
+typedef struct {
+    uint32_t          offset;
+    uint32_t          size;
+} audio_frame_t;
+
 #define BYTE_DATA_SHIFT( data, size )           \
 do {                                            \
     for( int i = 1; i < size; ++i )             \
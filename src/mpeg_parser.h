@@ -52,6 +52,7 @@ typedef struct {
     uint16_t                program_id;
     int64_t                 pts;
     int64_t                 dts;
+    int64_t                 arrival_time;
     int64_t                 gop_number;
     uint8_t                 progressive_sequence;
     uint8_t                 closed_gop;
@@ -72,6 +73,7 @@ typedef struct {
     uint16_t                program_id;
     int64_t                 pts;
     int64_t                 dts;
+    int64_t                 arrival_time;
     uint32_t                sampling_frequency;
     uint32_t                bitrate;
     uint16_t                channel;
@@ -79,9 +81,21 @@ typedef struct {
     uint8_t                 bit_depth;
 } audio_sample_info_t;
 
+typedef struct {
+    int64_t                 position;
+    int64_t                 next_position;      /* start of the first later sample after position, -1: unknown */
+    uint32_t                sample_size;
+    int32_t                 read_offset;
+    uint32_t                buffer_offset;
+    uint32_t                read_size;
+    uint32_t                sample_index;
+} sample_read_info_t;
+
 typedef struct {
     void *              (* initialize               )( const char *input, int64_t buffer_size );
     void                (* release                  )( void *ih );
+    void *              (* create_cursor            )( void *ih );
+    void                (* release_cursor           )( void *ch );
     int                 (* parse                    )( void *ih );
     int                 (* set_service_id           )( void *ih, uint16_t service_id );
     int32_t             (* get_service_id_num       )( void *ih );
@@ -93,14 +107,19 @@ typedef struct {
     int                 (* get_video_info           )( void *ih, uint8_t stream_number, video_sample_info_t *video_info );
     int                 (* get_audio_info           )( void *ih, uint8_t stream_number, audio_sample_info_t *audio_info );
     int                 (* get_pcr                  )( void *ih, pcr_info_t *pcr_info, uint16_t service_id );
+    int                 (* get_arrival_time_index   )( void *ih, uint32_t packet_interval, arrival_time_info_t **dst_index, uint32_t *dst_index_num );
+    int                 (* scan_pcr                 )( void *ih, uint16_t service_id, pcr_scan_data_t **dst_data, uint32_t *dst_data_num, pcr_scan_stats_t *stats );
+    int                 (* get_packet_stats         )( void *ih, packet_stats_t *stats );
+    int                 (* scan_bitrate             )( void *ih, uint16_t service_id, uint32_t bucket_msec, bitrate_histogram_t *histogram );
     uint8_t             (* get_stream_num           )( void *ih, mpeg_sample_type sample_type, uint16_t service_id );
     int                 (* get_stream_data          )( void *ih, mpeg_sample_type sample_type, uint8_t stream_number, int32_t read_offset, get_sample_data_mode get_mode, get_stream_data_cb_t *cb );
     int                 (* get_specific_stream_data )( void *ih, get_sample_data_mode get_mode, output_stream_type output_stream, int update_psi, get_stream_data_cb_t *cb );
     int64_t             (* get_sample_position      )( void *ih, mpeg_sample_type sample_type, uint8_t stream_number );
     int                 (* set_sample_position      )( void *ih, mpeg_sample_type sample_type, uint8_t stream_number, int64_t position );
     int                 (* seek_next_sample_position)( void *ih, mpeg_sample_type sample_type, uint8_t stream_number );
-    int                 (* get_sample_data          )( void *ih, mpeg_sample_type sample_type, uint8_t stream_number, int64_t position, uint32_t sample_size, int32_t read_offset, uint8_t **dst_buffer, uint32_t *dst_read_size, get_sample_data_mode get_mode );
-    void                (* free_sample_buffer       )( uint8_t **buffer );
+    int                 (* get_sample_data          )( void *ih, mpeg_sample_type sample_type, uint8_t stream_number, int64_t position, uint32_t sample_size, int32_t read_offset, uint8_t *dst_buffer, uint32_t *dst_read_size, get_sample_data_mode get_mode );
+    int                 (* get_sample_spans         )( void *ih, mpeg_sample_type sample_type, uint8_t stream_number, int64_t position, uint32_t sample_size, int32_t read_offset, sample_span_t **dst_spans, uint32_t *dst_span_num, get_sample_data_mode get_mode );
+    int                 (* get_sample_range_data    )( void *ih, mpeg_sample_type sample_type, uint8_t stream_number, sample_read_info_t *read_info, uint32_t read_num, uint8_t *dst_buffer, get_sample_data_mode get_mode );
     mpeg_stream_type    (* get_sample_stream_type   )( void *ih, mpeg_sample_type sample_type, uint8_t stream_number );
     const char *        (* get_stream_information   )( void *ih, mpeg_sample_type sample_type, uint8_t stream_number, get_information_key_type key );
 } mpeg_parser_t;
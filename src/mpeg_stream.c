@@ -138,16 +138,69 @@ extern mpeg_pes_stream_id_type mpeg_pes_get_steam_id_type( mpeg_stream_group_typ
     return stream_id_type;
 }
 
-#define ALLOCATE_DESCRIPTOR_INFO( name )                                                    \
-    name##_descriptor_info_t *name = descriptor_info->name;                                 \
-do {                                                                                        \
-    if( !name )                                                                             \
-    {                                                                                       \
-        name = (name##_descriptor_info_t *)calloc( 1, sizeof(name##_descriptor_info_t) );   \
-        if( !name )                                                                         \
-            return -1;                                                                      \
-        descriptor_info->name = name;                                                       \
-    }                                                                                       \
+#define DESCRIPTOR_ARENA_BLOCK_SIZE         (4096)
+
+typedef struct descriptor_arena_block_s {
+    struct descriptor_arena_block_s    *next;
+    uint32_t                            size;
+    uint32_t                            used;
+    uint64_t                            data[];
+} descriptor_arena_block_t;
+
+typedef struct {
+    descriptor_arena_block_t   *head;
+    descriptor_arena_block_t   *current;
+} descriptor_arena_t;
+
+static void *allocate_descriptor_arena( mpeg_descriptor_info_t *descriptor_info, uint32_t size )
+{
+    descriptor_arena_t *arena = (descriptor_arena_t *)descriptor_info->arena;
+    if( !arena )
+    {
+        arena = (descriptor_arena_t *)calloc( 1, sizeof(descriptor_arena_t) );
+        if( !arena )
+            return NULL;
+        descriptor_info->arena = arena;
+    }
+    size = (size + 7) & ~7;
+    descriptor_arena_block_t *block = arena->current;
+    while( !block || block->used + size > block->size )
+    {
+        /* move to the next kept block, or add a new one. */
+        descriptor_arena_block_t *next = block ? block->next : arena->head;
+        if( !next )
+        {
+            uint32_t block_size = (size > DESCRIPTOR_ARENA_BLOCK_SIZE) ? size : DESCRIPTOR_ARENA_BLOCK_SIZE;
+            next = (descriptor_arena_block_t *)malloc( sizeof(descriptor_arena_block_t) + block_size );
+            if( !next )
+                return NULL;
+            next->next = NULL;
+            next->size = block_size;
+            next->used = 0;
+            if( block )
+                block->next = next;
+            else
+                arena->head = next;
+        }
+        block          = next;
+        arena->current = block;
+    }
+    uint8_t *p = (uint8_t *)block->data + block->used;
+    block->used += size;
+    memset( p, 0, size );
+    return p;
+}
+
+#define ALLOCATE_DESCRIPTOR_INFO( name )                                                                            \
+    name##_descriptor_info_t *name = descriptor_info->name;                                                         \
+do {                                                                                                                \
+    if( !name )                                                                                                     \
+    {                                                                                                               \
+        name = (name##_descriptor_info_t *)allocate_descriptor_arena( descriptor_info, sizeof(name##_descriptor_info_t) );  \
+        if( !name )                                                                                                 \
+            return -1;                                                                                              \
+        descriptor_info->name = name;                                                                               \
+    }                                                                                                               \
 } while( 0 )
 #define READ_DESCRIPTOR( name )         \
 static int read_##name##_descriptor( uint8_t *descriptor, mpeg_descriptor_info_t *descriptor_info )
@@ -1170,6 +1223,78 @@ READ_DESCRIPTOR( CA_identifier )
 #undef ALLOCATE_DESCRIPTOR_INFO
 #undef READ_DESCRIPTOR
 
+#define RESET_DESCRIPTOR_INFO( name )       \
+do {                                        \
+    descriptor_info->name = NULL;           \
+} while( 0 )
+static void reset_descriptor_info( mpeg_descriptor_info_t *descriptor_info )
+{
+    descriptor_info->tags_num = 0;
+    descriptor_info->tags[0]  = 0;
+    /* rewind arena. */
+    descriptor_arena_t *arena = (descriptor_arena_t *)descriptor_info->arena;
+    if( arena )
+    {
+        for( descriptor_arena_block_t *block = arena->head; block; block = block->next )
+            block->used = 0;
+        arena->current = arena->head;
+    }
+    /* decoded information is in the arena. */
+    RESET_DESCRIPTOR_INFO( video_stream );
+    RESET_DESCRIPTOR_INFO( audio_stream );
+    RESET_DESCRIPTOR_INFO( hierarchy );
+    RESET_DESCRIPTOR_INFO( registration );
+    RESET_DESCRIPTOR_INFO( data_stream_alignment );
+    RESET_DESCRIPTOR_INFO( target_background_grid );
+    RESET_DESCRIPTOR_INFO( video_window );
+    RESET_DESCRIPTOR_INFO( conditional_access );
+    RESET_DESCRIPTOR_INFO( ISO_639_language );
+    RESET_DESCRIPTOR_INFO( system_clock );
+    RESET_DESCRIPTOR_INFO( multiplex_buffer_utilization );
+    RESET_DESCRIPTOR_INFO( copyright );
+    RESET_DESCRIPTOR_INFO( maximum_bitrate );
+    RESET_DESCRIPTOR_INFO( private_data_indicator );
+    RESET_DESCRIPTOR_INFO( smoothing_buffer );
+    RESET_DESCRIPTOR_INFO( STD );
+    RESET_DESCRIPTOR_INFO( ibp );
+    RESET_DESCRIPTOR_INFO( MPEG4_video );
+    RESET_DESCRIPTOR_INFO( MPEG4_audio );
+    RESET_DESCRIPTOR_INFO( IOD );
+    RESET_DESCRIPTOR_INFO( SL );
+    RESET_DESCRIPTOR_INFO( FMC );
+    RESET_DESCRIPTOR_INFO( External_ES_ID );
+    RESET_DESCRIPTOR_INFO( MuxCode );
+    RESET_DESCRIPTOR_INFO( FmxBufferSize );
+    RESET_DESCRIPTOR_INFO( MultiplexBuffer );
+    RESET_DESCRIPTOR_INFO( content_labeling );
+    RESET_DESCRIPTOR_INFO( metadata_pointer );
+    RESET_DESCRIPTOR_INFO( metadata );
+    RESET_DESCRIPTOR_INFO( metadata_STD );
+    RESET_DESCRIPTOR_INFO( AVC_video );
+    RESET_DESCRIPTOR_INFO( IPMP );
+    RESET_DESCRIPTOR_INFO( AVC_timing_and_HRD );
+    RESET_DESCRIPTOR_INFO( MPEG2_AAC_audio );
+    RESET_DESCRIPTOR_INFO( FlexMuxTiming );
+    RESET_DESCRIPTOR_INFO( MPEG4_text );
+    RESET_DESCRIPTOR_INFO( MPEG4_audio_extension );
+    RESET_DESCRIPTOR_INFO( Auxiliary_video_stream );
+    RESET_DESCRIPTOR_INFO( SVC_extension );
+    RESET_DESCRIPTOR_INFO( MVC_extension );
+    RESET_DESCRIPTOR_INFO( J2K_video );
+    RESET_DESCRIPTOR_INFO( MVC_operation_point );
+    RESET_DESCRIPTOR_INFO( MPEG2_stereoscopic_video_format );
+    RESET_DESCRIPTOR_INFO( Stereoscopic_program_info );
+    RESET_DESCRIPTOR_INFO( Stereoscopic_video_info );
+    RESET_DESCRIPTOR_INFO( Transport_profile );
+    RESET_DESCRIPTOR_INFO( HEVC_video );
+    RESET_DESCRIPTOR_INFO( Extension );
+    /*  */
+    RESET_DESCRIPTOR_INFO( component );
+    RESET_DESCRIPTOR_INFO( stream_identifier );
+    RESET_DESCRIPTOR_INFO( CA_identifier );
+}
+#undef RESET_DESCRIPTOR_INFO
+
 #define EXECUTE_READ_DESCRIPTOR( name )                                 \
 {                                                                       \
     case name##_descriptor :                                            \
@@ -1177,13 +1302,9 @@ READ_DESCRIPTOR( CA_identifier )
             return -1;                                                  \
         break;                                                          \
 }
-extern int mpeg_stream_get_descriptor_info
-(
- /* mpeg_stream_type            stream_type, */
-    uint8_t                    *descriptor,
-    mpeg_descriptor_info_t     *descriptor_info
-)
+static int decode_descriptor_info( mpeg_descriptor_info_t *descriptor_info, uint16_t index )
 {
+    uint8_t *descriptor = descriptor_info->data[index];
     switch( descriptor[0] )
     {
         EXECUTE_READ_DESCRIPTOR( video_stream )
@@ -1241,15 +1362,126 @@ extern int mpeg_stream_get_descriptor_info
         default :
             break;
     }
-    /* add tag list. */
-    descriptor_info->tags[descriptor_info->tags_num] = descriptor[0];
-    descriptor_info->length                          = descriptor[1];
-    ++ descriptor_info->tags_num;
-    descriptor_info->tags[descriptor_info->tags_num] = 0;
     return 0;
 }
 #undef EXECUTE_READ_DESCRIPTOR
 
+#define QUERY_DESCRIPTOR_INFO( name )                   \
+{                                                       \
+    case name##_descriptor :                            \
+        return descriptor_info->name;                   \
+}
+static void *get_decoded_descriptor_info( mpeg_descriptor_info_t *descriptor_info, mpeg_descriptor_tag_type tag )
+{
+    switch( tag )
+    {
+        QUERY_DESCRIPTOR_INFO( video_stream )
+        QUERY_DESCRIPTOR_INFO( audio_stream )
+        QUERY_DESCRIPTOR_INFO( hierarchy )
+        QUERY_DESCRIPTOR_INFO( registration )
+        QUERY_DESCRIPTOR_INFO( data_stream_alignment )
+        QUERY_DESCRIPTOR_INFO( target_background_grid )
+        QUERY_DESCRIPTOR_INFO( video_window )
+        QUERY_DESCRIPTOR_INFO( conditional_access )
+        QUERY_DESCRIPTOR_INFO( ISO_639_language )
+        QUERY_DESCRIPTOR_INFO( system_clock )
+        QUERY_DESCRIPTOR_INFO( multiplex_buffer_utilization )
+        QUERY_DESCRIPTOR_INFO( copyright )
+        QUERY_DESCRIPTOR_INFO( maximum_bitrate )
+        QUERY_DESCRIPTOR_INFO( private_data_indicator )
+        QUERY_DESCRIPTOR_INFO( smoothing_buffer )
+        QUERY_DESCRIPTOR_INFO( STD )
+        QUERY_DESCRIPTOR_INFO( ibp )
+        QUERY_DESCRIPTOR_INFO( MPEG4_video )
+        QUERY_DESCRIPTOR_INFO( MPEG4_audio )
+        QUERY_DESCRIPTOR_INFO( IOD )
+        QUERY_DESCRIPTOR_INFO( SL )
+        QUERY_DESCRIPTOR_INFO( FMC )
+        QUERY_DESCRIPTOR_INFO( External_ES_ID )
+        QUERY_DESCRIPTOR_INFO( MuxCode )
+        QUERY_DESCRIPTOR_INFO( FmxBufferSize )
+        QUERY_DESCRIPTOR_INFO( MultiplexBuffer )
+        QUERY_DESCRIPTOR_INFO( content_labeling )
+        QUERY_DESCRIPTOR_INFO( metadata_pointer )
+        QUERY_DESCRIPTOR_INFO( metadata )
+        QUERY_DESCRIPTOR_INFO( metadata_STD )
+        QUERY_DESCRIPTOR_INFO( AVC_video )
+        QUERY_DESCRIPTOR_INFO( IPMP )
+        QUERY_DESCRIPTOR_INFO( AVC_timing_and_HRD )
+        QUERY_DESCRIPTOR_INFO( MPEG2_AAC_audio )
+        QUERY_DESCRIPTOR_INFO( FlexMuxTiming )
+        QUERY_DESCRIPTOR_INFO( MPEG4_text )
+        QUERY_DESCRIPTOR_INFO( MPEG4_audio_extension )
+        QUERY_DESCRIPTOR_INFO( Auxiliary_video_stream )
+        QUERY_DESCRIPTOR_INFO( SVC_extension )
+        QUERY_DESCRIPTOR_INFO( MVC_extension )
+        QUERY_DESCRIPTOR_INFO( J2K_video )
+        QUERY_DESCRIPTOR_INFO( MVC_operation_point )
+        QUERY_DESCRIPTOR_INFO( MPEG2_stereoscopic_video_format )
+        QUERY_DESCRIPTOR_INFO( Stereoscopic_program_info )
+        QUERY_DESCRIPTOR_INFO( Stereoscopic_video_info )
+        QUERY_DESCRIPTOR_INFO( Transport_profile )
+        QUERY_DESCRIPTOR_INFO( HEVC_video )
+        QUERY_DESCRIPTOR_INFO( Extension )
+        /*  */
+        QUERY_DESCRIPTOR_INFO( component )
+        QUERY_DESCRIPTOR_INFO( stream_identifier )
+        QUERY_DESCRIPTOR_INFO( CA_identifier )
+        default :
+            break;
+    }
+    return NULL;
+}
+#undef QUERY_DESCRIPTOR_INFO
+
+extern int mpeg_stream_get_descriptor_info
+(
+ /* mpeg_stream_type            stream_type, */
+    uint8_t                    *descriptor_data,
+    int                         data_length,
+    mpeg_descriptor_info_t     *descriptor_info
+)
+{
+    reset_descriptor_info( descriptor_info );
+    if( data_length <= 0 )
+        return 0;
+    /* keep a copy of the descriptor loop, each descriptor is decoded on first query. */
+    uint8_t *data = (uint8_t *)allocate_descriptor_arena( descriptor_info, data_length );
+    if( !data )
+        return -1;
+    memcpy( data, descriptor_data, data_length );
+    int read_count = 0;
+    while( read_count + 2 <= data_length && descriptor_info->tags_num < 255 )
+    {
+        uint8_t descriptor_length = data[read_count + 1];
+        if( read_count + 2 + descriptor_length > data_length )
+            break;
+        /* add tag list. */
+        descriptor_info->tags[descriptor_info->tags_num] = data[read_count];
+        descriptor_info->data[descriptor_info->tags_num] = &(data[read_count]);
+        ++ descriptor_info->tags_num;
+        read_count += descriptor_length + 2;
+    }
+    descriptor_info->tags[descriptor_info->tags_num] = 0;
+    return 0;
+}
+
+extern void *mpeg_stream_query_descriptor_info( mpeg_descriptor_info_t *descriptor_info, mpeg_descriptor_tag_type tag )
+{
+    void *decoded = get_decoded_descriptor_info( descriptor_info, tag );
+    if( decoded )
+        return decoded;
+    /* the last one wins when a tag appears more than once. */
+    for( int i = descriptor_info->tags_num - 1; i >= 0; --i )
+        if( descriptor_info->tags[i] == tag )
+        {
+            if( decode_descriptor_info( descriptor_info, i ) )
+                return NULL;
+            return get_decoded_descriptor_info( descriptor_info, tag );
+        }
+    return NULL;
+}
+
 #define PRINT_DESCRIPTOR_INFO( name, ... )          \
 {                                                   \
     case name##_descriptor :                        \
@@ -1259,6 +1491,8 @@ extern int mpeg_stream_get_descriptor_info
 }
 extern void mpeg_stream_debug_descriptor_info( mpeg_descriptor_info_t *descriptor_info, uint16_t descriptor_num )
 {
+    if( decode_descriptor_info( descriptor_info, descriptor_num ) )
+        return;
     switch( descriptor_info->tags[descriptor_num] )
     {
         PRINT_DESCRIPTOR_INFO( video_stream,
@@ -2149,90 +2383,22 @@ extern void mpeg_stream_debug_descriptor_info( mpeg_descriptor_info_t *descripto
 }
 #undef PRINT_DESCRIPTOR_INFO
 
-#define RELEASE_DESCRIPTOR_INFO( name )     \
-do {                                        \
-    if( descriptor_info->name )             \
-    {                                       \
-        free( descriptor_info->name );      \
-        descriptor_info->name = NULL;       \
-    }                                       \
-} while( 0 )
 extern void mpeg_stream_release_descriptor_info( mpeg_descriptor_info_t *descriptor_info )
 {
+    reset_descriptor_info( descriptor_info );
     /* release. */
-    RELEASE_DESCRIPTOR_INFO( video_stream );
-    RELEASE_DESCRIPTOR_INFO( audio_stream );
-    RELEASE_DESCRIPTOR_INFO( hierarchy );
-    RELEASE_DESCRIPTOR_INFO( registration );
-    RELEASE_DESCRIPTOR_INFO( data_stream_alignment );
-    RELEASE_DESCRIPTOR_INFO( target_background_grid );
-    RELEASE_DESCRIPTOR_INFO( video_window );
-    RELEASE_DESCRIPTOR_INFO( conditional_access );
-    RELEASE_DESCRIPTOR_INFO( ISO_639_language );
-    RELEASE_DESCRIPTOR_INFO( system_clock );
-    RELEASE_DESCRIPTOR_INFO( multiplex_buffer_utilization );
-    RELEASE_DESCRIPTOR_INFO( copyright );
-    RELEASE_DESCRIPTOR_INFO( maximum_bitrate );
-    RELEASE_DESCRIPTOR_INFO( private_data_indicator );
-    RELEASE_DESCRIPTOR_INFO( smoothing_buffer );
-    RELEASE_DESCRIPTOR_INFO( STD );
-    RELEASE_DESCRIPTOR_INFO( ibp );
-    RELEASE_DESCRIPTOR_INFO( MPEG4_video );
-    RELEASE_DESCRIPTOR_INFO( MPEG4_audio );
-    RELEASE_DESCRIPTOR_INFO( IOD );
-    RELEASE_DESCRIPTOR_INFO( SL );
-    RELEASE_DESCRIPTOR_INFO( FMC );
-    RELEASE_DESCRIPTOR_INFO( External_ES_ID );
-    RELEASE_DESCRIPTOR_INFO( MuxCode );
-    RELEASE_DESCRIPTOR_INFO( FmxBufferSize );
-    RELEASE_DESCRIPTOR_INFO( MultiplexBuffer );
-    RELEASE_DESCRIPTOR_INFO( content_labeling );
-    RELEASE_DESCRIPTOR_INFO( metadata_pointer );
-    RELEASE_DESCRIPTOR_INFO( metadata );
-    RELEASE_DESCRIPTOR_INFO( metadata_STD );
-    RELEASE_DESCRIPTOR_INFO( AVC_video );
-    RELEASE_DESCRIPTOR_INFO( IPMP );
-    RELEASE_DESCRIPTOR_INFO( AVC_timing_and_HRD );
-    RELEASE_DESCRIPTOR_INFO( MPEG2_AAC_audio );
-    RELEASE_DESCRIPTOR_INFO( FlexMuxTiming );
-    RELEASE_DESCRIPTOR_INFO( MPEG4_text );
-    RELEASE_DESCRIPTOR_INFO( MPEG4_audio_extension );
-    RELEASE_DESCRIPTOR_INFO( Auxiliary_video_stream );
-    RELEASE_DESCRIPTOR_INFO( SVC_extension );
-    RELEASE_DESCRIPTOR_INFO( MVC_extension );
-    RELEASE_DESCRIPTOR_INFO( J2K_video );
-    RELEASE_DESCRIPTOR_INFO( MVC_operation_point );
-    RELEASE_DESCRIPTOR_INFO( MPEG2_stereoscopic_video_format );
-    RELEASE_DESCRIPTOR_INFO( Stereoscopic_program_info );
-    RELEASE_DESCRIPTOR_INFO( Stereoscopic_video_info );
-    RELEASE_DESCRIPTOR_INFO( Transport_profile );
-    RELEASE_DESCRIPTOR_INFO( HEVC_video );
-    RELEASE_DESCRIPTOR_INFO( Extension );
-    /*  */
-    RELEASE_DESCRIPTOR_INFO( component );
-    RELEASE_DESCRIPTOR_INFO( stream_identifier );
-    RELEASE_DESCRIPTOR_INFO( CA_identifier );
-}
-#undef RELEASE_DESCRIPTOR_INFO
-
-extern void mpeg_stream_init_descriptor_info( mpeg_descriptor_info_t *descriptor_info )
-{
-    descriptor_info->tags_num = 0;
-    if( descriptor_info->conditional_access )
-    {
-        descriptor_info->conditional_access->CA_system_ID = 0;
-        descriptor_info->conditional_access->CA_PID       = 0;
-    }
-    if( descriptor_info->registration )
+    descriptor_arena_t *arena = (descriptor_arena_t *)descriptor_info->arena;
+    if( !arena )
+        return;
+    descriptor_arena_block_t *block = arena->head;
+    while( block )
     {
-        descriptor_info->registration->format_identifier                     = 0;
-        descriptor_info->registration->additional_identification_info_length = 0;
+        descriptor_arena_block_t *next = block->next;
+        free( block );
+        block = next;
     }
-    /*  */
-    if( descriptor_info->component )
-        descriptor_info->component->component_tag = 0;
-    if( descriptor_info->stream_identifier )
-        descriptor_info->stream_identifier->component_tag = 0;
+    free( arena );
+    descriptor_info->arena = NULL;
 }
 
 #define FI_U32( a, b, c, d )    ( (uint32_t)a << 24 | (uint32_t)b << 16 | (uint32_t)c << 8 | (uint32_t)d )
@@ -2244,9 +2410,9 @@ extern void mpeg_stream_init_descriptor_info( mpeg_descriptor_info_t *descriptor
 
 extern mpeg_stream_type mpeg_stream_get_registration_stream_type( mpeg_descriptor_info_t *descriptor_info )
 {
-    if( !descriptor_info->registration )
+    registration_descriptor_info_t *registration = MPEG_DESCRIPTOR_INFO( descriptor_info, registration );
+    if( !registration )
         return STREAM_INVALID;
-    registration_descriptor_info_t *registration = descriptor_info->registration;
     switch( registration->format_identifier )
     {
         FI_CHECK( FI_U32( 'A', 'C', '-', '3' ), STREAM_AUDIO_AC3 )
@@ -2269,7 +2435,9 @@ extern mpeg_stream_type mpeg_stream_get_registration_stream_type( mpeg_descripto
 
 static mpeg_stream_group_type judge_group_type_from_registration_descriptor( mpeg_descriptor_info_t *descriptor_info )
 {
-    registration_descriptor_info_t *registration = descriptor_info->registration;
+    registration_descriptor_info_t *registration = MPEG_DESCRIPTOR_INFO( descriptor_info, registration );
+    if( !registration )
+        return STREAM_IS_UNKNOWN;
     switch( registration->format_identifier )
     {
         FI_CHECK( FI_U32( 'A', 'C', '-', '3' ), STREAM_IS_DOLBY_AUDIO )
@@ -2381,7 +2549,8 @@ extern mpeg_stream_group_type mpeg_stream_judge_type
                     stream_judge = judge_group_type_from_registration_descriptor( descriptor_info );
                 else if( descriptor_info->tags[i] == stream_identifier_descriptor )
                 {
-                    uint8_t component_tag = descriptor_info->stream_identifier->component_tag;
+                    stream_identifier_descriptor_info_t *stream_identifier = MPEG_DESCRIPTOR_INFO( descriptor_info, stream_identifier );
+                    uint8_t component_tag = stream_identifier ? stream_identifier->component_tag : 0;
                     if( 0x30 <= component_tag && component_tag <= 0x37 )
                         stream_judge = STREAM_IS_ARIB_CAPTION;          /* 0x30: default, 0x31-0x37: non-default */
                     else if( 0x38 <= component_tag && component_tag <= 0x3F )
@@ -2403,6 +2572,24 @@ extern mpeg_stream_group_type mpeg_stream_judge_type
 
 typedef int (*header_check_func)( uint8_t *header, mpeg_stream_raw_info_t *stream_raw_info );
 
+/* [version_id][layer] : row of mpa_bitrate. */
+static const uint8_t mpa_bitrate_row[4][4] =
+    {
+        {  0, 4, 4, 3 },                        /* MPEG-2.5     */
+        {  0, 0, 0, 0 },                        /* reserved     */
+        {  0, 4, 4, 3 },                        /* MPEG-2       */
+        {  0, 2, 1, 0 }                         /* MPEG-1       */
+    };
+
+static const uint16_t mpa_bitrate[5][15] =
+    {
+        {   0,   32,  64,  96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448 },
+        {   0,   32,  48,  56,  64,  80,  96, 112, 128, 160, 192, 224, 256, 320, 384 },
+        {   0,   32,  40,  48,  56,  64,  80,  96, 112, 128, 160, 192, 224, 256, 320 },
+        {   0,   32,  48,  56,  64,  80,  96, 112, 128, 144, 160, 176, 192, 224, 256 },
+        {   0,    8,  16,  24,  32,  40,  48,  56,  64,  80,  96, 112, 128, 144, 160 }
+    };
+
 static int mpa_header_check( uint8_t *header, mpeg_stream_raw_info_t *stream_raw_info )
 {
     if( header[0] != 0xFF || (header[1] & 0xE0) != 0xE0 )
@@ -2440,22 +2627,7 @@ static int mpa_header_check( uint8_t *header, mpeg_stream_raw_info_t *stream_raw
         DUAL_CHANNEL   = 0x02,
         SINGLE_CHANNEL = 0x03
     };
-    static const uint8_t version_layer_matrix[3][3] =
-        {
-            {  4, 4, 3 },
-            {  4, 4, 3 },
-            {  2, 1, 0 }
-        };
-    static const uint16_t bitrate_matrix[5][15] =
-        {
-            {   0,   32,  64,  96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448 },
-            {   0,   32,  48,  56,  64,  80,  96, 112, 128, 160, 192, 224, 256, 320, 384 },
-            {   0,   32,  40,  48,  56,  64,  80,  96, 112, 128, 160, 192, 224, 256, 320 },
-            {   0,   32,  48,  56,  64,  80,  96, 112, 128, 144, 160, 176, 192, 224, 256 },
-            {   0,    8,  16,  24,  32,  40,  48,  56,  64,  80,  96, 112, 128, 144, 160 }
-        };
-    int      vl_index = version_layer_matrix[version_id - 1][layer - 1];
-    uint16_t bitrate  = bitrate_matrix[vl_index][bitrate_index];
+    uint16_t bitrate  = mpa_bitrate[mpa_bitrate_row[version_id][layer]][bitrate_index];
     static const uint16_t ng_matrix[2][4] =
         {
             {  32,  48,  56,  80 },             /* stereo / joint stereo / dual channel */
@@ -2798,6 +2970,184 @@ static int dts_header_check( uint8_t *header, mpeg_stream_raw_info_t *stream_raw
     return 0;
 }
 
+static uint32_t mpa_frame_length( uint8_t *header )
+{
+    /* [version_id][layer] : bytes per frame at 1bps and 1Hz. */
+    static const uint8_t frame_coefficient[4][4] =
+        {
+            {  0,  72, 144, 12 },
+            {  0,   0,   0,  0 },
+            {  0,  72, 144, 12 },
+            {  0, 144, 144, 12 }
+        };
+    static const uint32_t sampling_frequency[4][3] =
+        {
+            { 11025, 12000,  8000 },
+            {     0,     0,     0 },
+            { 22050, 24000, 16000 },
+            { 44100, 48000, 32000 }
+        };
+    int      version_id = (header[1] & 0x18) >> 3;
+    int      layer      = (header[1] & 0x06) >> 1;
+    int      padding    = (header[2] & 0x02) >> 1;
+    uint32_t bitrate    = mpa_bitrate[mpa_bitrate_row[version_id][layer]][header[2] >> 4] * 1000;
+    uint32_t frequency  = sampling_frequency[version_id][(header[2] & 0x0C) >> 2];
+    if( !bitrate || !frequency )                /* free format                  */
+        return 0;
+    uint32_t slot_size  = (layer == 0x03) ? 4 : 1;
+    return (frame_coefficient[version_id][layer] * bitrate / frequency + padding) * slot_size;
+}
+
+static uint32_t aac_frame_length( uint8_t *header )
+{
+    return ((header[3] & 0x03) << 11) | (header[4] << 3) | (header[5] >> 5);
+}
+
+static uint32_t ac3_frame_length( uint8_t *header )
+{
+    /* [frame_size_code][sample_rate_code] : 16bit words per syncframe. */
+    static const uint16_t frame_size[38][3] =
+        {
+        {   64,   69,   96 }, {   64,   70,   96 },
+        {   80,   87,  120 }, {   80,   88,  120 },
+        {   96,  104,  144 }, {   96,  105,  144 },
+        {  112,  121,  168 }, {  112,  122,  168 },
+        {  128,  139,  192 }, {  128,  140,  192 },
+        {  160,  174,  240 }, {  160,  175,  240 },
+        {  192,  208,  288 }, {  192,  209,  288 },
+        {  224,  243,  336 }, {  224,  244,  336 },
+        {  256,  278,  384 }, {  256,  279,  384 },
+        {  320,  348,  480 }, {  320,  349,  480 },
+        {  384,  417,  576 }, {  384,  418,  576 },
+        {  448,  487,  672 }, {  448,  488,  672 },
+        {  512,  557,  768 }, {  512,  558,  768 },
+        {  640,  696,  960 }, {  640,  697,  960 },
+        {  768,  835, 1152 }, {  768,  836, 1152 },
+        {  896,  975, 1344 }, {  896,  976, 1344 },
+        { 1024, 1114, 1536 }, { 1024, 1115, 1536 },
+        { 1152, 1253, 1728 }, { 1152, 1254, 1728 },
+        { 1280, 1393, 1920 }, { 1280, 1394, 1920 }
+        };
+    return frame_size[header[4] & 0x3F][header[4] >> 6] * 2;
+}
+
+static uint32_t eac3_frame_length( uint8_t *header )
+{
+    return ((((header[2] & 0x07) << 8) | header[3]) + 1) * 2;
+}
+
+static uint32_t dts_frame_length( uint8_t *header )
+{
+    return (((header[5] & 0x03) << 12) | (header[6] << 4) | (header[7] >> 4)) + 1;
+}
+
+typedef struct {
+    uint8_t             sync_byte;
+    uint8_t             sync_mask;
+    uint8_t             sync_value;
+    uint8_t             check_size;
+    header_check_func   check;
+    uint32_t          (*frame_length)( uint8_t *header );
+} audio_sync_info_t;
+
+static const audio_sync_info_t *get_audio_sync_info( mpeg_stream_type stream_type, mpeg_stream_group_type stream_judge )
+{
+    static const audio_sync_info_t sync_info[5] =
+        {
+            { 0xFF, 0xE0, 0xE0, STREAM_MPA_HEADER_CHECK_SIZE , mpa_header_check , mpa_frame_length  },
+            { 0xFF, 0xF6, 0xF0, STREAM_AAC_HEADER_CHECK_SIZE , aac_header_check , aac_frame_length  },
+            { 0x0B, 0xFF, 0x77, STREAM_AC3_HEADER_CHECK_SIZE , ac3_header_check , ac3_frame_length  },
+            { 0x0B, 0xFF, 0x77, STREAM_EAC3_HEADER_CHECK_SIZE, eac3_header_check, eac3_frame_length },
+            { 0x7F, 0xFF, 0xFE, STREAM_DTS_HEADER_CHECK_SIZE , dts_header_check , dts_frame_length  }
+        };
+    switch( stream_judge )
+    {
+        case STREAM_IS_MPEG1_AUDIO :
+        case STREAM_IS_MPEG2_AUDIO :
+            return &(sync_info[0]);
+        case STREAM_IS_AAC_AUDIO :
+            return &(sync_info[1]);
+        case STREAM_IS_DOLBY_AUDIO :
+            return &(sync_info[(stream_type == STREAM_AUDIO_AC3) ? 2 : 3]);
+        case STREAM_IS_DTS_AUDIO :
+            return &(sync_info[4]);
+        default :
+            break;
+    }
+    return NULL;
+}
+
+static inline int check_audio_sync_word( const audio_sync_info_t *sync, uint8_t *p, uint8_t *end )
+{
+    if( p >= end || p[0] != sync->sync_byte )
+        return 0;
+    return (p + 1 == end) || (p[1] & sync->sync_mask) == sync->sync_value;
+}
+
+static uint8_t *search_audio_header( const audio_sync_info_t *sync, uint8_t *p, uint8_t *end, mpeg_stream_raw_info_t *stream_raw_info )
+{
+    while( end - p >= sync->check_size )
+    {
+        /* search the sync byte with memchr(), the C library vectorizes it. */
+        if( p[0] != sync->sync_byte )
+        {
+            p = memchr( p, sync->sync_byte, end - p - sync->check_size + 1 );
+            if( !p )
+                break;
+        }
+        /* check the whole header only after the sync word. */
+        if( (p[1] & sync->sync_mask) == sync->sync_value && !sync->check( p, stream_raw_info ) )
+            return p;
+        ++p;
+    }
+    return NULL;
+}
+
+/* split a raw audio sample into frames, for mpeg_api_get_audio_frames(). */
+extern uint32_t mpeg_stream_sync_audio_frames
+(
+    mpeg_stream_type            stream_type,
+    mpeg_stream_group_type      stream_judge,
+    uint8_t                    *buffer,
+    uint32_t                    buffer_size,
+    audio_frame_t              *frames,
+    uint32_t                    frame_num_max
+)
+{
+    if( !buffer || !buffer_size || !frames || !frame_num_max )
+        return 0;
+    if( stream_judge == STREAM_IS_PCM_AUDIO )
+    {
+        /* raw LPCM data has no frame header. */
+        frames[0].offset = 0;
+        frames[0].size   = buffer_size;
+        return 1;
+    }
+    const audio_sync_info_t *sync = get_audio_sync_info( stream_type, stream_judge );
+    if( !sync )
+        return 0;
+    uint32_t  frame_num = 0;
+    uint8_t  *p         = buffer;
+    uint8_t  *end       = buffer + buffer_size;
+    while( frame_num < frame_num_max && (p = search_audio_header( sync, p, end, NULL )) )
+    {
+        uint32_t frame_length = sync->frame_length( p );
+        /* accept a frame when the next sync word follows it, or it ends the buffer. */
+        if( !frame_length || frame_length > (uint32_t)(end - p)
+         || (p + frame_length < end && !check_audio_sync_word( sync, p + frame_length, end )) )
+        {
+            ++p;
+            continue;
+        }
+        frames[frame_num].offset = p - buffer;
+        frames[frame_num].size   = frame_length;
+        ++frame_num;
+        p += frame_length;
+    }
+    mapi_log( LOG_LV4, "[debug] %s()  buffer_size:%u  frame_num:%u\n", __func__, buffer_size, frame_num );
+    return frame_num;
+}
+
 extern int32_t mpeg_stream_check_header
 (
     mpeg_stream_type            stream_type,
@@ -2819,25 +3169,20 @@ extern int32_t mpeg_stream_check_header
         case STREAM_IS_MPEG1_AUDIO :
         case STREAM_IS_MPEG2_AUDIO :
         case STREAM_IS_AAC_AUDIO :
+        case STREAM_IS_DOLBY_AUDIO :
+        case STREAM_IS_DTS_AUDIO :
             {
-                static const struct {
-                    header_check_func   func;
-                    int                 size;
-                } header_check[2] =
-                    {
-                        { mpa_header_check, STREAM_MPA_HEADER_CHECK_SIZE },
-                        { aac_header_check, STREAM_AAC_HEADER_CHECK_SIZE }
-                    };
-                int index   = (stream_judge == STREAM_IS_AAC_AUDIO);
-                int idx_max = buffer_size - header_check[index].size;
-                for( int i = 0; i <= idx_max; ++i )
-                {
-                    if( header_check[index].func( &(buffer[i]), stream_raw_info ) )
-                        continue;
+                /* search with the sync table of the frame scanner. */
+                const audio_sync_info_t *sync = get_audio_sync_info( stream_type, stream_judge );
+                uint8_t *end = buffer + buffer_size;
+                /* the Dolby and DTS headers are checked at the start only. */
+                if( (stream_judge == STREAM_IS_DOLBY_AUDIO || stream_judge == STREAM_IS_DTS_AUDIO)
+                 && buffer_size > sync->check_size )
+                    end = buffer + sync->check_size;
+                uint8_t *p = search_audio_header( sync, buffer, end, stream_raw_info );
+                if( p )
                     /* setup. */
-                    header_offset = i;
-                    break;
-                }
+                    header_offset = p - buffer;
             }
             break;
         case STREAM_IS_PCM_AUDIO :
@@ -2854,33 +3199,6 @@ extern int32_t mpeg_stream_check_header
                 }
             }
             break;
-        case STREAM_IS_DOLBY_AUDIO :
-            {
-                static const struct {
-                    header_check_func   func;
-                    int                 size;
-                } header_check[2] =
-                    {
-                        { ac3_header_check , STREAM_AC3_HEADER_CHECK_SIZE  },
-                        { eac3_header_check, STREAM_EAC3_HEADER_CHECK_SIZE }
-                    };
-                int index = !(stream_type == STREAM_AUDIO_AC3);
-                if( (int)buffer_size >= header_check[index].size )
-                {
-                    if( !header_check[index].func( buffer, stream_raw_info ) )
-                        /* setup. */
-                        header_offset = 0;
-                }
-            }
-            break;
-        case STREAM_IS_DTS_AUDIO :
-            if( buffer_size >= STREAM_DTS_HEADER_CHECK_SIZE )
-            {
-                if( !dts_header_check( buffer, stream_raw_info ) )
-                    /* setup. */
-                    header_offset = 0;
-            }
-            break;
         default :
             header_offset = 0;
             break;
@@ -616,8 +616,9 @@ typedef struct {
 #define DESCRIPTOR_INFO_PTR( name )     DESCRIPTOR_INFO( name )   * name;
 typedef struct {
     mpeg_descriptor_tag_type                    tags[256];
+    uint8_t                                    *data[256];
     uint8_t                                     tags_num;
-    uint8_t                                     length;
+    void                                       *arena;
     DESCRIPTOR_INFO_PTR( video_stream )
     DESCRIPTOR_INFO_PTR( audio_stream )
     DESCRIPTOR_INFO_PTR( hierarchy )
@@ -709,16 +710,20 @@ extern mpeg_pes_stream_id_type mpeg_pes_get_steam_id_type( mpeg_stream_group_typ
 extern int mpeg_stream_get_descriptor_info
 (
  /* mpeg_stream_type            stream_type, */
-    uint8_t                    *descriptor,
+    uint8_t                    *descriptor_data,
+    int                         data_length,
     mpeg_descriptor_info_t     *descriptor_info
 );
 
+extern void *mpeg_stream_query_descriptor_info( mpeg_descriptor_info_t *descriptor_info, mpeg_descriptor_tag_type tag );
+
+#define MPEG_DESCRIPTOR_INFO( descriptor_info, name )   \
+    ((name##_descriptor_info_t *)mpeg_stream_query_descriptor_info( descriptor_info, name##_descriptor ))
+
 extern void mpeg_stream_debug_descriptor_info( mpeg_descriptor_info_t *descriptor_info, uint16_t descriptor_num );
 
 extern void mpeg_stream_release_descriptor_info( mpeg_descriptor_info_t *descriptor_info );
 
-extern void mpeg_stream_init_descriptor_info( mpeg_descriptor_info_t *descriptor_info );
-
 extern mpeg_stream_type mpeg_stream_get_registration_stream_type( mpeg_descriptor_info_t *descriptor_info );
 
 extern mpeg_stream_group_type mpeg_stream_judge_type
@@ -739,6 +744,16 @@ extern int32_t mpeg_stream_check_header
     int32_t                    *data_offset
 );
 
+extern uint32_t mpeg_stream_sync_audio_frames
+(
+    mpeg_stream_type            stream_type,
+    mpeg_stream_group_type      stream_judge,
+    uint8_t                    *buffer,
+    uint32_t                    buffer_size,
+    audio_frame_t              *frames,
+    uint32_t                    frame_num_max
+);
+
 extern int mpeg_stream_check_header_skip( mpeg_stream_group_type stream_judge );
 
 extern uint32_t mpeg_stream_get_header_check_size( mpeg_stream_type stream_type, mpeg_stream_group_type stream_judge );
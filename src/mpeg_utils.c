@@ -33,6 +33,7 @@
 #include <string.h>
 #include <inttypes.h>
 
+#include "mpeg_stream.h"
 #include "mpeg_parser.h"
 #include "mpeg_utils.h"
 #include "thread_utils.h"
@@ -55,6 +56,7 @@ typedef struct {
     int32_t                 raw_data_read_offset;
     uint32_t                au_size;
     uint16_t                program_id;
+    int64_t                 arrival_time;
     /* video. */
     int64_t                 gop_number;
     timestamp_t             timestamp;
@@ -91,12 +93,83 @@ typedef struct {
     int8_t                  audio_stream_num;
 } sample_list_t;
 
+#define SAMPLE_BUFFER_CLASS_SHIFT_MIN       (12)            /* 4 KiB */
+#define SAMPLE_BUFFER_CLASS_NUM             (13)            /* 4 KiB - 16 MiB */
+#define SAMPLE_BUFFER_POOL_DEPTH            (8)
+#define SAMPLE_BUFFER_HEADER_SIZE           ((sizeof(sample_buffer_t) + 15) & ~15)
+
+typedef struct sample_buffer_s sample_buffer_t;
+struct sample_buffer_s {
+    sample_buffer_t        *next;
+    uint32_t                capacity;
+    int32_t                 size_class;
+};
+
+typedef struct {
+    void                   *mutex;
+    sample_buffer_t        *free_list[SAMPLE_BUFFER_CLASS_NUM];
+    uint32_t                free_num[SAMPLE_BUFFER_CLASS_NUM];
+} sample_buffer_pool_t;
+
+#define CURSOR_LIST_UNIT_NUM                (8)
+
+typedef struct {
+    void                   *mutex;
+    void                  **cursor;
+    uint32_t                cursor_num;
+    uint32_t                list_size;
+} cursor_pool_t;
+
+#define PREFETCH_SAMPLE_NUM_MAX             (64)
+
+typedef enum {
+    PREFETCH_SLOT_EMPTY   = 0,
+    PREFETCH_SLOT_LOADING = 1,
+    PREFETCH_SLOT_READY   = 2
+} prefetch_slot_status;
+
+typedef struct {
+    prefetch_slot_status    status;
+    uint32_t                sample_number;
+    uint8_t                *buffer;
+    uint32_t                read_size;
+} prefetch_slot_t;
+
+typedef struct {
+    void                   *thread;
+    void                   *mutex;
+    void                   *cond;
+    void                   *cursor;
+    int                     quit;
+    mpeg_sample_type        sample_type;
+    uint8_t                 stream_number;
+    get_sample_data_mode    get_mode;
+    uint32_t                sample_num;
+    int64_t                 next_number;
+    uint32_t                slot_num;
+    prefetch_slot_t         slot[PREFETCH_SAMPLE_NUM_MAX];
+} prefetch_ctx_t;
+
+typedef struct {
+    uint32_t                active;
+    uint16_t                stream_num;
+    int64_t                 position_sum;
+} parse_progress_t;
+
 typedef struct {
     mpeg_parser_t          *parser;
     void                   *parser_info;
     sample_list_t           sample_list;
     int64_t                 wrap_around_check_v;
     int64_t                 file_size;
+    sample_buffer_pool_t    buffer_pool;
+    cursor_pool_t           cursor_pool;
+    prefetch_ctx_t         *prefetch;
+    mapi_log_sink_t        *log_sink;
+    mapi_log_sink_t       **closed_sink;
+    uint32_t                closed_sink_num;
+    mapi_stats_set_t       *stats;
+    parse_progress_t        progress;
 } mpeg_api_info_t;
 
 #define DEFAULT_GOP_SAMPLE_NUM              (40000)
@@ -105,29 +178,287 @@ typedef struct {
 
 #define TIMESTAMP_WRAP_AROUND_CHECK_VALUE       (0x0FFFFFFFFLL)
 
+#define PARSE_RANGE_SIZE_MIN                (64 * 1024 * 1024)
+#define PARSE_RANGE_NUM_MAX                 (64)
+#define PARSE_RANGE_SEEK_MARGIN             (1024 * 1024)
+#define PARSE_RANGE_CHECK_SAMPLE_NUM        (16)
+#define PARSE_RANGE_LIST_UNIT_NUM_MIN       (1024)
+#define PARSE_PROGRESS_STEP_SIZE            (1024 * 1024)
+
+typedef struct {
+    gop_list_data_t        *gop_list;
+    int64_t                 gop_num;
+    int64_t                 gop_list_size;
+    sample_list_data_t     *list;
+    int64_t                 list_num;
+    int64_t                 list_size;
+    sample_list_data_t     *check_list;         /* samples parsed beyond the end of the range. */
+    int64_t                 check_num;
+    int64_t                 check_size;
+} parse_range_t;
+
 typedef struct {
     mpeg_api_info_t  *api_info;
+    void             *parser_info;
     mpeg_sample_type  sample_type;
     uint8_t           stream_number;
-    void             *list_data;
-    uint16_t          thread_index;
-    uint16_t          thread_num;
-    int64_t          *progress;
+    parse_range_t    *range;
+    uint16_t          range_index;
+    uint16_t          range_num;
+    int64_t           start_position;
+    int64_t           end_position;
+    int64_t           progress_size;
 } parse_param_t;
 
-static void parse_progress( parse_param_t *param, int64_t position )
+static mpeg_api_info_t *get_api_info( void *ih )
+{
+    mpeg_api_info_t *info = (mpeg_api_info_t *)ih;
+    /* the logs and the counters of this thread go to the handle. */
+    mapi_log_sink_bind( info ? __atomic_load_n( &(info->log_sink), __ATOMIC_ACQUIRE ) : NULL );
+    mapi_stats_bind( info ? info->stats : NULL );
+    return info;
+}
+
+static int get_sample_buffer_class( uint32_t size )
+{
+    int size_class = 0;
+    while( size > (1U << (SAMPLE_BUFFER_CLASS_SHIFT_MIN + size_class)) )
+        if( ++size_class >= SAMPLE_BUFFER_CLASS_NUM )
+            return -1;
+    return size_class;
+}
+
+static uint8_t *acquire_sample_buffer( sample_buffer_pool_t *pool, uint32_t size )
+{
+    int size_class = get_sample_buffer_class( size );
+    sample_buffer_t *buffer = NULL;
+    if( size_class >= 0 )
+    {
+        thread_mutex_lock( pool->mutex );
+        buffer = pool->free_list[size_class];
+        if( buffer )
+        {
+            pool->free_list[size_class] = buffer->next;
+            --pool->free_num[size_class];
+        }
+        thread_mutex_unlock( pool->mutex );
+        if( buffer )
+            return (uint8_t *)buffer + SAMPLE_BUFFER_HEADER_SIZE;
+    }
+    /* allocate new buffer. */
+    uint32_t capacity = (size_class >= 0) ? (1U << (SAMPLE_BUFFER_CLASS_SHIFT_MIN + size_class)) : size;
+    buffer = (sample_buffer_t *)malloc( SAMPLE_BUFFER_HEADER_SIZE + capacity );
+    if( !buffer )
+        return NULL;
+    mapi_stats_add( MAPI_STATS_SAMPLE_ALLOCS, 1 );
+    buffer->next       = NULL;
+    buffer->capacity   = capacity;
+    buffer->size_class = size_class;
+    mapi_log( LOG_LV3, "[debug] sample buffer allocate  class:%d  capacity:%u\n", size_class, capacity );
+    return (uint8_t *)buffer + SAMPLE_BUFFER_HEADER_SIZE;
+}
+
+static void recycle_sample_buffer( sample_buffer_pool_t *pool, uint8_t *data )
+{
+    sample_buffer_t *buffer = (sample_buffer_t *)(data - SAMPLE_BUFFER_HEADER_SIZE);
+    int size_class = buffer->size_class;
+    if( size_class >= 0 )
+    {
+        thread_mutex_lock( pool->mutex );
+        int pooled = (pool->free_num[size_class] < SAMPLE_BUFFER_POOL_DEPTH);
+        if( pooled )
+        {
+            buffer->next = pool->free_list[size_class];
+            pool->free_list[size_class] = buffer;
+            ++pool->free_num[size_class];
+        }
+        thread_mutex_unlock( pool->mutex );
+        if( pooled )
+            return;
+    }
+    free( buffer );
+}
+
+static void release_sample_buffer_pool( sample_buffer_pool_t *pool )
+{
+    for( int i = 0; i < SAMPLE_BUFFER_CLASS_NUM; ++i )
+        while( pool->free_list[i] )
+        {
+            sample_buffer_t *next = pool->free_list[i]->next;
+            free( pool->free_list[i] );
+            pool->free_list[i] = next;
+        }
+    if( pool->mutex )
+        thread_mutex_release( pool->mutex );
+    memset( pool, 0, sizeof(sample_buffer_pool_t) );
+}
+
+static void *acquire_sample_cursor( mpeg_api_info_t *info )
+{
+    cursor_pool_t *pool = &(info->cursor_pool);
+    if( !pool->mutex )
+        return info->parser_info;
+    void *cursor = NULL;
+    thread_mutex_lock( pool->mutex );
+    if( pool->cursor_num )
+        cursor = pool->cursor[--pool->cursor_num];
+    thread_mutex_unlock( pool->mutex );
+    if( !cursor )
+        cursor = info->parser->create_cursor( info->parser_info );
+    return cursor;
+}
+
+static void recycle_sample_cursor( mpeg_api_info_t *info, void *cursor )
+{
+    cursor_pool_t *pool = &(info->cursor_pool);
+    if( !cursor || cursor == info->parser_info )
+        return;
+    thread_mutex_lock( pool->mutex );
+    if( pool->cursor_num == pool->list_size )
+    {
+        uint32_t  list_size = pool->list_size + CURSOR_LIST_UNIT_NUM;
+        void    **list      = (void **)realloc( pool->cursor, sizeof(void *) * list_size );
+        if( list )
+        {
+            pool->cursor    = list;
+            pool->list_size = list_size;
+        }
+    }
+    int pooled = (pool->cursor_num < pool->list_size);
+    if( pooled )
+        pool->cursor[pool->cursor_num++] = cursor;
+    thread_mutex_unlock( pool->mutex );
+    if( !pooled )
+        info->parser->release_cursor( cursor );
+}
+
+static void release_cursor_pool( mpeg_api_info_t *info )
+{
+    cursor_pool_t *pool = &(info->cursor_pool);
+    for( uint32_t i = 0; i < pool->cursor_num; ++i )
+        info->parser->release_cursor( pool->cursor[i] );
+    if( pool->cursor )
+        free( pool->cursor );
+    if( pool->mutex )
+        thread_mutex_release( pool->mutex );
+    memset( pool, 0, sizeof(cursor_pool_t) );
+}
+
+static void parse_progress( parse_param_t *param, int64_t position, int flush )
+{
+    /* only add to the shared counter at every step, the pollers render it. */
+    int64_t parsed_size = position - param->start_position;
+    if( parsed_size < 0 )
+        parsed_size = 0;
+    int64_t step_size = parsed_size - param->progress_size;
+    if( step_size >= PARSE_PROGRESS_STEP_SIZE || (flush && step_size) )
+    {
+        __atomic_add_fetch( &(param->api_info->progress.position_sum), step_size, __ATOMIC_RELAXED );
+        param->progress_size = parsed_size;
+    }
+}
+
+static int get_parse_sample
+(
+    mpeg_parser_t              *parser,
+    void                       *parser_info,
+    mpeg_sample_type            sample_type,
+    uint8_t                     stream_number,
+    sample_list_data_t         *sample,
+    gop_list_data_t            *gop
+)
 {
-    if( param )
+    parser->seek_next_sample_position( parser_info, sample_type, stream_number );
+    if( sample_type == SAMPLE_TYPE_VIDEO )
     {
-        param->progress[param->thread_index] = position;
-        uint64_t average = 0;
-        for( uint16_t i = 0; i < param->thread_num; ++i )
-            average += param->progress[i];
-        average /= param->thread_num;
-        mapi_log( LOG_LV_PROGRESS, "[parse_stream] %14" PRIu64 "/%-14" PRIu64 "\r", average, param->api_info->file_size );
+        video_sample_info_t video_sample_info;
+        if( parser->get_video_info( parser_info, stream_number, &video_sample_info ) )
+            return -1;
+        sample->file_position        = video_sample_info.file_position;
+        sample->sample_size          = video_sample_info.sample_size;
+        sample->raw_data_size        = video_sample_info.raw_data_size;
+        sample->raw_data_read_offset = video_sample_info.raw_data_read_offset;
+        sample->au_size              = video_sample_info.au_size;
+        sample->program_id           = video_sample_info.program_id;
+        sample->arrival_time         = video_sample_info.arrival_time;
+        sample->gop_number           = video_sample_info.gop_number;
+        sample->timestamp.pts        = video_sample_info.pts;
+        sample->timestamp.dts        = video_sample_info.dts;
+        sample->picture_coding_type  = video_sample_info.picture_coding_type;
+        sample->temporal_reference   = video_sample_info.temporal_reference;
+        sample->progressive_frame    = video_sample_info.progressive_frame;
+        sample->picture_structure    = video_sample_info.picture_structure;
+        sample->repeat_first_field   = video_sample_info.repeat_first_field;
+        sample->top_field_first      = video_sample_info.top_field_first;
+        sample->sampling_frequency   = 0;
+        sample->bitrate              = 0;
+        sample->channel              = 0;
+        sample->layer                = 0;
+        sample->bit_depth            = 0;
+        gop->progressive_sequence    = video_sample_info.progressive_sequence;
+        gop->closed_gop              = video_sample_info.closed_gop;
     }
     else
-        mapi_log( LOG_LV_PROGRESS, "[parse_stream] %14" PRIu64 "/%-14" PRIu64 "\n", position, position );
+    {
+        audio_sample_info_t audio_sample_info;
+        if( parser->get_audio_info( parser_info, stream_number, &audio_sample_info ) )
+            return -1;
+        sample->file_position        = audio_sample_info.file_position;
+        sample->sample_size          = audio_sample_info.sample_size;
+        sample->raw_data_size        = audio_sample_info.raw_data_size;
+        sample->raw_data_read_offset = audio_sample_info.raw_data_read_offset;
+        sample->au_size              = audio_sample_info.au_size;
+        sample->program_id           = audio_sample_info.program_id;
+        sample->arrival_time         = audio_sample_info.arrival_time;
+        sample->gop_number           = 0;
+        sample->timestamp.pts        = audio_sample_info.pts;
+        sample->timestamp.dts        = audio_sample_info.dts;
+        sample->picture_coding_type  = 0;
+        sample->temporal_reference   = 0;
+        sample->picture_structure    = 0;
+        sample->progressive_frame    = 0;
+        sample->repeat_first_field   = 0;
+        sample->top_field_first      = 0;
+        sample->sampling_frequency   = audio_sample_info.sampling_frequency;
+        sample->bitrate              = audio_sample_info.bitrate;
+        sample->channel              = audio_sample_info.channel;
+        sample->layer                = audio_sample_info.layer;
+        sample->bit_depth            = audio_sample_info.bit_depth;
+        gop->progressive_sequence    = 0;
+        gop->closed_gop              = 0;
+    }
+    return 0;
+}
+
+static sample_list_data_t *get_parse_range_entry
+(
+    sample_list_data_t        **list,
+    int64_t                    *list_size,
+    int64_t                     number,
+    int64_t                     unit_num
+)
+{
+    if( number >= *list_size )
+    {
+        int64_t list_size_new = *list_size + unit_num;
+        sample_list_data_t *tmp = (sample_list_data_t *)realloc( *list, sizeof(sample_list_data_t) * list_size_new );
+        if( !tmp )
+            return NULL;
+        *list      = tmp;
+        *list_size = list_size_new;
+    }
+    return &((*list)[number]);
+}
+
+static void release_parse_range( parse_range_t *range )
+{
+    if( range->gop_list )
+        free( range->gop_list );
+    if( range->list )
+        free( range->list );
+    if( range->check_list )
+        free( range->check_list );
+    memset( range, 0, sizeof(parse_range_t) );
 }
 
 static thread_func_ret parse_stream( void *args )
@@ -136,210 +467,351 @@ static thread_func_ret parse_stream( void *args )
     if( !param )
         return (thread_func_ret)(-1);
     mpeg_api_info_t  *info          = param->api_info;
+    mpeg_parser_t    *parser        = info->parser;
+    void             *parser_info   = param->parser_info;
     mpeg_sample_type  sample_type   = param->sample_type;
     uint8_t           stream_number = param->stream_number;
-    void             *list_data     = param->list_data;
-    mpeg_parser_t    *parser        = info->parser;
-    void             *parser_info   = info->parser_info;
-    /* parse */
-    gop_list_data_t    *gop_list   = NULL;
-    sample_list_data_t *video_list = NULL;
-    sample_list_data_t *audio_list = NULL;
-    if( sample_type == SAMPLE_TYPE_VIDEO )
+    parse_range_t    *range         = param->range;
+    mapi_log_sink_t  *prev_sink     = mapi_log_sink_bind( __atomic_load_n( &(info->log_sink), __ATOMIC_ACQUIRE ) );
+    mapi_stats_set_t *prev_stats    = mapi_stats_bind( info->stats );
+    mapi_trace_begin( sample_type == SAMPLE_TYPE_VIDEO ? "parse_stream (video)" : "parse_stream (audio)" );
+    int64_t list_unit_num = (sample_type == SAMPLE_TYPE_VIDEO ? DEFAULT_VIDEO_SAMPLE_NUM : DEFAULT_AUDIO_SAMPLE_NUM) / param->range_num;
+    int64_t gop_unit_num  = DEFAULT_GOP_SAMPLE_NUM / param->range_num;
+    if( list_unit_num < PARSE_RANGE_LIST_UNIT_NUM_MIN )
+        list_unit_num = PARSE_RANGE_LIST_UNIT_NUM_MIN;
+    if( gop_unit_num < PARSE_RANGE_LIST_UNIT_NUM_MIN )
+        gop_unit_num = PARSE_RANGE_LIST_UNIT_NUM_MIN;
+    /* the range, except the first one, starts from the first sync sample after the start position. */
+    enum {
+        PARSE_RANGE_SKIP,
+        PARSE_RANGE_STORE,
+        PARSE_RANGE_CHECK
+    } state = PARSE_RANGE_STORE;
+    if( param->range_index )
     {
-        video_stream_data_t *video_stream = (video_stream_data_t *)list_data;
-        int64_t gop_list_size   = DEFAULT_GOP_SAMPLE_NUM;
-        int64_t video_list_size = DEFAULT_VIDEO_SAMPLE_NUM;
-        gop_list   = (gop_list_data_t    *)malloc( sizeof(gop_list_data_t)    * gop_list_size   );
-        video_list = (sample_list_data_t *)malloc( sizeof(sample_list_data_t) * video_list_size );
-        if( !gop_list || !video_list )
-            goto fail_parse_stream;
-        /* create video lists. */
-        uint32_t wrap_around_count = 0;
-        int64_t  compare_ts        = 0;
-        int64_t  gop_number        = -1;
-        int64_t i;
-        for( i = 0; ; ++i )
+        int64_t seek_position = param->start_position - PARSE_RANGE_SEEK_MARGIN;
+        parser->set_sample_position( parser_info, sample_type, stream_number, (seek_position > 0) ? seek_position : 0 );
+        state = PARSE_RANGE_SKIP;
+    }
+    int64_t gop_base   = 0;
+    int64_t gop_number = -1;
+    int64_t sample_num = 0;
+    while( 1 )
+    {
+        sample_list_data_t sample;
+        gop_list_data_t    gop;
+        if( get_parse_sample( parser, parser_info, sample_type, stream_number, &sample, &gop ) )
+            break;
+        int new_gop = (gop_number < sample.gop_number);
+        if( new_gop )
+            gop_number = sample.gop_number;
+        /* sync sample: the first picture of GOP for video, every frame for audio. */
+        int sync = (sample_num++ > 0) && (sample_type != SAMPLE_TYPE_VIDEO || new_gop);
+        /* check the range boundaries. */
+        if( state == PARSE_RANGE_SKIP )
         {
-            if( i >= video_list_size )
+            if( !sync || sample.file_position < param->start_position )
             {
-                video_list_size += DEFAULT_VIDEO_SAMPLE_NUM;
-                sample_list_data_t *tmp = (sample_list_data_t *)realloc( video_list
-                                                                       , sizeof(sample_list_data_t) * video_list_size );
-                if( !tmp )
-                    goto fail_parse_stream;
-                video_list = tmp;
+                parse_progress( param, sample.file_position, 0 );
+                continue;
             }
-            parser->seek_next_sample_position( parser_info, SAMPLE_TYPE_VIDEO, stream_number );
-            video_sample_info_t video_sample_info;
-            if( parser->get_video_info( parser_info, stream_number, &video_sample_info ) )
-                break;
+            state    = PARSE_RANGE_STORE;
+            gop_base = sample.gop_number;
+        }
+        if( state == PARSE_RANGE_STORE && param->end_position >= 0
+         && sync && sample.file_position >= param->end_position )
+            state = PARSE_RANGE_CHECK;
+        else if( state == PARSE_RANGE_CHECK && sync && range->check_num >= PARSE_RANGE_CHECK_SAMPLE_NUM )
+            break;
+        if( sample.gop_number >= 0 )
+            sample.gop_number -= gop_base;
+        /* setup. */
+        if( state == PARSE_RANGE_CHECK )
+        {
+            sample_list_data_t *entry = get_parse_range_entry( &(range->check_list), &(range->check_size), range->check_num, PARSE_RANGE_CHECK_SAMPLE_NUM );
+            if( !entry )
+                goto fail_parse_stream;
+            *entry = sample;
+            ++ range->check_num;
+        }
+        else
+        {
+            sample_list_data_t *entry = get_parse_range_entry( &(range->list), &(range->list_size), range->list_num, list_unit_num );
+            if( !entry )
+                goto fail_parse_stream;
+            *entry = sample;
+            ++ range->list_num;
             /* setup GOP list. */
-            if( gop_number < video_sample_info.gop_number )
+            if( sample_type == SAMPLE_TYPE_VIDEO && new_gop )
             {
-                gop_number = video_sample_info.gop_number;
-                if( gop_number >= gop_list_size )
+                int64_t gop_index = sample.gop_number;
+                while( gop_index >= range->gop_list_size )
                 {
-                    gop_list_size += DEFAULT_GOP_SAMPLE_NUM;
-                    gop_list_data_t *tmp = (gop_list_data_t *)realloc( gop_list, sizeof(gop_list_data_t) * gop_list_size );
+                    int64_t gop_list_size = range->gop_list_size + gop_unit_num;
+                    gop_list_data_t *tmp = (gop_list_data_t *)realloc( range->gop_list, sizeof(gop_list_data_t) * gop_list_size );
                     if( !tmp )
                         goto fail_parse_stream;
-                    gop_list = tmp;
+                    range->gop_list      = tmp;
+                    range->gop_list_size = gop_list_size;
+                }
+                range->gop_list[gop_index] = gop;
+                range->gop_num             = gop_index + 1;
+            }
+        }
+        /* progress. */
+        parse_progress( param, sample.file_position, 0 );
+    }
+    parse_progress( param, (param->end_position >= 0) ? param->end_position : info->file_size, 1 );
+    mapi_trace_end();
+    mapi_log_sink_bind( prev_sink );
+    mapi_stats_bind( prev_stats );
+    return (thread_func_ret)(0);
+fail_parse_stream:
+    release_parse_range( range );
+    mapi_trace_end();
+    mapi_log_sink_bind( prev_sink );
+    mapi_stats_bind( prev_stats );
+    return (thread_func_ret)(-1);
+}
+
+static int check_parse_range_boundary( parse_range_t *prev, parse_range_t *next )
+{
+    /* the samples parsed beyond the previous range must be the same as the head of the next range. */
+    if( !prev->check_num )
+        return (next->list_num || next->check_num) ? -1 : 0;
+    sample_list_data_t *prev_head = &(prev->check_list[0]);
+    sample_list_data_t *next_head = next->list_num ? &(next->list[0]) : next->check_num ? &(next->check_list[0]) : NULL;
+    if( !next_head )
+        return -1;
+    for( int64_t i = 0; i < prev->check_num; ++i )
+    {
+        sample_list_data_t *a = &(prev->check_list[i]);
+        sample_list_data_t *b = NULL;
+        if( i < next->list_num )
+            b = &(next->list[i]);
+        else if( i - next->list_num < next->check_num )
+            b = &(next->check_list[i - next->list_num]);
+        if( !b )
+            return -1;
+        if( a->file_position        != b->file_position
+         || a->sample_size          != b->sample_size
+         || a->raw_data_size        != b->raw_data_size
+         || a->raw_data_read_offset != b->raw_data_read_offset
+         || a->au_size              != b->au_size
+         || a->program_id           != b->program_id
+         || a->timestamp.pts        != b->timestamp.pts
+         || a->timestamp.dts        != b->timestamp.dts
+         || a->picture_coding_type  != b->picture_coding_type
+         || a->temporal_reference   != b->temporal_reference
+         || a->picture_structure    != b->picture_structure
+         || a->progressive_frame    != b->progressive_frame
+         || a->repeat_first_field   != b->repeat_first_field
+         || a->top_field_first      != b->top_field_first
+         || a->sampling_frequency   != b->sampling_frequency
+         || a->bitrate              != b->bitrate
+         || a->channel              != b->channel
+         || a->layer                != b->layer
+         || a->bit_depth            != b->bit_depth
+         || a->gop_number - prev_head->gop_number != b->gop_number - next_head->gop_number )
+            return -1;
+        /* the arrival time is unwrapped from a different origin. */
+        int a_invalid = (a->arrival_time == (int64_t)MPEG_TIMESTAMP_INVALID_VALUE || prev_head->arrival_time == (int64_t)MPEG_TIMESTAMP_INVALID_VALUE);
+        int b_invalid = (b->arrival_time == (int64_t)MPEG_TIMESTAMP_INVALID_VALUE || next_head->arrival_time == (int64_t)MPEG_TIMESTAMP_INVALID_VALUE);
+        if( a_invalid != b_invalid
+         || (!a_invalid && a->arrival_time - prev_head->arrival_time != b->arrival_time - next_head->arrival_time) )
+            return -1;
+    }
+    return 0;
+}
+
+static int merge_parse_ranges
+(
+    mpeg_api_info_t            *info,
+    mpeg_sample_type            sample_type,
+    parse_range_t              *range,
+    uint16_t                    range_num,
+    void                       *list_data
+)
+{
+    for( uint16_t r = 1; r < range_num; ++r )
+        if( check_parse_range_boundary( &(range[r - 1]), &(range[r]) ) )
+            return -1;
+    /* join the ranges. */
+    gop_list_data_t    *gop_list    = NULL;
+    sample_list_data_t *sample_list = NULL;
+    int64_t             gop_num     = range[0].gop_num;
+    int64_t             sample_num  = range[0].list_num;
+    if( range_num == 1 )
+    {
+        gop_list          = range[0].gop_list;
+        sample_list       = range[0].list;
+        range[0].gop_list = NULL;
+        range[0].list     = NULL;
+    }
+    else
+    {
+        int64_t gop_offset[range_num];
+        int64_t arrival_offset[range_num];
+        gop_offset[0]     = 0;
+        arrival_offset[0] = 0;
+        for( uint16_t r = 1; r < range_num; ++r )
+        {
+            gop_offset[r]     = gop_offset[r - 1];
+            arrival_offset[r] = arrival_offset[r - 1];
+            if( range[r - 1].check_num )
+            {
+                sample_list_data_t *prev_head = &(range[r - 1].check_list[0]);
+                sample_list_data_t *next_head = range[r].list_num ? &(range[r].list[0]) : &(range[r].check_list[0]);
+                gop_offset[r] += prev_head->gop_number;
+                if( prev_head->arrival_time != (int64_t)MPEG_TIMESTAMP_INVALID_VALUE
+                 && next_head->arrival_time != (int64_t)MPEG_TIMESTAMP_INVALID_VALUE )
+                    arrival_offset[r] += prev_head->arrival_time - next_head->arrival_time;
+            }
+            if( range[r].gop_num && gop_num < gop_offset[r] + range[r].gop_num )
+                gop_num = gop_offset[r] + range[r].gop_num;
+            sample_num += range[r].list_num;
+        }
+        if( sample_num )
+        {
+            if( sample_type == SAMPLE_TYPE_VIDEO && gop_num )
+            {
+                gop_list = (gop_list_data_t *)malloc( sizeof(gop_list_data_t) * gop_num );
+                if( !gop_list )
+                    return -1;
+            }
+            sample_list = (sample_list_data_t *)malloc( sizeof(sample_list_data_t) * sample_num );
+            if( !sample_list )
+            {
+                if( gop_list )
+                    free( gop_list );
+                return -1;
+            }
+            int64_t i = 0;
+            for( uint16_t r = 0; r < range_num; ++r )
+            {
+                if( gop_list && range[r].gop_num )
+                    memcpy( &(gop_list[gop_offset[r]]), range[r].gop_list, sizeof(gop_list_data_t) * range[r].gop_num );
+                for( int64_t j = 0; j < range[r].list_num; ++j, ++i )
+                {
+                    sample_list[i] = range[r].list[j];
+                    if( sample_list[i].gop_number >= 0 )
+                        sample_list[i].gop_number += gop_offset[r];
+                    if( sample_list[i].arrival_time != (int64_t)MPEG_TIMESTAMP_INVALID_VALUE )
+                        sample_list[i].arrival_time += arrival_offset[r];
                 }
-                gop_list[gop_number].progressive_sequence = video_sample_info.progressive_sequence;
-                gop_list[gop_number].closed_gop           = video_sample_info.closed_gop;
+            }
+        }
+    }
+    if( !sample_num )
+    {
+        if( gop_list )
+            free( gop_list );
+        if( sample_list )
+            free( sample_list );
+        return 0;
+    }
+    /* correct the timestamps through the whole stream. */
+    if( sample_type == SAMPLE_TYPE_VIDEO )
+    {
+        video_stream_data_t *video_stream = (video_stream_data_t *)list_data;
+        uint32_t wrap_around_count = 0;
+        int64_t  compare_ts        = 0;
+        int64_t  gop_number        = -1;
+        for( int64_t i = 0; i < sample_num; ++i )
+        {
+            sample_list_data_t *sample = &(sample_list[i]);
+            if( gop_number < sample->gop_number )
+            {
+                gop_number = sample->gop_number;
                 /* correct check. */
-                if( compare_ts > video_sample_info.pts + info->wrap_around_check_v )
+                if( compare_ts > sample->timestamp.pts + info->wrap_around_check_v )
                     ++wrap_around_count;
-                compare_ts = video_sample_info.pts;
+                compare_ts = sample->timestamp.pts;
             }
 #define CALCLATE_CORRECTION_TIMESTAMP( _timestamp )     \
 ( _timestamp + (wrap_around_count + ((compare_ts > _timestamp + info->wrap_around_check_v) ? 1 : 0)) * MPEG_TIMESTAMP_WRAPAROUND_VALUE )
-            /* setup. */
-            video_list[i].file_position        = video_sample_info.file_position;
-            video_list[i].sample_size          = video_sample_info.sample_size;
-            video_list[i].raw_data_size        = video_sample_info.raw_data_size;
-            video_list[i].raw_data_read_offset = video_sample_info.raw_data_read_offset;
-            video_list[i].au_size              = video_sample_info.au_size;
-            video_list[i].program_id           = video_sample_info.program_id;
-            video_list[i].gop_number           = video_sample_info.gop_number;
-            video_list[i].timestamp.pts        = CALCLATE_CORRECTION_TIMESTAMP( video_sample_info.pts );
-            video_list[i].timestamp.dts        = CALCLATE_CORRECTION_TIMESTAMP( video_sample_info.dts );
-            video_list[i].picture_coding_type  = video_sample_info.picture_coding_type;
-            video_list[i].temporal_reference   = video_sample_info.temporal_reference;
-            video_list[i].progressive_frame    = video_sample_info.progressive_frame;
-            video_list[i].picture_structure    = video_sample_info.picture_structure;
-            video_list[i].repeat_first_field   = video_sample_info.repeat_first_field;
-            video_list[i].top_field_first      = video_sample_info.top_field_first;
-            video_list[i].sampling_frequency   = 0;
-            video_list[i].bitrate              = 0;
-            video_list[i].channel              = 0;
-            video_list[i].layer                = 0;
-            video_list[i].bit_depth            = 0;
+            sample->timestamp.pts = CALCLATE_CORRECTION_TIMESTAMP( sample->timestamp.pts );
+            sample->timestamp.dts = CALCLATE_CORRECTION_TIMESTAMP( sample->timestamp.dts );
 #undef CALCLATE_CORRECTION_TIMESTAMP
-            /* progress. */
-            parse_progress( param, video_sample_info.file_position );
         }
-        if( i > 0 )
+        /* correct check for no GOP picture. */
+        int16_t temporal_reference = (int16_t)((1 << 15) - 1);
+        compare_ts = 0;
+        for( int64_t j = 0; j < sample_num; ++j )
         {
-            /* correct check for no GOP picture. */
-            int16_t temporal_reference = (int16_t)((1 << 15) - 1);
-            compare_ts = 0;
-            for( uint32_t j = 0; j < i; ++j )
+            if( sample_list[j].gop_number >= 0 )
+                break;
+            if( sample_list[j].temporal_reference < temporal_reference )
             {
-                if( video_list[j].gop_number >= 0 )
-                    break;
-                if( video_list[j].temporal_reference < temporal_reference )
-                {
-                    compare_ts         = video_list[j].timestamp.pts;
-                    temporal_reference = video_list[j].temporal_reference;
-                }
+                compare_ts         = sample_list[j].timestamp.pts;
+                temporal_reference = sample_list[j].temporal_reference;
             }
-            if( compare_ts )
+        }
+        if( compare_ts )
+        {
+            for( int64_t j = 0; j < sample_num; ++j )
             {
-                for( uint32_t j = 0; j < i; ++j )
-                {
-                    if( video_list[j].gop_number >= 0 )
-                        break;
+                if( sample_list[j].gop_number >= 0 )
+                    break;
 #define CHECK_CORRECTION_TIME_VALUE( _timestamp )     \
 ( (compare_ts > _timestamp + info->wrap_around_check_v) ? MPEG_TIMESTAMP_WRAPAROUND_VALUE : 0 )
-                    video_list[j].timestamp.pts += CHECK_CORRECTION_TIME_VALUE( video_list[j].timestamp.pts );
-                    video_list[j].timestamp.dts += CHECK_CORRECTION_TIME_VALUE( video_list[j].timestamp.dts );
+                sample_list[j].timestamp.pts += CHECK_CORRECTION_TIME_VALUE( sample_list[j].timestamp.pts );
+                sample_list[j].timestamp.dts += CHECK_CORRECTION_TIME_VALUE( sample_list[j].timestamp.dts );
 #undef CHECK_CORRECTION_TIME_VALUE
-                }
             }
-            /* setup video sample list. */
-            video_stream->video_gop     = gop_list;
-            video_stream->video_gop_num = gop_number + 1;
-            video_stream->video         = video_list;
-            video_stream->video_num     = i;
-        }
-        else
-        {
-            free( gop_list );
-            free( video_list );
         }
-        gop_list   = NULL;
-        video_list = NULL;
+        /* setup video sample list. */
+        video_stream->video_gop     = gop_list;
+        video_stream->video_gop_num = gop_num;
+        video_stream->video         = sample_list;
+        video_stream->video_num     = sample_num;
     }
-    else if( sample_type == SAMPLE_TYPE_AUDIO )
+    else
     {
         audio_stream_data_t *audio_stream = (audio_stream_data_t *)list_data;
-        int64_t audio_list_size = DEFAULT_AUDIO_SAMPLE_NUM;
-        audio_list = (sample_list_data_t *)malloc( sizeof(sample_list_data_t) * audio_list_size );
-        if( !audio_list )
-            goto fail_parse_stream;
-        /* create audio sample list. */
         uint32_t wrap_around_count = 0;
         int64_t  compare_ts        = 0;
-        int64_t i;
-        for( i = 0; ; ++i )
+        for( int64_t i = 0; i < sample_num; ++i )
         {
-            if( i >= audio_list_size )
-            {
-                audio_list_size += DEFAULT_AUDIO_SAMPLE_NUM;
-                sample_list_data_t *tmp = (sample_list_data_t *)realloc( audio_list, sizeof(sample_list_data_t) * audio_list_size );
-                if( !tmp )
-                    goto fail_parse_stream;
-                audio_list = tmp;
-            }
-            parser->seek_next_sample_position( parser_info, SAMPLE_TYPE_AUDIO, stream_number );
-            audio_sample_info_t audio_sample_info;
-            if( parser->get_audio_info( parser_info, stream_number, &audio_sample_info ) )
-                break;
+            sample_list_data_t *sample = &(sample_list[i]);
             /* correct check. */
-            if( compare_ts > audio_sample_info.pts + info->wrap_around_check_v )
+            if( compare_ts > sample->timestamp.pts + info->wrap_around_check_v )
                 ++wrap_around_count;
-            compare_ts = audio_sample_info.pts;
-            /* setup. */
+            compare_ts = sample->timestamp.pts;
 #define CALCLATE_CORRECTION_TIMESTAMP( _timestamp )     \
 ( _timestamp + wrap_around_count * MPEG_TIMESTAMP_WRAPAROUND_VALUE )
-            audio_list[i].file_position        = audio_sample_info.file_position;
-            audio_list[i].sample_size          = audio_sample_info.sample_size;
-            audio_list[i].raw_data_size        = audio_sample_info.raw_data_size;
-            audio_list[i].raw_data_read_offset = audio_sample_info.raw_data_read_offset;
-            audio_list[i].au_size              = audio_sample_info.au_size;
-            audio_list[i].program_id           = audio_sample_info.program_id;
-            audio_list[i].gop_number           = 0;
-            audio_list[i].timestamp.pts        = CALCLATE_CORRECTION_TIMESTAMP( audio_sample_info.pts );
-            audio_list[i].timestamp.dts        = CALCLATE_CORRECTION_TIMESTAMP( audio_sample_info.dts );
-            audio_list[i].picture_coding_type  = 0;
-            audio_list[i].temporal_reference   = 0;
-            audio_list[i].picture_structure    = 0;
-            audio_list[i].progressive_frame    = 0;
-            audio_list[i].sampling_frequency   = audio_sample_info.sampling_frequency;
-            audio_list[i].bitrate              = audio_sample_info.bitrate;
-            audio_list[i].channel              = audio_sample_info.channel;
-            audio_list[i].layer                = audio_sample_info.layer;
-            audio_list[i].bit_depth            = audio_sample_info.bit_depth;
+            sample->timestamp.pts = CALCLATE_CORRECTION_TIMESTAMP( sample->timestamp.pts );
+            sample->timestamp.dts = CALCLATE_CORRECTION_TIMESTAMP( sample->timestamp.dts );
 #undef CALCLATE_CORRECTION_TIMESTAMP
-            /* progress. */
-            parse_progress( param, audio_sample_info.file_position );
-        }
-        if( i > 0 )
-        {
-            /* setup audio sample list. */
-            audio_stream->audio     = audio_list;
-            audio_stream->audio_num = i;
         }
-        else
-            free( audio_list );
-        audio_list = NULL;
+        if( gop_list )
+            free( gop_list );
+        /* setup audio sample list. */
+        audio_stream->audio     = sample_list;
+        audio_stream->audio_num = sample_num;
     }
-    return (thread_func_ret)(0);
-fail_parse_stream:
-    if( gop_list )
-        free( gop_list );
-    if( video_list )
-        free( video_list );
-    if( audio_list )
-        free( audio_list );
-    return (thread_func_ret)(-1);
+    return 0;
+}
+
+static uint16_t get_parse_range_num( mpeg_api_info_t *info )
+{
+    /* only the transport stream can restart the parsing from any position. */
+    if( info->parser != &mpegts_parser )
+        return 1;
+    int64_t range_num   = info->file_size / PARSE_RANGE_SIZE_MIN;
+    int64_t parallel_num = thread_pool_get_thread_num( thread_pool_get_shared() );
+    if( parallel_num < 2 || range_num < 2 )
+        return 1;
+    if( range_num > parallel_num )
+        range_num = parallel_num;
+    if( range_num > PARSE_RANGE_NUM_MAX )
+        range_num = PARSE_RANGE_NUM_MAX;
+    return (uint16_t)range_num;
 }
 
 MAPI_EXPORT int mpeg_api_create_sample_list( void *ih )
 {
-    mpeg_api_info_t *info = (mpeg_api_info_t *)ih;
+    mpeg_api_info_t *info = get_api_info( ih );
     if( !info || !info->parser_info )
         return -1;
     mpeg_parser_t *parser      = info->parser;
@@ -356,62 +828,115 @@ MAPI_EXPORT int mpeg_api_create_sample_list( void *ih )
     if( (video_stream_num && !video_stream)
      || (audio_stream_num && !audio_stream) )
         goto fail_create_list;
+    /* split the streams into the ranges of the file, and parse them with own cursors. */
+    uint16_t stream_num = video_stream_num + audio_stream_num;
+    uint16_t range_num  = get_parse_range_num( info );
+    void   **cursor     = NULL;
+    if( range_num > 1 )
+    {
+        cursor = (void **)calloc( range_num, sizeof(void *) );
+        for( uint16_t r = 0; cursor && r < range_num; ++r )
+        {
+            cursor[r] = parser->create_cursor( parser_info );
+            if( !cursor[r] )
+            {
+                for( uint16_t i = 0; i < r; ++i )
+                    parser->release_cursor( cursor[i] );
+                free( cursor );
+                cursor = NULL;
+            }
+        }
+        if( !cursor )
+            range_num = 1;
+    }
     /* create lists. */
-    uint16_t thread_num = video_stream_num + audio_stream_num;
-    parse_param_t *param    = (parse_param_t *)malloc( sizeof(parse_param_t) * thread_num );
-    int64_t       *progress = (int64_t       *)calloc( thread_num, sizeof(int64_t) * thread_num );
-    if( !param || !progress )
+    uint32_t       task_num = (uint32_t)stream_num * range_num;
+    parse_param_t *param    = (parse_param_t *)malloc( sizeof(parse_param_t) * task_num );
+    parse_range_t *range    = (parse_range_t *)calloc( task_num, sizeof(parse_range_t) );
+    if( !param || !range )
     {
         if( param )
             free( param );
-        if( progress )
-            free( progress );
+        if( range )
+            free( range );
+        if( cursor )
+        {
+            for( uint16_t r = 0; r < range_num; ++r )
+                parser->release_cursor( cursor[r] );
+            free( cursor );
+        }
         goto fail_create_list;
     }
     else
     {
-        void *parse_thread[thread_num];
-        memset( parse_thread, 0, sizeof(void *) * thread_num );
-        uint16_t thread_index = 0;
-        /* video. */
-        for( uint8_t i = 0; i < video_stream_num; ++i )
-        {
-            param[thread_index].api_info      = info;
-            param[thread_index].sample_type   = SAMPLE_TYPE_VIDEO;
-            param[thread_index].stream_number = i;
-            param[thread_index].list_data     = &(video_stream[i]);
-            param[thread_index].thread_index  = thread_index;
-            param[thread_index].thread_num    = thread_num;
-            param[thread_index].progress      = progress;
-            parse_thread[thread_index] = thread_create( parse_stream, &param[thread_index] );
-            ++thread_index;
-        }
-        /* audio. */
-        for( uint8_t i = 0; i < audio_stream_num; ++i )
+        __atomic_store_n( &(info->progress.stream_num), stream_num, __ATOMIC_RELAXED );
+        __atomic_store_n( &(info->progress.position_sum), 0, __ATOMIC_RELAXED );
+        __atomic_store_n( &(info->progress.active), 1, __ATOMIC_RELEASE );
+        /* the tasks are queued to the shared pool, the video streams first, and taken by idle workers. */
+        void *pool = thread_pool_get_shared();
+        void *parse_task[task_num];
+        memset( parse_task, 0, sizeof(void *) * task_num );
+        uint32_t task_index = 0;
+        for( uint16_t i = 0; i < stream_num; ++i )
+            for( uint16_t r = 0; r < range_num; ++r )
+            {
+                parse_param_t *p = &(param[task_index]);
+                p->api_info       = info;
+                p->parser_info    = cursor ? cursor[r] : parser_info;
+                p->sample_type    = (i < video_stream_num) ? SAMPLE_TYPE_VIDEO : SAMPLE_TYPE_AUDIO;
+                p->stream_number  = (i < video_stream_num) ? i : i - video_stream_num;
+                p->range          = &(range[task_index]);
+                p->range_index    = r;
+                p->range_num      = range_num;
+                p->start_position = info->file_size * r / range_num;
+                p->end_position   = (r + 1 < range_num) ? info->file_size * (r + 1) / range_num : -1;
+                p->progress_size  = 0;
+                parse_task[task_index] = thread_pool_submit( pool, parse_stream, p );
+                if( !parse_task[task_index] )
+                    parse_stream( p );
+                ++task_index;
+            }
+        /* wait parse end. */
+        for( uint32_t i = 0; i < task_index; ++i )
+            thread_future_wait( parse_task[i], NULL );
+        if( cursor )
         {
-            param[thread_index].api_info      = info;
-            param[thread_index].sample_type   = SAMPLE_TYPE_AUDIO;
-            param[thread_index].stream_number = i;
-            param[thread_index].list_data     = &(audio_stream[i]);
-            param[thread_index].thread_index  = thread_index;
-            param[thread_index].thread_num    = thread_num;
-            param[thread_index].progress      = progress;
-            parse_thread[thread_index] = thread_create( parse_stream, &param[thread_index] );
-            ++thread_index;
+            for( uint16_t r = 0; r < range_num; ++r )
+                parser->release_cursor( cursor[r] );
+            free( cursor );
         }
-        /* wait parse end. */
-        if( thread_index )
+        /* merge the ranges of each stream. */
+        for( uint16_t i = 0; i < stream_num; ++i )
         {
-            for( uint16_t i = 0; i < thread_index; ++i )
+            mpeg_sample_type sample_type   = param[i * range_num].sample_type;
+            uint8_t          stream_number = param[i * range_num].stream_number;
+            void            *list_data     = (sample_type == SAMPLE_TYPE_VIDEO)
+                                           ? (void *)&(video_stream[stream_number])
+                                           : (void *)&(audio_stream[stream_number]);
+            if( merge_parse_ranges( info, sample_type, &(range[i * range_num]), range_num, list_data ) )
             {
-                //mapi_log( LOG_LV_PROGRESS, "[log] wait %s Stream[%3u]...\n"
-                //                         , param[i].stream_name, param[i].stream_number );
-                thread_wait_end( parse_thread[i], NULL );
+                /* the ranges were not joined, so parse the whole stream again. */
+                mapi_log( LOG_LV2, "[log] re-parse the whole stream. type:%d, stream:%u\n", sample_type, stream_number );
+                parse_range_t whole_range = { 0 };
+                parse_param_t whole_param = param[i * range_num];
+                whole_param.parser_info    = parser_info;
+                whole_param.range          = &whole_range;
+                whole_param.range_index    = 0;
+                whole_param.range_num      = 1;
+                whole_param.start_position = 0;
+                whole_param.end_position   = -1;
+                whole_param.progress_size  = 0;
+                parse_stream( &whole_param );
+                merge_parse_ranges( info, sample_type, &whole_range, 1, list_data );
+                release_parse_range( &whole_range );
             }
         }
+        for( uint32_t i = 0; i < task_num; ++i )
+            release_parse_range( &(range[i]) );
         free( param );
-        free( progress );
-        parse_progress( NULL, info->file_size );
+        free( range );
+        __atomic_store_n( &(info->progress.active), 0, __ATOMIC_RELEASE );
+        mapi_log( LOG_LV_PROGRESS, "[parse_stream] %14" PRIu64 "/%-14" PRIu64 "\n", info->file_size, info->file_size );
     }
     /* check. */
     if( video_stream )
@@ -451,9 +976,27 @@ fail_create_list:
     return -1;
 }
 
+MAPI_EXPORT int mpeg_api_get_progress( void *ih, progress_info_t *progress )
+{
+    mpeg_api_info_t *info = get_api_info( ih );
+    if( !info || !progress )
+        return -1;
+    /* can be called from the other thread while creating the sample list. */
+    parse_progress_t *parse_progress = &(info->progress);
+    progress->active   = __atomic_load_n( &(parse_progress->active), __ATOMIC_ACQUIRE );
+    progress->total    = info->file_size;
+    progress->position = 0;
+    uint16_t stream_num = __atomic_load_n( &(parse_progress->stream_num), __ATOMIC_RELAXED );
+    if( stream_num )
+        progress->position = __atomic_load_n( &(parse_progress->position_sum), __ATOMIC_RELAXED ) / stream_num;
+    if( progress->position > progress->total )
+        progress->position = progress->total;
+    return 0;
+}
+
 MAPI_EXPORT int64_t mpeg_api_get_sample_position( void *ih, mpeg_sample_type sample_type, uint8_t stream_number )
 {
-    mpeg_api_info_t *info = (mpeg_api_info_t *)ih;
+    mpeg_api_info_t *info = get_api_info( ih );
     if( !info || !info->parser_info )
         return -1;
     return info->parser->get_sample_position( info->parser_info, sample_type, stream_number );
@@ -467,7 +1010,7 @@ MAPI_EXPORT int mpeg_api_set_sample_position
     int64_t                     position
 )
 {
-    mpeg_api_info_t *info = (mpeg_api_info_t *)ih;
+    mpeg_api_info_t *info = get_api_info( ih );
     if( !info || !info->parser_info )
         return -1;
     return info->parser->set_sample_position( info->parser_info, sample_type, stream_number, position );
@@ -482,7 +1025,7 @@ MAPI_EXPORT int mpeg_api_get_all_stream_data
     get_stream_data_cb_t       *cb
 )
 {
-    mpeg_api_info_t *info = (mpeg_api_info_t *)ih;
+    mpeg_api_info_t *info = get_api_info( ih );
     if( !info || !info->parser_info )
         return -1;
     mpeg_parser_t *parser      = info->parser;
@@ -523,7 +1066,7 @@ MAPI_EXPORT int mpeg_api_get_stream_all
     get_stream_data_cb_t       *cb
 )
 {
-    mpeg_api_info_t *info = (mpeg_api_info_t *)ih;
+    mpeg_api_info_t *info = get_api_info( ih );
     if( !info || !info->parser_info )
         return -1;
     mpeg_parser_t *parser      = info->parser;
@@ -568,7 +1111,7 @@ MAPI_EXPORT int mpeg_api_get_stream_data
     get_sample_data_mode        get_mode
 )
 {
-    mpeg_api_info_t *info = (mpeg_api_info_t *)ih;
+    mpeg_api_info_t *info = get_api_info( ih );
     if( !info || !info->parser_info )
         return -1;
     mpeg_parser_t *parser      = info->parser;
@@ -608,17 +1151,26 @@ MAPI_EXPORT int mpeg_api_get_stream_data
     }
     if( !sample_size )
         return -1;
+    uint8_t *buffer = acquire_sample_buffer( &(info->buffer_pool), sample_size );
+    if( !buffer )
+        return -1;
     int64_t reset_position = parser->get_sample_position( parser_info, sample_type, stream_number );
     int     result         = parser->get_sample_data( parser_info, sample_type, stream_number
                                                     , file_position, sample_size, read_offset
-                                                    , dst_buffer, dst_read_size, get_mode );
+                                                    , buffer, dst_read_size, get_mode );
     parser->set_sample_position( parser_info, sample_type, stream_number, reset_position );
-    return result;
+    if( result )
+    {
+        recycle_sample_buffer( &(info->buffer_pool), buffer );
+        return result;
+    }
+    *dst_buffer = buffer;
+    return 0;
 }
 
 MAPI_EXPORT uint8_t mpeg_api_get_stream_num( void *ih, mpeg_sample_type sample_type, uint16_t service_id )
 {
-    mpeg_api_info_t *info = (mpeg_api_info_t *)ih;
+    mpeg_api_info_t *info = get_api_info( ih );
     if( !info || !info->parser_info )
         return 0;
     return info->parser->get_stream_num( info->parser_info, sample_type, service_id );
@@ -632,7 +1184,7 @@ MAPI_EXPORT const char *mpeg_api_get_stream_information
     get_information_key_type    key
 )
 {
-    mpeg_api_info_t *info = (mpeg_api_info_t *)ih;
+    mpeg_api_info_t *info = get_api_info( ih );
     if( !info || !info->parser_info )
         return NULL;
     return info->parser->get_stream_information( info->parser_info, sample_type, stream_number, key );
@@ -645,7 +1197,7 @@ MAPI_EXPORT const char *mpeg_api_get_sample_file_extension
     uint8_t                     stream_number
 )
 {
-    mpeg_api_info_t *info = (mpeg_api_info_t *)ih;
+    mpeg_api_info_t *info = get_api_info( ih );
     if( !info || !info->parser_info )
         return NULL;
     if( sample_type != SAMPLE_TYPE_VIDEO && sample_type != SAMPLE_TYPE_AUDIO )
@@ -723,12 +1275,34 @@ MAPI_EXPORT mpeg_stream_type mpeg_api_get_sample_stream_type
     uint8_t                     stream_number
 )
 {
-    mpeg_api_info_t *info = (mpeg_api_info_t *)ih;
+    mpeg_api_info_t *info = get_api_info( ih );
     if( !info || !info->parser_info )
         return -1;
     return info->parser->get_sample_stream_type( info->parser_info, sample_type, stream_number );
 }
 
+MAPI_EXPORT int mpeg_api_get_audio_frames
+(
+    void                       *ih,
+    uint8_t                     stream_number,
+    uint8_t                    *buffer,
+    uint32_t                    buffer_size,
+    audio_frame_t              *dst_frames,
+    uint32_t                    frame_num_max,
+    uint32_t                   *dst_frame_num
+)
+{
+    mpeg_api_info_t *info = get_api_info( ih );
+    if( !info || !info->parser_info || !buffer || !dst_frames || !dst_frame_num )
+        return -1;
+    mpeg_stream_type       stream_type  = info->parser->get_sample_stream_type( info->parser_info, SAMPLE_TYPE_AUDIO, stream_number );
+    mpeg_stream_group_type stream_judge = mpeg_stream_judge_type( stream_type, 0, NULL );
+    if( !(stream_judge & STREAM_IS_AUDIO) )
+        return -1;
+    *dst_frame_num = mpeg_stream_sync_audio_frames( stream_type, stream_judge, buffer, buffer_size, dst_frames, frame_num_max );
+    return 0;
+}
+
 MAPI_EXPORT uint32_t mpeg_api_get_sample_num
 (
     void                       *ih,
@@ -736,7 +1310,7 @@ MAPI_EXPORT uint32_t mpeg_api_get_sample_num
     uint8_t                     stream_number
 )
 {
-    mpeg_api_info_t *info = (mpeg_api_info_t *)ih;
+    mpeg_api_info_t *info = get_api_info( ih );
     if( !info || !info->parser_info )
         return 0;
     uint32_t sample_num = 0;
@@ -756,7 +1330,7 @@ MAPI_EXPORT int mpeg_api_get_sample_info
     stream_info_t              *stream_info
 )
 {
-    mpeg_api_info_t *info = (mpeg_api_info_t *)ih;
+    mpeg_api_info_t *info = get_api_info( ih );
     if( !info || !info->parser_info || !stream_info )
         return -1;
     if( sample_type == SAMPLE_TYPE_VIDEO && stream_number < info->sample_list.video_stream_num )
@@ -765,11 +1339,16 @@ MAPI_EXPORT int mpeg_api_get_sample_info
         int64_t             list_num = info->sample_list.video_stream[stream_number].video_num;
         if( !list || sample_number >= list_num )
             return -1;
-        gop_list_data_t *gop = &(info->sample_list.video_stream[stream_number].video_gop[list[sample_number].gop_number]);
+        /* the pictures before the first GOP (or keyframe) have no GOP information. */
+        static const gop_list_data_t no_gop = { 0 };
+        const gop_list_data_t *gop = (list[sample_number].gop_number >= 0)
+                                   ? &(info->sample_list.video_stream[stream_number].video_gop[list[sample_number].gop_number])
+                                   : &no_gop;
         stream_info->file_position        = list[sample_number].file_position;
         stream_info->sample_size          = list[sample_number].sample_size;
         stream_info->raw_data_size        = list[sample_number].raw_data_size;
         stream_info->au_size              = list[sample_number].au_size;
+        stream_info->arrival_time         = list[sample_number].arrival_time;
         stream_info->video_pts            = list[sample_number].timestamp.pts;
         stream_info->video_dts            = list[sample_number].timestamp.dts;
         stream_info->video_program_id     = list[sample_number].program_id;
@@ -793,6 +1372,7 @@ MAPI_EXPORT int mpeg_api_get_sample_info
         stream_info->sample_size        = list[sample_number].sample_size;
         stream_info->raw_data_size      = list[sample_number].raw_data_size;
         stream_info->au_size            = list[sample_number].au_size;
+        stream_info->arrival_time       = list[sample_number].arrival_time;
         stream_info->audio_pts          = list[sample_number].timestamp.pts;
         stream_info->audio_dts          = list[sample_number].timestamp.dts;
         stream_info->audio_program_id   = list[sample_number].program_id;
@@ -807,32 +1387,28 @@ MAPI_EXPORT int mpeg_api_get_sample_info
     return 0;
 }
 
-MAPI_EXPORT int mpeg_api_get_sample_data
+static int get_sample_read_info
 (
-    void                       *ih,
+    mpeg_api_info_t            *info,
     mpeg_sample_type            sample_type,
     uint8_t                     stream_number,
     uint32_t                    sample_number,
-    uint8_t                   **dst_buffer,
-    uint32_t                   *dst_read_size,
-    get_sample_data_mode        get_mode
+    get_sample_data_mode        get_mode,
+    int64_t                    *file_position,
+    uint32_t                   *sample_size,
+    int32_t                    *read_offset
 )
 {
-    mpeg_api_info_t *info = (mpeg_api_info_t *)ih;
-    if( !info || !info->parser_info || !dst_buffer || !dst_read_size )
-        return -1;
-    mpeg_parser_t *parser      = info->parser;
-    void          *parser_info = info->parser_info;
     sample_list_data_t *list;
     int64_t list_num;
-    if( sample_type == SAMPLE_TYPE_VIDEO )
+    if( sample_type == SAMPLE_TYPE_VIDEO && stream_number < info->sample_list.video_stream_num )
     {
         list     = info->sample_list.video_stream[stream_number].video;
         list_num = info->sample_list.video_stream[stream_number].video_num;
         if( !list || sample_number >= list_num )
             return -1;
     }
-    else if( sample_type == SAMPLE_TYPE_AUDIO )
+    else if( sample_type == SAMPLE_TYPE_AUDIO && stream_number < info->sample_list.audio_stream_num )
     {
         list     = info->sample_list.audio_stream[stream_number].audio;
         list_num = info->sample_list.audio_stream[stream_number].audio_num;
@@ -841,42 +1417,580 @@ MAPI_EXPORT int mpeg_api_get_sample_data
     }
     else
         return -1;
-    /* get sample data. */
-    int64_t  file_position = list[sample_number].file_position;
-    uint32_t sample_size   = list[sample_number].sample_size;
-    int32_t  read_offset   = 0;
+    /* setup. */
+    *file_position = list[sample_number].file_position;
+    *sample_size   = list[sample_number].sample_size;
+    *read_offset   = 0;
     if( get_mode == GET_SAMPLE_DATA_RAW )
     {
-        sample_size        = list[sample_number].raw_data_size;
-        read_offset        = list[sample_number].raw_data_read_offset;
+        *sample_size = list[sample_number].raw_data_size;
+        *read_offset = list[sample_number].raw_data_read_offset;
     }
-    if( !sample_size )
+    if( !(*sample_size) )
+        return -1;
+    return 0;
+}
+
+static int read_sample_buffer
+(
+    mpeg_api_info_t            *info,
+    void                       *parser_info,
+    mpeg_sample_type            sample_type,
+    uint8_t                     stream_number,
+    uint32_t                    sample_number,
+    get_sample_data_mode        get_mode,
+    uint8_t                   **dst_buffer,
+    uint32_t                   *dst_read_size
+)
+{
+    int64_t  file_position;
+    uint32_t sample_size;
+    int32_t  read_offset;
+    if( get_sample_read_info( info, sample_type, stream_number, sample_number, get_mode
+                            , &file_position, &sample_size, &read_offset ) )
+        return -1;
+    uint8_t *buffer = acquire_sample_buffer( &(info->buffer_pool), sample_size );
+    if( !buffer )
+        return -1;
+    if( info->parser->get_sample_data( parser_info, sample_type, stream_number
+                                     , file_position, sample_size, read_offset
+                                     , buffer, dst_read_size, get_mode ) )
+    {
+        recycle_sample_buffer( &(info->buffer_pool), buffer );
+        return -1;
+    }
+    *dst_buffer = buffer;
+    return 0;
+}
+
+static prefetch_slot_t *find_prefetch_slot( prefetch_ctx_t *prefetch, uint32_t sample_number )
+{
+    for( uint32_t i = 0; i < prefetch->slot_num; ++i )
+        if( prefetch->slot[i].status != PREFETCH_SLOT_EMPTY && prefetch->slot[i].sample_number == sample_number )
+            return &(prefetch->slot[i]);
+    return NULL;
+}
+
+static prefetch_slot_t *get_free_prefetch_slot( mpeg_api_info_t *info, prefetch_ctx_t *prefetch )
+{
+    prefetch_slot_t *stale = NULL;
+    for( uint32_t i = 0; i < prefetch->slot_num; ++i )
+    {
+        prefetch_slot_t *slot = &(prefetch->slot[i]);
+        if( slot->status == PREFETCH_SLOT_EMPTY )
+            return slot;
+        if( slot->status == PREFETCH_SLOT_READY
+         && (slot->sample_number < prefetch->next_number || slot->sample_number >= prefetch->next_number + prefetch->slot_num) )
+            stale = slot;
+    }
+    if( !stale )
+        return NULL;
+    /* evict the sample that is out of the prefetch window. */
+    if( stale->buffer )
+        recycle_sample_buffer( &(info->buffer_pool), stale->buffer );
+    stale->status = PREFETCH_SLOT_EMPTY;
+    stale->buffer = NULL;
+    return stale;
+}
+
+static thread_func_ret prefetch_sample( void *args )
+{
+    mpeg_api_info_t *info     = (mpeg_api_info_t *)args;
+    prefetch_ctx_t  *prefetch = info->prefetch;
+    mapi_stats_bind( info->stats );
+    thread_mutex_lock( prefetch->mutex );
+    while( !prefetch->quit )
+    {
+        /* search the next sample to be read. */
+        prefetch_slot_t *slot   = NULL;
+        uint32_t         number = 0;
+        if( prefetch->next_number >= 0 )
+            for( int64_t n = prefetch->next_number; n < prefetch->next_number + prefetch->slot_num && n < prefetch->sample_num; ++n )
+                if( !find_prefetch_slot( prefetch, (uint32_t)n ) )
+                {
+                    slot   = get_free_prefetch_slot( info, prefetch );
+                    number = (uint32_t)n;
+                    break;
+                }
+        if( !slot )
+        {
+            thread_cond_wait( prefetch->cond, prefetch->mutex );
+            continue;
+        }
+        slot->status        = PREFETCH_SLOT_LOADING;
+        slot->sample_number = number;
+        thread_mutex_unlock( prefetch->mutex );
+        /* follow the replacement of the sink. */
+        mapi_log_sink_bind( __atomic_load_n( &(info->log_sink), __ATOMIC_ACQUIRE ) );
+        /* read sample data. */
+        uint8_t  *buffer    = NULL;
+        uint32_t  read_size = 0;
+        if( read_sample_buffer( info, prefetch->cursor, prefetch->sample_type, prefetch->stream_number, number
+                              , prefetch->get_mode, &buffer, &read_size ) )
+            mapi_log( LOG_LV2, "[log] prefetch failed.  sample:%u\n", number );
+        thread_mutex_lock( prefetch->mutex );
+        slot->buffer    = buffer;
+        slot->read_size = read_size;
+        slot->status    = PREFETCH_SLOT_READY;
+        thread_cond_broadcast( prefetch->cond );
+    }
+    thread_mutex_unlock( prefetch->mutex );
+    return (thread_func_ret)(0);
+}
+
+static int get_prefetched_sample
+(
+    mpeg_api_info_t            *info,
+    uint32_t                    sample_number,
+    uint8_t                   **dst_buffer,
+    uint32_t                   *dst_read_size
+)
+{
+    prefetch_ctx_t *prefetch = info->prefetch;
+    thread_mutex_lock( prefetch->mutex );
+    prefetch_slot_t *slot = find_prefetch_slot( prefetch, sample_number );
+    while( slot && slot->status == PREFETCH_SLOT_LOADING )
+    {
+        thread_cond_wait( prefetch->cond, prefetch->mutex );
+        slot = find_prefetch_slot( prefetch, sample_number );
+    }
+    uint8_t  *buffer    = NULL;
+    uint32_t  read_size = 0;
+    if( slot )
+    {
+        buffer       = slot->buffer;
+        read_size    = slot->read_size;
+        slot->status = PREFETCH_SLOT_EMPTY;
+        slot->buffer = NULL;
+    }
+    /* move the prefetch window. */
+    prefetch->next_number = (int64_t)sample_number + 1;
+    thread_cond_broadcast( prefetch->cond );
+    thread_mutex_unlock( prefetch->mutex );
+    if( !buffer )
+        return -1;
+    *dst_buffer    = buffer;
+    *dst_read_size = read_size;
+    return 0;
+}
+
+static inline int is_prefetch_stream( mpeg_api_info_t *info, mpeg_sample_type sample_type, uint8_t stream_number )
+{
+    return info->prefetch
+        && info->prefetch->sample_type   == sample_type
+        && info->prefetch->stream_number == stream_number;
+}
+
+MAPI_EXPORT int mpeg_api_get_sample_data
+(
+    void                       *ih,
+    mpeg_sample_type            sample_type,
+    uint8_t                     stream_number,
+    uint32_t                    sample_number,
+    uint8_t                   **dst_buffer,
+    uint32_t                   *dst_read_size,
+    get_sample_data_mode        get_mode
+)
+{
+    mpeg_api_info_t *info = get_api_info( ih );
+    if( !info || !info->parser_info || !dst_buffer || !dst_read_size )
+        return -1;
+    /* get sample data. */
+    if( is_prefetch_stream( info, sample_type, stream_number ) && info->prefetch->get_mode == get_mode
+     && !get_prefetched_sample( info, sample_number, dst_buffer, dst_read_size ) )
+        return 0;
+    void *cursor = acquire_sample_cursor( info );
+    if( !cursor )
+        return -1;
+    int result = read_sample_buffer( info, cursor, sample_type, stream_number, sample_number, get_mode
+                                   , dst_buffer, dst_read_size );
+    recycle_sample_cursor( info, cursor );
+    return result;
+}
+
+MAPI_EXPORT int mpeg_api_read_sample_data
+(
+    void                       *ih,
+    mpeg_sample_type            sample_type,
+    uint8_t                     stream_number,
+    uint32_t                    sample_number,
+    uint8_t                    *buffer,
+    uint32_t                    buffer_size,
+    uint32_t                   *dst_read_size,
+    get_sample_data_mode        get_mode
+)
+{
+    mpeg_api_info_t *info = get_api_info( ih );
+    if( !info || !info->parser_info || !buffer || !dst_read_size )
+        return -1;
+    /* read sample data into caller's buffer. */
+    int64_t  file_position;
+    uint32_t sample_size;
+    int32_t  read_offset;
+    if( get_sample_read_info( info, sample_type, stream_number, sample_number, get_mode
+                            , &file_position, &sample_size, &read_offset ) )
+        return -1;
+    if( buffer_size < sample_size )
+    {
+        mapi_log( LOG_LV2, "[log] buffer is too small.  size:%u  required:%u\n", buffer_size, sample_size );
+        return -1;
+    }
+    void *cursor = acquire_sample_cursor( info );
+    if( !cursor )
+        return -1;
+    int result = info->parser->get_sample_data( cursor, sample_type, stream_number
+                                              , file_position, sample_size, read_offset
+                                              , buffer, dst_read_size, get_mode );
+    recycle_sample_cursor( info, cursor );
+    return result;
+}
+
+static int compare_sample_read_position( const void *a, const void *b )
+{
+    const sample_read_info_t *info_a = (const sample_read_info_t *)a;
+    const sample_read_info_t *info_b = (const sample_read_info_t *)b;
+    if( info_a->position != info_b->position )
+        return (info_a->position < info_b->position) ? -1 : 1;
+    return (info_a->sample_index < info_b->sample_index) ? -1 : (info_a->sample_index > info_b->sample_index);
+}
+
+MAPI_EXPORT int mpeg_api_get_sample_range
+(
+    void                       *ih,
+    mpeg_sample_type            sample_type,
+    uint8_t                     stream_number,
+    uint32_t                    start_number,
+    uint32_t                    sample_num,
+    uint8_t                   **dst_buffer,
+    sample_span_t              *dst_samples,
+    get_sample_data_mode        get_mode
+)
+{
+    mpeg_api_info_t *info = get_api_info( ih );
+    if( !info || !info->parser_info || !dst_buffer || !dst_samples || !sample_num )
+        return -1;
+    if( (uint64_t)start_number + sample_num > UINT32_MAX )
+        return -1;
+    sample_buffer_pool_t *pool = &(info->buffer_pool);
+    uint32_t read_info_size = sizeof(sample_read_info_t) * sample_num;
+    if( read_info_size / sizeof(sample_read_info_t) != sample_num )
+        return -1;
+    sample_read_info_t *read_info = (sample_read_info_t *)acquire_sample_buffer( pool, read_info_size );
+    if( !read_info )
+        return -1;
+    uint8_t *buffer = NULL;
+    /* collect the byte ranges of the samples. */
+    int sorted = 1;
+    for( uint32_t i = 0; i < sample_num; ++i )
+    {
+        sample_read_info_t *r = &(read_info[i]);
+        if( get_sample_read_info( info, sample_type, stream_number, start_number + i, get_mode
+                                , &(r->position), &(r->sample_size), &(r->read_offset) ) )
+            goto fail_get_range;
+        r->read_size     = 0;
+        r->sample_index  = i;
+        r->next_position = -1;
+        if( i && r->position < read_info[i - 1].position )
+            sorted = 0;
+    }
+    /* find the first later sample which starts after each sample, samples can share a start. */
+    int64_t next_position = -1;
+    for( uint32_t number = start_number + sample_num; number < UINT32_MAX; ++number )
+    {
+        int64_t  position;
+        uint32_t size;
+        int32_t  offset;
+        if( get_sample_read_info( info, sample_type, stream_number, number, get_mode, &position, &size, &offset ) )
+            break;
+        if( position > read_info[sample_num - 1].position )
+        {
+            next_position = position;
+            break;
+        }
+        if( position < read_info[sample_num - 1].position )
+            break;
+    }
+    for( uint32_t i = sample_num; i; --i )
+    {
+        sample_read_info_t *r = &(read_info[i - 1]);
+        if( next_position > r->position )
+            r->next_position = next_position;
+        if( i > 1 && r->position > read_info[i - 2].position )
+            next_position = r->position;
+        else if( i > 1 && r->position < read_info[i - 2].position )
+            next_position = -1;
+    }
+    if( !sorted )
+        qsort( read_info, sample_num, sizeof(sample_read_info_t), compare_sample_read_position );
+    /* lay out the samples in file order. */
+    uint64_t total_size = 0;
+    for( uint32_t i = 0; i < sample_num; ++i )
+    {
+        read_info[i].buffer_offset = (uint32_t)total_size;
+        total_size += read_info[i].sample_size;
+        if( total_size > UINT32_MAX )
+            goto fail_get_range;
+    }
+    buffer = acquire_sample_buffer( pool, (uint32_t)total_size );
+    if( !buffer )
+        goto fail_get_range;
+    /* read all samples in one forward sweep. */
+    void *cursor = acquire_sample_cursor( info );
+    if( !cursor )
+        goto fail_get_range;
+    int result = info->parser->get_sample_range_data( cursor, sample_type, stream_number
+                                                    , read_info, sample_num, buffer, get_mode );
+    recycle_sample_cursor( info, cursor );
+    if( result )
+        goto fail_get_range;
+    for( uint32_t i = 0; i < sample_num; ++i )
+    {
+        sample_span_t *sample = &(dst_samples[read_info[i].sample_index]);
+        sample->data = buffer + read_info[i].buffer_offset;
+        sample->size = read_info[i].read_size;
+    }
+    recycle_sample_buffer( pool, (uint8_t *)read_info );
+    *dst_buffer = buffer;
+    return 0;
+fail_get_range:
+    if( buffer )
+        recycle_sample_buffer( pool, buffer );
+    recycle_sample_buffer( pool, (uint8_t *)read_info );
+    return -1;
+}
+
+MAPI_EXPORT int mpeg_api_get_sample_spans
+(
+    void                       *ih,
+    mpeg_sample_type            sample_type,
+    uint8_t                     stream_number,
+    uint32_t                    sample_number,
+    sample_span_t             **dst_spans,
+    uint32_t                   *dst_span_num,
+    get_sample_data_mode        get_mode
+)
+{
+    mpeg_api_info_t *info = get_api_info( ih );
+    if( !info || !info->parser_info || !dst_spans || !dst_span_num )
+        return -1;
+    /* the spans would point into the reader cache of a pooled cursor. */
+    if( info->cursor_pool.mutex )
+        return -1;
+    /* get sample data spans. */
+    int64_t  file_position;
+    uint32_t sample_size;
+    int32_t  read_offset;
+    if( get_sample_read_info( info, sample_type, stream_number, sample_number, get_mode
+                            , &file_position, &sample_size, &read_offset ) )
         return -1;
-    return parser->get_sample_data( parser_info, sample_type, stream_number
-                                  , file_position, sample_size, read_offset
-                                  , dst_buffer, dst_read_size, get_mode );
+    return info->parser->get_sample_spans( info->parser_info, sample_type, stream_number
+                                         , file_position, sample_size, read_offset
+                                         , dst_spans, dst_span_num, get_mode );
+}
+
+MAPI_EXPORT uint32_t mpeg_api_copy_sample_spans
+(
+    sample_span_t              *spans,
+    uint32_t                    span_num,
+    uint8_t                    *dst_buffer,
+    uint32_t                    dst_buffer_size
+)
+{
+    if( !spans || !dst_buffer )
+        return 0;
+    uint32_t copy_size = 0;
+    for( uint32_t i = 0; i < span_num && copy_size < dst_buffer_size; ++i )
+    {
+        uint32_t size = spans[i].size;
+        if( size > dst_buffer_size - copy_size )
+            size = dst_buffer_size - copy_size;
+        memcpy( dst_buffer + copy_size, spans[i].data, size );
+        copy_size += size;
+    }
+    return copy_size;
 }
 
 MAPI_EXPORT int mpeg_api_free_sample_buffer( void *ih, uint8_t **buffer )
 {
-    mpeg_api_info_t *info = (mpeg_api_info_t *)ih;
-    if( !info || !info->parser_info || !buffer )
+    mpeg_api_info_t *info = get_api_info( ih );
+    if( !info || !buffer )
         return -1;
-    info->parser->free_sample_buffer( buffer );
+    if( *buffer )
+        recycle_sample_buffer( &(info->buffer_pool), *buffer );
+    *buffer = NULL;
     return 0;
 }
 
+MAPI_EXPORT int mpeg_api_set_shared_access( void *ih, int enable )
+{
+    mpeg_api_info_t *info = get_api_info( ih );
+    if( !info || !info->parser_info )
+        return -1;
+    if( !enable )
+    {
+        release_cursor_pool( info );
+        return 0;
+    }
+    if( info->cursor_pool.mutex )
+        return 0;
+    info->cursor_pool.mutex = thread_mutex_create();
+    return info->cursor_pool.mutex ? 0 : -1;
+}
+
+MAPI_EXPORT void mpeg_api_stop_prefetch( void *ih )
+{
+    mpeg_api_info_t *info = get_api_info( ih );
+    if( !info || !info->prefetch )
+        return;
+    prefetch_ctx_t *prefetch = info->prefetch;
+    if( prefetch->thread )
+    {
+        thread_mutex_lock( prefetch->mutex );
+        prefetch->quit = 1;
+        thread_cond_broadcast( prefetch->cond );
+        thread_mutex_unlock( prefetch->mutex );
+        thread_wait_end( prefetch->thread, NULL );
+    }
+    for( uint32_t i = 0; i < prefetch->slot_num; ++i )
+        if( prefetch->slot[i].buffer )
+            recycle_sample_buffer( &(info->buffer_pool), prefetch->slot[i].buffer );
+    if( prefetch->cursor )
+        info->parser->release_cursor( prefetch->cursor );
+    if( prefetch->cond )
+        thread_cond_release( prefetch->cond );
+    if( prefetch->mutex )
+        thread_mutex_release( prefetch->mutex );
+    free( prefetch );
+    info->prefetch = NULL;
+}
+
+MAPI_EXPORT int mpeg_api_start_prefetch
+(
+    void                       *ih,
+    mpeg_sample_type            sample_type,
+    uint8_t                     stream_number,
+    uint32_t                    prefetch_num,
+    get_sample_data_mode        get_mode
+)
+{
+    mpeg_api_info_t *info = get_api_info( ih );
+    if( !info || !info->parser_info || !prefetch_num )
+        return -1;
+    mpeg_api_stop_prefetch( info );
+    uint32_t sample_num = mpeg_api_get_sample_num( info, sample_type, stream_number );
+    if( !sample_num )
+        return -1;
+    prefetch_ctx_t *prefetch = (prefetch_ctx_t *)malloc( sizeof(prefetch_ctx_t) );
+    if( !prefetch )
+        return -1;
+    memset( prefetch, 0, sizeof(prefetch_ctx_t) );
+    prefetch->sample_type   = sample_type;
+    prefetch->stream_number = stream_number;
+    prefetch->get_mode      = get_mode;
+    prefetch->sample_num    = sample_num;
+    prefetch->next_number   = -1;
+    prefetch->slot_num      = (prefetch_num < PREFETCH_SAMPLE_NUM_MAX) ? prefetch_num : PREFETCH_SAMPLE_NUM_MAX;
+    prefetch->mutex         = thread_mutex_create();
+    prefetch->cond          = thread_cond_create();
+    prefetch->cursor        = info->parser->create_cursor( info->parser_info );
+    info->prefetch = prefetch;
+    if( !prefetch->mutex || !prefetch->cond || !prefetch->cursor )
+        goto fail_start_prefetch;
+    prefetch->thread = thread_create( prefetch_sample, info );
+    if( !prefetch->thread )
+        goto fail_start_prefetch;
+    mapi_log( LOG_LV2, "[log] prefetch start.  stream:%u  slot_num:%u\n", stream_number, prefetch->slot_num );
+    return 0;
+fail_start_prefetch:
+    mpeg_api_stop_prefetch( info );
+    return -1;
+}
+
 MAPI_EXPORT int mpeg_api_get_pcr( void *ih, pcr_info_t *pcr_info, uint16_t service_id )
 {
-    mpeg_api_info_t *info = (mpeg_api_info_t *)ih;
+    mpeg_api_info_t *info = get_api_info( ih );
     if( !info || !info->parser_info )
         return -1;
     return info->parser->get_pcr( info->parser_info, pcr_info, service_id );
 }
 
+MAPI_EXPORT int mpeg_api_get_arrival_time_index
+(
+    void                       *ih,
+    uint32_t                    packet_interval,
+    arrival_time_info_t       **dst_index,
+    uint32_t                   *dst_index_num
+)
+{
+    mpeg_api_info_t *info = get_api_info( ih );
+    if( !info || !info->parser_info || !dst_index || !dst_index_num )
+        return -1;
+    /* the index is owned by the parser and valid until the next call. */
+    return info->parser->get_arrival_time_index( info->parser_info, packet_interval, dst_index, dst_index_num );
+}
+
+MAPI_EXPORT int mpeg_api_scan_pcr
+(
+    void                       *ih,
+    uint16_t                    service_id,
+    pcr_scan_data_t           **dst_data,
+    uint32_t                   *dst_data_num,
+    pcr_scan_stats_t           *stats
+)
+{
+    mpeg_api_info_t *info = get_api_info( ih );
+    if( !info || !info->parser_info )
+        return -1;
+    /* the data is owned by the parser and valid until the next call. */
+    return info->parser->scan_pcr( info->parser_info, service_id, dst_data, dst_data_num, stats );
+}
+
+MAPI_EXPORT int mpeg_api_get_packet_stats( void *ih, packet_stats_t *stats )
+{
+    mpeg_api_info_t *info = get_api_info( ih );
+    if( !info || !info->parser_info || !stats )
+        return -1;
+    /* the PID list is owned by the parser and valid until the next call. */
+    return info->parser->get_packet_stats( info->parser_info, stats );
+}
+
+MAPI_EXPORT int mpeg_api_get_stats( void *ih, perf_stats_t *stats )
+{
+    mpeg_api_info_t *info = get_api_info( ih );
+    if( !info || !stats )
+        return -1;
+    uint64_t counter[MAPI_STATS_COUNTER_NUM];
+    mapi_stats_collect( info->stats, counter );
+    stats->read_bytes        = counter[MAPI_STATS_READ_BYTES       ];
+    stats->read_calls        = counter[MAPI_STATS_READ_CALLS       ];
+    stats->seek_calls        = counter[MAPI_STATS_SEEK_CALLS       ];
+    stats->cache_hits        = counter[MAPI_STATS_CACHE_HITS       ];
+    stats->cache_misses      = counter[MAPI_STATS_CACHE_MISSES     ];
+    stats->packets_scanned   = counter[MAPI_STATS_PACKETS_SCANNED  ];
+    stats->packets_delivered = counter[MAPI_STATS_PACKETS_DELIVERED];
+    stats->pes_assembled     = counter[MAPI_STATS_PES_ASSEMBLED    ];
+    stats->sample_allocs     = counter[MAPI_STATS_SAMPLE_ALLOCS    ];
+    return 0;
+}
+
+MAPI_EXPORT int mpeg_api_scan_bitrate
+(
+    void                       *ih,
+    uint16_t                    service_id,
+    uint32_t                    bucket_msec,
+    bitrate_histogram_t        *histogram
+)
+{
+    mpeg_api_info_t *info = get_api_info( ih );
+    if( !info || !info->parser_info || !bucket_msec || !histogram )
+        return -1;
+    /* the PID list and buckets are owned by the parser and valid until the next call. */
+    return info->parser->scan_bitrate( info->parser_info, service_id, bucket_msec, histogram );
+}
+
 MAPI_EXPORT int mpeg_api_get_video_frame( void *ih, uint8_t stream_number, stream_info_t *stream_info )
 {
-    mpeg_api_info_t *info = (mpeg_api_info_t *)ih;
+    mpeg_api_info_t *info = get_api_info( ih );
     if( !info || !info->parser_info )
         return -1;
     mpeg_parser_t *parser      = info->parser;
@@ -890,6 +2004,7 @@ MAPI_EXPORT int mpeg_api_get_video_frame( void *ih, uint8_t stream_number, strea
     stream_info->sample_size          = video_sample_info.sample_size;
     stream_info->raw_data_size        = video_sample_info.raw_data_size;
     stream_info->au_size              = video_sample_info.au_size;
+    stream_info->arrival_time         = video_sample_info.arrival_time;
     stream_info->video_pts            = video_sample_info.pts;
     stream_info->video_dts            = video_sample_info.dts;
     stream_info->video_program_id     = video_sample_info.program_id;
@@ -907,7 +2022,7 @@ MAPI_EXPORT int mpeg_api_get_video_frame( void *ih, uint8_t stream_number, strea
 
 MAPI_EXPORT int mpeg_api_get_audio_frame( void *ih, uint8_t stream_number, stream_info_t *stream_info )
 {
-    mpeg_api_info_t *info = (mpeg_api_info_t *)ih;
+    mpeg_api_info_t *info = get_api_info( ih );
     if( !info || !info->parser_info )
         return -1;
     mpeg_parser_t *parser      = info->parser;
@@ -921,6 +2036,7 @@ MAPI_EXPORT int mpeg_api_get_audio_frame( void *ih, uint8_t stream_number, strea
     stream_info->sample_size        = audio_sample_info.sample_size;
     stream_info->raw_data_size      = audio_sample_info.raw_data_size;
     stream_info->au_size            = audio_sample_info.au_size;
+    stream_info->arrival_time       = audio_sample_info.arrival_time;
     stream_info->audio_pts          = audio_sample_info.pts;
     stream_info->audio_dts          = audio_sample_info.dts;
     stream_info->audio_program_id   = audio_sample_info.program_id;
@@ -934,7 +2050,7 @@ MAPI_EXPORT int mpeg_api_get_audio_frame( void *ih, uint8_t stream_number, strea
 
 MAPI_EXPORT int mpeg_api_parse( void *ih )
 {
-    mpeg_api_info_t *info = (mpeg_api_info_t *)ih;
+    mpeg_api_info_t *info = get_api_info( ih );
     if( !info || !info->parser_info )
         return -1;
     return info->parser->parse( info->parser_info );
@@ -949,7 +2065,7 @@ MAPI_EXPORT int mpeg_api_get_stream_parse_info
     uint16_t                    service_id
 )
 {
-    mpeg_api_info_t *info = (mpeg_api_info_t *)ih;
+    mpeg_api_info_t *info = get_api_info( ih );
     if( !info || !info->parser_info )
         return -1;
     mpeg_parser_t *parser      = info->parser;
@@ -1005,7 +2121,7 @@ MAPI_EXPORT int mpeg_api_get_stream_parse_info
 
 MAPI_EXPORT int mpeg_api_set_pmt_target( void *ih, pmt_target_type pmt_target )
 {
-    mpeg_api_info_t *info = (mpeg_api_info_t *)ih;
+    mpeg_api_info_t *info = get_api_info( ih );
     if( !info || !info->parser_info )
         return -1;
     info->parser->set_program_target( info->parser_info, pmt_target );
@@ -1014,7 +2130,7 @@ MAPI_EXPORT int mpeg_api_set_pmt_target( void *ih, pmt_target_type pmt_target )
 
 MAPI_EXPORT int mpeg_api_set_pmt_program_id( void *ih, uint16_t pmt_program_id )
 {
-    mpeg_api_info_t *info = (mpeg_api_info_t *)ih;
+    mpeg_api_info_t *info = get_api_info( ih );
     if( !info || !info->parser_info )
         return -1;
     return info->parser->set_program_id( info->parser_info, PID_TYPE_PMT, pmt_program_id );
@@ -1022,7 +2138,7 @@ MAPI_EXPORT int mpeg_api_set_pmt_program_id( void *ih, uint16_t pmt_program_id )
 
 MAPI_EXPORT int mpeg_api_set_service_id( void *ih, uint16_t service_id )
 {
-    mpeg_api_info_t *info = (mpeg_api_info_t *)ih;
+    mpeg_api_info_t *info = get_api_info( ih );
     if( !info || !info->parser_info )
         return -1;
     return info->parser->set_service_id( info->parser_info, service_id );
@@ -1030,7 +2146,7 @@ MAPI_EXPORT int mpeg_api_set_service_id( void *ih, uint16_t service_id )
 
 MAPI_EXPORT int mpeg_api_get_service_id_num( void *ih )
 {
-    mpeg_api_info_t *info = (mpeg_api_info_t *)ih;
+    mpeg_api_info_t *info = get_api_info( ih );
     if( !info || !info->parser_info )
         return -1;
     return info->parser->get_service_id_num( info->parser_info );
@@ -1038,7 +2154,7 @@ MAPI_EXPORT int mpeg_api_get_service_id_num( void *ih )
 
 MAPI_EXPORT int mpeg_api_set_service_id_info( void *ih, service_id_info_t *sid_info, int32_t sid_info_num )
 {
-    mpeg_api_info_t *info = (mpeg_api_info_t *)ih;
+    mpeg_api_info_t *info = get_api_info( ih );
     if( !info || !info->parser_info )
         return -1;
     return info->parser->set_service_id_info( info->parser_info, sid_info, sid_info_num );
@@ -1046,7 +2162,7 @@ MAPI_EXPORT int mpeg_api_set_service_id_info( void *ih, service_id_info_t *sid_i
 
 MAPI_EXPORT int mpeg_api_get_service_id_info( void *ih, service_id_info_t *sid_info, int32_t sid_info_num )
 {
-    mpeg_api_info_t *info = (mpeg_api_info_t *)ih;
+    mpeg_api_info_t *info = get_api_info( ih );
     if( !info || !info->parser_info )
         return -1;
     return info->parser->get_service_id_info( info->parser_info, sid_info, sid_info_num );
@@ -1054,7 +2170,7 @@ MAPI_EXPORT int mpeg_api_get_service_id_info( void *ih, service_id_info_t *sid_i
 
 MAPI_EXPORT uint16_t mpeg_api_get_program_id( void *ih, mpeg_sample_type sample_type, uint8_t stream_no, uint16_t service_id )
 {
-    mpeg_api_info_t *info = (mpeg_api_info_t *)ih;
+    mpeg_api_info_t *info = get_api_info( ih );
     if( !info || !info->parser_info )
         return -1;
     return info->parser->get_program_id( info->parser_info, sample_type, stream_no, service_id );
@@ -1062,9 +2178,13 @@ MAPI_EXPORT uint16_t mpeg_api_get_program_id( void *ih, mpeg_sample_type sample_
 
 MAPI_EXPORT void *mpeg_api_initialize_info( const char *mpeg, int64_t buffer_size )
 {
+    mapi_log_sink_bind( NULL );
     mpeg_api_info_t *info = (mpeg_api_info_t *)malloc( sizeof(mpeg_api_info_t) );
     if( !info )
         return NULL;
+    /* count from the first parsing. */
+    mapi_stats_set_t *stats = mapi_stats_create();
+    mapi_stats_bind( stats );
     mpeg_parser_t *parser      = NULL;
     void          *parser_info = NULL;
     static mpeg_parser_t *parsers[MPEG_PARSER_NUM + 1] =
@@ -1092,10 +2212,19 @@ MAPI_EXPORT void *mpeg_api_initialize_info( const char *mpeg, int64_t buffer_siz
     info->parser_info         = parser_info;
     info->wrap_around_check_v = TIMESTAMP_WRAP_AROUND_CHECK_VALUE;
     info->file_size           = file_size;
+    info->stats               = stats;
+    info->buffer_pool.mutex   = thread_mutex_create();
+    if( !info->buffer_pool.mutex )
+    {
+        parser->release( parser_info );
+        parser_info = NULL;
+        goto fail_initialize;
+    }
     return info;
 fail_initialize:
     if( parser_info )
         free( parser_info );
+    mapi_stats_release( stats );
     if( info )
         free( info );
     return NULL;
@@ -1103,9 +2232,11 @@ fail_initialize:
 
 MAPI_EXPORT void mpeg_api_release_info( void *ih )
 {
-    mpeg_api_info_t *info = (mpeg_api_info_t *)ih;
+    mpeg_api_info_t *info = get_api_info( ih );
     if( !info )
         return;
+    mpeg_api_stop_prefetch( info );
+    release_cursor_pool( info );
     if( info->parser_info )
         info->parser->release( info->parser_info );
     if( info->sample_list.video_stream )
@@ -1130,5 +2261,51 @@ MAPI_EXPORT void mpeg_api_release_info( void *ih )
         }
         free( info->sample_list.audio_stream );
     }
+    release_sample_buffer_pool( &(info->buffer_pool) );
+    mapi_log_sink_release( info->log_sink );
+    for( uint32_t i = 0; i < info->closed_sink_num; ++i )
+        mapi_log_sink_release( info->closed_sink[i] );
+    if( info->closed_sink )
+        free( info->closed_sink );
+    mapi_stats_release( info->stats );
     free( info );
 }
+
+MAPI_EXPORT int mpeg_api_setup_log_sink
+(
+    void                       *ih,
+    log_level                   level,
+    FILE                       *output,
+    mapi_log_cb_t               callback,
+    void                       *cb_params
+)
+{
+    mpeg_api_info_t *info = get_api_info( ih );
+    if( !info )
+        return -1;
+    /* the other threads of the handle may still hold the old sink, so keep it until the release. */
+    if( info->log_sink )
+    {
+        mapi_log_sink_t **list = (mapi_log_sink_t **)realloc( info->closed_sink, sizeof(mapi_log_sink_t *) * (info->closed_sink_num + 1) );
+        if( !list )
+            return -1;
+        info->closed_sink = list;
+    }
+    /* replace the sink, or go back to the global setting without output and callback. */
+    mapi_log_sink_t *sink = NULL;
+    if( output || callback )
+    {
+        sink = mapi_log_sink_create( level, output, callback, cb_params );
+        if( !sink )
+            return -1;
+    }
+    mapi_log_sink_t *old_sink = __atomic_exchange_n( &(info->log_sink), sink, __ATOMIC_ACQ_REL );
+    mapi_log_sink_bind( sink );
+    if( old_sink )
+    {
+        /* deliver the logs so far, and drop the later ones. */
+        mapi_log_sink_close( old_sink );
+        info->closed_sink[info->closed_sink_num++] = old_sink;
+    }
+    return 0;
+}
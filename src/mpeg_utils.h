@@ -33,12 +33,19 @@
 
 #include "mpeg_common.h"
 
+typedef struct {
+    int                     active;
+    int64_t                 position;
+    int64_t                 total;
+} progress_info_t;
+
 typedef struct {
     int64_t                 file_position;
     uint32_t                sample_size;
     uint32_t                raw_data_size;
     uint32_t                au_size;
     int64_t                 pcr;
+    int64_t                 arrival_time;
     /* video. */
     int64_t                 video_pts;
     int64_t                 video_dts;
@@ -69,6 +76,9 @@ extern "C" {
 
 MAPI_EXPORT int mpeg_api_create_sample_list( void *ih );
 
+/* the progress of mpeg_api_create_sample_list(), polled from any thread. */
+MAPI_EXPORT int mpeg_api_get_progress( void *ih, progress_info_t *progress );
+
 MAPI_EXPORT int64_t mpeg_api_get_sample_position( void *ih, mpeg_sample_type sample_type, uint8_t stream_number );
 
 MAPI_EXPORT int mpeg_api_set_sample_position
@@ -131,6 +141,17 @@ MAPI_EXPORT mpeg_stream_type mpeg_api_get_sample_stream_type
     uint8_t                     stream_number
 );
 
+MAPI_EXPORT int mpeg_api_get_audio_frames
+(
+    void                       *ih,
+    uint8_t                     stream_number,
+    uint8_t                    *buffer,
+    uint32_t                    buffer_size,
+    audio_frame_t              *dst_frames,
+    uint32_t                    frame_num_max,
+    uint32_t                   *dst_frame_num
+);
+
 MAPI_EXPORT uint32_t mpeg_api_get_sample_num
 (
     void                       *ih,
@@ -158,10 +179,96 @@ MAPI_EXPORT int mpeg_api_get_sample_data
     get_sample_data_mode        get_mode
 );
 
+MAPI_EXPORT int mpeg_api_read_sample_data
+(
+    void                       *ih,
+    mpeg_sample_type            sample_type,
+    uint8_t                     stream_number,
+    uint32_t                    sample_number,
+    uint8_t                    *buffer,
+    uint32_t                    buffer_size,
+    uint32_t                   *dst_read_size,
+    get_sample_data_mode        get_mode
+);
+
+MAPI_EXPORT int mpeg_api_get_sample_range
+(
+    void                       *ih,
+    mpeg_sample_type            sample_type,
+    uint8_t                     stream_number,
+    uint32_t                    start_number,
+    uint32_t                    sample_num,
+    uint8_t                   **dst_buffer,
+    sample_span_t              *dst_samples,
+    get_sample_data_mode        get_mode
+);
+
+MAPI_EXPORT int mpeg_api_get_sample_spans
+(
+    void                       *ih,
+    mpeg_sample_type            sample_type,
+    uint8_t                     stream_number,
+    uint32_t                    sample_number,
+    sample_span_t             **dst_spans,
+    uint32_t                   *dst_span_num,
+    get_sample_data_mode        get_mode
+);
+
+MAPI_EXPORT uint32_t mpeg_api_copy_sample_spans
+(
+    sample_span_t              *spans,
+    uint32_t                    span_num,
+    uint8_t                    *dst_buffer,
+    uint32_t                    dst_buffer_size
+);
+
 MAPI_EXPORT int mpeg_api_free_sample_buffer( void *ih, uint8_t **buffer );
 
+MAPI_EXPORT int mpeg_api_set_shared_access( void *ih, int enable );
+
+MAPI_EXPORT int mpeg_api_start_prefetch
+(
+    void                       *ih,
+    mpeg_sample_type            sample_type,
+    uint8_t                     stream_number,
+    uint32_t                    prefetch_num,
+    get_sample_data_mode        get_mode
+);
+
+MAPI_EXPORT void mpeg_api_stop_prefetch( void *ih );
+
 MAPI_EXPORT int mpeg_api_get_pcr( void *ih, pcr_info_t *pcr_info, uint16_t service_id );
 
+MAPI_EXPORT int mpeg_api_get_arrival_time_index
+(
+    void                       *ih,
+    uint32_t                    packet_interval,
+    arrival_time_info_t       **dst_index,
+    uint32_t                   *dst_index_num
+);
+
+MAPI_EXPORT int mpeg_api_scan_pcr
+(
+    void                       *ih,
+    uint16_t                    service_id,
+    pcr_scan_data_t           **dst_data,
+    uint32_t                   *dst_data_num,
+    pcr_scan_stats_t           *stats
+);
+
+MAPI_EXPORT int mpeg_api_get_packet_stats( void *ih, packet_stats_t *stats );
+
+/* the counters of all threads which worked for the handle. */
+MAPI_EXPORT int mpeg_api_get_stats( void *ih, perf_stats_t *stats );
+
+MAPI_EXPORT int mpeg_api_scan_bitrate
+(
+    void                       *ih,
+    uint16_t                    service_id,
+    uint32_t                    bucket_msec,
+    bitrate_histogram_t        *histogram
+);
+
 MAPI_EXPORT int mpeg_api_get_video_frame( void *ih, uint8_t stream_number, stream_info_t *stream_info );
 
 MAPI_EXPORT int mpeg_api_get_audio_frame( void *ih, uint8_t stream_number, stream_info_t *stream_info );
@@ -197,6 +304,26 @@ MAPI_EXPORT void mpeg_api_release_info( void *ih );
 
 MAPI_EXPORT void mpeg_api_setup_log_lv( log_level level, FILE *output );
 
+/* per-handle log: the logs are written to output, or passed to callback, by the delivery thread of the sink, */
+/* not by the thread which logs. at the replacement, the old sink delivers the logs so far and drops the later ones. */
+MAPI_EXPORT int mpeg_api_setup_log_sink
+(
+    void                       *ih,
+    log_level                   level,
+    FILE                       *output,
+    mapi_log_cb_t               callback,
+    void                       *cb_params
+);
+
+/* trace: the spans are written as the Chrome trace JSON at close. */
+MAPI_EXPORT int mpeg_api_trace_open( const char *file_name );
+
+MAPI_EXPORT void mpeg_api_trace_close( void );
+
+MAPI_EXPORT void mpeg_api_trace_begin( const char *name );
+
+MAPI_EXPORT void mpeg_api_trace_end( void );
+
 #ifdef __cplusplus
 }
 #endif
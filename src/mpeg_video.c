@@ -74,6 +74,172 @@ extern int mpeg_video_check_start_code( uint8_t *start_code, mpeg_video_start_co
     return 0;
 }
 
+extern void mpeg_bit_reader_init
+(
+    mpeg_bit_reader_t              *br,
+    uint8_t                        *data,
+    uint32_t                        data_size,
+    mpeg_bit_reader_refill_func     refill,
+    void                           *param
+)
+{
+    br->cache      = 0;
+    br->cache_bits = 0;
+    br->error      = 0;
+    br->data       = data;
+    br->data_end   = data ? data + data_size : NULL;
+    br->read_bits  = 0;
+    br->escape     = 0;
+    br->zero_count = 0;
+    br->refill     = refill;
+    br->param      = param;
+}
+
+static int bit_reader_next_span( mpeg_bit_reader_t *br )
+{
+    do
+    {
+        if( br->error || !br->refill || br->refill( br->param, &(br->data), &(br->data_end) ) )
+        {
+            br->error = 1;
+            return -1;
+        }
+    }
+    while( br->data == br->data_end );
+    return 0;
+}
+
+static inline int bit_reader_fill( mpeg_bit_reader_t *br, int32_t bits )
+{
+    while( br->cache_bits < bits )
+    {
+        if( br->data == br->data_end && bit_reader_next_span( br ) )
+            return -1;
+        /* load the span data as much as the cache can hold. */
+        while( br->cache_bits <= 56 && br->data < br->data_end )
+        {
+            uint8_t byte = *(br->data++);
+            if( br->escape )
+            {
+                /* skip emulation_prevention_three_byte. */
+                if( byte == 0x03 && br->zero_count >= 2 )
+                {
+                    br->zero_count = 0;
+                    continue;
+                }
+                br->zero_count = byte ? 0 : br->zero_count + 1;
+            }
+            br->cache      |= (uint64_t)byte << (56 - br->cache_bits);
+            br->cache_bits += 8;
+            /* load on demand, since the start codes are searched in the raw data. */
+            if( br->escape && br->cache_bits >= bits )
+                break;
+        }
+    }
+    return 0;
+}
+
+extern uint32_t mpeg_bit_reader_show_bits( mpeg_bit_reader_t *br, int32_t bits )
+{
+    /* bits: 1 - 32 */
+    if( bit_reader_fill( br, bits ) )
+        return 0;
+    return (uint32_t)(br->cache >> (64 - bits));
+}
+
+extern uint32_t mpeg_bit_reader_get_bits( mpeg_bit_reader_t *br, int32_t bits )
+{
+    /* bits: 1 - 32 */
+    if( bit_reader_fill( br, bits ) )
+        return 0;
+    uint32_t value = (uint32_t)(br->cache >> (64 - bits));
+    br->cache     <<= bits;
+    br->cache_bits -= bits;
+    br->read_bits  += bits;
+    return value;
+}
+
+extern void mpeg_bit_reader_skip_bits( mpeg_bit_reader_t *br, int64_t bits )
+{
+    for( ; bits > 32; bits -= 32 )
+        mpeg_bit_reader_get_bits( br, 32 );
+    if( bits > 0 )
+        mpeg_bit_reader_get_bits( br, (int32_t)bits );
+}
+
+extern uint32_t mpeg_bit_reader_get_ue( mpeg_bit_reader_t *br )
+{
+    int32_t leading_zero_bits = 0;
+    while( !mpeg_bit_reader_get_bits( br, 1 ) )
+    {
+        if( br->error || ++leading_zero_bits > 31 )
+        {
+            br->error = 1;
+            return 0;
+        }
+    }
+    if( !leading_zero_bits )
+        return 0;
+    return (1U << leading_zero_bits) - 1 + mpeg_bit_reader_get_bits( br, leading_zero_bits );
+}
+
+extern int32_t mpeg_bit_reader_get_se( mpeg_bit_reader_t *br )
+{
+    uint32_t code_num = mpeg_bit_reader_get_ue( br );
+    return (code_num & 0x01) ? (int32_t)((code_num >> 1) + 1) : -(int32_t)(code_num >> 1);
+}
+
+extern void mpeg_bit_reader_byte_align( mpeg_bit_reader_t *br )
+{
+    int32_t bits = br->cache_bits & 0x07;
+    if( bits )
+        mpeg_bit_reader_get_bits( br, bits );
+}
+
+extern int mpeg_bit_reader_next_start_code( mpeg_bit_reader_t *br, uint8_t *start_code )
+{
+    mpeg_bit_reader_byte_align( br );
+    /* check the rest data in the cache. */
+    uint32_t prefix = 0xFFFFFF;
+    while( br->cache_bits )
+    {
+        prefix = ((prefix << 8) | mpeg_bit_reader_get_bits( br, 8 )) & 0xFFFFFF;
+        if( prefix == 0x000001 )
+            goto detect_start_code;
+    }
+    /* search the span data directly. */
+    while( 1 )
+    {
+        if( br->data == br->data_end && bit_reader_next_span( br ) )
+            return -1;
+        uint8_t *data = br->data;
+        int64_t  size = br->data_end - data;
+        uint8_t *p    = memchr( data, 0x01, size );
+        if( !p )
+        {
+            prefix = (size >= 2) ? (prefix << 16) | (data[size - 2] << 8) | data[size - 1]
+                                 : (prefix <<  8) |  data[size - 1];
+            prefix &= 0xFFFFFF;
+            br->read_bits += size * 8;
+            br->data       = br->data_end;
+            continue;
+        }
+        int64_t  offset = p - data;
+        uint32_t zero   = (offset >= 2) ? (uint32_t)((p[-2] << 8) | p[-1])
+                        : (offset == 1) ? ((prefix & 0xFF) << 8) | p[-1]
+                        :                  (prefix & 0xFFFF);
+        br->read_bits += (offset + 1) * 8;
+        br->data       = p + 1;
+        if( !zero )
+            goto detect_start_code;
+        prefix = ((zero & 0xFF) << 8) | 0x01;
+    }
+detect_start_code:
+    br->zero_count = 0;
+    *start_code    = mpeg_bit_reader_get_bits( br, 8 );
+    return br->error ? -1 : 0;
+}
+
 /*
   zig-zag scan order:
      0   1   5   6  14  15  27  28
@@ -119,161 +285,118 @@ static const uint8_t alternate_scan_order_idx[64] = {
 };
 #endif
 
-static int32_t read_sequence_header( uint8_t *data, mpeg_video_sequence_header_t *sequence )
+#define getbits( br, n )        mpeg_bit_reader_get_bits( br, n )
+#define skipbits( br, n )       mpeg_bit_reader_skip_bits( br, n )
+
+static void read_quantiser_matrix( mpeg_bit_reader_t *br, uint8_t load, uint8_t *quantiser_matrix )
 {
-    int32_t check_size = MPEG_VIDEO_SEQUENCE_SECTION_HEADER_SIZE;
-    sequence->horizontal_size             =   (data[0] << 4) | ((data[1] & 0xF0) >> 4);
-    sequence->vertical_size               =  ((data[1] & 0x0F) << 8) | (data[2]);
-    sequence->aspect_ratio_information    =   (data[3] & 0xF0) >> 4;
-    sequence->frame_rate_code             =    data[3] & 0x0F;
-    sequence->bit_rate                    =   (data[4] << 10) | (data[5] << 2) | (data[6] >> 6);
-    /* marker_bit '1'                     = !!(data[6] & 0x20); */
-    sequence->vbv_buffer_size             =  ((data[6] & 0x1F) << 5) | (data[7] >> 3);
-    sequence->constrained_parameters_flag = !!(data[7] & 0x04);
-    sequence->load_intra_quantiser_matrix = !!(data[7] & 0x02);
-    uint8_t *p = &(data[7]);
-    if( sequence->load_intra_quantiser_matrix )
-        for( int i = 0; i < 64; ++i, ++p )
-            sequence->intra_quantiser_matrix[zigzag_scan_order_idx[i]]
-                                          =   (*p & 0x01) << 7 | *(p+1) >> 1;
+    if( load )
+        for( int i = 0; i < 64; ++i )
+            quantiser_matrix[zigzag_scan_order_idx[i]] = getbits( br, 8 );
     else
-    {
-        memset( sequence->intra_quantiser_matrix, 0, 64 );
-        check_size -= 64;
-    }
-    sequence->load_non_intra_quantiser_matrix
-                                          = !!(*p & 0x01);
-    ++p;
-    if( sequence->load_non_intra_quantiser_matrix )
-        for( int i = 0; i < 64; ++i, ++p )
-            sequence->non_intra_quantiser_matrix[zigzag_scan_order_idx[i]]
-                                          =    *p;
-    else
-    {
-        memset( sequence->non_intra_quantiser_matrix, 0, 64 );
-        check_size -= 64;
-    }
-    return check_size;
+        memset( quantiser_matrix, 0, 64 );
 }
 
-static int32_t read_gop_header( uint8_t *data, mpeg_video_gop_header_t *gop )
+static void read_sequence_header( mpeg_bit_reader_t *br, mpeg_video_sequence_header_t *sequence )
 {
-    gop->time_code   = (data[0] << 17) | (data[1] << 9) | (data[2] << 1) | (data[3] >> 7);
-    gop->closed_gop  = !!(data[3] & 0x40);
-    gop->broken_link = !!(data[3] & 0x20);
-    return MPEG_VIDEO_GOP_SECTION_HEADER_SIZE;
+    sequence->horizontal_size                 = getbits( br, 12 );
+    sequence->vertical_size                   = getbits( br, 12 );
+    sequence->aspect_ratio_information        = getbits( br,  4 );
+    sequence->frame_rate_code                 = getbits( br,  4 );
+    sequence->bit_rate                        = getbits( br, 18 );
+    skipbits( br, 1 );                          /* marker_bit '1' */
+    sequence->vbv_buffer_size                 = getbits( br, 10 );
+    sequence->constrained_parameters_flag     = getbits( br,  1 );
+    sequence->load_intra_quantiser_matrix     = getbits( br,  1 );
+    read_quantiser_matrix( br, sequence->load_intra_quantiser_matrix, sequence->intra_quantiser_matrix );
+    sequence->load_non_intra_quantiser_matrix = getbits( br,  1 );
+    read_quantiser_matrix( br, sequence->load_non_intra_quantiser_matrix, sequence->non_intra_quantiser_matrix );
 }
 
-static int32_t read_picture_header( uint8_t *data, mpeg_video_picture_header_t *picture )
+static void read_gop_header( mpeg_bit_reader_t *br, mpeg_video_gop_header_t *gop )
 {
-    int32_t check_size = MPEG_VIDEO_PICTURE_SECTION_HEADER_SIZE;
-    picture->temporal_reference           =  (data[0] << 2) | (data[1] >> 6);
-    picture->picture_coding_type          =  (data[1] & 0x38) >> 3;
-    picture->vbv_delay                    = ((data[1] & 0x07) << 13) | (data[2] << 5) | (data[3] >> 3);
-    uint8_t *p = &(data[3]);
+    gop->time_code   = getbits( br, 25 );
+    gop->closed_gop  = getbits( br,  1 );
+    gop->broken_link = getbits( br,  1 );
+}
+
+static void read_picture_header( mpeg_bit_reader_t *br, mpeg_video_picture_header_t *picture )
+{
+    picture->temporal_reference           = getbits( br, 10 );
+    picture->picture_coding_type          = getbits( br,  3 );
+    picture->vbv_delay                    = getbits( br, 16 );
     if( picture->picture_coding_type == MPEG_VIDEO_P_FRAME || picture->picture_coding_type == MPEG_VIDEO_B_FRAME )
     {
-        picture->full_pel_forward_vector  = !!(*p & 0x04);
-        picture->forward_f_code           =   (*p & 0x03) << 2 | (*(p+1) & 0x80) >> 7;
-        ++p;
+        picture->full_pel_forward_vector  = getbits( br,  1 );
+        picture->forward_f_code           = getbits( br,  3 );
     }
     else
     {
         picture->full_pel_forward_vector  = 0;
         picture->forward_f_code           = 0;
-        --check_size;
     }
     if( picture->picture_coding_type == MPEG_VIDEO_B_FRAME )
     {
-        picture->full_pel_backword_vector = !!(*p & 0x40);
-        picture->backward_f_code          =   (*p & 0x38) >> 3;;
+        picture->full_pel_backword_vector = getbits( br,  1 );
+        picture->backward_f_code          = getbits( br,  3 );
     }
     else
     {
         picture->full_pel_backword_vector = 0;
         picture->backward_f_code          = 0;
     }
-#if 0
-#define get_nextbits( p, mask, flag )       \
-{                                           \
-    flag = !!(*p & mask);                   \
-    if( mask == 0x01 )                      \
-        mask = 0x80;                        \
-    else                                    \
-        mask >>= 1;                         \
-}
-    uint8_t mask = 0x04;
-    int extra_bit_picutre;
-    get_nextbits( p, mask, extra_bit_picutre );
-    int count = 0;
-    while( extra_bit_picutre )
-    {
-        if( mask = 0x80 )
-            ++count;
-        ++count;
-        //uint8_t extra_information_picutre;
-        ++p;            /* 8its skip */
-        get_nextbits( p, mask, extra_bit_picutre );
-    }
-    check_size += count;
-#undef get_nextbits
-#endif
-    return check_size;
 }
 
-static int64_t read_slice_header( /* uint8_t *data, */ mpeg_video_slice_header_t *slice )
+static void read_slice_header( mpeg_bit_reader_t *br, mpeg_video_slice_header_t *slice )
 {
     /* No reading header data. */           // FIXME
+    skipbits( br, MPEG_VIDEO_SLICE_SECTION_HEADER_SIZE * 8 );
     slice->slice_vertical_position_extension = 0;
     slice->priority_breakpoint               = 0;
     slice->quantiser_scale_code              = 0;
     slice->intra_slice                       = 0;
-    return MPEG_VIDEO_SLICE_SECTION_HEADER_SIZE;
 }
 
-static int32_t read_sequence_extension( uint8_t *data, mpeg_video_sequence_extension_t *sequence_ext )
+static void read_sequence_extension( mpeg_bit_reader_t *br, mpeg_video_sequence_extension_t *sequence_ext )
 {
-    sequence_ext->profile_and_level_indication =  ((data[0] & 0x0F) << 4) | (data[1] >> 4);
-    sequence_ext->progressive_sequence         = !!(data[1] & 0x08);
-    sequence_ext->chroma_format                =   (data[1] & 0x06) >> 1;
-    sequence_ext->horizontal_size_extension    =  ((data[1] & 0x01) << 1) | !!(data[2] & 0x80);
-    sequence_ext->vertical_size_extension      =   (data[2] & 0x60) >> 5;
-    sequence_ext->bit_rate_extension           =  ((data[2] & 0x1F) << 7) | ((data[3] & 0xFE) >> 1);
-    /* marker_bit '1'                          = !!(data[3] & 0x01); */
-    sequence_ext->vbv_buffer_size_extension    =    data[4];
-    sequence_ext->low_delay                    = !!(data[5] & 0x80);
-    sequence_ext->frame_rate_extension_n       =   (data[5] & 0x60) >> 5;
-    sequence_ext->frame_rate_extension_d       =   (data[5] & 0x1F);
-    return MPEG_VIDEO_SEQUENCE_EXTENSION_SIZE;
+    skipbits( br, 4 );                          /* extension_start_code_identifier */
+    sequence_ext->profile_and_level_indication = getbits( br,  8 );
+    sequence_ext->progressive_sequence         = getbits( br,  1 );
+    sequence_ext->chroma_format                = getbits( br,  2 );
+    sequence_ext->horizontal_size_extension    = getbits( br,  2 );
+    sequence_ext->vertical_size_extension      = getbits( br,  2 );
+    sequence_ext->bit_rate_extension           = getbits( br, 12 );
+    skipbits( br, 1 );                          /* marker_bit '1' */
+    sequence_ext->vbv_buffer_size_extension    = getbits( br,  8 );
+    sequence_ext->low_delay                    = getbits( br,  1 );
+    sequence_ext->frame_rate_extension_n       = getbits( br,  2 );
+    sequence_ext->frame_rate_extension_d       = getbits( br,  5 );
 }
 
-static int32_t read_sequence_display_extension
+static void read_sequence_display_extension
 (
-    uint8_t                                    *data,
+    mpeg_bit_reader_t                          *br,
     mpeg_video_sequence_display_extension_t    *sequence_display_ext
 )
 {
-    int32_t check_size = MPEG_VIDEO_SEQUENCE_DISPLAY_EXTENSION_SIZE;
-    sequence_display_ext->video_format                 =   (data[0] & 0x0E) >> 1;
-    sequence_display_ext->colour_description           = !!(data[0] & 0x01);
-    uint8_t *p = &(data[1]);
+    skipbits( br, 4 );                          /* extension_start_code_identifier */
+    sequence_display_ext->video_format                 = getbits( br,  3 );
+    sequence_display_ext->colour_description           = getbits( br,  1 );
     if( sequence_display_ext->colour_description )
     {
-        sequence_display_ext->colour_primaries         =   *p++;
-        sequence_display_ext->transfer_characteristics =   *p++;
-        sequence_display_ext->matrix_coefficients      =   *p++;
+        sequence_display_ext->colour_primaries         = getbits( br,  8 );
+        sequence_display_ext->transfer_characteristics = getbits( br,  8 );
+        sequence_display_ext->matrix_coefficients      = getbits( br,  8 );
     }
     else
     {
         sequence_display_ext->colour_primaries         = 0;
         sequence_display_ext->transfer_characteristics = 0;
         sequence_display_ext->matrix_coefficients      = 0;
-        check_size -= 3;
     }
-    sequence_display_ext->display_horizontal_size      =   (p[0] << 6) | (p[1] >> 2);
-    /* marker_bit '1'                                  = !!(p[1] & 0x02); */
-    sequence_display_ext->display_vertical_size        =  ((p[1] & 0x01) << 13) | (p[2] << 5) | (p[3] >> 3);
-    return check_size;
+    sequence_display_ext->display_horizontal_size      = getbits( br, 14 );
+    skipbits( br, 1 );                          /* marker_bit '1' */
+    sequence_display_ext->display_vertical_size        = getbits( br, 14 );
 }
 
 typedef enum {
@@ -283,75 +406,65 @@ typedef enum {
     temporal_scalability = 0x03
 } scalable_mode;
 
-static int32_t read_sequence_scalable_extension
+static void read_sequence_scalable_extension
 (
-    uint8_t                                    *data,
+    mpeg_bit_reader_t                          *br,
     mpeg_video_sequence_scalable_extension_t   *sequence_scalable_ext
 )
 {
-    int32_t check_size = MPEG_VIDEO_SEQUENCE_SCALABLE_EXTENSION_SIZE;
-    sequence_scalable_ext->scalable_mode                              =    data[0] & 0x0C >> 2;
-    sequence_scalable_ext->layer_id                                   =   (data[0] & 0x03) << 2 | ((data[1] & 0xC0) >> 6);
+    skipbits( br, 4 );                          /* extension_start_code_identifier */
+    sequence_scalable_ext->scalable_mode                              = getbits( br,  2 );
+    sequence_scalable_ext->layer_id                                   = getbits( br,  4 );
     if( sequence_scalable_ext->scalable_mode == spatial_scalability )
     {
-        sequence_scalable_ext->lower_layer_prediction_horizontal_size =  ((data[1] & 0x3F) << 8) | data[2];
-        /* marker_bit '1'                                             = !!(data[3] & 0x80); */
-        sequence_scalable_ext->lower_layer_prediction_vertical_size   =  ((data[3] & 0x7F) << 7) | (data[4] >> 1);
-        sequence_scalable_ext->horizontal_subsampling_factor_m        =  ((data[4] & 0x01) << 4) | (data[5] >> 4);
-        sequence_scalable_ext->horizontal_subsampling_factor_n        =  ((data[4] & 0x0F) << 1) | !!(data[5] & 0x80);
-        sequence_scalable_ext->vertical_subsampling_factor_m          =   (data[5] & 0x7C) >> 2;
-        sequence_scalable_ext->vertical_subsampling_factor_n          =  ((data[5] & 0x03) << 3) | (data[6] >> 5);
+        sequence_scalable_ext->lower_layer_prediction_horizontal_size = getbits( br, 14 );
+        skipbits( br, 1 );                      /* marker_bit '1' */
+        sequence_scalable_ext->lower_layer_prediction_vertical_size   = getbits( br, 14 );
+        sequence_scalable_ext->horizontal_subsampling_factor_m        = getbits( br,  5 );
+        sequence_scalable_ext->horizontal_subsampling_factor_n        = getbits( br,  5 );
+        sequence_scalable_ext->vertical_subsampling_factor_m          = getbits( br,  5 );
+        sequence_scalable_ext->vertical_subsampling_factor_n          = getbits( br,  5 );
     }
     else if( sequence_scalable_ext->scalable_mode == temporal_scalability )
     {
-        sequence_scalable_ext->picture_mux_enable                     = !!(data[1] & 0x20);
-        if( sequence_scalable_ext->picture_mux_enable )
-        {
-            sequence_scalable_ext->mux_to_progressive_sequence        = !!(data[1] & 0x10);
-            sequence_scalable_ext->picture_mux_order                  =   (data[1] & 0x0E) >> 1;
-            sequence_scalable_ext->picture_mux_factor                 =  ((data[1] & 0x01) << 2) | ((data[2] & 0xC0) >> 6);
-        }
-        else
-        {
-            sequence_scalable_ext->mux_to_progressive_sequence        = 0;
-            sequence_scalable_ext->picture_mux_order                  =   (data[1] & 0x1C) >> 2;
-            sequence_scalable_ext->picture_mux_factor                 =  ((data[1] & 0x03) << 1) | !!(data[2] & 0x80);
-        }
-        check_size = 3;
+        sequence_scalable_ext->picture_mux_enable                     = getbits( br,  1 );
+        sequence_scalable_ext->mux_to_progressive_sequence            = sequence_scalable_ext->picture_mux_enable
+                                                                      ? getbits( br,  1 ) : 0;
+        sequence_scalable_ext->picture_mux_order                      = getbits( br,  3 );
+        sequence_scalable_ext->picture_mux_factor                     = getbits( br,  3 );
     }
-    return check_size;
 }
 
-static int32_t read_picture_coding_extension
+static void read_picture_coding_extension
 (
-    uint8_t                                *data,
+    mpeg_bit_reader_t                      *br,
     mpeg_video_picture_coding_extension_t  *picture_coding_ext
 )
 {
-    int32_t check_size = MPEG_VIDEO_PICTURE_CODING_EXTENSION_SIZE;
-    picture_coding_ext->f_code[0].horizontal       =    data[0] & 0x0F;
-    picture_coding_ext->f_code[0].vertical         =   (data[1] & 0xF0) >> 4;
-    picture_coding_ext->f_code[1].horizontal       =    data[1] & 0x0F;
-    picture_coding_ext->f_code[1].vertical         =   (data[2] & 0xF0) >> 4;
-    picture_coding_ext->intra_dc_precision         =   (data[2] & 0x0C) >> 2;
-    picture_coding_ext->picture_structure          =   (data[2] & 0x03);
-    picture_coding_ext->top_field_first            = !!(data[3] & 0x80);
-    picture_coding_ext->frame_predictive_frame_dct = !!(data[3] & 0x40);
-    picture_coding_ext->concealment_motion_vectors = !!(data[3] & 0x20);
-    picture_coding_ext->q_scale_type               = !!(data[3] & 0x10);
-    picture_coding_ext->intra_vlc_format           = !!(data[3] & 0x08);
-    picture_coding_ext->alternate_scan             = !!(data[3] & 0x04);
-    picture_coding_ext->repeat_first_field         = !!(data[3] & 0x02);
-    picture_coding_ext->chroma_420_type            = !!(data[3] & 0x01);
-    picture_coding_ext->progressive_frame          = !!(data[4] & 0x80);
-    picture_coding_ext->composite_display_flag     = !!(data[4] & 0x40);
+    skipbits( br, 4 );                          /* extension_start_code_identifier */
+    picture_coding_ext->f_code[0].horizontal       = getbits( br,  4 );
+    picture_coding_ext->f_code[0].vertical         = getbits( br,  4 );
+    picture_coding_ext->f_code[1].horizontal       = getbits( br,  4 );
+    picture_coding_ext->f_code[1].vertical         = getbits( br,  4 );
+    picture_coding_ext->intra_dc_precision         = getbits( br,  2 );
+    picture_coding_ext->picture_structure          = getbits( br,  2 );
+    picture_coding_ext->top_field_first            = getbits( br,  1 );
+    picture_coding_ext->frame_predictive_frame_dct = getbits( br,  1 );
+    picture_coding_ext->concealment_motion_vectors = getbits( br,  1 );
+    picture_coding_ext->q_scale_type               = getbits( br,  1 );
+    picture_coding_ext->intra_vlc_format           = getbits( br,  1 );
+    picture_coding_ext->alternate_scan             = getbits( br,  1 );
+    picture_coding_ext->repeat_first_field         = getbits( br,  1 );
+    picture_coding_ext->chroma_420_type            = getbits( br,  1 );
+    picture_coding_ext->progressive_frame          = getbits( br,  1 );
+    picture_coding_ext->composite_display_flag     = getbits( br,  1 );
     if( picture_coding_ext->composite_display_flag )
     {
-        picture_coding_ext->v_axis                 = !!(data[4] & 0x20);
-        picture_coding_ext->field_sequence         =   (data[4] & 0x1C) >> 2;
-        picture_coding_ext->sub_carrier            = !!(data[4] & 0x02);
-        picture_coding_ext->burst_amplitude        =  ((data[4] & 0x01) << 6) | (data[5] >> 2);
-        picture_coding_ext->sub_carrier_phase      =  ((data[5] & 0x03) << 6) | (data[6] >> 2);
+        picture_coding_ext->v_axis                 = getbits( br,  1 );
+        picture_coding_ext->field_sequence         = getbits( br,  3 );
+        picture_coding_ext->sub_carrier            = getbits( br,  1 );
+        picture_coding_ext->burst_amplitude        = getbits( br,  7 );
+        picture_coding_ext->sub_carrier_phase      = getbits( br,  8 );
     }
     else
     {
@@ -360,166 +473,98 @@ static int32_t read_picture_coding_extension
         picture_coding_ext->sub_carrier            = 0;
         picture_coding_ext->burst_amplitude        = 0;
         picture_coding_ext->sub_carrier_phase      = 0;
-        check_size -= 2;
     }
-    return check_size;
 }
 
-static int32_t read_quant_matrix_extension
+static void read_quant_matrix_extension
 (
-    uint8_t                                *data,
+    mpeg_bit_reader_t                      *br,
     mpeg_video_quant_matrix_extension_t    *quant_matrix_ext
 )
 {
-    int32_t check_size = MPEG_VIDEO_QUANT_MATRIX_EXTENSION_SIZE;
-    uint8_t *p = &(data[0]);
-    quant_matrix_ext->load_intra_quantiser_matrix = !!(*p & 0x08);
-    if( quant_matrix_ext->load_intra_quantiser_matrix )
-        for( int i = 0; i < 64; ++i, ++p )
-            quant_matrix_ext->intra_quantiser_matrix[zigzag_scan_order_idx[i]]
-                                                  =  ((*p & 0x07) << 5) | (*(p+1) >> 3);
-    else
-    {
-        memset( quant_matrix_ext->intra_quantiser_matrix, 0, 64 );
-        check_size -= 64;
-    }
-    quant_matrix_ext->load_non_intra_quantiser_matrix
-                                                  = !!(*p & 0x04);
-    if( quant_matrix_ext->load_non_intra_quantiser_matrix )
-        for( int i = 0; i < 64; ++i, ++p )
-            quant_matrix_ext->non_intra_quantiser_matrix[zigzag_scan_order_idx[i]]
-                                                  =  ((*p & 0x03) << 6) | (*(p+1) >> 2);
-    else
-    {
-        memset( quant_matrix_ext->non_intra_quantiser_matrix, 0, 64 );
-        check_size -= 64;
-    }
-    quant_matrix_ext->load_chroma_intra_quantiser_matrix
-                                                  = !!(*p & 0x02);
-    if( quant_matrix_ext->load_chroma_intra_quantiser_matrix )
-        for( int i = 0; i < 64; ++i, ++p )
-            quant_matrix_ext->chroma_intra_quantiser_matrix[zigzag_scan_order_idx[i]]
-                                                  =  ((*p & 0x01) << 7) | (*(p+1) >> 1);
-    else
-    {
-        memset( quant_matrix_ext->chroma_intra_quantiser_matrix, 0, 64 );
-        check_size -= 64;
-    }
-    quant_matrix_ext->load_chroma_non_intra_quantiser_matrix
-                                                  = !!(*p & 0x01);
-    ++p;
-    if( quant_matrix_ext->load_chroma_non_intra_quantiser_matrix )
-        for( int i = 0; i < 64; ++i, ++p )
-            quant_matrix_ext->chroma_non_intra_quantiser_matrix[zigzag_scan_order_idx[i]]
-                                                  =   *p;
-    else
-    {
-        memset( quant_matrix_ext->chroma_non_intra_quantiser_matrix, 0, 64 );
-        check_size -= 64;
-    }
-    return check_size;
+    skipbits( br, 4 );                          /* extension_start_code_identifier */
+    quant_matrix_ext->load_intra_quantiser_matrix            = getbits( br, 1 );
+    read_quantiser_matrix( br, quant_matrix_ext->load_intra_quantiser_matrix
+                             , quant_matrix_ext->intra_quantiser_matrix );
+    quant_matrix_ext->load_non_intra_quantiser_matrix        = getbits( br, 1 );
+    read_quantiser_matrix( br, quant_matrix_ext->load_non_intra_quantiser_matrix
+                             , quant_matrix_ext->non_intra_quantiser_matrix );
+    quant_matrix_ext->load_chroma_intra_quantiser_matrix     = getbits( br, 1 );
+    read_quantiser_matrix( br, quant_matrix_ext->load_chroma_intra_quantiser_matrix
+                             , quant_matrix_ext->chroma_intra_quantiser_matrix );
+    quant_matrix_ext->load_chroma_non_intra_quantiser_matrix = getbits( br, 1 );
+    read_quantiser_matrix( br, quant_matrix_ext->load_chroma_non_intra_quantiser_matrix
+                             , quant_matrix_ext->chroma_non_intra_quantiser_matrix );
 }
 
-#define bit_shift( p, n, m )        \
-do {                                \
-    if( m == 0x01 )                 \
-    {                               \
-        m = 0x80;                   \
-        ++p;                        \
-    }                               \
-    else                            \
-        m >>= 1;                    \
-} while( 0 )
-#define getbits( p, n, m, v )       \
-do {                                \
-    int getbits_count = n;          \
-    while( getbits_count )          \
-    {                               \
-        v = (v << 1) | !!(*p & m);  \
-        bit_shift( p, n, m );       \
-        --getbits_count;            \
-    }                               \
-} while( 0 )
-static int32_t read_picture_display_extension
+static void read_picture_display_extension
 (
-    uint8_t                                    *data,
+    mpeg_bit_reader_t                          *br,
     mpeg_video_picture_display_extension_t     *picture_display_ext
 )
 {
     uint8_t number_of_frame_centre_offsets = picture_display_ext->number_of_frame_centre_offsets;
     /* initialize. */
     memset( picture_display_ext, 0, sizeof(mpeg_video_picture_display_extension_t) );
-    if( !number_of_frame_centre_offsets )
-        return 0;
     picture_display_ext->number_of_frame_centre_offsets = number_of_frame_centre_offsets;
     /* read. */
-    uint8_t *p = &(data[0]);
-    uint8_t bit_start = 0x08;
+    skipbits( br, 4 );                          /* extension_start_code_identifier */
     for( int i = 0; i < number_of_frame_centre_offsets; ++i )
     {
-        getbits( p, 14, bit_start, picture_display_ext->frame_centre_offsets[i].horizontal_offset );
-        bit_shift( p, 1, bit_start );       /* marker_bit '1' */
-        getbits( p, 14, bit_start, picture_display_ext->frame_centre_offsets[i].vertical_offset );
-        bit_shift( p, 1, bit_start );       /* marker_bit '1' */
+        picture_display_ext->frame_centre_offsets[i].horizontal_offset = getbits( br, 16 );
+        skipbits( br, 1 );                      /* marker_bit '1' */
+        picture_display_ext->frame_centre_offsets[i].vertical_offset   = getbits( br, 16 );
+        skipbits( br, 1 );                      /* marker_bit '1' */
     }
-    return (number_of_frame_centre_offsets == 3) ? 14 :   /* 4bits + 34bits * 3 */
-           (number_of_frame_centre_offsets == 2) ?  9 :   /* 4bits + 34bits * 2 */
-           (number_of_frame_centre_offsets == 1) ?  5 :   /* 4bits + 34bits * 1 */
-                                                    1;    /* 4bits              */
 }
-#undef bit_shift
-#undef getbits
 
-static int32_t read_picture_temporal_scalable_extension
+static void read_picture_temporal_scalable_extension
 (
-    uint8_t                                            *data,
+    mpeg_bit_reader_t                                  *br,
     mpeg_video_picture_temporal_scalable_extension_t   *picture_temporal_scalable_ext
 )
 {
-    picture_temporal_scalable_ext->reference_select_code       =   (data[0] & 0x0C) >> 2;
-    picture_temporal_scalable_ext->forward_temporal_reference  =  ((data[0] & 0x03) << 8) | data[1];
-    /* marker_bit '1'                                          = !!(data[2] & 0x80); */
-    picture_temporal_scalable_ext->backward_temporal_reference =   (data[2] & 0x7F) << 3 | (data[3] >> 5);
-    return MPEG_VIDEO_PICTURE_TEMPORAL_SCALABLE_EXTENSION_SIZE;
+    skipbits( br, 4 );                          /* extension_start_code_identifier */
+    picture_temporal_scalable_ext->reference_select_code       = getbits( br,  2 );
+    picture_temporal_scalable_ext->forward_temporal_reference  = getbits( br, 10 );
+    skipbits( br, 1 );                          /* marker_bit '1' */
+    picture_temporal_scalable_ext->backward_temporal_reference = getbits( br, 10 );
 }
 
-static int32_t read_picture_spatial_scalable_extension
+static void read_picture_spatial_scalable_extension
 (
-    uint8_t                                            *data,
+    mpeg_bit_reader_t                                  *br,
     mpeg_video_picture_spatial_scalable_extension_t    *picture_spatial_scalable_ext
 )
 {
-    picture_spatial_scalable_ext->lower_layer_temporal_reference           =  ((data[0] & 0x08) << 6)
-                                                                           |   (data[1]         >> 2);
-    /* marker_bit '1'                                                      = !!(data[1] & 0x02); */
-    picture_spatial_scalable_ext->lower_layer_horizontal_offset            =  ((data[1] & 0x01) << 14)
-                                                                           |   (data[2]         <<  6)
-                                                                           |   (data[3]         >>  2);
-    /* marker_bit '1'                                                      = !!(data[3] & 0x02); */
-    picture_spatial_scalable_ext->lower_layer_vertical_offset              =  ((data[3] & 0x01) << 14)
-                                                                           |   (data[4]         <<  6)
-                                                                           |   (data[5]         >>  2);
-    picture_spatial_scalable_ext->spatial_temporal_weight_code_table_index =    data[5] & 0x02;
-    picture_spatial_scalable_ext->lower_layer_progressive_frame            = !!(data[6] & 0x80);
-    picture_spatial_scalable_ext->lower_layer_deinterlaced_field_select    = !!(data[6] & 0x40);
-    return MPEG_VIDEO_PICTURE_SPATIAL_SCALABLE_EXTENSION_SIZE;
+    skipbits( br, 4 );                          /* extension_start_code_identifier */
+    picture_spatial_scalable_ext->lower_layer_temporal_reference           = getbits( br, 10 );
+    skipbits( br, 1 );                          /* marker_bit '1' */
+    picture_spatial_scalable_ext->lower_layer_horizontal_offset            = getbits( br, 15 );
+    skipbits( br, 1 );                          /* marker_bit '1' */
+    picture_spatial_scalable_ext->lower_layer_vertical_offset              = getbits( br, 15 );
+    picture_spatial_scalable_ext->spatial_temporal_weight_code_table_index = getbits( br,  2 );
+    picture_spatial_scalable_ext->lower_layer_progressive_frame            = getbits( br,  1 );
+    picture_spatial_scalable_ext->lower_layer_deinterlaced_field_select    = getbits( br,  1 );
 }
 
-static int32_t read_copyright_extension( uint8_t *data, mpeg_video_copyright_extension_t *copyright_ext )
+static void read_copyright_extension( mpeg_bit_reader_t *br, mpeg_video_copyright_extension_t *copyright_ext )
 {
-    copyright_ext->copyright_flag       = !!(data[0] & 0x08);
-    copyright_ext->copyright_identifier =  ((data[0] & 0x07) << 5) | (data[1] >> 3);
-    copyright_ext->original_or_copy     = !!(data[1] & 0x04);
-    /* reserved     7bit                =  ((data[1] & 0x03) << 5) | (data[2] >> 3); */
-    /* marker_bit '1'                   = !!(data[2] & 0x04); */
-    copyright_ext->copyright_number_1   =  ((data[2] & 0x03) << 20) | (data[3] << 12) | (data[4] << 4) | (data[5] >> 4);
-    /* marker_bit '1'                   = !!(data[5] & 0x08); */
-    copyright_ext->copyright_number_2   =  ((data[5] & 0x07) << 19) | (data[6] << 11) | (data[7] << 3) | (data[7] >> 5);
-    /* marker_bit '1'                   = !!(data[7] & 0x40); */
-    copyright_ext->copyright_number_3   =  ((data[8] & 0x3F) << 16) | (data[9] << 8) | data[10];
-    return MPEG_VIDEO_COPYRIGHT_EXTENSION_SIZE;
+    skipbits( br, 4 );                          /* extension_start_code_identifier */
+    copyright_ext->copyright_flag       = getbits( br,  1 );
+    copyright_ext->copyright_identifier = getbits( br,  8 );
+    copyright_ext->original_or_copy     = getbits( br,  1 );
+    skipbits( br, 8 );                          /* reserved 7bit, marker_bit '1' */
+    copyright_ext->copyright_number_1   = getbits( br, 20 );
+    skipbits( br, 1 );                          /* marker_bit '1' */
+    copyright_ext->copyright_number_2   = getbits( br, 22 );
+    skipbits( br, 1 );                          /* marker_bit '1' */
+    copyright_ext->copyright_number_3   = getbits( br, 22 );
 }
 
+#undef getbits
+#undef skipbits
+
 static uint8_t get_number_of_frame_centre_offsets( mpeg_video_info_t *video_info )
 {
     uint8_t number_of_frame_centre_offsets = 0;
@@ -577,46 +622,44 @@ typedef enum {
     /* 1111 reserved                        = 0x0F      */
 } extension_start_code_identifier_code;
 
-static int32_t mpeg_video_get_extension_info( uint8_t *buf, mpeg_video_info_t *video_info )
+static void mpeg_video_get_extension_info( mpeg_bit_reader_t *br, mpeg_video_info_t *video_info )
 {
-    int32_t check_size = 0;
-    extension_start_code_identifier_code extension_start_code_identifier = buf[0] >> 4;
+    extension_start_code_identifier_code extension_start_code_identifier = mpeg_bit_reader_show_bits( br, 4 );
     switch( extension_start_code_identifier )
     {
         /* Sequence Header */
         case Sequence_Extension_ID :
-            check_size = read_sequence_extension( buf, &(video_info->sequence_ext) );
+            read_sequence_extension( br, &(video_info->sequence_ext) );
             break;
         case Sequence_Display_Extension_ID :
-            check_size = read_sequence_display_extension( buf, &(video_info->sequence_display_ext) );
+            read_sequence_display_extension( br, &(video_info->sequence_display_ext) );
             break;
         case Sequence_Scalable_Extension_ID :
-            check_size = read_sequence_scalable_extension( buf, &(video_info->sequence_scalable_ext) );
+            read_sequence_scalable_extension( br, &(video_info->sequence_scalable_ext) );
             break;
         /* Picture Header */
         case Picture_Coding_Extension_ID :
-            check_size = read_picture_coding_extension( buf, &(video_info->picture_coding_ext) );
+            read_picture_coding_extension( br, &(video_info->picture_coding_ext) );
             break;
         case Quant_Matrix_Extension_ID :
-            check_size = read_quant_matrix_extension( buf, &(video_info->quant_matrix_ext) );
+            read_quant_matrix_extension( br, &(video_info->quant_matrix_ext) );
             break;
         case Picture_Display_Extension_ID :
             video_info->picture_display_ext.number_of_frame_centre_offsets = get_number_of_frame_centre_offsets( video_info );
-            check_size = read_picture_display_extension( buf, &(video_info->picture_display_ext) );
+            read_picture_display_extension( br, &(video_info->picture_display_ext) );
             break;
         case Picture_Temporal_Scalable_Extension_ID :
-            check_size = read_picture_temporal_scalable_extension( buf, &(video_info->picture_temporal_scalable_ext) );
+            read_picture_temporal_scalable_extension( br, &(video_info->picture_temporal_scalable_ext) );
             break;
         case Picture_Spatial_Scalable_Extension_ID :
-            check_size = read_picture_spatial_scalable_extension( buf, &(video_info->picture_spatial_scalable_ext) );
+            read_picture_spatial_scalable_extension( br, &(video_info->picture_spatial_scalable_ext) );
             break;
         case Copyright_Extension_ID :
-            check_size = read_copyright_extension( buf, &(video_info->copyright_ext) );
+            read_copyright_extension( br, &(video_info->copyright_ext) );
             break;
         default:
             break;
     }
-    return check_size;
 }
 
 static mpeg_video_extension_type mpeg_video_check_extension_start_code_identifier( uint8_t identifier )
@@ -660,39 +703,52 @@ static mpeg_video_extension_type mpeg_video_check_extension_start_code_identifie
     return extension_type;
 }
 
-extern int32_t mpeg_video_get_header_info
+extern int mpeg_video_read_header_info
 (
-    uint8_t                        *buf,
+    mpeg_bit_reader_t              *br,
     mpeg_video_start_code_type      start_code,
     mpeg_video_info_t              *video_info
 )
 {
-    int32_t check_size = 0;
     switch( start_code )
     {
         case MPEG_VIDEO_START_CODE_SHC :
-            check_size = read_sequence_header( buf, &(video_info->sequence) );
+            read_sequence_header( br, &(video_info->sequence) );
             break;
         case MPEG_VIDEO_START_CODE_ESC :
-            check_size = mpeg_video_get_extension_info( buf, video_info );
+            mpeg_video_get_extension_info( br, video_info );
             break;
         case MPEG_VIDEO_START_CODE_UDSC :
             break;
         case MPEG_VIDEO_START_CODE_SEC :
             break;
         case MPEG_VIDEO_START_CODE_GSC :
-            check_size = read_gop_header( buf, &(video_info->gop) );
+            read_gop_header( br, &(video_info->gop) );
             break;
         case MPEG_VIDEO_START_CODE_PSC :
-            check_size = read_picture_header( buf, &(video_info->picture) );
+            read_picture_header( br, &(video_info->picture) );
             break;
         case MPEG_VIDEO_START_CODE_SSC :
-            check_size = read_slice_header( /* buf, */ &(video_info->slice) );
+            read_slice_header( br, &(video_info->slice) );
             break;
         default :
             break;
     }
-    return check_size;
+    return br->error ? -1 : 0;
+}
+
+extern int32_t mpeg_video_get_header_info
+(
+    uint8_t                        *buf,
+    uint32_t                        buf_size,
+    mpeg_video_start_code_type      start_code,
+    mpeg_video_info_t              *video_info
+)
+{
+    mpeg_bit_reader_t br;
+    mpeg_bit_reader_init( &br, buf, buf_size, NULL, NULL );
+    mpeg_video_read_header_info( &br, start_code, video_info );
+    return (int32_t)((br.read_bits + 7) / 8);
 }
 
 extern void mpeg_video_debug_header_info
@@ -278,6 +278,21 @@ typedef struct {
     mpeg_video_start_code_searching_status  searching_status;
 } mpeg_video_start_code_info_t;
 
+typedef int (*mpeg_bit_reader_refill_func)( void *param, uint8_t **data, uint8_t **data_end );
+
+typedef struct {
+    uint64_t                        cache;
+    int32_t                         cache_bits;
+    int32_t                         error;
+    uint8_t                        *data;
+    uint8_t                        *data_end;
+    int64_t                         read_bits;
+    int32_t                         escape;             /* remove emulation_prevention_three_byte */
+    int32_t                         zero_count;
+    mpeg_bit_reader_refill_func     refill;
+    void                           *param;
+} mpeg_bit_reader_t;
+
 #define PAL_FRAME_RATE_NUM      (25)
 #define PAL_FRAME_RATE_DEN      (1)
 #define NTSC_FRAME_RATE_NUM     (30000)
@@ -291,9 +306,40 @@ extern int mpeg_video_check_start_code_common_head( uint8_t *start_code );
 
 extern int mpeg_video_check_start_code( uint8_t *start_code, mpeg_video_start_code_type start_code_type );
 
+extern void mpeg_bit_reader_init
+(
+    mpeg_bit_reader_t              *br,
+    uint8_t                        *data,
+    uint32_t                        data_size,
+    mpeg_bit_reader_refill_func     refill,
+    void                           *param
+);
+
+extern uint32_t mpeg_bit_reader_get_bits( mpeg_bit_reader_t *br, int32_t bits );
+
+extern uint32_t mpeg_bit_reader_show_bits( mpeg_bit_reader_t *br, int32_t bits );
+
+extern void mpeg_bit_reader_skip_bits( mpeg_bit_reader_t *br, int64_t bits );
+
+extern uint32_t mpeg_bit_reader_get_ue( mpeg_bit_reader_t *br );
+
+extern int32_t mpeg_bit_reader_get_se( mpeg_bit_reader_t *br );
+
+extern void mpeg_bit_reader_byte_align( mpeg_bit_reader_t *br );
+
+extern int mpeg_bit_reader_next_start_code( mpeg_bit_reader_t *br, uint8_t *start_code );
+
+extern int mpeg_video_read_header_info
+(
+    mpeg_bit_reader_t              *br,
+    mpeg_video_start_code_type      start_code,
+    mpeg_video_info_t              *video_info
+);
+
 extern int32_t mpeg_video_get_header_info
 (
     uint8_t                        *buf,
+    uint32_t                        buf_size,
     mpeg_video_start_code_type      start_code,
     mpeg_video_info_t              *video_info
 );
@@ -41,6 +41,8 @@
 
 typedef struct {
     parser_status_type      status;
+    char                   *mpeges;
+    int64_t                 buffer_size;
     int64_t                 read_position;
     int64_t                 video_position;
     uint8_t                 video_stream_type;
@@ -52,6 +54,7 @@ typedef struct {
     int32_t                 picture_num;
     int32_t                 field_picture_num;
     mpeg_video_info_t      *video_info;
+    sample_span_t           sample_span;
     void                   *fr_ctx;
 } mpeges_info_t;
 
@@ -152,7 +155,7 @@ static int mpeges_parse_stream_type( mpeges_info_t *info )
         mpeges_fread( info, buf, read_size, &dest_size );
         if( dest_size != read_size )
             goto end_parse_stream_type;
-        int64_t check_size = mpeg_video_get_header_info( buf, start_code_info.start_code, info->video_info );
+        int64_t check_size = mpeg_video_get_header_info( buf, read_size, start_code_info.start_code, info->video_info );
         if( check_size < read_size )
             mpeges_fseek( info, start_code_position + MPEG_VIDEO_START_CODE_SIZE + check_size, SEEK_SET );
         /* debug. */
@@ -241,7 +244,7 @@ static int mpeges_get_mpeg_video_picture_info( mpeges_info_t *info )
         mpeges_fread( info, buf, read_size, &dest_size );
         if( dest_size != read_size )
             goto end_get_video_picture_info;
-        int64_t check_size = mpeg_video_get_header_info( buf, start_code_info.start_code, info->video_info );
+        int64_t check_size = mpeg_video_get_header_info( buf, read_size, start_code_info.start_code, info->video_info );
         if( check_size < read_size )
             mpeges_fseek( info, start_code_position + MPEG_VIDEO_START_CODE_SIZE + check_size, SEEK_SET );
         /* debug. */
@@ -344,15 +347,6 @@ static mpeg_stream_type get_sample_stream_type( void *ih, mpeg_sample_type sampl
     return stream_type;
 }
 
-static void free_sample_buffer( uint8_t **buffer )
-{
-    if( !buffer )
-        return;
-    if( *buffer )
-        free( *buffer );
-    buffer = NULL;
-}
-
 static int get_sample_data
 (
     void                       *ih,
@@ -361,7 +355,7 @@ static int get_sample_data
     int64_t                     position,
     uint32_t                    sample_size,
     int32_t                     read_offset,
-    uint8_t                   **dst_buffer,
+    uint8_t                    *dst_buffer,
     uint32_t                   *dst_read_size,
     get_sample_data_mode        get_mode
 )
@@ -371,27 +365,116 @@ static int get_sample_data
     (void) get_mode;
 #endif
     mpeges_info_t *info = (mpeges_info_t *)ih;
-    if( !info || stream_number || position < 0 )
+    if( !info || !dst_buffer || stream_number || position < 0 )
         return -1;
     if( sample_type != SAMPLE_TYPE_VIDEO )
         return -1;
     /* seek reading start position. */
     mpeges_fseek( info, position, SEEK_SET );
-    /* allocate buffer. */
-    uint8_t *buffer = (uint8_t *)malloc( sample_size );
-    if( !buffer )
-        return -1;
     mapi_log( LOG_LV3, "[debug] buffer_size:%d\n", sample_size );
     /* get data. */
     int64_t dest_size = 0;
-    mpeges_fread( info, buffer, sample_size, &dest_size );
+    mpeges_fread( info, dst_buffer, sample_size, &dest_size );
     uint32_t read_size = (uint32_t)dest_size;
     mapi_log( LOG_LV3, "[debug] read_size:%d\n", read_size );
-    *dst_buffer    = buffer;
     *dst_read_size = read_size;
     return 0;
 }
 
+static int get_sample_spans
+(
+    void                       *ih,
+    mpeg_sample_type            sample_type,
+    uint8_t                     stream_number,
+    int64_t                     position,
+    uint32_t                    sample_size,
+    int32_t                     read_offset,
+    sample_span_t             **dst_spans,
+    uint32_t                   *dst_span_num,
+    get_sample_data_mode        get_mode
+)
+{
+#if ENABLE_SUPPRESS_WARNINGS
+    (void) read_offset;
+    (void) get_mode;
+#endif
+    mpeges_info_t *info = (mpeges_info_t *)ih;
+    if( !info || stream_number || position < 0 )
+        return -1;
+    if( sample_type != SAMPLE_TYPE_VIDEO )
+        return -1;
+    /* check size. */
+    int64_t map_size = mpeges_get_file_size( info ) - position;
+    if( map_size > sample_size )
+        map_size = sample_size;
+    if( map_size <= 0 )
+        return -1;
+    /* map the sample range into the reader cache. */
+    uint8_t *map_data = NULL;
+    if( file_reader.fmap( info->fr_ctx, position, map_size, &map_data ) )
+        return -1;
+    mapi_log( LOG_LV3, "[debug] map_size:%" PRId64 "\n", map_size );
+    info->sample_span.data = map_data;
+    info->sample_span.size = (uint32_t)map_size;
+    *dst_spans    = &(info->sample_span);
+    *dst_span_num = 1;
+    return 0;
+}
+
+static int get_sample_range_data
+(
+    void                       *ih,
+    mpeg_sample_type            sample_type,
+    uint8_t                     stream_number,
+    sample_read_info_t         *read_info,
+    uint32_t                    read_num,
+    uint8_t                    *dst_buffer,
+    get_sample_data_mode        get_mode
+)
+{
+#if ENABLE_SUPPRESS_WARNINGS
+    (void) get_mode;
+#endif
+    mpeges_info_t *info = (mpeges_info_t *)ih;
+    if( !info || !read_info || !dst_buffer || stream_number )
+        return -1;
+    if( sample_type != SAMPLE_TYPE_VIDEO )
+        return -1;
+    /* read each run of adjoining samples with a single read. */
+    uint32_t i = 0;
+    while( i < read_num )
+    {
+        if( read_info[i].position < 0 )
+            return -1;
+        uint32_t run_num  = 1;
+        uint64_t run_size = read_info[i].sample_size;
+        while( i + run_num < read_num )
+        {
+            sample_read_info_t *prev = &(read_info[i + run_num - 1]);
+            sample_read_info_t *next = &(read_info[i + run_num]);
+            if( next->position      != prev->position      + prev->sample_size
+             || next->buffer_offset != prev->buffer_offset + prev->sample_size )
+                break;
+            run_size += next->sample_size;
+            ++run_num;
+        }
+        mpeges_fseek( info, read_info[i].position, SEEK_SET );
+        int64_t dest_size = 0;
+        mpeges_fread( info, dst_buffer + read_info[i].buffer_offset, run_size, &dest_size );
+        mapi_log( LOG_LV3, "[debug] sample run  start:%" PRId64 "  size:%" PRIu64 "  num:%u\n"
+                         , read_info[i].position, run_size, run_num );
+        for( ; run_num; --run_num, ++i )
+        {
+            uint32_t read_size = read_info[i].sample_size;
+            if( dest_size < read_size )
+                read_size = (dest_size > 0) ? (uint32_t)dest_size : 0;
+            read_info[i].read_size = read_size;
+            dest_size -= read_info[i].sample_size;
+        }
+    }
+    return 0;
+}
+
 static int64_t get_sample_position( void *ih, mpeg_sample_type sample_type, uint8_t stream_number )
 {
     mpeges_info_t *info = (mpeges_info_t *)ih;
@@ -484,6 +567,68 @@ static int get_pcr( void *ih, pcr_info_t *pcr_info, uint16_t service_id )
     return -1;
 }
 
+static int get_arrival_time_index
+(
+    void                       *ih,
+    uint32_t                    packet_interval,
+    arrival_time_info_t       **dst_index,
+    uint32_t                   *dst_index_num
+)
+{
+#if ENABLE_SUPPRESS_WARNINGS
+    (void) ih;
+    (void) packet_interval;
+    (void) dst_index;
+    (void) dst_index_num;
+#endif
+    return -1;
+}
+
+static int scan_pcr
+(
+    void                       *ih,
+    uint16_t                    service_id,
+    pcr_scan_data_t           **dst_data,
+    uint32_t                   *dst_data_num,
+    pcr_scan_stats_t           *stats
+)
+{
+#if ENABLE_SUPPRESS_WARNINGS
+    (void) ih;
+    (void) service_id;
+    (void) dst_data;
+    (void) dst_data_num;
+    (void) stats;
+#endif
+    return -1;
+}
+
+static int get_packet_stats( void *ih, packet_stats_t *stats )
+{
+#if ENABLE_SUPPRESS_WARNINGS
+    (void) ih;
+    (void) stats;
+#endif
+    return -1;
+}
+
+static int scan_bitrate
+(
+    void                       *ih,
+    uint16_t                    service_id,
+    uint32_t                    bucket_msec,
+    bitrate_histogram_t        *histogram
+)
+{
+#if ENABLE_SUPPRESS_WARNINGS
+    (void) ih;
+    (void) service_id;
+    (void) bucket_msec;
+    (void) histogram;
+#endif
+    return -1;
+}
+
 static int get_video_info( void *ih, uint8_t stream_number, video_sample_info_t *video_sample_info )
 {
     mapi_log( LOG_LV2, "[mpeges_parser] %s()\n", __func__ );
@@ -516,6 +661,7 @@ static int get_video_info( void *ih, uint8_t stream_number, video_sample_info_t
     video_sample_info->program_id           = 0;
     video_sample_info->pts                  = ts.pts;
     video_sample_info->dts                  = ts.dts;
+    video_sample_info->arrival_time         = MPEG_TIMESTAMP_INVALID_VALUE;
     video_sample_info->gop_number           = gop_number;
     video_sample_info->progressive_sequence = progressive_sequence;
     video_sample_info->closed_gop           = closed_gop;
@@ -628,11 +774,14 @@ static void *initialize( const char *mpeges, int64_t buffer_size )
     mapi_log( LOG_LV2, "[mpeges_parser] %s()\n", __func__ );
     mpeges_info_t     *info       = (mpeges_info_t     *)calloc( 1, sizeof(mpeges_info_t) );
     mpeg_video_info_t *video_info = (mpeg_video_info_t *)malloc( sizeof(mpeg_video_info_t) );
-    if( !info || !video_info )
+    char              *file_name  = strdup( mpeges );
+    if( !info || !video_info || !file_name )
         goto fail_initialize;
-    if( mpeges_open( info, (char *)mpeges, buffer_size ) )
+    if( mpeges_open( info, file_name, buffer_size ) )
         goto fail_initialize;
     /* initialize. */
+    info->mpeges            = file_name;
+    info->buffer_size       = buffer_size;
     info->read_position     = -1;
     info->gop_number        = -1;
     info->video_stream_type = STREAM_INVALID;
@@ -648,6 +797,8 @@ fail_initialize:
     mapi_log( LOG_LV2, "[mpeges_parser] failed to initialize.\n" );
     if( video_info )
         free( video_info );
+    if( file_name )
+        free( file_name );
     if( info )
     {
         mpeges_close( info );
@@ -665,12 +816,43 @@ static void release( void *ih )
     /*  release. */
     mpeges_close( info );
     free( info->video_info );
+    free( info->mpeges );
     free( info );
 }
 
+static void *create_cursor( void *ih )
+{
+    mpeges_info_t *info = (mpeges_info_t *)ih;
+    if( !info )
+        return NULL;
+    mpeges_info_t *cursor = (mpeges_info_t *)malloc( sizeof(mpeges_info_t) );
+    if( !cursor )
+        return NULL;
+    /* share the parsed information, and read with own file reader. */
+    *cursor = *info;
+    cursor->fr_ctx = NULL;
+    if( mpeges_open( cursor, info->mpeges, info->buffer_size ) )
+    {
+        free( cursor );
+        return NULL;
+    }
+    return cursor;
+}
+
+static void release_cursor( void *ch )
+{
+    mpeges_info_t *cursor = (mpeges_info_t *)ch;
+    if( !cursor )
+        return;
+    mpeges_close( cursor );
+    free( cursor );
+}
+
 mpeg_parser_t mpeges_parser = {
     initialize,
     release,
+    create_cursor,
+    release_cursor,
     parse,
     set_service_id,
     get_service_id_num,
@@ -682,6 +864,10 @@ mpeg_parser_t mpeges_parser = {
     get_video_info,
     get_audio_info,
     get_pcr,
+    get_arrival_time_index,
+    scan_pcr,
+    get_packet_stats,
+    scan_bitrate,
     get_stream_num,
     get_stream_data,
     get_specific_stream_data,
@@ -689,7 +875,8 @@ mpeg_parser_t mpeges_parser = {
     set_sample_position,
     seek_next_sample_position,
     get_sample_data,
-    free_sample_buffer,
+    get_sample_spans,
+    get_sample_range_data,
     get_sample_stream_type,
     get_stream_information
 };
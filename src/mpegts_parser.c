@@ -32,10 +32,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include <inttypes.h>
+#include <math.h>
 
 #include "mpeg_common.h"
 #include "mpeg_stream.h"
 #include "mpeg_video.h"
+#include "avc_video.h"
+#include "hevc_video.h"
 #include "mpeg_parser.h"
 #include "mpegts_def.h"
 #include "file_reader.h"
@@ -47,24 +50,77 @@
 #define TTS_PACKET_SIZE                     (192)
 #define FEC_TS_PACKET_SIZE                  (204)
 
+#define TTS_HEADER_SIZE                     (4)
+#define TTS_ARRIVAL_TIME_WRAPAROUND_VALUE   (0x0000000040000000LL)
+#define TS_ARRIVAL_TIME_INDEX_UNIT_NUM      (1024)
+
+#define PCR_CLOCK_FREQUENCY                 (27000000)
+#define PCR_CLOCK_WRAPAROUND_VALUE          (MPEG_TIMESTAMP_WRAPAROUND_VALUE * 300)
+#define PCR_REPETITION_INTERVAL_MAX         (PCR_CLOCK_FREQUENCY / 1000 * 40)
+#define PCR_DISCONTINUITY_INTERVAL_MAX      (PCR_CLOCK_FREQUENCY / 1000 * 100)
+#define TS_PCR_SCAN_BUFFER_PACKET_NUM       (4096)
+#define TS_PCR_SCAN_DATA_UNIT_NUM           (4096)
+
+#define TS_PID_NUM                          (0x2000)
+#define TS_PID_NULL_PACKET                  (0x1FFF)
+#define TS_STATS_PID_UNIT_NUM               (16)
+#define TS_STATS_SECTION_INTERVAL_MAX       (PCR_CLOCK_FREQUENCY / 1000 * 500)
+#define TS_BITRATE_BUCKET_UNIT_NUM          (256)
+
 #define TS_PACKET_TYPE_NUM                  (3)
 #define TS_PACKET_FIRST_CHECK_COUNT_NUM     (4)
 #define TS_PACKET_SEARCH_CHECK_COUNT_NUM    (1000000)
 #define TS_PACKET_SEARCH_RETRY_COUNT_NUM    (5)
+#define TS_PACKET_SEARCH_WINDOW_NUM         (8)         /* keep the map within the default reader cache. */
 
 #define TS_PSI_PACKET_NUM_CHECK_MARGIN      (2)
 
+#define TS_SAMPLE_SPAN_LIST_UNIT_NUM        (64)
+#define TS_SAMPLE_RANGE_MERGE_GAP           (0x0080000)
+#define TS_SAMPLE_RANGE_WINDOW_MAX          (0x0800000)
+
 //#define NEED_OPCR_VALUE
 #undef NEED_OPCR_VALUE
 
 typedef struct {
+    pid_packet_stats_t          stats;
+    uint8_t                     continuity_counter;     /* over 0x0F: unknown */
+    uint8_t                     duplicate;
+    int64_t                     last_pcr;
+    int64_t                     last_section_time;
+} mpegts_pid_stats_t;
+
+typedef struct {
+    int64_t                     start_position;
+    int64_t                     end_position;
+    int64_t                     packet_num;
+    uint16_t                    clock_program_id;
+    int64_t                     clock_pcr;
+    int64_t                     clock;
+    uint16_t                    pid_num;
+    uint16_t                    pid_size;
+    mpegts_pid_stats_t         *pid;
+    uint16_t                    pid_index[TS_PID_NUM];  /* 0: none, index + 1 */
+} mpegts_stats_run_t;
+
+typedef struct {
+    mpegts_stats_run_t          run[2];
+    int                         best;
+} mpegts_stats_ctx_t;
+
+typedef struct mpegts_file_ctx_s mpegts_file_ctx_t;
+struct mpegts_file_ctx_s {
     int32_t                     packet_size;
     int32_t                     sync_byte_position;
     int64_t                     read_position;
     int32_t                     ts_packet_length;
     uint32_t                    packet_check_count_num;
     void                       *fr_ctx;
-} mpegts_file_ctx_t;
+    int64_t                     arrival_time;
+    int                       (*search_packet)( mpegts_file_ctx_t *tsf_ctx, mpegts_packet_header_t *h,
+                                                uint32_t *check_count, uint16_t search_program_id );
+    void                      (*seek_next)( mpegts_file_ctx_t *tsf_ctx, int64_t seek_offset );
+};
 
 typedef struct {
     mpegts_file_ctx_t           tsf_ctx;
@@ -74,6 +130,11 @@ typedef struct {
     void                       *stream_parse_info;
     int64_t                     gop_number;
     int32_t                     header_offset;
+    struct {
+        sample_span_t          *list;
+        int64_t                *position;
+        uint32_t                size;
+    } span_info;
     struct {
         mpeg_stream_type        reg_stream_type;
         struct {
@@ -137,8 +198,21 @@ typedef struct {
     uint16_t                    emm_program_id;
     pmt_target_type             pmt_target;
     mpeg_descriptor_info_t     *descriptor_info;
+    arrival_time_info_t        *arrival_time_index;
+    uint32_t                    arrival_time_index_size;
+    pcr_scan_data_t            *pcr_scan_data;
+    uint32_t                    pcr_scan_data_size;
+    mpegts_stats_ctx_t         *packet_stats;
+    pid_packet_stats_t         *pid_packet_stats;
+    pid_bitrate_histogram_t    *bitrate_histogram;
+    uint16_t                    bitrate_histogram_size;
 } mpegts_info_t;
 
+typedef struct {
+    mpegts_info_t               info;
+    mpegts_psi_ctx_t            psi_ctx;
+} mpegts_cursor_t;
+
 /*  */
 #define tsf_ctx_t           mpegts_file_ctx_t
 #define tss_ctx_t           mpegts_stream_ctx_t
@@ -190,6 +264,33 @@ static inline void tsp_get_pcr( uint8_t *pcr_data, int64_t *pcr_value )
     *pcr_value = pcr_base + pcr_ext / 300;
 }
 
+static inline int64_t tsp_get_arrival_time_stamp( uint8_t *tp_extra_header )
+{
+    /* copy_permission_indicator  2 bit  = tp_extra_header[0] >> 6; */
+    return (int64_t)(tp_extra_header[0] & 0x3F) << 24
+         | (int64_t) tp_extra_header[1]         << 16
+         | (int64_t) tp_extra_header[2]         << 8
+         | (int64_t) tp_extra_header[3];
+}
+
+static inline int64_t tsp_get_program_clock_reference( uint8_t *pcr_data )
+{
+    /* 27MHz clock: base * 300 + extension. */
+    int64_t pcr_base = (int64_t) pcr_data[0] << 25
+                     | (int64_t) pcr_data[1] << 17
+                     | (int64_t) pcr_data[2] << 9
+                     | (int64_t) pcr_data[3] << 1
+                     | (int64_t) pcr_data[4] >> 7;
+    int64_t pcr_ext  = (int64_t)(pcr_data[4] & 0x01) << 8
+                     | (int64_t) pcr_data[5];
+    return pcr_base * 300 + pcr_ext;
+}
+
+static inline int64_t pcr_get_interval( int64_t prev_pcr, int64_t pcr )
+{
+    return (pcr - prev_pcr + PCR_CLOCK_WRAPAROUND_VALUE) % PCR_CLOCK_WRAPAROUND_VALUE;
+}
+
 static inline void tsp_parse_pat_header( uint8_t *section_header, tsp_pat_si_t *pat_si )
 {
     pat_si->table_id                 =    section_header[0];
@@ -266,6 +367,185 @@ static inline int mpegts_fseek( tsf_ctx_t *tsf_ctx, int64_t seek_offset, int ori
     return file_reader.fseek( tsf_ctx->fr_ctx, seek_offset, origin );
 }
 
+static void mpegts_reset_stats_run( mpegts_stats_run_t *run, int64_t position )
+{
+    /* clear the index of the PIDs seen in the last run only. */
+    for( uint16_t i = 0; i < run->pid_num; ++i )
+        run->pid_index[run->pid[i].stats.program_id] = 0;
+    run->start_position   = position;
+    run->end_position     = position;
+    run->packet_num       = 0;
+    run->clock_program_id = TS_PID_ERR;
+    run->clock_pcr        = -1;
+    run->clock            = 0;
+    run->pid_num          = 0;
+}
+
+static mpegts_pid_stats_t *mpegts_get_pid_stats( mpegts_stats_run_t *run, uint16_t program_id )
+{
+    if( run->pid_index[program_id] )
+        return &(run->pid[run->pid_index[program_id] - 1]);
+    if( run->pid_num >= run->pid_size )
+    {
+        uint16_t pid_size = run->pid_size + TS_STATS_PID_UNIT_NUM;
+        mpegts_pid_stats_t *tmp = (mpegts_pid_stats_t *)realloc( run->pid, sizeof(mpegts_pid_stats_t) * pid_size );
+        if( !tmp )
+            return NULL;
+        run->pid      = tmp;
+        run->pid_size = pid_size;
+    }
+    mpegts_pid_stats_t *pid_stats = &(run->pid[run->pid_num]);
+    memset( pid_stats, 0, sizeof(mpegts_pid_stats_t) );
+    pid_stats->stats.program_id   = program_id;
+    pid_stats->continuity_counter = 0xFF;
+    pid_stats->last_pcr           = -1;
+    pid_stats->last_section_time  = -1;
+    run->pid_index[program_id] = ++(run->pid_num);
+    return pid_stats;
+}
+
+static void mpegts_update_stats( mpegts_stats_ctx_t *stats, int32_t packet_size, int64_t position, uint8_t *packet )
+{
+    mpegts_stats_run_t *run = &(stats->run[!stats->best]);
+    if( position != run->end_position )
+    {
+        /* ignore the packets read again. */
+        if( run->start_position <= position && position < run->end_position )
+            return;
+        /* start a new run, and keep the longest one. */
+        if( run->packet_num > stats->run[stats->best].packet_num )
+        {
+            stats->best = !stats->best;
+            run = &(stats->run[!stats->best]);
+        }
+        mpegts_reset_stats_run( run, position );
+    }
+    run->end_position = position + packet_size;
+    ++(run->packet_num);
+    uint16_t            program_id = ((packet[1] & 0x1F) << 8) | packet[2];
+    mpegts_pid_stats_t *pid_stats  = mpegts_get_pid_stats( run, program_id );
+    if( !pid_stats )
+        return;
+    ++(pid_stats->stats.packet_num);
+    if( packet[1] & 0x80 )
+    {
+        /* the header is not reliable. */
+        ++(pid_stats->stats.tei_error_num);
+        pid_stats->continuity_counter = 0xFF;
+        return;
+    }
+    uint8_t adaptation_field_control = (packet[3] >> 4) & 0x03;
+    uint8_t continuity_counter       =  packet[3] & 0x0F;
+    uint8_t discontinuity_indicator  = 0;
+    int64_t pcr                      = -1;
+    if( (adaptation_field_control & 0x02) && packet[4] )
+    {
+        /* adaptation field flags and PCR. */
+        discontinuity_indicator = !!(packet[5] & 0x80);
+        if( (packet[5] & 0x10) && packet[4] >= 7 )
+            pcr = tsp_get_program_clock_reference( &(packet[6]) );
+    }
+    /* continuity_counter. */
+    if( program_id != TS_PID_NULL_PACKET )
+    {
+        uint8_t last_counter = pid_stats->continuity_counter;
+        if( last_counter <= 0x0F && !discontinuity_indicator )
+        {
+            if( !(adaptation_field_control & 0x01) )
+            {
+                if( continuity_counter != last_counter )
+                    ++(pid_stats->stats.cc_error_num);
+            }
+            else if( continuity_counter == last_counter && !pid_stats->duplicate )
+                pid_stats->duplicate = 1;
+            else if( continuity_counter != ((last_counter + 1) & 0x0F) )
+                ++(pid_stats->stats.cc_error_num);
+            else
+                pid_stats->duplicate = 0;
+        }
+        pid_stats->continuity_counter = continuity_counter;
+    }
+    /* PCR. */
+    if( pcr >= 0 )
+    {
+        ++(pid_stats->stats.pcr_num);
+        if( pid_stats->last_pcr >= 0 && !discontinuity_indicator )
+        {
+            int64_t interval = pcr_get_interval( pid_stats->last_pcr, pcr );
+            if( interval > PCR_DISCONTINUITY_INTERVAL_MAX )
+                ++(pid_stats->stats.pcr_discontinuity_error_num);
+            else
+            {
+                if( interval > PCR_REPETITION_INTERVAL_MAX )
+                    ++(pid_stats->stats.pcr_repetition_error_num);
+                if( pid_stats->stats.pcr_interval_max < interval )
+                    pid_stats->stats.pcr_interval_max = interval;
+            }
+        }
+        pid_stats->last_pcr = pcr;
+        /* the first PCR PID is the clock of the intervals. */
+        if( run->clock_program_id == TS_PID_ERR )
+            run->clock_program_id = program_id;
+        if( run->clock_program_id == program_id )
+        {
+            if( run->clock_pcr >= 0 )
+            {
+                int64_t interval = pcr_get_interval( run->clock_pcr, pcr );
+                if( interval <= PCR_DISCONTINUITY_INTERVAL_MAX )
+                    run->clock += interval;
+            }
+            run->clock_pcr = pcr;
+        }
+    }
+    /* section and PES intervals. */
+    if( packet[1] & 0x40 )
+    {
+        ++(pid_stats->stats.section_num);
+        if( run->clock_pcr >= 0 )
+        {
+            if( pid_stats->last_section_time >= 0 )
+            {
+                int64_t interval = run->clock - pid_stats->last_section_time;
+                if( interval > TS_STATS_SECTION_INTERVAL_MAX )
+                    ++(pid_stats->stats.section_interval_error_num);
+                if( pid_stats->stats.section_interval_max < interval )
+                    pid_stats->stats.section_interval_max = interval;
+            }
+            pid_stats->last_section_time = run->clock;
+        }
+    }
+}
+
+static mpegts_stats_run_t *mpegts_get_stats_run( mpegts_stats_ctx_t *stats )
+{
+    if( !stats )
+        return NULL;
+    mpegts_stats_run_t *run = &(stats->run[stats->best]);
+    if( run->packet_num < stats->run[!stats->best].packet_num )
+        run = &(stats->run[!stats->best]);
+    return run;
+}
+
+static mpegts_stats_ctx_t *mpegts_create_stats( void )
+{
+    mpegts_stats_ctx_t *stats = (mpegts_stats_ctx_t *)calloc( 1, sizeof(mpegts_stats_ctx_t) );
+    if( !stats )
+        return NULL;
+    mpegts_reset_stats_run( &(stats->run[0]), -1 );
+    mpegts_reset_stats_run( &(stats->run[1]), -1 );
+    return stats;
+}
+
+static void mpegts_release_stats( mpegts_stats_ctx_t **stats )
+{
+    if( !*stats )
+        return;
+    free( (*stats)->run[0].pid );
+    free( (*stats)->run[1].pid );
+    free( *stats );
+    *stats = NULL;
+}
+
 static int mpegts_open( tsf_ctx_t *tsf_ctx, char *file_name, int64_t buffer_size )
 {
     if( !tsf_ctx )
@@ -347,6 +627,11 @@ typedef enum {
 
 static void mpegts_file_seek( tsf_ctx_t *tsf_ctx, int64_t seek_offset, mpegts_seek_type seek_type )
 {
+    if( seek_type == MPEGTS_SEEK_NEXT && tsf_ctx->seek_next )
+    {
+        tsf_ctx->seek_next( tsf_ctx, seek_offset );
+        return;
+    }
     int origin = (seek_type == MPEGTS_SEEK_CUR || seek_type == MPEGTS_SEEK_NEXT) ? SEEK_CUR : SEEK_SET;
     if( seek_type == MPEGTS_SEEK_NEXT )
         seek_offset += tsf_ctx->ts_packet_length + tsf_ctx->packet_size - TS_PACKET_SIZE;
@@ -387,6 +672,37 @@ detect_sync_byte:
     return 0;
 }
 
+static int64_t mpegts_update_arrival_time( tsf_ctx_t *tsf_ctx, int64_t arrival_time_stamp )
+{
+    /* unwrap around the last arrival time. */
+    int64_t arrival_time = arrival_time_stamp;
+    int64_t last_time    = tsf_ctx->arrival_time;
+    if( last_time != (int64_t)MPEG_TIMESTAMP_INVALID_VALUE )
+    {
+        arrival_time += last_time - last_time % TTS_ARRIVAL_TIME_WRAPAROUND_VALUE;
+        if( arrival_time - last_time > TTS_ARRIVAL_TIME_WRAPAROUND_VALUE / 2 && arrival_time >= TTS_ARRIVAL_TIME_WRAPAROUND_VALUE )
+            arrival_time -= TTS_ARRIVAL_TIME_WRAPAROUND_VALUE;
+        else if( last_time - arrival_time > TTS_ARRIVAL_TIME_WRAPAROUND_VALUE / 2 )
+            arrival_time += TTS_ARRIVAL_TIME_WRAPAROUND_VALUE;
+    }
+    tsf_ctx->arrival_time = arrival_time;
+    return arrival_time;
+}
+
+static int64_t mpegts_get_arrival_time( tsf_ctx_t *tsf_ctx, int64_t position )
+{
+    if( tsf_ctx->packet_size != TTS_PACKET_SIZE || position < TTS_HEADER_SIZE )
+        return MPEG_TIMESTAMP_INVALID_VALUE;
+    int64_t reset_position = mpegts_ftell( tsf_ctx );
+    uint8_t tp_extra_header[TTS_HEADER_SIZE];
+    int result = mpegts_fseek( tsf_ctx, position - TTS_HEADER_SIZE, SEEK_SET )
+              || mpegts_fread( tsf_ctx, tp_extra_header, TTS_HEADER_SIZE, NULL );
+    mpegts_fseek( tsf_ctx, reset_position, SEEK_SET );
+    if( result )
+        return MPEG_TIMESTAMP_INVALID_VALUE;
+    return mpegts_update_arrival_time( tsf_ctx, tsp_get_arrival_time_stamp( tp_extra_header ) );
+}
+
 static int mpegts_first_check( tsf_ctx_t *tsf_ctx )
 {
     int result = -1;
@@ -402,6 +718,7 @@ static int mpegts_first_check( tsf_ctx_t *tsf_ctx )
         {
             tsf_ctx->packet_size        = tsp_size[i];
             tsf_ctx->sync_byte_position = position;
+            tsf_ctx->arrival_time       = mpegts_get_arrival_time( tsf_ctx, mpegts_ftell( tsf_ctx ) + position );
             result = 0;
             mapi_log( LOG_LV3, "[check] packet size:%d\n", tsf_ctx->packet_size );
             break;
@@ -439,6 +756,7 @@ static int mpegts_read_packet_header( tsf_ctx_t *tsf_ctx, tsp_header_t *h )
         return -1;
     uint8_t ts_header[TS_PACKET_HEADER_SIZE];
     mpegts_file_read( tsf_ctx, ts_header, TS_PACKET_HEADER_SIZE );
+    mapi_stats_add( MAPI_STATS_PACKETS_SCANNED, 1 );
     /* setup header data. */
     tsp_parse_header( ts_header, h );
     /* initialize status. */
@@ -485,9 +803,110 @@ static inline void show_pmt_section_info( tsp_pmt_si_t *pmt_si )
               , pmt_si->program_info_length );
 }
 
+/* scan the mapped packets with a constant stride, and leave the rest to the generic search. */
+#define DEFINE_SEARCH_PROGRAM_ID_PACKET( _name, _packet_size )                                      \
+static int mpegts_search_##_name##_program_id_packet                                                \
+(                                                                                                   \
+    tsf_ctx_t                  *tsf_ctx,                                                            \
+    tsp_header_t               *h,                                                                  \
+    uint32_t                   *check_count,                                                        \
+    uint16_t                    search_program_id                                                   \
+)                                                                                                   \
+{                                                                                                   \
+    int64_t file_size = mpegts_get_file_size( tsf_ctx );                                            \
+    int64_t position  = tsf_ctx->read_position;                                                     \
+    while( *check_count )                                                                           \
+    {                                                                                               \
+        /* map the packets which have the next sync byte in the file. */                            \
+        int64_t num = (file_size - position - 1) / _packet_size;                                    \
+        if( num > TS_PACKET_SEARCH_WINDOW_NUM )                                                     \
+            num = TS_PACKET_SEARCH_WINDOW_NUM;                                                      \
+        if( num > *check_count )                                                                    \
+            num = *check_count;                                                                     \
+        uint8_t *data;                                                                              \
+        if( num <= 0 || file_reader.fmap( tsf_ctx->fr_ctx, position, num * _packet_size + 1, &data ) ) \
+            break;                                                                                  \
+        for( int64_t i = 0; i < num; ++i )                                                          \
+        {                                                                                           \
+            uint8_t *packet = &(data[i * _packet_size]);                                            \
+            if( packet[0] != SYNC_BYTE || packet[_packet_size] != SYNC_BYTE )                       \
+            {                                                                                       \
+                mapi_stats_add( MAPI_STATS_PACKETS_SCANNED, i );                                    \
+                position += i * _packet_size;                                                       \
+                goto generic_search;                                                                \
+            }                                                                                       \
+            if( (((packet[1] & 0x1F) << 8) | packet[2]) == search_program_id )                      \
+            {                                                                                       \
+                mapi_stats_add( MAPI_STATS_PACKETS_SCANNED, i );                                    \
+                --(*check_count);                                                                   \
+                mpegts_fseek( tsf_ctx, position + i * _packet_size, SEEK_SET );                     \
+                tsf_ctx->sync_byte_position = 0;                                                    \
+                return mpegts_read_packet_header( tsf_ctx, h ) ? -1 : 1;                            \
+            }                                                                                       \
+            --(*check_count);                                                                       \
+        }                                                                                           \
+        mapi_stats_add( MAPI_STATS_PACKETS_SCANNED, num );                                          \
+        position += num * _packet_size;                                                             \
+    }                                                                                               \
+generic_search:                                                                                     \
+    mpegts_fseek( tsf_ctx, position, SEEK_SET );                                                    \
+    tsf_ctx->sync_byte_position = -1;                                                               \
+    tsf_ctx->ts_packet_length   = 0;                                                                \
+    return 0;                                                                                       \
+}
+DEFINE_SEARCH_PROGRAM_ID_PACKET( ts , TS_PACKET_SIZE     )
+DEFINE_SEARCH_PROGRAM_ID_PACKET( tts, TTS_PACKET_SIZE    )
+DEFINE_SEARCH_PROGRAM_ID_PACKET( fec, FEC_TS_PACKET_SIZE )
+#undef DEFINE_SEARCH_PROGRAM_ID_PACKET
+
+/* skip to the next packet, and check the sync bytes on the map instead of reading byte by byte. */
+#define DEFINE_SEEK_NEXT_PACKET( _name, _packet_size )                                              \
+static void mpegts_seek_next_##_name##_packet( tsf_ctx_t *tsf_ctx, int64_t seek_offset )           \
+{                                                                                                   \
+    int64_t position = mpegts_ftell( tsf_ctx ) + seek_offset                                        \
+                     + tsf_ctx->ts_packet_length + (_packet_size - TS_PACKET_SIZE);                 \
+    uint8_t *data;                                                                                  \
+    int      synced  = !file_reader.fmap( tsf_ctx->fr_ctx, position, _packet_size + 1, &data )     \
+                    && data[0] == SYNC_BYTE && data[_packet_size] == SYNC_BYTE;                     \
+    mpegts_fseek( tsf_ctx, position, SEEK_SET );                                                    \
+    /* leave the unsure position to the generic check. */                                           \
+    tsf_ctx->sync_byte_position = synced ? 0 : -1;                                                  \
+    tsf_ctx->ts_packet_length   = 0;                                                                \
+}
+DEFINE_SEEK_NEXT_PACKET( ts , TS_PACKET_SIZE     )
+DEFINE_SEEK_NEXT_PACKET( tts, TTS_PACKET_SIZE    )
+DEFINE_SEEK_NEXT_PACKET( fec, FEC_TS_PACKET_SIZE )
+#undef DEFINE_SEEK_NEXT_PACKET
+
+static void mpegts_select_packet_funcs( tsf_ctx_t *tsf_ctx )
+{
+    switch( tsf_ctx->packet_size )
+    {
+        case TTS_PACKET_SIZE :
+            tsf_ctx->search_packet = mpegts_search_tts_program_id_packet;
+            tsf_ctx->seek_next     = mpegts_seek_next_tts_packet;
+            break;
+        case FEC_TS_PACKET_SIZE :
+            tsf_ctx->search_packet = mpegts_search_fec_program_id_packet;
+            tsf_ctx->seek_next     = mpegts_seek_next_fec_packet;
+            break;
+        default :
+            tsf_ctx->search_packet = mpegts_search_ts_program_id_packet;
+            tsf_ctx->seek_next     = mpegts_seek_next_ts_packet;
+            break;
+    }
+}
+
 static int mpegts_search_program_id_packet( tsf_ctx_t *tsf_ctx, tsp_header_t *h, uint16_t search_program_id )
 {
-    int check_count = tsf_ctx->packet_check_count_num;
+    uint32_t check_count = tsf_ctx->packet_check_count_num;
+    if( !check_count )
+        return 1;
+    if( mpegts_seek_sync_byte_position( tsf_ctx ) )
+        return -1;
+    int result = tsf_ctx->search_packet( tsf_ctx, h, &check_count, search_program_id );
+    if( result )
+        return (result > 0) ? 0 : -1;
     do
     {
         if( !check_count )
@@ -608,6 +1027,7 @@ static int mpegts_seek_packet_payload_data
         uint8_t adpf_data[adaptation_field_size];
         mpegts_get_adaptation_field_data( tsf_ctx, h, adpf_data, adaptation_field_size );
     }
+    mapi_stats_add( MAPI_STATS_PACKETS_DELIVERED, 1 );
     return 0;
 }
 
@@ -801,9 +1221,12 @@ static int mpegts_get_ca_pid_from_descriptor
     uint16_t               *ca_pid
 )
 {
-    if( !descriptor_num || !descriptor_info->conditional_access || !descriptor_info->conditional_access->CA_system_ID )
+    if( !descriptor_num )
         return -1;
-    *ca_pid = descriptor_info->conditional_access->CA_PID;
+    conditional_access_descriptor_info_t *conditional_access = MPEG_DESCRIPTOR_INFO( descriptor_info, conditional_access );
+    if( !conditional_access || !conditional_access->CA_system_ID )
+        return -1;
+    *ca_pid = conditional_access->CA_PID;
     return 0;
 }
 
@@ -815,27 +1238,23 @@ static int mpegts_parse_descriptor
     uint16_t               *descriptor_num
 )
 {
-    uint16_t tags_num   = 0;
-    uint16_t read_count = 0;
-    /* init. */
-    mpeg_stream_init_descriptor_info( descriptor_info );
     /* parse. */
-    while( read_count < data_length - 2 )
-    {
-        if( mpeg_stream_get_descriptor_info( /* stream_type, */ &(descriptor_data[read_count]), descriptor_info ) )
-            return -1;
-        uint8_t descriptor_length = descriptor_info->length;
-        char descriptor_data_str[descriptor_length * 2 + 1]; //= { 0 };
-        descriptor_data_str[descriptor_length * 2] = 0;
-        for( int i = 0; i < descriptor_length; ++i )
-            sprintf( &(descriptor_data_str[i * 2]), "%02X", descriptor_data[read_count + i + 2] );
-        mapi_log( LOG_LV2, "[check] descriptor_tag:0x%02X, descriptor_length:%u, [%s]\n"
-                         , descriptor_info->tags[tags_num], descriptor_length, descriptor_data_str );
-        mpeg_stream_debug_descriptor_info( descriptor_info, tags_num );
-        /* next descriptor. */
-        read_count += descriptor_length + 2;
-        ++tags_num;
-    }
+    if( mpeg_stream_get_descriptor_info( /* stream_type, */ descriptor_data, data_length, descriptor_info ) )
+        return -1;
+    uint16_t tags_num = descriptor_info->tags_num;
+    if( mapi_log_enabled( LOG_LV2 ) )
+        for( uint16_t i = 0; i < tags_num; ++i )
+        {
+            uint8_t *descriptor        = descriptor_info->data[i];
+            uint8_t  descriptor_length = descriptor[1];
+            char descriptor_data_str[descriptor_length * 2 + 1]; //= { 0 };
+            descriptor_data_str[descriptor_length * 2] = 0;
+            for( int j = 0; j < descriptor_length; ++j )
+                sprintf( &(descriptor_data_str[j * 2]), "%02X", descriptor[j + 2] );
+            mapi_log( LOG_LV2, "[check] descriptor_tag:0x%02X, descriptor_length:%u, [%s]\n"
+                             , descriptor_info->tags[i], descriptor_length, descriptor_data_str );
+            mpeg_stream_debug_descriptor_info( descriptor_info, i );
+        }
     *descriptor_num = tags_num;
     return 0;
 }
@@ -1384,158 +1803,151 @@ do {
     /* get PES packet length, flags. */                                                 \
     mpegts_file_read( _ctx, pes_header_check_buffer, PES_PACKET_HEADER_CHECK_SIZE );    \
     mpeg_pes_get_header_info( pes_header_check_buffer, &_pes );                         \
+    mapi_stats_add( MAPI_STATS_PES_ASSEMBLED, 1 );                                      \
 } while( 0 )
 
-static inline int read_1byte( tsf_ctx_t *tsf_ctx, tsp_header_t *h, uint16_t program_id, uint8_t *buffer )
+typedef struct {
+    tsf_ctx_t                  *tsf_ctx;
+    uint16_t                    program_id;
+    uint32_t                    packet_count;
+    int                         no_exist_start_indicator;
+} mpegts_payload_reader_t;
+
+static int mpegts_map_next_payload_data( void *param, uint8_t **data, uint8_t **data_end )
 {
-    if( !tsf_ctx->ts_packet_length )
+    mpegts_payload_reader_t *reader  = (mpegts_payload_reader_t *)param;
+    tsf_ctx_t               *tsf_ctx = reader->tsf_ctx;
+    tsp_header_t h;
+    while( 1 )
     {
-        mpegts_file_seek( tsf_ctx, 0, MPEGTS_SEEK_NEXT );
-        if( mpegts_seek_packet_payload_data( tsf_ctx, h, program_id, INDICATOR_IS_ON ) )
+        /* seek next. */
+        if( reader->packet_count++ )
+            mpegts_file_seek( tsf_ctx, 0, MPEGTS_SEEK_NEXT );
+        if( mpegts_seek_packet_payload_data( tsf_ctx, &h, reader->program_id, INDICATOR_UNCHECKED ) )
             return -1;
+        /* check start indicator. */
+        if( reader->no_exist_start_indicator && !h.payload_unit_start_indicator )
+            continue;
+        if( h.payload_unit_start_indicator )
+        {
+            /* check PES packet length, flags. */
+            mpeg_pes_header_info_t pes_info;
+            GET_PES_PACKET_HEADER( tsf_ctx, pes_info );
+            mapi_log( LOG_LV3, "[debug] PES packet_len:%d, pts_flag:%d, dts_flag:%d, header_len:%d\n"
+                             , pes_info.packet_length, pes_info.pts_flag, pes_info.dts_flag, pes_info.header_length );
+            mpegts_file_seek( tsf_ctx, pes_info.header_length, MPEGTS_SEEK_CUR );
+            reader->no_exist_start_indicator = 0;
+        }
+        if( tsf_ctx->ts_packet_length > 0 )
+            break;
     }
-    mpegts_file_read( tsf_ctx, buffer, 1 );
+    /* map the rest of payload data in the reader cache. */
+    int64_t position = mpegts_ftell( tsf_ctx );
+    int32_t length   = tsf_ctx->ts_packet_length;
+    if( file_reader.fmap( tsf_ctx->fr_ctx, position, length, data ) )
+        return -1;
+    *data_end = *data + length;
+    tsf_ctx->ts_packet_length = 0;
+    mapi_log( LOG_LV4, "[debug] map payload data. position:%" PRId64 "  length:%d\n", position, length );
     return 0;
 }
 
-static int mpegts_read_mpeg_video_picutre_info
+static int mpegts_get_mpeg_video_picture_info
 (
     tsf_ctx_t                  *tsf_ctx,
     uint16_t                    program_id,
     mpeg_video_info_t          *video_info,
-    int64_t                    *gop_number,
-    uint8_t                    *mpeg_video_head_data
+    int64_t                    *gop_number
 )
 {
-    tsp_header_t h;
-    int64_t reset_position        = mpegts_ftell( tsf_ctx );
-    int32_t rest_ts_packet_length = tsf_ctx->ts_packet_length;
-    /* check identifier. */
-    uint8_t identifier;
-    if( read_1byte( tsf_ctx, &h, program_id, &identifier ) )
-        return -1;
-    mpegts_file_seek( tsf_ctx, reset_position, MPEGTS_SEEK_SET );
-    tsf_ctx->ts_packet_length = rest_ts_packet_length;
-    /* check Start Code. */
-    mpeg_video_start_code_info_t start_code_info;
-    if( mpeg_video_judge_start_code( mpeg_video_head_data, identifier, &start_code_info ) )
-        return -2;
-    uint32_t read_size = start_code_info.read_size;
-    /* get header/extension information. */
-    uint8_t buf[read_size];
-    uint8_t *buf_p = buf;
-    while( tsf_ctx->ts_packet_length < (int32_t)read_size )
-    {
-        if( tsf_ctx->ts_packet_length )
-        {
-            int32_t read = tsf_ctx->ts_packet_length;
-            mpegts_file_read( tsf_ctx, buf_p, read );
-            buf_p += read;
-            read_size -= read;
-        }
-        mpegts_file_seek( tsf_ctx, 0, MPEGTS_SEEK_NEXT );
-        if( mpegts_seek_packet_payload_data( tsf_ctx, &h, program_id, INDICATOR_UNCHECKED ) )
+    mapi_log( LOG_LV2, "[check] %s()\n", __func__ );
+    int result = -1;
+    /* parse payload data. */
+    mpegts_payload_reader_t reader = { tsf_ctx, program_id, 0, 1 };
+    mpeg_bit_reader_t br;
+    mpeg_bit_reader_init( &br, NULL, 0, mpegts_map_next_payload_data, &reader );
+    uint8_t mpeg_video_head_data[MPEG_VIDEO_START_CODE_SIZE] = { 0x00, 0x00, 0x01, 0x00 };
+    while( !mpeg_bit_reader_next_start_code( &br, &(mpeg_video_head_data[MPEG_VIDEO_START_CODE_SIZE - 1]) ) )
+    {
+        /* check Start Code. */
+        uint8_t identifier = mpeg_bit_reader_show_bits( &br, 8 );
+        if( br.error )
+            return -1;
+        mpeg_video_start_code_info_t start_code_info;
+        if( mpeg_video_judge_start_code( mpeg_video_head_data, identifier, &start_code_info ) )
+            continue;
+        /* get header/extension information. */
+        if( mpeg_video_read_header_info( &br, start_code_info.start_code, video_info ) )
             return -1;
+        /* debug. */
+        mpeg_video_debug_header_info( video_info, start_code_info.searching_status );
+        /* check the status detection. */
+        if( start_code_info.searching_status == DETECT_GSC )
+            ++(*gop_number);
+        else if( start_code_info.searching_status == DETECT_PSC )
+            result = 0;
+        else if( start_code_info.searching_status == DETECT_SSC
+              || start_code_info.searching_status == DETECT_SEC )
+            return result;
     }
-    mpegts_file_read( tsf_ctx, buf_p, read_size );
-    int32_t check_size = mpeg_video_get_header_info( buf, start_code_info.start_code, video_info );
-    if( check_size < (int32_t)start_code_info.read_size )
+    return -1;
+}
+
+static int mpegts_get_avc_video_picture_info
+(
+    tsf_ctx_t                  *tsf_ctx,
+    uint16_t                    program_id,
+    avc_video_info_t           *avc_info,
+    int64_t                    *gop_number
+)
+{
+    mapi_log( LOG_LV2, "[check] %s()\n", __func__ );
+    /* parse payload data. */
+    mpegts_payload_reader_t reader = { tsf_ctx, program_id, 0, 1 };
+    mpeg_bit_reader_t br;
+    mpeg_bit_reader_init( &br, NULL, 0, mpegts_map_next_payload_data, &reader );
+    br.escape = 1;
+    avc_video_reset_access_unit( avc_info );
+    uint8_t nal_header;
+    while( !mpeg_bit_reader_next_start_code( &br, &nal_header ) )
     {
-        /* reset position. */
-        mpegts_file_seek( tsf_ctx, reset_position, MPEGTS_SEEK_SET );
-        tsf_ctx->ts_packet_length = rest_ts_packet_length;
-        int64_t seek_size = check_size;
-        while( tsf_ctx->ts_packet_length < seek_size )
-        {
-            seek_size -= tsf_ctx->ts_packet_length;
-            mpegts_file_seek( tsf_ctx, 0, MPEGTS_SEEK_NEXT );
-            if( mpegts_seek_packet_payload_data( tsf_ctx, &h, program_id, INDICATOR_UNCHECKED ) )
-                return -1;
-        }
-        mpegts_file_seek( tsf_ctx, seek_size, MPEGTS_SEEK_CUR );
-    }
-    /* debug. */
-    mpeg_video_debug_header_info( video_info, start_code_info.searching_status );
-    /* check the status detection. */
-    if( start_code_info.searching_status == DETECT_GSC )
-        ++(*gop_number);
-    else if( start_code_info.searching_status == DETECT_PSC )
-        return 2;
-    else if( start_code_info.searching_status == DETECT_SSC
-          || start_code_info.searching_status == DETECT_SEC )
-        return 1;
-    return 0;
+        if( avc_video_read_nal_unit( &br, nal_header, avc_info ) != 1 )
+            continue;
+        /* detect the first slice of the access unit. */
+        avc_video_debug_picture_info( avc_info );
+        if( avc_info->picture.keyframe )
+            ++(*gop_number);
+        return 0;
+    }
+    return -1;
 }
 
-static int mpegts_get_mpeg_video_picture_info
+static int mpegts_get_hevc_video_picture_info
 (
     tsf_ctx_t                  *tsf_ctx,
     uint16_t                    program_id,
-    mpeg_video_info_t          *video_info,
+    hevc_video_info_t          *hevc_info,
     int64_t                    *gop_number
 )
 {
     mapi_log( LOG_LV2, "[check] %s()\n", __func__ );
-    int result = -1;
     /* parse payload data. */
-    tsp_header_t h;
-    uint8_t mpeg_video_head_data[MPEG_VIDEO_START_CODE_SIZE];
-    memset( mpeg_video_head_data, MPEG_VIDEO_START_CODE_ALL_CLEAR_VALUE, MPEG_VIDEO_START_CODE_SIZE );
-    int no_exist_start_indicator = 1;
-    do
+    mpegts_payload_reader_t reader = { tsf_ctx, program_id, 0, 1 };
+    mpeg_bit_reader_t br;
+    mpeg_bit_reader_init( &br, NULL, 0, mpegts_map_next_payload_data, &reader );
+    br.escape = 1;
+    uint8_t nal_header;
+    while( !mpeg_bit_reader_next_start_code( &br, &nal_header ) )
     {
-        if( mpegts_seek_packet_payload_data( tsf_ctx, &h, program_id, INDICATOR_UNCHECKED ) )
-            return -1;
-        /* check start indicator. */
-        if( no_exist_start_indicator && !h.payload_unit_start_indicator )
-        {
-            mpegts_file_seek( tsf_ctx, 0, MPEGTS_SEEK_NEXT );
+        if( hevc_video_read_nal_unit( &br, nal_header, hevc_info ) != 1 )
             continue;
-        }
-        if( h.payload_unit_start_indicator )
-        {
-            /* check PES packet length, flags. */
-            mpeg_pes_header_info_t pes_info;
-            GET_PES_PACKET_HEADER( tsf_ctx, pes_info );
-            mapi_log( LOG_LV3, "[debug] PES packet_len:%d, pts_flag:%d, dts_flag:%d, header_len:%d\n"
-                             , pes_info.packet_length, pes_info.pts_flag, pes_info.dts_flag, pes_info.header_length );
-            mpegts_file_seek( tsf_ctx, pes_info.header_length, MPEGTS_SEEK_CUR );
-            no_exist_start_indicator = 0;
-        }
-        /* search Start Code. */
-        while( tsf_ctx->ts_packet_length )
-        {
-            mpegts_file_read( tsf_ctx, &(mpeg_video_head_data[MPEG_VIDEO_START_CODE_SIZE - 1]), 1 );
-            /* check Start Code. */
-            if( mpeg_video_check_start_code_common_head( mpeg_video_head_data ) )
-            {
-                BYTE_DATA_SHIFT( mpeg_video_head_data, MPEG_VIDEO_START_CODE_SIZE );
-                continue;
-            }
-            /* get header information. */
-            int read_reslut = mpegts_read_mpeg_video_picutre_info( tsf_ctx, program_id, video_info, gop_number, mpeg_video_head_data );
-            if( read_reslut == -2 )
-            {
-                BYTE_DATA_SHIFT( mpeg_video_head_data, MPEG_VIDEO_START_CODE_SIZE );
-                continue;
-            }
-            else if( read_reslut == 2 )
-                result = 0;
-            else if( read_reslut < 0 )
-                return -1;
-            else if( read_reslut )
-                goto end_get_video_picture_info;
-            /* cleanup buffer. */
-            memset( mpeg_video_head_data, MPEG_VIDEO_START_CODE_ALL_CLEAR_VALUE, MPEG_VIDEO_START_CODE_SIZE );
-        }
-        mapi_log( LOG_LV4, "[debug] continue next packet. buf:0x%02X 0x%02X 0x%02X 0x--\n"
-                         , mpeg_video_head_data[0], mpeg_video_head_data[1], mpeg_video_head_data[2] );
-        /* seek next. */
-        mpegts_file_seek( tsf_ctx, 0, MPEGTS_SEEK_NEXT );
+        /* detect the first slice segment of the access unit. */
+        hevc_video_debug_picture_info( hevc_info );
+        if( hevc_info->picture.keyframe )
+            ++(*gop_number);
+        return 0;
     }
-    while( 1 );
-end_get_video_picture_info:
-    return result;
+    return -1;
 }
 
 static uint32_t mpegts_get_sample_packets_num( tsf_ctx_t *tsf_ctx, uint16_t program_id, mpeg_stream_type stream_type )
@@ -1850,17 +2262,13 @@ static void mpegts_get_sample_raw_data
     mpeg_stream_group_type      stream_judge, */
     uint32_t                    raw_data_size,
     int32_t                     read_offset,
-    uint8_t                   **buffer,
+    uint8_t                    *buffer,
     uint32_t                   *read_size
 )
 {
     mapi_log( LOG_LV3, "[check] %s()\n", __func__ );
     if( !raw_data_size )
         return;
-    /* allocate buffer. */
-    *buffer = (uint8_t *)malloc( raw_data_size );
-    if( !(*buffer) )
-        return;
     mapi_log( LOG_LV3, "[debug] buffer_size:%u\n", raw_data_size );
     /* read. */
     tsp_header_t h;
@@ -1897,12 +2305,12 @@ static void mpegts_get_sample_raw_data
             if( raw_data_size > *read_size + tsf_ctx->ts_packet_length )
             {
                 int32_t read = tsf_ctx->ts_packet_length;
-                mpegts_file_read( tsf_ctx, *buffer + *read_size, read );
+                mpegts_file_read( tsf_ctx, buffer + *read_size, read );
                 *read_size += read;
             }
             else
             {
-                mpegts_file_read( tsf_ctx, *buffer + *read_size, raw_data_size - *read_size );
+                mpegts_file_read( tsf_ctx, buffer + *read_size, raw_data_size - *read_size );
                 *read_size = raw_data_size;
                 mpegts_file_seek( tsf_ctx, 0, MPEGTS_SEEK_NEXT );
                 break;
@@ -1919,17 +2327,12 @@ static void mpegts_get_sample_pes_packet_data
     tsf_ctx_t                  *tsf_ctx,
     uint16_t                    program_id,
     uint32_t                    ts_packet_count,
-    uint8_t                   **buffer,
+    uint8_t                    *buffer,
     uint32_t                   *read_size
 )
 {
     mapi_log( LOG_LV3, "[check] %s()\n", __func__ );
-    /* allocate buffer. */
-    uint32_t sample_size = ts_packet_count * TS_PACKET_SIZE;
-    *buffer = (uint8_t *)malloc( sample_size );
-    if( !(*buffer) )
-        return;
-    mapi_log( LOG_LV3, "[debug] buffer_size:%u\n", sample_size );
+    mapi_log( LOG_LV3, "[debug] buffer_size:%u\n", ts_packet_count * TS_PACKET_SIZE );
     /* read. */
     tsp_header_t h;
     *read_size = 0;
@@ -1941,7 +2344,7 @@ static void mpegts_get_sample_pes_packet_data
         if( tsf_ctx->ts_packet_length > 0 )
         {
             int32_t read = tsf_ctx->ts_packet_length;
-            mpegts_file_read( tsf_ctx, *buffer + *read_size, read );
+            mpegts_file_read( tsf_ctx, buffer + *read_size, read );
             *read_size += read;
         }
         /* seek next. */
@@ -1954,60 +2357,271 @@ static void mpegts_get_sample_ts_packet_data
     tsf_ctx_t                  *tsf_ctx,
     uint16_t                    program_id,
     uint32_t                    ts_packet_count,
-    uint8_t                   **buffer,
+    uint8_t                    *buffer,
     uint32_t                   *read_size
 )
 {
     mapi_log( LOG_LV3, "[check] %s()\n", __func__ );
-    /* allocate buffer. */
-    uint32_t sample_size = ts_packet_count * TS_PACKET_SIZE;
-    *buffer = (uint8_t *)malloc( sample_size );
-    if( !(*buffer) )
-        return;
-    mapi_log( LOG_LV3, "[debug] buffer_size:%u\n", sample_size );
+    mapi_log( LOG_LV3, "[debug] buffer_size:%u\n", ts_packet_count * TS_PACKET_SIZE );
     /* read. */
     tsp_header_t h;
     *read_size = 0;
     for( uint32_t i = 0; i < ts_packet_count; ++i )
     {
         /* read packet data. */
-        mpegts_file_read( tsf_ctx, *buffer + *read_size, TS_PACKET_SIZE );
+        mpegts_file_read( tsf_ctx, buffer + *read_size, TS_PACKET_SIZE );
         *read_size += TS_PACKET_SIZE;
         /* seek next packet. */
+        mpegts_file_seek( tsf_ctx, 0, MPEGTS_SEEK_NEXT );
         if( mpegts_search_program_id_packet( tsf_ctx, &h, program_id ) )
             break;
         mpegts_file_seek( tsf_ctx, -(TS_PACKET_HEADER_SIZE), MPEGTS_SEEK_CUR );
     }
 }
 
-static int mpegts_malloc_stream_parse_ctx
+static int mpegts_read_sample_data
 (
- /* mpeg_stream_type            stream_type, */
-    mpeg_stream_group_type      stream_judge,
-    void                      **stream_parse_info
+    tsf_ctx_t                  *tsf_ctx,
+    uint16_t                    program_id,
+    int64_t                     position,
+    uint32_t                    sample_size,
+    int32_t                     read_offset,
+    uint8_t                    *buffer,
+    uint32_t                   *read_size,
+    get_sample_data_mode        get_mode
 )
 {
-    *stream_parse_info = NULL;
-    if( (stream_judge & STREAM_IS_MPEG_VIDEO) == STREAM_IS_MPEG_VIDEO )
+    /* seek reading start position. */
+    mpegts_file_seek( tsf_ctx, position, MPEGTS_SEEK_RESET );
+    tsf_ctx->sync_byte_position = 0;
+    /* get data. */
+    uint32_t ts_packet_count = sample_size / TS_PACKET_SIZE;
+    *read_size = 0;
+    switch( get_mode )
     {
-        void *ctx = malloc( sizeof(mpeg_video_info_t) );
-        if( !ctx )
+        case GET_SAMPLE_DATA_CONTAINER :
+            mpegts_get_sample_ts_packet_data( tsf_ctx, program_id, ts_packet_count, buffer, read_size );
+            break;
+        case GET_SAMPLE_DATA_PES_PACKET :
+            mpegts_get_sample_pes_packet_data( tsf_ctx, program_id, ts_packet_count, buffer, read_size );
+            break;
+        case GET_SAMPLE_DATA_RAW :
+            mpegts_get_sample_raw_data( tsf_ctx, program_id /*, stream_type, stream_judge */
+                                      , sample_size, read_offset, buffer, read_size );
+            break;
+        default :
             return -1;
-        *stream_parse_info = ctx;
     }
+    mapi_log( LOG_LV3, "[debug] read_size:%d\n", *read_size );
     return 0;
 }
 
-static tsp_psi_ctx_t *mpegts_get_pmt_ctx( mpegts_info_t *info, uint16_t program_id )
+static int mpegts_add_sample_span( tss_ctx_t *stream, uint32_t *span_num, int64_t position, uint32_t size )
 {
-    if( info->pmt_ctx_index < info->pat_ctx.pid_list_num )
+    sample_span_t *list  = stream->span_info.list;
+    int64_t       *pos   = stream->span_info.position;
+    uint32_t       index = *span_num;
+    /* merge with the previous span if continuous. */
+    if( index && pos[index - 1] + list[index - 1].size == position )
     {
-        if( program_id == info->pmt_ctx[info->pmt_ctx_index].pmt_program_id )
-            return &(info->pmt_ctx[info->pmt_ctx_index]);
+        list[index - 1].size += size;
+        return 0;
     }
-    else
-        for( int32_t i = 0; i < info->pat_ctx.pid_list_num; ++i )
-        {
+    /* extend list. */
+    if( index >= stream->span_info.size )
+    {
+        uint32_t list_size = stream->span_info.size + TS_SAMPLE_SPAN_LIST_UNIT_NUM;
+        list = (sample_span_t *)realloc( stream->span_info.list, sizeof(sample_span_t) * list_size );
+        if( !list )
+            return -1;
+        stream->span_info.list = list;
+        pos = (int64_t *)realloc( stream->span_info.position, sizeof(int64_t) * list_size );
+        if( !pos )
+            return -1;
+        stream->span_info.position = pos;
+        stream->span_info.size     = list_size;
+    }
+    list[index].data = NULL;
+    list[index].size = size;
+    pos [index]      = position;
+    ++(*span_num);
+    return 0;
+}
+
+static int mpegts_get_sample_raw_data_spans
+(
+    tss_ctx_t                  *stream,
+    uint32_t                    raw_data_size,
+    int32_t                     read_offset,
+    uint32_t                   *span_num
+)
+{
+    mapi_log( LOG_LV3, "[check] %s()\n", __func__ );
+    tsf_ctx_t *tsf_ctx    = &(stream->tsf_ctx);
+    uint16_t   program_id = stream->program_id;
+    /* search. */
+    tsp_header_t h;
+    uint32_t read_size = 0;
+    while( read_size < raw_data_size )
+    {
+        if( mpegts_seek_packet_payload_data( tsf_ctx, &h, program_id, INDICATOR_UNCHECKED ) )
+            break;
+        if( h.payload_unit_start_indicator )
+        {
+            mpeg_pes_header_info_t pes_info;
+            GET_PES_PACKET_HEADER( tsf_ctx, pes_info );
+            /* skip PES packet header. */
+            if( mpegts_skip_pes_header( tsf_ctx, &h, program_id, &pes_info ) )
+                break;
+        }
+        /* check read start point. */
+        if( read_offset )
+        {
+            if( read_offset > tsf_ctx->ts_packet_length )
+            {
+                read_offset -= tsf_ctx->ts_packet_length;
+                mpegts_file_seek( tsf_ctx, tsf_ctx->ts_packet_length, MPEGTS_SEEK_CUR );
+            }
+            else
+            {
+                mpegts_file_seek( tsf_ctx, read_offset, MPEGTS_SEEK_CUR );
+                read_offset = 0;
+            }
+        }
+        /* add raw data span. */
+        if( tsf_ctx->ts_packet_length > 0 )
+        {
+            uint32_t size = tsf_ctx->ts_packet_length;
+            if( size > raw_data_size - read_size )
+                size = raw_data_size - read_size;
+            if( mpegts_add_sample_span( stream, span_num, mpegts_ftell( tsf_ctx ), size ) )
+                return -1;
+            read_size += size;
+        }
+        /* seek next. */
+        mpegts_file_seek( tsf_ctx, 0, MPEGTS_SEEK_NEXT );
+    }
+    return 0;
+}
+
+static int mpegts_get_sample_pes_packet_spans
+(
+    tss_ctx_t                  *stream,
+    uint32_t                    ts_packet_count,
+    uint32_t                   *span_num
+)
+{
+    mapi_log( LOG_LV3, "[check] %s()\n", __func__ );
+    tsf_ctx_t *tsf_ctx = &(stream->tsf_ctx);
+    tsp_header_t h;
+    for( uint32_t i = 0; i < ts_packet_count; ++i )
+    {
+        if( mpegts_seek_packet_payload_data( tsf_ctx, &h, stream->program_id, INDICATOR_UNCHECKED ) )
+            break;
+        /* add packet payload span. */
+        if( tsf_ctx->ts_packet_length > 0
+         && mpegts_add_sample_span( stream, span_num, mpegts_ftell( tsf_ctx ), tsf_ctx->ts_packet_length ) )
+            return -1;
+        /* seek next. */
+        mpegts_file_seek( tsf_ctx, 0, MPEGTS_SEEK_NEXT );
+    }
+    return 0;
+}
+
+static int mpegts_get_sample_ts_packet_spans
+(
+    tss_ctx_t                  *stream,
+    uint32_t                    ts_packet_count,
+    uint32_t                   *span_num
+)
+{
+    mapi_log( LOG_LV3, "[check] %s()\n", __func__ );
+    tsf_ctx_t *tsf_ctx = &(stream->tsf_ctx);
+    tsp_header_t h;
+    for( uint32_t i = 0; i < ts_packet_count; ++i )
+    {
+        /* add packet span. */
+        if( mpegts_add_sample_span( stream, span_num, mpegts_ftell( tsf_ctx ), TS_PACKET_SIZE ) )
+            return -1;
+        /* seek next packet. */
+        mpegts_file_seek( tsf_ctx, 0, MPEGTS_SEEK_NEXT );
+        if( mpegts_search_program_id_packet( tsf_ctx, &h, stream->program_id ) )
+            break;
+        mpegts_file_seek( tsf_ctx, -(TS_PACKET_HEADER_SIZE), MPEGTS_SEEK_CUR );
+    }
+    return 0;
+}
+
+static int mpegts_malloc_stream_parse_ctx
+(
+    mpeg_stream_type            stream_type,
+    mpeg_stream_group_type      stream_judge,
+    void                      **stream_parse_info
+)
+{
+    *stream_parse_info = NULL;
+    if( (stream_judge & STREAM_IS_MPEG_VIDEO) == STREAM_IS_MPEG_VIDEO )
+    {
+        void *ctx = malloc( sizeof(mpeg_video_info_t) );
+        if( !ctx )
+            return -1;
+        *stream_parse_info = ctx;
+    }
+    else if( stream_type == STREAM_VIDEO_AVC )
+    {
+        void *ctx = calloc( 1, sizeof(avc_video_info_t) );
+        if( !ctx )
+            return -1;
+        *stream_parse_info = ctx;
+    }
+    else if( stream_type == STREAM_VIDEO_HEVC )
+    {
+        void *ctx = calloc( 1, sizeof(hevc_video_info_t) );
+        if( !ctx )
+            return -1;
+        *stream_parse_info = ctx;
+    }
+    return 0;
+}
+
+static int mpegts_copy_stream_parse_ctx
+(
+    mpeg_stream_type            stream_type,
+    mpeg_stream_group_type      stream_judge,
+    void                       *src_parse_info,
+    void                      **dst_parse_info
+)
+{
+    *dst_parse_info = NULL;
+    if( !src_parse_info )
+        return 0;
+    size_t size = 0;
+    if( (stream_judge & STREAM_IS_MPEG_VIDEO) == STREAM_IS_MPEG_VIDEO )
+        size = sizeof(mpeg_video_info_t);
+    else if( stream_type == STREAM_VIDEO_AVC )
+        size = sizeof(avc_video_info_t);
+    else if( stream_type == STREAM_VIDEO_HEVC )
+        size = sizeof(hevc_video_info_t);
+    if( !size )
+        return 0;
+    void *ctx = malloc( size );
+    if( !ctx )
+        return -1;
+    memcpy( ctx, src_parse_info, size );
+    *dst_parse_info = ctx;
+    return 0;
+}
+
+static tsp_psi_ctx_t *mpegts_get_pmt_ctx( mpegts_info_t *info, uint16_t program_id )
+{
+    if( info->pmt_ctx_index < info->pat_ctx.pid_list_num )
+    {
+        if( program_id == info->pmt_ctx[info->pmt_ctx_index].pmt_program_id )
+            return &(info->pmt_ctx[info->pmt_ctx_index]);
+    }
+    else
+        for( int32_t i = 0; i < info->pat_ctx.pid_list_num; ++i )
+        {
             if( info->pat_ctx.pid_list[i].disable_pid )
                 continue;
             if( program_id == info->pmt_ctx[i].pmt_program_id )
@@ -2406,15 +3020,6 @@ static mpeg_stream_type get_sample_stream_type( void *ih, mpeg_sample_type sampl
     return stream->stream_type;
 }
 
-static void free_sample_buffer( uint8_t **buffer )
-{
-    if( !buffer )
-        return;
-    if( *buffer )
-        free( *buffer );
-    buffer = NULL;
-}
-
 static int get_sample_data
 (
     void                       *ih,
@@ -2423,13 +3028,13 @@ static int get_sample_data
     int64_t                     position,
     uint32_t                    sample_size,
     int32_t                     read_offset,
-    uint8_t                   **dst_buffer,
+    uint8_t                    *dst_buffer,
     uint32_t                   *dst_read_size,
     get_sample_data_mode        get_mode
 )
 {
     mpegts_info_t *info = (mpegts_info_t *)ih;
-    if( !info || position < 0 )
+    if( !info || !dst_buffer || position < 0 )
         return -1;
     /* check program id. */
     tsp_psi_ctx_t          *psi_ctx      = &(info->pmt_ctx[info->pmt_ctx_index]);
@@ -2467,32 +3072,191 @@ static int get_sample_data
     }
     else
         return -1;
+    return mpegts_read_sample_data( tsf_ctx, program_id, position, sample_size, read_offset
+                                  , dst_buffer, dst_read_size, get_mode );
+}
+
+static int get_sample_spans
+(
+    void                       *ih,
+    mpeg_sample_type            sample_type,
+    uint8_t                     stream_number,
+    int64_t                     position,
+    uint32_t                    sample_size,
+    int32_t                     read_offset,
+    sample_span_t             **dst_spans,
+    uint32_t                   *dst_span_num,
+    get_sample_data_mode        get_mode
+)
+{
+    mpegts_info_t *info = (mpegts_info_t *)ih;
+    if( !info || position < 0 )
+        return -1;
+    /* check stream. */
+    tsp_psi_ctx_t *psi_ctx = &(info->pmt_ctx[info->pmt_ctx_index]);
+    tss_ctx_t     *stream  = NULL;
+    if( sample_type == SAMPLE_TYPE_VIDEO && stream_number < psi_ctx->video_stream_num )
+        stream = &(psi_ctx->video_stream[stream_number]);
+    else if( sample_type == SAMPLE_TYPE_AUDIO && stream_number < psi_ctx->audio_stream_num )
+        stream = &(psi_ctx->audio_stream[stream_number]);
+    else if( sample_type == SAMPLE_TYPE_CAPTION && stream_number < psi_ctx->caption_stream_num )
+        stream = &(psi_ctx->caption_stream[stream_number]);
+    else if( sample_type == SAMPLE_TYPE_DSMCC && stream_number < psi_ctx->dsmcc_stream_num )
+        stream = &(psi_ctx->dsmcc_stream[stream_number]);
+    else
+        return -1;
+    tsf_ctx_t *tsf_ctx = &(stream->tsf_ctx);
     /* seek reading start position. */
     mpegts_file_seek( tsf_ctx, position, MPEGTS_SEEK_RESET );
     tsf_ctx->sync_byte_position = 0;
-    /* get data. */
-    uint32_t  ts_packet_count = sample_size / TS_PACKET_SIZE;
-    uint8_t  *buffer          = NULL;
-    uint32_t  read_size       = 0;
+    /* collect data spans. */
+    uint32_t ts_packet_count = sample_size / TS_PACKET_SIZE;
+    uint32_t span_num        = 0;
+    int      result          = -1;
     switch( get_mode )
     {
         case GET_SAMPLE_DATA_CONTAINER :
-            mpegts_get_sample_ts_packet_data( tsf_ctx, program_id, ts_packet_count, &buffer, &read_size );
+            result = mpegts_get_sample_ts_packet_spans( stream, ts_packet_count, &span_num );
             break;
         case GET_SAMPLE_DATA_PES_PACKET :
-            mpegts_get_sample_pes_packet_data( tsf_ctx, program_id, ts_packet_count, &buffer, &read_size );
+            result = mpegts_get_sample_pes_packet_spans( stream, ts_packet_count, &span_num );
             break;
         case GET_SAMPLE_DATA_RAW :
-            mpegts_get_sample_raw_data( tsf_ctx, program_id /*, stream_type, stream_judge */
-                                      , sample_size, read_offset, &buffer, &read_size );
+            result = mpegts_get_sample_raw_data_spans( stream, sample_size, read_offset, &span_num );
+            break;
         default :
             break;
     }
-    if( !buffer )
+    if( result || !span_num )
+        return -1;
+    /* map the sample range into the reader cache. */
+    sample_span_t *list         = stream->span_info.list;
+    int64_t       *span_pos     = stream->span_info.position;
+    int64_t        end_position = mpegts_ftell( tsf_ctx );
+    int64_t        map_position = span_pos[0];
+    int64_t        map_size     = span_pos[span_num - 1] + list[span_num - 1].size - map_position;
+    uint8_t       *map_data     = NULL;
+    if( file_reader.fmap( tsf_ctx->fr_ctx, map_position, map_size, &map_data ) )
+        return -1;
+    for( uint32_t i = 0; i < span_num; ++i )
+        list[i].data = map_data + (span_pos[i] - map_position);
+    mpegts_fseek( tsf_ctx, end_position, SEEK_SET );
+    mapi_log( LOG_LV3, "[debug] span_num:%u  map_size:%" PRId64 "\n", span_num, map_size );
+    *dst_spans    = list;
+    *dst_span_num = span_num;
+    return 0;
+}
+
+static inline int64_t mpegts_get_sample_range_end( tsf_ctx_t *tsf_ctx, sample_read_info_t *read_info, int64_t file_size )
+{
+    /* the data of a sample ends in the packet which has the start of the next sample. */
+    int64_t end = (read_info->next_position > read_info->position)
+                ? read_info->next_position + tsf_ctx->packet_size
+                : read_info->position + ((int64_t)read_info->sample_size / TS_PACKET_SIZE + 1) * tsf_ctx->packet_size;
+    return (end < file_size) ? end : file_size;
+}
+
+static int get_sample_range_data
+(
+    void                       *ih,
+    mpeg_sample_type            sample_type,
+    uint8_t                     stream_number,
+    sample_read_info_t         *read_info,
+    uint32_t                    read_num,
+    uint8_t                    *dst_buffer,
+    get_sample_data_mode        get_mode
+)
+{
+    mpegts_info_t *info = (mpegts_info_t *)ih;
+    if( !info || !read_info || !dst_buffer )
+        return -1;
+    /* check stream. */
+    tsp_psi_ctx_t *psi_ctx = &(info->pmt_ctx[info->pmt_ctx_index]);
+    tss_ctx_t     *stream  = NULL;
+    if( sample_type == SAMPLE_TYPE_VIDEO && stream_number < psi_ctx->video_stream_num )
+        stream = &(psi_ctx->video_stream[stream_number]);
+    else if( sample_type == SAMPLE_TYPE_AUDIO && stream_number < psi_ctx->audio_stream_num )
+        stream = &(psi_ctx->audio_stream[stream_number]);
+    else if( sample_type == SAMPLE_TYPE_CAPTION && stream_number < psi_ctx->caption_stream_num )
+        stream = &(psi_ctx->caption_stream[stream_number]);
+    else if( sample_type == SAMPLE_TYPE_DSMCC && stream_number < psi_ctx->dsmcc_stream_num )
+        stream = &(psi_ctx->dsmcc_stream[stream_number]);
+    else
         return -1;
-    mapi_log( LOG_LV3, "[debug] read_size:%d\n", read_size );
-    *dst_buffer    = buffer;
-    *dst_read_size = read_size;
+    tsf_ctx_t *tsf_ctx   = &(stream->tsf_ctx);
+    int64_t    file_size = mpegts_get_file_size( tsf_ctx );
+    /* read samples in position order, one cache window per merged range. */
+    uint32_t i = 0;
+    while( i < read_num )
+    {
+        if( read_info[i].position < 0 )
+            return -1;
+        int64_t  window_start = read_info[i].position;
+        int64_t  window_end   = mpegts_get_sample_range_end( tsf_ctx, &(read_info[i]), file_size );
+        uint32_t window_num   = 1;
+        while( i + window_num < read_num )
+        {
+            sample_read_info_t *next = &(read_info[i + window_num]);
+            int64_t end = mpegts_get_sample_range_end( tsf_ctx, next, file_size );
+            if( next->position > window_end + TS_SAMPLE_RANGE_MERGE_GAP || end - window_start > TS_SAMPLE_RANGE_WINDOW_MAX )
+                break;
+            if( window_end < end )
+                window_end = end;
+            ++window_num;
+        }
+        if( window_end - window_start > TS_SAMPLE_RANGE_WINDOW_MAX )
+            window_end = window_start + TS_SAMPLE_RANGE_WINDOW_MAX;
+        if( window_end > file_size )
+            window_end = file_size;
+        /* fill the reader cache with the whole window at once. */
+        uint8_t *map_data = NULL;
+        if( file_reader.fmap( tsf_ctx->fr_ctx, window_start, window_end - window_start, &map_data ) )
+            return -1;
+        mapi_log( LOG_LV3, "[debug] sample window  start:%" PRId64 "  size:%" PRId64 "  num:%u\n"
+                         , window_start, window_end - window_start, window_num );
+        /* demux the successive samples in one pass. */
+        uint32_t window_last = i + window_num;
+        while( i < window_last )
+        {
+            uint32_t run_num  = 1;
+            uint32_t run_size = read_info[i].sample_size;
+            while( i + run_num < window_last )
+            {
+                sample_read_info_t *prev = &(read_info[i + run_num - 1]);
+                sample_read_info_t *next = &(read_info[i + run_num]);
+                if( next->position       < prev->position
+                 || next->position       > prev->next_position
+                 || next->sample_index  != prev->sample_index  + 1
+                 || next->buffer_offset != prev->buffer_offset + prev->sample_size )
+                    break;
+                run_size += next->sample_size;
+                ++run_num;
+            }
+            mapi_log( LOG_LV3, "[debug] sample run  start:%" PRId64 "  size:%u  num:%u\n"
+                             , read_info[i].position, run_size, run_num );
+            if( get_mode == GET_SAMPLE_DATA_PES_PACKET )
+            {
+                /* the size of PES payloads is unknown, so continue reading each sample from the last position. */
+                mpegts_file_seek( tsf_ctx, read_info[i].position, MPEGTS_SEEK_RESET );
+                tsf_ctx->sync_byte_position = 0;
+                for( ; run_num; --run_num, ++i )
+                    mpegts_get_sample_pes_packet_data( tsf_ctx, stream->program_id, read_info[i].sample_size / TS_PACKET_SIZE
+                                                     , dst_buffer + read_info[i].buffer_offset, &(read_info[i].read_size) );
+                continue;
+            }
+            /* the data of the successive samples adjoin, so read them at once and split. */
+            uint32_t read_size = 0;
+            if( mpegts_read_sample_data( tsf_ctx, stream->program_id, read_info[i].position
+                                       , run_size, read_info[i].read_offset
+                                       , dst_buffer + read_info[i].buffer_offset, &read_size, get_mode ) )
+                return -1;
+            for( ; run_num; --run_num, ++i )
+            {
+                read_info[i].read_size = (read_size < read_info[i].sample_size) ? read_size : read_info[i].sample_size;
+                read_size -= read_info[i].read_size;
+            }
+        }
+    }
     return 0;
 }
 
@@ -3036,6 +3800,548 @@ static int get_pcr( void *ih, pcr_info_t *pcr_info, uint16_t service_id )
     return result;
 }
 
+static int get_arrival_time_index
+(
+    void                       *ih,
+    uint32_t                    packet_interval,
+    arrival_time_info_t       **dst_index,
+    uint32_t                   *dst_index_num
+)
+{
+    mapi_log( LOG_LV2, "[mpegts_parser] %s()\n", __func__ );
+    mpegts_info_t *info = (mpegts_info_t *)ih;
+    if( !info || !info->tsf_ctx.fr_ctx || info->tsf_ctx.packet_size != TTS_PACKET_SIZE )
+        return -1;
+    if( !packet_interval )
+        packet_interval = 1;
+    int64_t   reset_position = mpegts_ftell( &(info->tsf_ctx) );
+    tsf_ctx_t tsf_ctx        = info->tsf_ctx;
+    tsf_ctx.arrival_time = MPEG_TIMESTAMP_INVALID_VALUE;
+    /* seek the first packet. */
+    mpegts_file_seek( &tsf_ctx, 0, MPEGTS_SEEK_RESET );
+    int      result    = -1;
+    uint32_t index_num = 0;
+    if( mpegts_seek_sync_byte_position( &tsf_ctx ) )
+        goto end_get_index;
+    int64_t position = tsf_ctx.read_position;
+    while( 1 )
+    {
+        /* read the TP_extra_header only. */
+        uint8_t header[TTS_HEADER_SIZE + 1];
+        if( mpegts_fseek( &tsf_ctx, position - TTS_HEADER_SIZE, SEEK_SET )
+         || mpegts_fread( &tsf_ctx, header, TTS_HEADER_SIZE + 1, NULL ) )
+            break;
+        if( header[TTS_HEADER_SIZE] != SYNC_BYTE )
+        {
+            mpegts_file_seek( &tsf_ctx, position, MPEGTS_SEEK_RESET );
+            if( mpegts_seek_sync_byte_position( &tsf_ctx ) )
+                break;
+            position = tsf_ctx.read_position;
+            continue;
+        }
+        /* extend index. */
+        if( index_num >= info->arrival_time_index_size )
+        {
+            uint32_t index_size = info->arrival_time_index_size + TS_ARRIVAL_TIME_INDEX_UNIT_NUM;
+            arrival_time_info_t *index = (arrival_time_info_t *)realloc( info->arrival_time_index, sizeof(arrival_time_info_t) * index_size );
+            if( !index )
+                goto end_get_index;
+            info->arrival_time_index      = index;
+            info->arrival_time_index_size = index_size;
+        }
+        info->arrival_time_index[index_num].file_position = position;
+        info->arrival_time_index[index_num].arrival_time  = mpegts_update_arrival_time( &tsf_ctx, tsp_get_arrival_time_stamp( header ) );
+        ++index_num;
+        position += (int64_t)packet_interval * TTS_PACKET_SIZE;
+    }
+    mapi_log( LOG_LV3, "[debug] arrival time index num:%u\n", index_num );
+    *dst_index     = info->arrival_time_index;
+    *dst_index_num = index_num;
+    result = index_num ? 0 : -1;
+end_get_index:
+    mpegts_file_seek( &(info->tsf_ctx), reset_position, MPEGTS_SEEK_RESET );
+    return result;
+}
+
+static int mpegts_open_scan( mpegts_info_t *info, tsf_ctx_t *tsf_ctx, int64_t *position )
+{
+    int32_t packet_size = info->tsf_ctx.packet_size;
+    int32_t header_size = (packet_size == TTS_PACKET_SIZE) ? TTS_HEADER_SIZE : 0;
+    memset( tsf_ctx, 0, sizeof(tsf_ctx_t) );
+    tsf_ctx->packet_size  = packet_size;
+    tsf_ctx->arrival_time = MPEG_TIMESTAMP_INVALID_VALUE;
+    /* use own reader, and map the large blocks directly from its cache. */
+    if( mpegts_open( tsf_ctx, info->mpegts, (int64_t)packet_size * TS_PCR_SCAN_BUFFER_PACKET_NUM ) )
+        return -1;
+    int32_t sync_position = mpegts_check_sync_byte_position( tsf_ctx, packet_size, TS_PACKET_FIRST_CHECK_COUNT_NUM );
+    if( sync_position < 0 )
+    {
+        mpegts_close( tsf_ctx );
+        return -1;
+    }
+    *position = sync_position < header_size ? sync_position + packet_size : sync_position;
+    return 0;
+}
+
+static int64_t mpegts_map_scan_packets( mpegts_info_t *info, tsf_ctx_t *tsf_ctx, int64_t *position, uint8_t **data )
+{
+    /* map the continuous packets from the position, and resync if lost. */
+    int32_t packet_size = tsf_ctx->packet_size;
+    int32_t header_size = (packet_size == TTS_PACKET_SIZE) ? TTS_HEADER_SIZE : 0;
+    while( 1 )
+    {
+        int64_t packet_num = (info->file_size - (*position - header_size)) / packet_size;
+        if( packet_num > TS_PCR_SCAN_BUFFER_PACKET_NUM )
+            packet_num = TS_PCR_SCAN_BUFFER_PACKET_NUM;
+        if( packet_num <= 0 || file_reader.fmap( tsf_ctx->fr_ctx, *position - header_size, packet_num * packet_size, data ) )
+            return 0;
+        int64_t i = 0;
+        while( i < packet_num && (*data)[i * packet_size + header_size] == SYNC_BYTE )
+            ++i;
+        mapi_stats_add( MAPI_STATS_PACKETS_SCANNED, i );
+        if( i )
+            return i;
+        if( mpegts_fseek( tsf_ctx, *position + 1, SEEK_SET ) )
+            return 0;
+        int32_t sync_position = mpegts_check_sync_byte_position( tsf_ctx, packet_size, TS_PACKET_FIRST_CHECK_COUNT_NUM );
+        *position += 1 + (sync_position < 0 ? packet_size : sync_position);
+    }
+}
+
+static int mpegts_scan_pcr( mpegts_info_t *info, uint16_t program_id, uint32_t *dst_data_num )
+{
+    mapi_log( LOG_LV2, "[check] %s()\n", __func__ );
+    int32_t   packet_size = info->tsf_ctx.packet_size;
+    int32_t   header_size = (packet_size == TTS_PACKET_SIZE) ? TTS_HEADER_SIZE : 0;
+    tsf_ctx_t tsf_ctx;
+    int64_t   position;
+    if( mpegts_open_scan( info, &tsf_ctx, &position ) )
+        return -1;
+    int      result   = -1;
+    uint32_t data_num = 0;
+    int64_t  prev_pcr = -1;
+    int64_t  packet_num;
+    uint8_t *data;
+    while( (packet_num = mpegts_map_scan_packets( info, &tsf_ctx, &position, &data )) > 0 )
+    {
+        for( int64_t i = 0; i < packet_num; ++i )
+        {
+            uint8_t *packet = &(data[i * packet_size + header_size]);
+            /* check PID, adaptation field and PCR flag only. */
+            if( (((packet[1] & 0x1F) << 8) | packet[2]) != program_id
+             || (packet[1] & 0x80) || !(packet[3] & 0x20) || packet[4] < 7 || !(packet[5] & 0x10) )
+                continue;
+            if( data_num >= info->pcr_scan_data_size )
+            {
+                uint32_t data_size = info->pcr_scan_data_size + TS_PCR_SCAN_DATA_UNIT_NUM;
+                pcr_scan_data_t *tmp = (pcr_scan_data_t *)realloc( info->pcr_scan_data, sizeof(pcr_scan_data_t) * data_size );
+                if( !tmp )
+                    goto end_scan;
+                info->pcr_scan_data      = tmp;
+                info->pcr_scan_data_size = data_size;
+            }
+            pcr_scan_data_t *pcr_data = &(info->pcr_scan_data[data_num++]);
+            pcr_data->file_position = position + i * packet_size;
+            pcr_data->pcr           = tsp_get_program_clock_reference( &(packet[6]) );
+            pcr_data->arrival_time  = header_size
+                                    ? mpegts_update_arrival_time( &tsf_ctx, tsp_get_arrival_time_stamp( &(packet[-TTS_HEADER_SIZE]) ) )
+                                    : (int64_t)MPEG_TIMESTAMP_INVALID_VALUE;
+            pcr_data->discontinuity = (prev_pcr < 0)
+                                   || (packet[5] & 0x80)
+                                   || pcr_get_interval( prev_pcr, pcr_data->pcr ) > PCR_DISCONTINUITY_INTERVAL_MAX;
+            prev_pcr = pcr_data->pcr;
+        }
+        position += packet_num * packet_size;
+    }
+    mapi_log( LOG_LV3, "[check] PCR scan num:%u\n", data_num );
+    *dst_data_num = data_num;
+    result = data_num ? 0 : -1;
+end_scan:
+    mpegts_close( &tsf_ctx );
+    return result;
+}
+
+static void mpegts_calculate_pcr_stats( pcr_scan_data_t *data, uint32_t data_num, int32_t packet_size, pcr_scan_stats_t *stats )
+{
+    /* fit each continuous segment by the least squares, assuming a constant bitrate. */
+    double   total_packets = 0, total_ticks = 0, total_arrival_ticks = 0, total_arrival_pcr_ticks = 0;
+    double   square_sum = 0, jitter_max = 0;
+    uint32_t residual_num = 0, interval_num = 0;
+    stats->min_interval = stats->max_interval = 0;
+    for( uint32_t start = 0, end; start < data_num; start = end )
+    {
+        if( start )
+            ++(stats->discontinuity_num);
+        for( end = start + 1; end < data_num && !data[end].discontinuity; ++end )
+        {
+            int64_t interval = pcr_get_interval( data[end - 1].pcr, data[end].pcr );
+            if( interval > PCR_REPETITION_INTERVAL_MAX )
+                ++(stats->repetition_error_num);
+            if( !(interval_num++) || interval < stats->min_interval )
+                stats->min_interval = interval;
+            if( stats->max_interval < interval )
+                stats->max_interval = interval;
+        }
+        if( end - start < 2 )
+            continue;
+        /* x: packet count, y: unwrapped PCR, relative to the segment start. */
+        uint32_t num = end - start;
+        double   mean_x = 0, mean_y = 0, y = 0;
+        for( uint32_t i = start + 1; i < end; ++i )
+        {
+            y      += pcr_get_interval( data[i - 1].pcr, data[i].pcr );
+            mean_x += (double)((data[i].file_position - data[start].file_position) / packet_size);
+            mean_y += y;
+        }
+        double segment_packets = (double)((data[end - 1].file_position - data[start].file_position) / packet_size);
+        double segment_ticks   = y;
+        mean_x /= num;
+        mean_y /= num;
+        double sxx = 0, sxy = 0;
+        y = 0;
+        for( uint32_t i = start; i < end; ++i )
+        {
+            if( i > start )
+                y += pcr_get_interval( data[i - 1].pcr, data[i].pcr );
+            double dx = (double)((data[i].file_position - data[start].file_position) / packet_size) - mean_x;
+            sxx += dx * dx;
+            sxy += dx * (y - mean_y);
+        }
+        double slope = sxx > 0 ? sxy / sxx : 0;
+        y = 0;
+        for( uint32_t i = start; i < end; ++i )
+        {
+            if( i > start )
+                y += pcr_get_interval( data[i - 1].pcr, data[i].pcr );
+            double dx       = (double)((data[i].file_position - data[start].file_position) / packet_size) - mean_x;
+            double residual = y - (mean_y + slope * dx);
+            square_sum += residual * residual;
+            if( jitter_max < fabs( residual ) )
+                jitter_max = fabs( residual );
+            ++residual_num;
+        }
+        total_packets += segment_packets;
+        total_ticks   += segment_ticks;
+        if( data[start].arrival_time != (int64_t)MPEG_TIMESTAMP_INVALID_VALUE )
+        {
+            total_arrival_ticks     += (double)(data[end - 1].arrival_time - data[start].arrival_time);
+            total_arrival_pcr_ticks += segment_ticks;
+        }
+    }
+    stats->pcr_num    = data_num;
+    stats->duration   = (int64_t)total_ticks;
+    stats->bitrate    = total_ticks > 0 ? total_packets * TS_PACKET_SIZE * 8 * PCR_CLOCK_FREQUENCY / total_ticks : 0;
+    stats->jitter_max = jitter_max * 1000 / (PCR_CLOCK_FREQUENCY / 1000000);
+    stats->jitter_rms = residual_num ? sqrt( square_sum / residual_num ) * 1000 / (PCR_CLOCK_FREQUENCY / 1000000) : 0;
+    stats->drift      = total_arrival_ticks > 0 ? (total_arrival_pcr_ticks / total_arrival_ticks - 1) * 1000000 : 0;
+}
+
+static uint16_t mpegts_get_service_pcr_program_id( mpegts_info_t *info, uint16_t service_id )
+{
+    if( !info->pmt_ctx || !info->pat_ctx.pid_list_num )
+        return TS_PID_ERR;
+    uint32_t pmt_ctx_index = 0;
+    if( service_id )
+    {
+        for( int32_t i = 0; i < info->pat_ctx.pid_list_num; ++i )
+            if( info->pat_ctx.pid_list[i].program_number == service_id )
+            {
+                pmt_ctx_index = i;
+                break;
+            }
+    }
+    else if( info->pmt_ctx_index < info->pat_ctx.pid_list_num )
+        pmt_ctx_index = info->pmt_ctx_index;
+    return info->pmt_ctx[pmt_ctx_index].pcr_program_id;
+}
+
+static int scan_pcr
+(
+    void                       *ih,
+    uint16_t                    service_id,
+    pcr_scan_data_t           **dst_data,
+    uint32_t                   *dst_data_num,
+    pcr_scan_stats_t           *stats
+)
+{
+    mapi_log( LOG_LV2, "[mpegts_parser] %s()\n", __func__ );
+    mpegts_info_t *info = (mpegts_info_t *)ih;
+    if( !info )
+        return -1;
+    uint16_t program_id = mpegts_get_service_pcr_program_id( info, service_id );
+    if( program_id & MPEGTS_ILLEGAL_PROGRAM_ID_MASK )
+        return -1;
+    uint32_t data_num = 0;
+    if( mpegts_scan_pcr( info, program_id, &data_num ) )
+        return -1;
+    if( stats )
+    {
+        memset( stats, 0, sizeof(pcr_scan_stats_t) );
+        stats->pcr_program_id = program_id;
+        mpegts_calculate_pcr_stats( info->pcr_scan_data, data_num, info->tsf_ctx.packet_size, stats );
+    }
+    if( dst_data )
+        *dst_data = info->pcr_scan_data;
+    if( dst_data_num )
+        *dst_data_num = data_num;
+    return 0;
+}
+
+static int mpegts_scan_packet_stats( mpegts_info_t *info )
+{
+    mapi_log( LOG_LV2, "[check] %s()\n", __func__ );
+    int32_t   packet_size = info->tsf_ctx.packet_size;
+    int32_t   header_size = (packet_size == TTS_PACKET_SIZE) ? TTS_HEADER_SIZE : 0;
+    tsf_ctx_t tsf_ctx;
+    int64_t   position;
+    mpegts_stats_ctx_t *stats = mpegts_create_stats();
+    if( !stats )
+        return -1;
+    if( mpegts_open_scan( info, &tsf_ctx, &position ) )
+    {
+        mpegts_release_stats( &stats );
+        return -1;
+    }
+    int64_t  packet_num;
+    uint8_t *data;
+    while( (packet_num = mpegts_map_scan_packets( info, &tsf_ctx, &position, &data )) > 0 )
+    {
+        for( int64_t i = 0; i < packet_num; ++i )
+            mpegts_update_stats( stats, packet_size, position + i * packet_size, &(data[i * packet_size + header_size]) );
+        position += packet_num * packet_size;
+    }
+    mpegts_close( &tsf_ctx );
+    info->packet_stats = stats;
+    return 0;
+}
+
+static int compare_pid_packet_stats( const void *a, const void *b )
+{
+    return (int)((const pid_packet_stats_t *)a)->program_id - (int)((const pid_packet_stats_t *)b)->program_id;
+}
+
+static int get_packet_stats( void *ih, packet_stats_t *stats )
+{
+    mapi_log( LOG_LV2, "[mpegts_parser] %s()\n", __func__ );
+    mpegts_info_t *info = (mpegts_info_t *)ih;
+    if( !info || !stats )
+        return -1;
+    /* the parsing and the demuxing do not collect, so scan the file at the first request. */
+    if( !info->packet_stats && mpegts_scan_packet_stats( info ) )
+        return -1;
+    /* select the most packets read continuously. */
+    mpegts_stats_run_t *run = mpegts_get_stats_run( info->packet_stats );
+    if( !run || !run->packet_num )
+        return -1;
+    pid_packet_stats_t *pid_stats = (pid_packet_stats_t *)realloc( info->pid_packet_stats, sizeof(pid_packet_stats_t) * run->pid_num );
+    if( !pid_stats )
+        return -1;
+    info->pid_packet_stats = pid_stats;
+    for( uint16_t i = 0; i < run->pid_num; ++i )
+        pid_stats[i] = run->pid[i].stats;
+    qsort( pid_stats, run->pid_num, sizeof(pid_packet_stats_t), compare_pid_packet_stats );
+    /* summarize. */
+    memset( stats, 0, sizeof(packet_stats_t) );
+    stats->start_position = run->start_position;
+    stats->end_position   = run->end_position;
+    stats->packet_num     = run->packet_num;
+    stats->pid_stats_num  = run->pid_num;
+    stats->pid_stats      = pid_stats;
+    for( uint16_t i = 0; i < run->pid_num; ++i )
+    {
+        pid_packet_stats_t *pid = &(pid_stats[i]);
+        stats->cc_error_num  += pid->cc_error_num;
+        stats->tei_error_num += pid->tei_error_num;
+        if( pid->pcr_num )
+        {
+            stats->pcr_repetition_error_num    += pid->pcr_repetition_error_num;
+            stats->pcr_discontinuity_error_num += pid->pcr_discontinuity_error_num;
+            if( stats->pcr_interval_max < pid->pcr_interval_max )
+                stats->pcr_interval_max = pid->pcr_interval_max;
+        }
+        if( pid->program_id == TS_PID_PAT )
+        {
+            stats->pat_error_num    = pid->section_interval_error_num;
+            stats->pat_interval_max = pid->section_interval_max;
+            continue;
+        }
+        for( int32_t j = 0; j < info->pat_ctx.pid_list_num; ++j )
+            if( info->pat_ctx.pid_list[j].program_id == pid->program_id )
+            {
+                stats->pmt_error_num += pid->section_interval_error_num;
+                if( stats->pmt_interval_max < pid->section_interval_max )
+                    stats->pmt_interval_max = pid->section_interval_max;
+                break;
+            }
+    }
+    return 0;
+}
+
+static int compare_pid_bitrate_histogram( const void *a, const void *b )
+{
+    return (int)((const pid_bitrate_histogram_t *)a)->program_id - (int)((const pid_bitrate_histogram_t *)b)->program_id;
+}
+
+static void mpegts_release_bitrate_histogram( mpegts_info_t *info )
+{
+    for( uint16_t i = 0; i < info->bitrate_histogram_size; ++i )
+        free( info->bitrate_histogram[i].bucket );
+    free( info->bitrate_histogram );
+    info->bitrate_histogram      = NULL;
+    info->bitrate_histogram_size = 0;
+}
+
+static int mpegts_extend_bitrate_buckets( mpegts_info_t *info, uint16_t pid_num, uint32_t bucket_size, uint32_t new_bucket_size )
+{
+    for( uint16_t i = 0; i < pid_num; ++i )
+    {
+        uint32_t *bucket = (uint32_t *)realloc( info->bitrate_histogram[i].bucket, sizeof(uint32_t) * new_bucket_size );
+        if( !bucket )
+            return -1;
+        memset( &(bucket[bucket_size]), 0, sizeof(uint32_t) * (new_bucket_size - bucket_size) );
+        info->bitrate_histogram[i].bucket = bucket;
+    }
+    return 0;
+}
+
+static int mpegts_scan_bitrate( mpegts_info_t *info, uint16_t pcr_program_id, int64_t bucket_duration, bitrate_histogram_t *histogram )
+{
+    mapi_log( LOG_LV2, "[check] %s()\n", __func__ );
+    int32_t   packet_size = info->tsf_ctx.packet_size;
+    int32_t   header_size = (packet_size == TTS_PACKET_SIZE) ? TTS_HEADER_SIZE : 0;
+    uint16_t *pid_index   = (uint16_t *)calloc( TS_PID_NUM, sizeof(uint16_t) );     /* 0: none, index + 1 */
+    if( !pid_index )
+        return -1;
+    tsf_ctx_t tsf_ctx;
+    int64_t   position;
+    if( mpegts_open_scan( info, &tsf_ctx, &position ) )
+    {
+        free( pid_index );
+        return -1;
+    }
+    mpegts_release_bitrate_histogram( info );
+    int      result      = -1;
+    uint16_t pid_num     = 0;
+    uint32_t bucket_size = 0;
+    uint32_t bucket_num  = 0;
+    int64_t  total_num   = 0;
+    /* clock: the arrival time, or the PCR interpolated by the packet count. */
+    int64_t  start_time  = -1;
+    int64_t  pcr_clock   = 0;
+    int64_t  last_pcr    = -1;
+    int64_t  last_pcr_packet_num = 0;
+    double   packet_ticks = 0;
+    int64_t  packet_num;
+    uint8_t *data;
+    while( (packet_num = mpegts_map_scan_packets( info, &tsf_ctx, &position, &data )) > 0 )
+    {
+        for( int64_t i = 0; i < packet_num; ++i, ++total_num )
+        {
+            uint8_t *packet     = &(data[i * packet_size + header_size]);
+            uint16_t program_id = ((packet[1] & 0x1F) << 8) | packet[2];
+            int64_t  clock      = 0;
+            if( header_size )
+            {
+                int64_t arrival_time = mpegts_update_arrival_time( &tsf_ctx, tsp_get_arrival_time_stamp( &(packet[-TTS_HEADER_SIZE]) ) );
+                if( start_time < 0 )
+                    start_time = arrival_time;
+                clock = arrival_time - start_time;
+            }
+            else
+            {
+                if( program_id == pcr_program_id
+                 && !(packet[1] & 0x80) && (packet[3] & 0x20) && packet[4] >= 7 && (packet[5] & 0x10) )
+                {
+                    int64_t pcr = tsp_get_program_clock_reference( &(packet[6]) );
+                    if( last_pcr >= 0 )
+                    {
+                        int64_t interval = pcr_get_interval( last_pcr, pcr );
+                        int64_t count    = total_num - last_pcr_packet_num;
+                        /* keep the clock continuous over the discontinuity. */
+                        if( (packet[5] & 0x80) || interval > PCR_DISCONTINUITY_INTERVAL_MAX )
+                            interval = (int64_t)(count * packet_ticks);
+                        else if( count )
+                            packet_ticks = (double)interval / count;
+                        pcr_clock += interval;
+                    }
+                    last_pcr            = pcr;
+                    last_pcr_packet_num = total_num;
+                }
+                if( last_pcr >= 0 )
+                    clock = pcr_clock + (int64_t)((total_num - last_pcr_packet_num) * packet_ticks);
+            }
+            uint32_t bucket_index = clock > 0 ? (uint32_t)(clock / bucket_duration) : 0;
+            if( bucket_index >= bucket_size )
+            {
+                uint32_t new_bucket_size = bucket_index + TS_BITRATE_BUCKET_UNIT_NUM;
+                if( mpegts_extend_bitrate_buckets( info, pid_num, bucket_size, new_bucket_size ) )
+                    goto end_scan;
+                bucket_size = new_bucket_size;
+            }
+            if( bucket_num <= bucket_index )
+                bucket_num = bucket_index + 1;
+            if( !pid_index[program_id] )
+            {
+                if( pid_num >= info->bitrate_histogram_size )
+                {
+                    uint16_t histogram_size = info->bitrate_histogram_size + TS_STATS_PID_UNIT_NUM;
+                    pid_bitrate_histogram_t *tmp = (pid_bitrate_histogram_t *)realloc( info->bitrate_histogram, sizeof(pid_bitrate_histogram_t) * histogram_size );
+                    if( !tmp )
+                        goto end_scan;
+                    memset( &(tmp[pid_num]), 0, sizeof(pid_bitrate_histogram_t) * (histogram_size - pid_num) );
+                    info->bitrate_histogram      = tmp;
+                    info->bitrate_histogram_size = histogram_size;
+                }
+                pid_bitrate_histogram_t *pid = &(info->bitrate_histogram[pid_num]);
+                pid->program_id = program_id;
+                pid->packet_num = 0;
+                pid->bucket     = (uint32_t *)calloc( bucket_size, sizeof(uint32_t) );
+                if( !pid->bucket )
+                    goto end_scan;
+                pid_index[program_id] = ++pid_num;
+            }
+            pid_bitrate_histogram_t *pid = &(info->bitrate_histogram[pid_index[program_id] - 1]);
+            ++(pid->packet_num);
+            ++(pid->bucket[bucket_index]);
+        }
+        position += packet_num * packet_size;
+    }
+    mapi_log( LOG_LV3, "[check] bitrate scan packets:%" PRId64 " buckets:%u\n", total_num, bucket_num );
+    qsort( info->bitrate_histogram, pid_num, sizeof(pid_bitrate_histogram_t), compare_pid_bitrate_histogram );
+    histogram->arrival_time_base = !!header_size;
+    histogram->bucket_num        = bucket_num;
+    histogram->packet_num        = total_num;
+    histogram->pid_num           = pid_num;
+    histogram->pid               = info->bitrate_histogram;
+    result = pid_num ? 0 : -1;
+end_scan:
+    mpegts_close( &tsf_ctx );
+    free( pid_index );
+    return result;
+}
+
+static int scan_bitrate
+(
+    void                       *ih,
+    uint16_t                    service_id,
+    uint32_t                    bucket_msec,
+    bitrate_histogram_t        *histogram
+)
+{
+    mapi_log( LOG_LV2, "[mpegts_parser] %s()\n", __func__ );
+    mpegts_info_t *info = (mpegts_info_t *)ih;
+    if( !info || !bucket_msec || !histogram || !info->tsf_ctx.fr_ctx )
+        return -1;
+    /* PCR is necessary as the clock except TTS. */
+    uint16_t program_id = mpegts_get_service_pcr_program_id( info, service_id );
+    if( (program_id & MPEGTS_ILLEGAL_PROGRAM_ID_MASK) && info->tsf_ctx.packet_size != TTS_PACKET_SIZE )
+        return -1;
+    memset( histogram, 0, sizeof(bitrate_histogram_t) );
+    histogram->pcr_program_id  = program_id;
+    histogram->bucket_duration = (int64_t)bucket_msec * (PCR_CLOCK_FREQUENCY / 1000);
+    return mpegts_scan_bitrate( info, program_id, histogram->bucket_duration, histogram );
+}
+
 static int get_video_info( void *ih, uint8_t stream_number, video_sample_info_t *video_sample_info )
 {
     mapi_log( LOG_LV2, "[mpegts_parser] %s()\n", __func__ );
@@ -3058,6 +4364,7 @@ static int get_video_info( void *ih, uint8_t stream_number, video_sample_info_t
     if( mpegts_get_stream_timestamp( tsf_ctx, program_id, stream_id_type, &ts ) )
         return -1;
     int64_t start_position = tsf_ctx->read_position;
+    int64_t arrival_time   = mpegts_get_arrival_time( tsf_ctx, start_position );
     /* check raw data. */
     sample_raw_data_info_t raw_data_info = { 0 };
     if( mpegts_get_sample_raw_data_info( tsf_ctx, program_id, stream_type, stream_judge, &raw_data_info ) )
@@ -3090,6 +4397,35 @@ static int get_video_info( void *ih, uint8_t stream_number, video_sample_info_t
             top_field_first      = video_info->picture_coding_ext.top_field_first;
         }
     }
+    else if( stream_type == STREAM_VIDEO_AVC )
+    {
+        avc_video_info_t *avc_info = (avc_video_info_t *)stream_parse_info;
+        if( !mpegts_get_avc_video_picture_info( tsf_ctx, program_id, avc_info, video_stream_gop_number ) )
+        {
+            gop_number           = *video_stream_gop_number;
+            progressive_sequence = avc_info->picture.progressive_sequence;
+            closed_gop           = avc_info->picture.closed_gop;
+            picture_coding_type  = avc_info->picture.picture_coding_type;
+            temporal_reference   = avc_info->picture.temporal_reference;
+            picture_structure    = avc_info->picture.picture_structure;
+            progressive_frame    = avc_info->picture.progressive_sequence;
+            top_field_first      = (picture_structure == MPEG_VIDEO_TOP_FIELD_STRUCTURE);
+        }
+    }
+    else if( stream_type == STREAM_VIDEO_HEVC )
+    {
+        hevc_video_info_t *hevc_info = (hevc_video_info_t *)stream_parse_info;
+        if( !mpegts_get_hevc_video_picture_info( tsf_ctx, program_id, hevc_info, video_stream_gop_number ) )
+        {
+            gop_number           = *video_stream_gop_number;
+            progressive_sequence = hevc_info->picture.progressive_sequence;
+            closed_gop           = hevc_info->picture.closed_gop;
+            picture_coding_type  = hevc_info->picture.picture_coding_type;
+            temporal_reference   = hevc_info->picture.temporal_reference;
+            picture_structure    = hevc_info->picture.picture_structure;
+            progressive_frame    = hevc_info->picture.progressive_sequence;
+        }
+    }
     else
     {
         gop_number = 0;     // FIXME
@@ -3109,6 +4445,7 @@ static int get_video_info( void *ih, uint8_t stream_number, video_sample_info_t
     video_sample_info->program_id           = program_id;
     video_sample_info->pts                  = ts.pts;
     video_sample_info->dts                  = ts.dts;
+    video_sample_info->arrival_time         = arrival_time;
     video_sample_info->gop_number           = gop_number;
     video_sample_info->progressive_sequence = progressive_sequence;
     video_sample_info->closed_gop           = closed_gop;
@@ -3148,6 +4485,7 @@ static int get_audio_info( void *ih, uint8_t stream_number, audio_sample_info_t
     if( mpegts_get_stream_timestamp( tsf_ctx, program_id, stream_id_type, &ts ) )
         return -1;
     int64_t start_position = tsf_ctx->read_position;
+    int64_t arrival_time   = mpegts_get_arrival_time( tsf_ctx, start_position );
     /* check raw data. */
     sample_raw_data_info_t raw_data_info = { 0 };
     if( mpegts_get_sample_raw_data_info( tsf_ctx, program_id, stream_type, stream_judge, &raw_data_info ) )
@@ -3169,6 +4507,7 @@ static int get_audio_info( void *ih, uint8_t stream_number, audio_sample_info_t
     audio_sample_info->program_id           = program_id;
     audio_sample_info->pts                  = ts.pts;
     audio_sample_info->dts                  = ts.dts;
+    audio_sample_info->arrival_time         = arrival_time;
     audio_sample_info->sampling_frequency   = raw_data_info.stream_raw_info.sampling_frequency;
     audio_sample_info->bitrate              = raw_data_info.stream_raw_info.bitrate;
     audio_sample_info->channel              = raw_data_info.stream_raw_info.channel;
@@ -3192,6 +4531,10 @@ static inline void release_stream_handle( tss_ctx_t **stream_ctxs, uint8_t *stre
         mpegts_close( &(stream->tsf_ctx) );
         if( stream->stream_parse_info )
             free( stream->stream_parse_info );
+        if( stream->span_info.list )
+            free( stream->span_info.list );
+        if( stream->span_info.position )
+            free( stream->span_info.position );
     }
     free( *stream_ctxs );
     *stream_ctxs = NULL;
@@ -3268,24 +4611,28 @@ static int set_pmt_stream_info( mpegts_info_t *info )
         tss_ctx_t *stream = &(video_ctx[i]);
         stream->tsf_ctx.fr_ctx    = NULL;
         stream->stream_parse_info = NULL;
+        memset( &(stream->span_info), 0, sizeof(stream->span_info) );
     }
     for( uint8_t i = 0; i < audio_stream_num; ++i )
     {
         tss_ctx_t *stream = &(audio_ctx[i]);
         stream->tsf_ctx.fr_ctx    = NULL;
         stream->stream_parse_info = NULL;
+        memset( &(stream->span_info), 0, sizeof(stream->span_info) );
     }
     for( uint8_t i = 0; i < caption_stream_num; ++i )
     {
         tss_ctx_t *stream = &(caption_ctx[i]);
         stream->tsf_ctx.fr_ctx    = NULL;
         stream->stream_parse_info = NULL;
+        memset( &(stream->span_info), 0, sizeof(stream->span_info) );
     }
     for( uint8_t i = 0; i < dsmcc_stream_num; ++i )
     {
         tss_ctx_t *stream = &(dsmcc_ctx[i]);
         stream->tsf_ctx.fr_ctx    = NULL;
         stream->stream_parse_info = NULL;
+        memset( &(stream->span_info), 0, sizeof(stream->span_info) );
     }
     /* check exist. */
     video_stream_num = audio_stream_num = caption_stream_num = dsmcc_stream_num = 0;
@@ -3373,13 +4720,16 @@ static int set_pmt_stream_info( mpegts_info_t *info )
                 {
                     /* allocate. */
                     void *stream_parse_info;
-                    if( mpegts_malloc_stream_parse_ctx( /* stream_type, */ stream_judge, &stream_parse_info ) )
+                    if( mpegts_malloc_stream_parse_ctx( stream_type, stream_judge, &stream_parse_info ) )
                     {
                         mpegts_close( &(stream->tsf_ctx) );
                         goto fail_allocate_ctxs;
                     }
                     /* setup. */
                     stream->tsf_ctx.packet_size            = info->tsf_ctx.packet_size;
+                    stream->tsf_ctx.search_packet          = info->tsf_ctx.search_packet;
+                    stream->tsf_ctx.seek_next              = info->tsf_ctx.seek_next;
+                    stream->tsf_ctx.arrival_time           = info->tsf_ctx.arrival_time;
                     stream->tsf_ctx.sync_byte_position     = -1;
                     stream->tsf_ctx.read_position          = 0;
                     stream->tsf_ctx.ts_packet_length       = TS_PACKET_SIZE;
@@ -3566,11 +4916,19 @@ static int parse_pmt_info( mpegts_info_t *info )
     int64_t start_position = mpegts_ftell( &(info->tsf_ctx) );
     for( int32_t i = 0; i < info->pat_ctx.pid_list_num; ++i )
     {
-        
-        if( mpegts_parse_pmt( info, i ) < 0 )
-            goto fail_parse;
-        if( info->pmt_ctx[i].pcr_program_id && mpegts_parse_pcr( info, i ) )
+        mapi_trace_begin( "mpegts_parse_pmt" );
+        int pmt_result = mpegts_parse_pmt( info, i );
+        mapi_trace_end();
+        if( pmt_result < 0 )
             goto fail_parse;
+        if( info->pmt_ctx[i].pcr_program_id )
+        {
+            mapi_trace_begin( "mpegts_parse_pcr" );
+            int pcr_result = mpegts_parse_pcr( info, i );
+            mapi_trace_end();
+            if( pcr_result )
+                goto fail_parse;
+        }
         /* reset position. */
         mpegts_file_seek( &(info->tsf_ctx), start_position, MPEGTS_SEEK_RESET );
     }
@@ -3791,7 +5149,10 @@ static int parse( void *ih )
         release_all_handle( info );
     int result = -1;
     int64_t start_position = mpegts_ftell( &(info->tsf_ctx) );
-    if( mpegts_parse_pat( info ) )
+    mapi_trace_begin( "mpegts_parse_pat" );
+    int pat_result = mpegts_parse_pat( info );
+    mapi_trace_end();
+    if( pat_result )
         goto end_parse;
     if( mpegts_parse_cat( info ) )
         mapi_log( LOG_LV2, "[check] CAT packet was not detected.\n" );
@@ -3826,6 +5187,9 @@ static void *initialize( const char *input_file, int64_t buffer_size )
     info->file_size                      = file_size;
     info->buffer_size                    = buffer_size;
     info->tsf_ctx.packet_size            = TS_PACKET_SIZE;
+    info->tsf_ctx.search_packet          = mpegts_search_ts_program_id_packet;
+    info->tsf_ctx.seek_next              = NULL;
+    info->tsf_ctx.arrival_time           = MPEG_TIMESTAMP_INVALID_VALUE;
     info->tsf_ctx.sync_byte_position     = -1;
     info->tsf_ctx.read_position          = 0;
     info->tsf_ctx.ts_packet_length       = TS_PACKET_SIZE;
@@ -3836,8 +5200,12 @@ static void *initialize( const char *input_file, int64_t buffer_size )
     info->emm_program_id                 = TS_PID_ERR;
     info->descriptor_info                = descriptor_info;
     /* first check. */
-    if( mpegts_first_check( &(info->tsf_ctx) ) )
+    mapi_trace_begin( "mpegts_first_check" );
+    int first_check = mpegts_first_check( &(info->tsf_ctx) );
+    mapi_trace_end();
+    if( first_check )
         goto fail_initialize;
+    mpegts_select_packet_funcs( &(info->tsf_ctx) );
     return info;
 fail_initialize:
     mapi_log( LOG_LV2, "[mpegts_parser] failed to initialize.\n" );
@@ -3867,13 +5235,100 @@ static void release( void *ih )
     free( info->descriptor_info );
     release_all_handle( info );
     mpegts_close( &(info->tsf_ctx) );
+    free( info->arrival_time_index );
+    free( info->pcr_scan_data );
+    mpegts_release_stats( &(info->packet_stats) );
+    free( info->pid_packet_stats );
+    mpegts_release_bitrate_histogram( info );
     free( info->mpegts );
     free( info );
 }
 
+static int clone_stream_handle( mpegts_info_t *info, tss_ctx_t **dst_ctxs, tss_ctx_t *src_ctxs, uint8_t stream_num )
+{
+    *dst_ctxs = NULL;
+    if( !src_ctxs || !stream_num )
+        return 0;
+    tss_ctx_t *stream_ctxs = (tss_ctx_t *)malloc( sizeof(tss_ctx_t) * stream_num );
+    if( !stream_ctxs )
+        return -1;
+    for( uint8_t i = 0; i < stream_num; ++i )
+    {
+        tss_ctx_t *stream = &(stream_ctxs[i]);
+        *stream = src_ctxs[i];
+        stream->stream_parse_info = NULL;
+        stream->tsf_ctx.fr_ctx    = NULL;
+        memset( &(stream->span_info), 0, sizeof(stream->span_info) );
+        /* keep the sequence level information for parsing from the middle of the stream. */
+        if( mpegts_copy_stream_parse_ctx( stream->stream_type, stream->stream_judge
+                                        , src_ctxs[i].stream_parse_info, &(stream->stream_parse_info) )
+         || (src_ctxs[i].tsf_ctx.fr_ctx && mpegts_open( &(stream->tsf_ctx), info->mpegts, info->buffer_size )) )
+        {
+            if( stream->stream_parse_info )
+                free( stream->stream_parse_info );
+            release_stream_handle( &stream_ctxs, &i );
+            return -1;
+        }
+    }
+    *dst_ctxs = stream_ctxs;
+    return 0;
+}
+
+static void release_cursor( void *ch )
+{
+    mpegts_cursor_t *cursor = (mpegts_cursor_t *)ch;
+    if( !cursor )
+        return;
+    tsp_psi_ctx_t *psi_ctx = &(cursor->psi_ctx);
+    release_stream_handle( &(psi_ctx->video_stream), &(psi_ctx->video_stream_num) );
+    release_stream_handle( &(psi_ctx->audio_stream), &(psi_ctx->audio_stream_num) );
+    release_stream_handle( &(psi_ctx->caption_stream), &(psi_ctx->caption_stream_num) );
+    release_stream_handle( &(psi_ctx->dsmcc_stream), &(psi_ctx->dsmcc_stream_num) );
+    free( cursor );
+}
+
+static void *create_cursor( void *ih )
+{
+    mpegts_info_t *info = (mpegts_info_t *)ih;
+    if( !info || !info->pmt_ctx )
+        return NULL;
+    mpegts_cursor_t *cursor = (mpegts_cursor_t *)calloc( 1, sizeof(mpegts_cursor_t) );
+    if( !cursor )
+        return NULL;
+    /* share the parsed information, and read the streams with own file readers. */
+    tsp_psi_ctx_t *psi_ctx = &(info->pmt_ctx[info->pmt_ctx_index]);
+    cursor->info                = *info;
+    cursor->info.pmt_ctx        = &(cursor->psi_ctx);
+    cursor->info.pmt_ctx_index  = 0;
+    cursor->info.tsf_ctx.fr_ctx = NULL;
+    cursor->info.arrival_time_index      = NULL;
+    cursor->info.arrival_time_index_size = 0;
+    cursor->info.pcr_scan_data           = NULL;
+    cursor->info.pcr_scan_data_size      = 0;
+    cursor->info.packet_stats            = NULL;
+    cursor->info.pid_packet_stats        = NULL;
+    cursor->info.bitrate_histogram       = NULL;
+    cursor->info.bitrate_histogram_size  = 0;
+    cursor->psi_ctx.video_stream_num   = psi_ctx->video_stream_num;
+    cursor->psi_ctx.audio_stream_num   = psi_ctx->audio_stream_num;
+    cursor->psi_ctx.caption_stream_num = psi_ctx->caption_stream_num;
+    cursor->psi_ctx.dsmcc_stream_num   = psi_ctx->dsmcc_stream_num;
+    if( clone_stream_handle( info, &(cursor->psi_ctx.video_stream), psi_ctx->video_stream, psi_ctx->video_stream_num )
+     || clone_stream_handle( info, &(cursor->psi_ctx.audio_stream), psi_ctx->audio_stream, psi_ctx->audio_stream_num )
+     || clone_stream_handle( info, &(cursor->psi_ctx.caption_stream), psi_ctx->caption_stream, psi_ctx->caption_stream_num )
+     || clone_stream_handle( info, &(cursor->psi_ctx.dsmcc_stream), psi_ctx->dsmcc_stream, psi_ctx->dsmcc_stream_num ) )
+        goto fail_create_cursor;
+    return cursor;
+fail_create_cursor:
+    release_cursor( cursor );
+    return NULL;
+}
+
 mpeg_parser_t mpegts_parser = {
     initialize,
     release,
+    create_cursor,
+    release_cursor,
     parse,
     set_service_id,
     get_service_id_num,
@@ -3885,6 +5340,10 @@ mpeg_parser_t mpegts_parser = {
     get_video_info,
     get_audio_info,
     get_pcr,
+    get_arrival_time_index,
+    scan_pcr,
+    get_packet_stats,
+    scan_bitrate,
     get_stream_num,
     get_stream_data,
     get_specific_stream_data,
@@ -3892,7 +5351,8 @@ mpeg_parser_t mpegts_parser = {
     set_sample_position,
     seek_next_sample_position,
     get_sample_data,
-    free_sample_buffer,
+    get_sample_spans,
+    get_sample_range_data,
     get_sample_stream_type,
     get_stream_information
 };
@@ -58,3 +58,118 @@ extern void thread_wait_end( void * th, void **value_ptr )
         mapi_log( LOG_LV0, "[log] thread_wait_end()  result:%d\n", result );
     free( thread_ctrl );
 }
+
+typedef struct {
+    __gthread_mutex_t   mutex;
+} mutex_control_t;
+
+extern void *thread_mutex_create( void )
+{
+    mutex_control_t *mutex_ctrl = (mutex_control_t *)malloc( sizeof(mutex_control_t) );
+    if( !mutex_ctrl )
+        return NULL;
+    __gthread_mutex_init_function( &(mutex_ctrl->mutex) );
+    return mutex_ctrl;
+}
+
+extern void thread_mutex_lock( void *mh )
+{
+    mutex_control_t *mutex_ctrl = (mutex_control_t *)mh;
+    if( mutex_ctrl )
+        __gthread_mutex_lock( &(mutex_ctrl->mutex) );
+}
+
+extern void thread_mutex_unlock( void *mh )
+{
+    mutex_control_t *mutex_ctrl = (mutex_control_t *)mh;
+    if( mutex_ctrl )
+        __gthread_mutex_unlock( &(mutex_ctrl->mutex) );
+}
+
+extern void thread_mutex_release( void *mh )
+{
+    mutex_control_t *mutex_ctrl = (mutex_control_t *)mh;
+    if( !mutex_ctrl )
+        return;
+    __gthread_mutex_destroy( &(mutex_ctrl->mutex) );
+    free( mutex_ctrl );
+}
+
+typedef struct {
+    __gthread_cond_t    cond;
+} cond_control_t;
+
+extern void *thread_cond_create( void )
+{
+    cond_control_t *cond_ctrl = (cond_control_t *)malloc( sizeof(cond_control_t) );
+    if( !cond_ctrl )
+        return NULL;
+    __gthread_cond_init_function( &(cond_ctrl->cond) );
+    return cond_ctrl;
+}
+
+extern void thread_cond_wait( void *ch, void *mh )
+{
+    cond_control_t  *cond_ctrl  = (cond_control_t *)ch;
+    mutex_control_t *mutex_ctrl = (mutex_control_t *)mh;
+    if( cond_ctrl && mutex_ctrl )
+        __gthread_cond_wait( &(cond_ctrl->cond), &(mutex_ctrl->mutex) );
+}
+
+extern void thread_cond_signal( void *ch )
+{
+    cond_control_t *cond_ctrl = (cond_control_t *)ch;
+    if( cond_ctrl )
+        __gthread_cond_signal( &(cond_ctrl->cond) );
+}
+
+extern void thread_cond_broadcast( void *ch )
+{
+    cond_control_t *cond_ctrl = (cond_control_t *)ch;
+    if( cond_ctrl )
+        __gthread_cond_broadcast( &(cond_ctrl->cond) );
+}
+
+extern void thread_cond_release( void *ch )
+{
+    cond_control_t *cond_ctrl = (cond_control_t *)ch;
+    if( !cond_ctrl )
+        return;
+    __gthread_cond_destroy( &(cond_ctrl->cond) );
+    free( cond_ctrl );
+}
+
+#include <windows.h>
+
+extern uint32_t thread_get_cpu_num( void )
+{
+    SYSTEM_INFO si;
+    GetSystemInfo( &si );
+    return si.dwNumberOfProcessors ? (uint32_t)si.dwNumberOfProcessors : 1;
+}
+
+static __gthread_once_t shared_once = __GTHREAD_ONCE_INIT;
+
+static void thread_call_shared_once( void (*func)( void ) )
+{
+    __gthread_once( &shared_once, func );
+}
+
+static void thread_yield( void )
+{
+    SwitchToThread();
+}
+
+extern void thread_sleep( uint32_t msec )
+{
+    Sleep( msec );
+}
+
+extern uint64_t thread_get_time( void )
+{
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency( &frequency );
+    QueryPerformanceCounter( &counter );
+    return (uint64_t)(counter.QuadPart / frequency.QuadPart * 1000000
+                    + counter.QuadPart % frequency.QuadPart * 1000000 / frequency.QuadPart);
+}
@@ -60,3 +60,153 @@ extern void thread_wait_end( void * th, void **value_ptr )
         mapi_log( LOG_LV0, "[log] thread_wait_end()  result:%d\n", result );
     free( thread_ctrl );
 }
+
+typedef struct {
+    pthread_mutex_t mutex;
+} mutex_control_t;
+
+extern void *thread_mutex_create( void )
+{
+    mutex_control_t *mutex_ctrl = (mutex_control_t *)malloc( sizeof(mutex_control_t) );
+    if( !mutex_ctrl )
+        return NULL;
+    int result = pthread_mutex_init( &(mutex_ctrl->mutex), NULL );
+    if( result )
+    {
+        mapi_log( LOG_LV0, "[log] thread_mutex_create()  result:%d\n", result );
+        free( mutex_ctrl );
+        mutex_ctrl = NULL;
+    }
+    return mutex_ctrl;
+}
+
+extern void thread_mutex_lock( void *mh )
+{
+    mutex_control_t *mutex_ctrl = (mutex_control_t *)mh;
+    if( mutex_ctrl )
+        pthread_mutex_lock( &(mutex_ctrl->mutex) );
+}
+
+extern void thread_mutex_unlock( void *mh )
+{
+    mutex_control_t *mutex_ctrl = (mutex_control_t *)mh;
+    if( mutex_ctrl )
+        pthread_mutex_unlock( &(mutex_ctrl->mutex) );
+}
+
+extern void thread_mutex_release( void *mh )
+{
+    mutex_control_t *mutex_ctrl = (mutex_control_t *)mh;
+    if( !mutex_ctrl )
+        return;
+    pthread_mutex_destroy( &(mutex_ctrl->mutex) );
+    free( mutex_ctrl );
+}
+
+typedef struct {
+    pthread_cond_t  cond;
+} cond_control_t;
+
+extern void *thread_cond_create( void )
+{
+    cond_control_t *cond_ctrl = (cond_control_t *)malloc( sizeof(cond_control_t) );
+    if( !cond_ctrl )
+        return NULL;
+    int result = pthread_cond_init( &(cond_ctrl->cond), NULL );
+    if( result )
+    {
+        mapi_log( LOG_LV0, "[log] thread_cond_create()  result:%d\n", result );
+        free( cond_ctrl );
+        cond_ctrl = NULL;
+    }
+    return cond_ctrl;
+}
+
+extern void thread_cond_wait( void *ch, void *mh )
+{
+    cond_control_t  *cond_ctrl  = (cond_control_t *)ch;
+    mutex_control_t *mutex_ctrl = (mutex_control_t *)mh;
+    if( cond_ctrl && mutex_ctrl )
+        pthread_cond_wait( &(cond_ctrl->cond), &(mutex_ctrl->mutex) );
+}
+
+extern void thread_cond_signal( void *ch )
+{
+    cond_control_t *cond_ctrl = (cond_control_t *)ch;
+    if( cond_ctrl )
+        pthread_cond_signal( &(cond_ctrl->cond) );
+}
+
+extern void thread_cond_broadcast( void *ch )
+{
+    cond_control_t *cond_ctrl = (cond_control_t *)ch;
+    if( cond_ctrl )
+        pthread_cond_broadcast( &(cond_ctrl->cond) );
+}
+
+extern void thread_cond_release( void *ch )
+{
+    cond_control_t *cond_ctrl = (cond_control_t *)ch;
+    if( !cond_ctrl )
+        return;
+    pthread_cond_destroy( &(cond_ctrl->cond) );
+    free( cond_ctrl );
+}
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <time.h>
+#endif
+
+extern uint32_t thread_get_cpu_num( void )
+{
+#ifdef _WIN32
+    SYSTEM_INFO si;
+    GetSystemInfo( &si );
+    long cpu_num = si.dwNumberOfProcessors;
+#else
+    long cpu_num = sysconf( _SC_NPROCESSORS_ONLN );
+#endif
+    return cpu_num > 0 ? (uint32_t)cpu_num : 1;
+}
+
+static pthread_once_t shared_once = PTHREAD_ONCE_INIT;
+
+static void thread_call_shared_once( void (*func)( void ) )
+{
+    pthread_once( &shared_once, func );
+}
+
+#include <sched.h>
+
+static void thread_yield( void )
+{
+    sched_yield();
+}
+
+extern void thread_sleep( uint32_t msec )
+{
+#ifdef _WIN32
+    Sleep( msec );
+#else
+    struct timespec ts = { msec / 1000, (msec % 1000) * 1000000L };
+    nanosleep( &ts, NULL );
+#endif
+}
+
+extern uint64_t thread_get_time( void )
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency( &frequency );
+    QueryPerformanceCounter( &counter );
+    return (uint64_t)(counter.QuadPart / frequency.QuadPart * 1000000
+                    + counter.QuadPart % frequency.QuadPart * 1000000 / frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
@@ -71,3 +71,420 @@ extern const char *thread_get_model_name( void )
 #endif
     return model_name[model_type];
 }
+
+typedef struct thread_task_s thread_task_t;
+struct thread_task_s {
+    thread_task_t      *next;
+    thread_func         func;
+    void               *func_arg;
+    thread_func_ret     ret;
+    int                 done;
+    void               *pool;
+};
+
+typedef struct {
+    void               *mutex;
+    void               *task_cond;
+    void               *done_cond;
+    thread_task_t      *head;
+    thread_task_t      *tail;
+    int                 quit;
+    uint32_t            thread_num;
+    void              **thread;
+} thread_pool_t;
+
+static thread_task_t *thread_pool_pop_task( thread_pool_t *pool )
+{
+    thread_task_t *task = pool->head;
+    if( task )
+    {
+        pool->head = task->next;
+        if( !pool->head )
+            pool->tail = NULL;
+    }
+    return task;
+}
+
+static void thread_pool_run_task( thread_pool_t *pool, thread_task_t *task )
+{
+    /* called with the lock, and returns with the lock. */
+    thread_mutex_unlock( pool->mutex );
+    thread_func_ret ret = task->func( task->func_arg );
+    thread_mutex_lock( pool->mutex );
+    task->ret  = ret;
+    task->done = 1;
+    thread_cond_broadcast( pool->done_cond );
+}
+
+static thread_func_ret thread_pool_worker( void *args )
+{
+    thread_pool_t *pool = (thread_pool_t *)args;
+    thread_mutex_lock( pool->mutex );
+    while( 1 )
+    {
+        thread_task_t *task = thread_pool_pop_task( pool );
+        if( task )
+            thread_pool_run_task( pool, task );
+        else if( pool->quit )
+            break;
+        else
+            thread_cond_wait( pool->task_cond, pool->mutex );
+    }
+    thread_mutex_unlock( pool->mutex );
+    return (thread_func_ret)(0);
+}
+
+extern void *thread_pool_create( uint32_t thread_num )
+{
+    thread_pool_t *pool = (thread_pool_t *)calloc( 1, sizeof(thread_pool_t) );
+    if( !pool )
+        return NULL;
+    if( !thread_num )
+        thread_num = thread_get_cpu_num();
+    pool->mutex     = thread_mutex_create();
+    pool->task_cond = thread_cond_create();
+    pool->done_cond = thread_cond_create();
+    pool->thread    = (void **)calloc( thread_num, sizeof(void *) );
+    if( !pool->mutex || !pool->task_cond || !pool->done_cond || !pool->thread )
+        goto fail;
+    for( uint32_t i = 0; i < thread_num; ++i )
+    {
+        pool->thread[i] = thread_create( thread_pool_worker, pool );
+        if( !pool->thread[i] )
+            break;
+        ++(pool->thread_num);
+    }
+    if( pool->thread_num )
+        return pool;
+fail:
+    thread_pool_release( pool );
+    return NULL;
+}
+
+extern void thread_pool_release( void *ph )
+{
+    thread_pool_t *pool = (thread_pool_t *)ph;
+    if( !pool )
+        return;
+    /* the workers finish the queued tasks before the end. */
+    thread_mutex_lock( pool->mutex );
+    pool->quit = 1;
+    thread_cond_broadcast( pool->task_cond );
+    thread_mutex_unlock( pool->mutex );
+    for( uint32_t i = 0; i < pool->thread_num; ++i )
+        thread_wait_end( pool->thread[i], NULL );
+    free( pool->thread );
+    thread_cond_release( pool->done_cond );
+    thread_cond_release( pool->task_cond );
+    thread_mutex_release( pool->mutex );
+    free( pool );
+}
+
+static void *shared_pool;
+
+static void thread_pool_create_shared( void )
+{
+    shared_pool = thread_pool_create( 0 );
+}
+
+extern void *thread_pool_get_shared( void )
+{
+    /* created at the first use, and kept until the process exit. */
+    thread_call_shared_once( thread_pool_create_shared );
+    return shared_pool;
+}
+
+extern uint32_t thread_pool_get_thread_num( void *ph )
+{
+    thread_pool_t *pool = (thread_pool_t *)ph;
+    return pool ? pool->thread_num : 0;
+}
+
+extern void *thread_pool_submit( void *ph, thread_func func, void *func_arg )
+{
+    thread_pool_t *pool = (thread_pool_t *)ph;
+    if( !pool || !func )
+        return NULL;
+    thread_task_t *task = (thread_task_t *)calloc( 1, sizeof(thread_task_t) );
+    if( !task )
+        return NULL;
+    task->func     = func;
+    task->func_arg = func_arg;
+    task->pool     = pool;
+    thread_mutex_lock( pool->mutex );
+    if( pool->tail )
+        pool->tail->next = task;
+    else
+        pool->head = task;
+    pool->tail = task;
+    thread_cond_signal( pool->task_cond );
+    thread_mutex_unlock( pool->mutex );
+    return task;
+}
+
+extern void thread_future_wait( void *fh, void **value_ptr )
+{
+    thread_task_t *task = (thread_task_t *)fh;
+    if( !task )
+        return;
+    thread_pool_t *pool = (thread_pool_t *)task->pool;
+    thread_mutex_lock( pool->mutex );
+    while( !task->done )
+    {
+        /* help the queued tasks, so the waiting in a task does not stall the pool. */
+        thread_task_t *queued = thread_pool_pop_task( pool );
+        if( queued )
+            thread_pool_run_task( pool, queued );
+        else
+            thread_cond_wait( pool->done_cond, pool->mutex );
+    }
+    thread_mutex_unlock( pool->mutex );
+    if( value_ptr )
+        *value_ptr = task->ret;
+    free( task );
+}
+
+#define THREAD_CACHE_LINE_SIZE      (64)
+#define THREAD_RING_SPIN_NUM        (64)
+
+typedef struct {
+    uint32_t            sequence;
+    void               *data;
+} thread_ring_slot_t;
+
+typedef struct {
+    /* producer side. */
+    uint32_t            tail;
+    uint32_t            cached_head;
+    uint8_t             tail_pad[THREAD_CACHE_LINE_SIZE - 2 * sizeof(uint32_t)];
+    /* consumer side. */
+    uint32_t            head;
+    uint32_t            cached_tail;
+    uint8_t             head_pad[THREAD_CACHE_LINE_SIZE - 2 * sizeof(uint32_t)];
+    /* blocking wait. */
+    uint32_t            waiter_num;
+    uint32_t            closed;
+    uint8_t             wait_pad[THREAD_CACHE_LINE_SIZE - 2 * sizeof(uint32_t)];
+    thread_ring_type    type;
+    uint32_t            mask;
+    thread_ring_slot_t *slot;
+    void               *mutex;
+    void               *cond;
+} thread_ring_t;
+
+#define RING_LOAD( _ptr )               __atomic_load_n( _ptr, __ATOMIC_ACQUIRE )
+#define RING_STORE( _ptr, _value )      __atomic_store_n( _ptr, _value, __ATOMIC_RELEASE )
+
+extern void *thread_ring_create( uint32_t element_num, thread_ring_type type )
+{
+    if( !element_num || element_num > (1U << 30) )
+        return NULL;
+    uint32_t size = 1;
+    while( size < element_num )
+        size <<= 1;
+    thread_ring_t *ring = (thread_ring_t *)calloc( 1, sizeof(thread_ring_t) );
+    if( !ring )
+        return NULL;
+    ring->type  = type;
+    ring->mask  = size - 1;
+    ring->slot  = (thread_ring_slot_t *)calloc( size, sizeof(thread_ring_slot_t) );
+    ring->mutex = thread_mutex_create();
+    ring->cond  = thread_cond_create();
+    if( !ring->slot || !ring->mutex || !ring->cond )
+    {
+        thread_ring_release( ring );
+        return NULL;
+    }
+    for( uint32_t i = 0; i < size; ++i )
+        ring->slot[i].sequence = i;
+    return ring;
+}
+
+extern void thread_ring_release( void *rh )
+{
+    thread_ring_t *ring = (thread_ring_t *)rh;
+    if( !ring )
+        return;
+    if( ring->cond )
+        thread_cond_release( ring->cond );
+    if( ring->mutex )
+        thread_mutex_release( ring->mutex );
+    if( ring->slot )
+        free( ring->slot );
+    free( ring );
+}
+
+static int thread_ring_try_push( thread_ring_t *ring, void *data )
+{
+    if( ring->type == THREAD_RING_SPSC )
+    {
+        uint32_t tail = ring->tail;
+        if( tail - ring->cached_head > ring->mask )
+        {
+            ring->cached_head = RING_LOAD( &(ring->head) );
+            if( tail - ring->cached_head > ring->mask )
+                return -1;
+        }
+        ring->slot[tail & ring->mask].data = data;
+        RING_STORE( &(ring->tail), tail + 1 );
+        return 0;
+    }
+    /* reserve the slot, whose sequence tells that the consumer has released it. */
+    uint32_t tail = __atomic_load_n( &(ring->tail), __ATOMIC_RELAXED );
+    thread_ring_slot_t *slot;
+    while( 1 )
+    {
+        slot = &(ring->slot[tail & ring->mask]);
+        int32_t diff = (int32_t)(RING_LOAD( &(slot->sequence) ) - tail);
+        if( diff < 0 )
+            return -1;
+        if( diff == 0
+         && __atomic_compare_exchange_n( &(ring->tail), &tail, tail + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED ) )
+            break;
+        if( diff > 0 )
+            tail = __atomic_load_n( &(ring->tail), __ATOMIC_RELAXED );
+    }
+    slot->data = data;
+    RING_STORE( &(slot->sequence), tail + 1 );
+    return 0;
+}
+
+static int thread_ring_try_pop( thread_ring_t *ring, void **data )
+{
+    uint32_t head = ring->head;
+    if( ring->type == THREAD_RING_SPSC )
+    {
+        if( head == ring->cached_tail )
+        {
+            ring->cached_tail = RING_LOAD( &(ring->tail) );
+            if( head == ring->cached_tail )
+                return -1;
+        }
+        *data = ring->slot[head & ring->mask].data;
+        RING_STORE( &(ring->head), head + 1 );
+        return 0;
+    }
+    thread_ring_slot_t *slot = &(ring->slot[head & ring->mask]);
+    if( RING_LOAD( &(slot->sequence) ) != head + 1 )
+        return -1;
+    *data = slot->data;
+    RING_STORE( &(slot->sequence), head + ring->mask + 1 );
+    ring->head = head + 1;
+    return 0;
+}
+
+static void thread_ring_notify( thread_ring_t *ring )
+{
+    /* pairs with the fence in thread_ring_wait(), so a waiter does not miss the update. */
+    __atomic_thread_fence( __ATOMIC_SEQ_CST );
+    if( __atomic_load_n( &(ring->waiter_num), __ATOMIC_RELAXED ) )
+    {
+        thread_mutex_lock( ring->mutex );
+        thread_cond_broadcast( ring->cond );
+        thread_mutex_unlock( ring->mutex );
+    }
+}
+
+static int thread_ring_is_full( thread_ring_t *ring )
+{
+    uint32_t tail = RING_LOAD( &(ring->tail) );
+    if( ring->type == THREAD_RING_SPSC )
+        return tail - RING_LOAD( &(ring->head) ) > ring->mask;
+    return (int32_t)(RING_LOAD( &(ring->slot[tail & ring->mask].sequence) ) - tail) < 0;
+}
+
+static int thread_ring_is_empty( thread_ring_t *ring )
+{
+    uint32_t head = RING_LOAD( &(ring->head) );
+    if( ring->type == THREAD_RING_SPSC )
+        return head == RING_LOAD( &(ring->tail) );
+    return RING_LOAD( &(ring->slot[head & ring->mask].sequence) ) != head + 1;
+}
+
+static void thread_ring_wait( thread_ring_t *ring, int (*is_blocked)( thread_ring_t * ), uint32_t *spin_count )
+{
+    /* spin a little, and then sleep until the other side updates the ring. */
+    if( *spin_count < THREAD_RING_SPIN_NUM )
+    {
+        ++(*spin_count);
+        thread_yield();
+        return;
+    }
+    thread_mutex_lock( ring->mutex );
+    __atomic_add_fetch( &(ring->waiter_num), 1, __ATOMIC_SEQ_CST );
+    __atomic_thread_fence( __ATOMIC_SEQ_CST );
+    if( is_blocked( ring ) && !RING_LOAD( &(ring->closed) ) )
+        thread_cond_wait( ring->cond, ring->mutex );
+    __atomic_sub_fetch( &(ring->waiter_num), 1, __ATOMIC_SEQ_CST );
+    thread_mutex_unlock( ring->mutex );
+}
+
+extern int thread_ring_push( void *rh, void *data )
+{
+    thread_ring_t *ring = (thread_ring_t *)rh;
+    if( !ring || RING_LOAD( &(ring->closed) ) || thread_ring_try_push( ring, data ) )
+        return -1;
+    thread_ring_notify( ring );
+    return 0;
+}
+
+extern int thread_ring_pop( void *rh, void **data )
+{
+    thread_ring_t *ring = (thread_ring_t *)rh;
+    if( !ring || !data || thread_ring_try_pop( ring, data ) )
+        return -1;
+    thread_ring_notify( ring );
+    return 0;
+}
+
+extern int thread_ring_push_wait( void *rh, void *data )
+{
+    thread_ring_t *ring = (thread_ring_t *)rh;
+    if( !ring )
+        return -1;
+    uint32_t spin_count = 0;
+    while( !RING_LOAD( &(ring->closed) ) )
+    {
+        if( !thread_ring_try_push( ring, data ) )
+        {
+            thread_ring_notify( ring );
+            return 0;
+        }
+        thread_ring_wait( ring, thread_ring_is_full, &spin_count );
+    }
+    return -1;
+}
+
+extern int thread_ring_pop_wait( void *rh, void **data )
+{
+    thread_ring_t *ring = (thread_ring_t *)rh;
+    if( !ring || !data )
+        return -1;
+    uint32_t spin_count = 0;
+    while( 1 )
+    {
+        if( !thread_ring_try_pop( ring, data ) )
+        {
+            thread_ring_notify( ring );
+            return 0;
+        }
+        /* check the data again, which may be pushed before closing. */
+        if( RING_LOAD( &(ring->closed) ) )
+            return thread_ring_try_pop( ring, data );
+        thread_ring_wait( ring, thread_ring_is_empty, &spin_count );
+    }
+}
+
+extern void thread_ring_close( void *rh )
+{
+    thread_ring_t *ring = (thread_ring_t *)rh;
+    if( !ring )
+        return;
+    thread_mutex_lock( ring->mutex );
+    RING_STORE( &(ring->closed), 1 );
+    thread_cond_broadcast( ring->cond );
+    thread_mutex_unlock( ring->mutex );
+}
+
+#undef RING_LOAD
+#undef RING_STORE
@@ -29,10 +29,17 @@
 #ifndef __THREAD_UTILS_H__
 #define __THREAD_UTILS_H__
 
+#include <stdint.h>
+
 #define thread_func_ret     void *
 
 typedef thread_func_ret (*thread_func)( void * );
 
+typedef enum {
+    THREAD_RING_SPSC = 0,       /* single producer, single consumer. */
+    THREAD_RING_MPSC = 1        /* multi producer, single consumer. */
+} thread_ring_type;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -41,8 +48,64 @@ extern void *thread_create( thread_func func, void *func_arg );
 
 extern void thread_wait_end( void * th, void **value_ptr );
 
+extern void *thread_mutex_create( void );
+
+extern void thread_mutex_lock( void *mh );
+
+extern void thread_mutex_unlock( void *mh );
+
+extern void thread_mutex_release( void *mh );
+
+extern void *thread_cond_create( void );
+
+extern void thread_cond_wait( void *ch, void *mh );
+
+extern void thread_cond_signal( void *ch );
+
+extern void thread_cond_broadcast( void *ch );
+
+extern void thread_cond_release( void *ch );
+
 extern const char *thread_get_model_name( void );
 
+extern uint32_t thread_get_cpu_num( void );
+
+extern void thread_sleep( uint32_t msec );
+
+/* monotonic clock in microseconds. */
+extern uint64_t thread_get_time( void );
+
+/* thread pool: thread_num 0 means the number of processors. */
+extern void *thread_pool_create( uint32_t thread_num );
+
+extern void thread_pool_release( void *ph );
+
+extern void *thread_pool_get_shared( void );
+
+extern uint32_t thread_pool_get_thread_num( void *ph );
+
+/* returns a future, which must be waited by thread_future_wait() once. */
+extern void *thread_pool_submit( void *ph, thread_func func, void *func_arg );
+
+extern void thread_future_wait( void *fh, void **value_ptr );
+
+/* lock-free ring buffer: element_num is rounded up to the power of 2. */
+extern void *thread_ring_create( uint32_t element_num, thread_ring_type type );
+
+extern void thread_ring_release( void *rh );
+
+/* returns -1 without blocking, when the ring is full or empty. */
+extern int thread_ring_push( void *rh, void *data );
+
+extern int thread_ring_pop( void *rh, void **data );
+
+/* block until done, returns -1 when the ring is closed. the data left in the closed ring can be popped. */
+extern int thread_ring_push_wait( void *rh, void *data );
+
+extern int thread_ring_pop_wait( void *rh, void **data );
+
+extern void thread_ring_close( void *rh );
+
 #ifdef __cplusplus
 }
 #endif
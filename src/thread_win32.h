@@ -29,6 +29,12 @@
 
 //#include "thread_utils.h"
 
+/* Condition variables need Windows Vista or later. */
+#if !defined(_WIN32_WINNT) || _WIN32_WINNT < 0x0600
+#undef  _WIN32_WINNT
+#define _WIN32_WINNT 0x0600
+#endif
+
 #include <windows.h>
 #include <process.h>
 
@@ -73,3 +79,126 @@ extern void thread_wait_end( void * th, void **value_ptr )
         *value_ptr = thread_ctrl->ret;
     free( thread_ctrl );
 }
+
+typedef struct {
+    CRITICAL_SECTION    mutex;
+} mutex_control_t;
+
+extern void *thread_mutex_create( void )
+{
+    mutex_control_t *mutex_ctrl = (mutex_control_t *)malloc( sizeof(mutex_control_t) );
+    if( !mutex_ctrl )
+        return NULL;
+    InitializeCriticalSection( &(mutex_ctrl->mutex) );
+    return mutex_ctrl;
+}
+
+extern void thread_mutex_lock( void *mh )
+{
+    mutex_control_t *mutex_ctrl = (mutex_control_t *)mh;
+    if( mutex_ctrl )
+        EnterCriticalSection( &(mutex_ctrl->mutex) );
+}
+
+extern void thread_mutex_unlock( void *mh )
+{
+    mutex_control_t *mutex_ctrl = (mutex_control_t *)mh;
+    if( mutex_ctrl )
+        LeaveCriticalSection( &(mutex_ctrl->mutex) );
+}
+
+extern void thread_mutex_release( void *mh )
+{
+    mutex_control_t *mutex_ctrl = (mutex_control_t *)mh;
+    if( !mutex_ctrl )
+        return;
+    DeleteCriticalSection( &(mutex_ctrl->mutex) );
+    free( mutex_ctrl );
+}
+
+typedef struct {
+    CONDITION_VARIABLE  cond;
+} cond_control_t;
+
+extern void *thread_cond_create( void )
+{
+    cond_control_t *cond_ctrl = (cond_control_t *)malloc( sizeof(cond_control_t) );
+    if( !cond_ctrl )
+        return NULL;
+    InitializeConditionVariable( &(cond_ctrl->cond) );
+    return cond_ctrl;
+}
+
+extern void thread_cond_wait( void *ch, void *mh )
+{
+    cond_control_t  *cond_ctrl  = (cond_control_t *)ch;
+    mutex_control_t *mutex_ctrl = (mutex_control_t *)mh;
+    if( cond_ctrl && mutex_ctrl )
+        SleepConditionVariableCS( &(cond_ctrl->cond), &(mutex_ctrl->mutex), INFINITE );
+}
+
+extern void thread_cond_signal( void *ch )
+{
+    cond_control_t *cond_ctrl = (cond_control_t *)ch;
+    if( cond_ctrl )
+        WakeConditionVariable( &(cond_ctrl->cond) );
+}
+
+extern void thread_cond_broadcast( void *ch )
+{
+    cond_control_t *cond_ctrl = (cond_control_t *)ch;
+    if( cond_ctrl )
+        WakeAllConditionVariable( &(cond_ctrl->cond) );
+}
+
+extern void thread_cond_release( void *ch )
+{
+    cond_control_t *cond_ctrl = (cond_control_t *)ch;
+    if( !cond_ctrl )
+        return;
+    free( cond_ctrl );
+}
+
+extern uint32_t thread_get_cpu_num( void )
+{
+    SYSTEM_INFO si;
+    GetSystemInfo( &si );
+    return si.dwNumberOfProcessors ? (uint32_t)si.dwNumberOfProcessors : 1;
+}
+
+static INIT_ONCE shared_once = INIT_ONCE_STATIC_INIT;
+static void    (*shared_once_func)( void );
+
+static BOOL CALLBACK win32_once_starter( PINIT_ONCE once, PVOID param, PVOID *context )
+{
+    (void) once;
+    (void) param;
+    (void) context;
+    shared_once_func();
+    return TRUE;
+}
+
+static void thread_call_shared_once( void (*func)( void ) )
+{
+    shared_once_func = func;
+    InitOnceExecuteOnce( &shared_once, win32_once_starter, NULL, NULL );
+}
+
+static void thread_yield( void )
+{
+    SwitchToThread();
+}
+
+extern void thread_sleep( uint32_t msec )
+{
+    Sleep( msec );
+}
+
+extern uint64_t thread_get_time( void )
+{
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency( &frequency );
+    QueryPerformanceCounter( &counter );
+    return (uint64_t)(counter.QuadPart / frequency.QuadPart * 1000000
+                    + counter.QuadPart % frequency.QuadPart * 1000000 / frequency.QuadPart);
+}
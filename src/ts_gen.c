@@ -0,0 +1,1050 @@
+/*****************************************************************************
+ * ts_gen.c
+ *****************************************************************************
+ *
+ * Authors: Masaki Tanaka <maki.rxrz@gmail.com>
+ *
+ * NYSL Version 0.9982 (en) (Unofficial)
+ * ----------------------------------------
+ * A. This software is "Everyone'sWare". It means:
+ *   Anybody who has this software can use it as if he/she is
+ *   the author.
+ *
+ *   A-1. Freeware. No fee is required.
+ *   A-2. You can freely redistribute this software.
+ *   A-3. You can freely modify this software. And the source
+ *       may be used in any software with no limitation.
+ *
+ * B. The author is not responsible for any kind of damages or loss
+ *   while using or misusing this software, which is distributed
+ *   "AS IS". No warranty of any kind is expressed or implied.
+ *   You use AT YOUR OWN RISK.
+ *
+ * C. Moral rights of author belong to maki. Copyright is abandoned.
+ *
+ * D. Above three clauses are applied both to source and binary
+ *   form of this software.
+ *
+ ****************************************************************************/
+
+#include "common.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <stdarg.h>
+
+#include "config.h"
+
+#include "mpeg_common.h"
+#include "mpegts_def.h"
+#include "crc.h"
+
+#define PROGRAM_NAME                    "MPEG-2 TS Generator"
+
+#define PROGRAM_VERSION                 "0.1.0"
+
+#ifndef REVISION_NUMBER
+#define REVISION_NUMBER                 "0"
+#endif
+
+#define TS_PACKET_SIZE                  (188)
+#define TS_PACKET_HEADER_SIZE           (4)
+#define TS_PACKET_SYNC_BYTE             (0x47)
+#define TS_PCR_ADAPTATION_SIZE          (8)
+#define TS_TIMESTAMP_BASE               (90000)
+#define TS_PCR_EXTENSION_SCALE          (300)
+
+#define VIDEO_FRAME_DURATION            (3003)
+#define VIDEO_START_TIMESTAMP           (TS_TIMESTAMP_BASE)
+#define VIDEO_DECODE_DELAY              (TS_TIMESTAMP_BASE / 2)
+#define VIDEO_STREAM_ID                 (0xE0)
+
+#define SERVICE_MAX_NUM                 (16)
+#define SERVICE_PID_STEP                (0x0020)
+#define SERVICE_VIDEO_PID_OFFSET        (0x0011)
+#define SERVICE_AUDIO_PID_OFFSET        (0x0012)
+#define AUDIO_MAX_NUM                   (4)
+
+#define SECTION_MAX_SIZE                (TS_PACKET_SIZE - TS_PACKET_HEADER_SIZE - 1)
+#define WRITE_BUFFER_SIZE               (4 * 1024 * 1024)
+
+typedef enum {
+    AUDIO_CODEC_MP2 = 0,
+    AUDIO_CODEC_AAC = 1,
+    AUDIO_CODEC_AC3 = 2,
+    AUDIO_CODEC_MAX
+} audio_codec_type;
+
+/* 48kHz stereo, the frame size is fixed. */
+static const struct {
+    const char         *name;
+    mpeg_stream_type    stream_type;
+    uint8_t             stream_id;
+    uint32_t            frame_size;
+    uint32_t            frame_duration;
+    uint8_t             header[8];
+    uint32_t            header_size;
+} audio_codec_list[AUDIO_CODEC_MAX] =
+    {
+        { "mp2", STREAM_AUDIO_MP2, 0xC0, 576, 2160, { 0xFF, 0xFD, 0xA4, 0x04 }, 4 },
+        { "aac", STREAM_AUDIO_AAC, 0xC0, 384, 1920, { 0xFF, 0xF1, 0x4C, 0x80, 0x30, 0x1F, 0xFC }, 7 },
+        { "ac3", STREAM_AUDIO_AC3, 0xFD, 768, 2880, { 0x0B, 0x77, 0x00, 0x00, 0x14, 0x40, 0x43, 0xE0 }, 8 }
+    };
+
+typedef enum {
+    INJECT_ERROR_NONE       = 0x00,
+    INJECT_ERROR_CONTINUITY = 0x01,
+    INJECT_ERROR_SYNC_BYTE  = 0x02,
+    INJECT_ERROR_TRANSPORT  = 0x04,
+    INJECT_ERROR_CRC        = 0x08,
+    INJECT_ERROR_ALL        = 0x0F
+} inject_error_type;
+
+static const struct {
+    const char         *name;
+    inject_error_type   type;
+} inject_error_list[4] =
+    {
+        { "cc"  , INJECT_ERROR_CONTINUITY },
+        { "sync", INJECT_ERROR_SYNC_BYTE  },
+        { "tei" , INJECT_ERROR_TRANSPORT  },
+        { "crc" , INJECT_ERROR_CRC        }
+    };
+
+typedef struct {
+    char               *output;
+    uint16_t            packet_size;
+    uint16_t            service_num;
+    uint16_t            pid_base;
+    uint16_t            transport_stream_id;
+    int64_t             duration;
+    int64_t             file_size;
+    uint32_t            video_bitrate;
+    uint32_t            gop_size;
+    uint32_t            ref_distance;
+    int                 open_gop;
+    uint32_t            audio_num;
+    audio_codec_type    audio_codec[AUDIO_MAX_NUM];
+    uint32_t            psi_interval;
+    uint32_t            error_type;
+    uint32_t            error_interval;
+    uint32_t            seed;
+} param_t;
+
+typedef struct {
+    uint16_t            pid;
+    uint8_t             continuity_counter;
+} pid_ctx_t;
+
+typedef struct {
+    pid_ctx_t           pmt;
+    pid_ctx_t           video;
+    pid_ctx_t           audio[AUDIO_MAX_NUM];
+    int64_t             audio_pts[AUDIO_MAX_NUM];
+    uint8_t             pmt_section[SECTION_MAX_SIZE];
+    uint32_t            pmt_section_size;
+} service_ctx_t;
+
+/* the PCR and the arrival time are stamped at the output of the slot. */
+typedef struct {
+    uint8_t             data[TS_PACKET_SIZE];
+    uint8_t             pcr;
+    uint8_t             crc_offset;
+} ts_packet_t;
+
+typedef struct {
+    uint16_t            temporal_reference;
+    uint8_t             picture_coding_type;
+} coded_picture_t;
+
+typedef struct {
+    param_t            *p;
+    FILE               *fp;
+    uint64_t            rand_state;
+    uint64_t            error_state;
+    pid_ctx_t           pat;
+    uint8_t             pat_section[SECTION_MAX_SIZE];
+    uint32_t            pat_section_size;
+    service_ctx_t       service[SERVICE_MAX_NUM];
+    coded_picture_t    *gop;
+    uint32_t            unit_size;
+    ts_packet_t        *packet;
+    uint32_t            packet_num;
+    uint32_t            packet_size;
+    uint8_t            *pes;
+    uint32_t            pes_size;
+    uint64_t            output_packets;
+    uint64_t            next_error;
+    uint32_t            error_index;
+    int                 crc_error;
+    int64_t             output_size;
+    int64_t             video_frames;
+    int64_t             audio_frames;
+    int64_t             errors;
+} generator_t;
+
+static void print_version( void )
+{
+    fprintf( stdout,
+        PROGRAM_NAME " version " PROGRAM_VERSION "." REVISION_NUMBER "\n"
+    );
+}
+
+static void print_help( void )
+{
+    fprintf( stdout,
+        "\n"
+        PROGRAM_NAME " version " PROGRAM_VERSION "." REVISION_NUMBER "\n"
+        "\n"
+        "usage:  ts_gen [options] <output>\n"
+        "\n"
+        "options:\n"
+        "       --packet-size <integer> Specify TS packet size. [188/192/204]\n"
+        "                                   (default: 188)\n"
+        "       --services <integer>    Specify number of services. [1-16]\n"
+        "                                   (default: 1)\n"
+        "       --pid-base <integer>    Specify base PID of the services.\n"
+        "                                   (default: 0x0100)\n"
+        "                               The service n uses 'base + n * 0x20' as PMT,\n"
+        "                               and +0x11 as Video/PCR, +0x12... as Audio.\n"
+        "       --tsid <integer>        Specify transport stream id. (default: 1)\n"
+        "       --duration <integer>    Specify duration in seconds. (default: 60)\n"
+        "       --size <integer>        Specify output size in MiB instead of the duration.\n"
+        "       --bitrate <integer>     Specify video bitrate in kbps. (default: 8000)\n"
+        "       --gop <N>,<M>           Specify GOP length and distance of the reference pictures.\n"
+        "                                   (default: 15,3)\n"
+        "       --open-gop              Make open GOP with the leading B pictures.\n"
+        "       --audio <string>        Specify audio codecs by the comma separated list. [0-4]\n"
+        "                                   - mp2 : MPEG-1 Audio Layer II\n"
+        "                                   - aac : ADTS-AAC\n"
+        "                                   - ac3 : AC-3\n"
+        "                                   - none: no audio\n"
+        "                                   (default: mp2)\n"
+        "       --psi-interval <integer>\n"
+        "                               Specify repetition interval of PAT/PMT in msec.\n"
+        "                                   (default: 100)\n"
+        "       --error <string>        Inject errors by the comma separated list.\n"
+        "                                   - cc   : drop the packet\n"
+        "                                   - sync : corrupt the sync byte\n"
+        "                                   - tei  : set transport_error_indicator\n"
+        "                                   - crc  : corrupt CRC32 of PSI\n"
+        "                                   - all  : all of the above\n"
+        "       --error-interval <integer>\n"
+        "                               Specify average interval of the errors in packets.\n"
+        "                                   (default: 10000)\n"
+        "       --seed <integer>        Specify seed of the pseudo random data. (default: 1)\n"
+        "    -v --version               Display the version information.\n"
+        "\n"
+    );
+}
+
+static log_level debug_log_lv = LOG_LV0;
+
+extern void mapi_log( log_level level, const char *format, ... )
+{
+    if( debug_log_lv < level )
+        return;
+    FILE *msg_out = (level == LOG_LV_OUTPUT) ? stdout : stderr;
+    va_list argptr;
+    va_start( argptr, format );
+    mapi_vfprintf( msg_out, format, argptr );
+    va_end( argptr );
+}
+
+static int init_parameter( param_t *p )
+{
+    if( !p )
+        return -1;
+    memset( p, 0, sizeof(param_t) );
+    p->packet_size         = TS_PACKET_SIZE;
+    p->service_num         = 1;
+    p->pid_base            = 0x0100;
+    p->transport_stream_id = 1;
+    p->duration            = 60;
+    p->video_bitrate       = 8000;
+    p->gop_size            = 15;
+    p->ref_distance        = 3;
+    p->audio_num           = 1;
+    p->audio_codec[0]      = AUDIO_CODEC_MP2;
+    p->psi_interval        = 100;
+    p->error_interval      = 10000;
+    p->seed                = 1;
+    return 0;
+}
+
+static void cleanup_parameter( param_t *p )
+{
+    if( p->output )
+        free( p->output );
+}
+
+static int parse_integer( const char *str )
+{
+    int base = (strncmp( str, "0x", 2 )) ? 10 : 16;
+    return (int)strtol( str, NULL, base );
+}
+
+static int parse_audio_codec( const char *str, param_t *p )
+{
+    p->audio_num = 0;
+    if( !strcasecmp( str, "none" ) )
+        return 0;
+    char list[strlen( str ) + 1];
+    strcpy( list, str );
+    for( char *name = strtok( list, "," ); name; name = strtok( NULL, "," ) )
+    {
+        int codec = 0;
+        while( codec < AUDIO_CODEC_MAX && strcasecmp( name, audio_codec_list[codec].name ) )
+            ++codec;
+        if( codec == AUDIO_CODEC_MAX || p->audio_num >= AUDIO_MAX_NUM )
+            return -1;
+        p->audio_codec[p->audio_num ++] = (audio_codec_type)codec;
+    }
+    return 0;
+}
+
+static int parse_error_type( const char *str, param_t *p )
+{
+    p->error_type = INJECT_ERROR_NONE;
+    char list[strlen( str ) + 1];
+    strcpy( list, str );
+    for( char *name = strtok( list, "," ); name; name = strtok( NULL, "," ) )
+    {
+        if( !strcasecmp( name, "all" ) )
+        {
+            p->error_type = INJECT_ERROR_ALL;
+            continue;
+        }
+        int i = 0;
+        while( i < 4 && strcasecmp( name, inject_error_list[i].name ) )
+            ++i;
+        if( i == 4 )
+            return -1;
+        p->error_type |= inject_error_list[i].type;
+    }
+    return 0;
+}
+
+static int parse_commandline( int argc, char **argv, param_t *p )
+{
+    int i = 1;
+    while( i < argc && *argv[i] == '-' )
+    {
+        /* all options take the value. */
+        int has_value = (i + 1 < argc);
+        if( !strcasecmp( argv[i], "--open-gop" ) )
+            p->open_gop = 1;
+        else if( !has_value )
+        {
+            mapi_log( LOG_LV0, "[log] invalid paramter: '%s'\n", argv[i] );
+            return -1;
+        }
+        else if( !strcasecmp( argv[i], "--packet-size" ) )
+            p->packet_size = parse_integer( argv[++i] );
+        else if( !strcasecmp( argv[i], "--services" ) )
+            p->service_num = parse_integer( argv[++i] );
+        else if( !strcasecmp( argv[i], "--pid-base" ) )
+            p->pid_base = parse_integer( argv[++i] );
+        else if( !strcasecmp( argv[i], "--tsid" ) )
+            p->transport_stream_id = parse_integer( argv[++i] );
+        else if( !strcasecmp( argv[i], "--duration" ) )
+            p->duration = parse_integer( argv[++i] );
+        else if( !strcasecmp( argv[i], "--size" ) )
+            p->file_size = parse_integer( argv[++i] );
+        else if( !strcasecmp( argv[i], "--bitrate" ) )
+            p->video_bitrate = parse_integer( argv[++i] );
+        else if( !strcasecmp( argv[i], "--gop" ) )
+        {
+            ++i;
+            p->gop_size = parse_integer( argv[i] );
+            char *sep = strchr( argv[i], ',' );
+            if( sep )
+                p->ref_distance = parse_integer( sep + 1 );
+        }
+        else if( !strcasecmp( argv[i], "--audio" ) )
+        {
+            if( parse_audio_codec( argv[++i], p ) )
+            {
+                mapi_log( LOG_LV0, "[log] invalid audio codec: '%s'\n", argv[i] );
+                return -1;
+            }
+        }
+        else if( !strcasecmp( argv[i], "--psi-interval" ) )
+            p->psi_interval = parse_integer( argv[++i] );
+        else if( !strcasecmp( argv[i], "--error" ) )
+        {
+            if( parse_error_type( argv[++i], p ) )
+            {
+                mapi_log( LOG_LV0, "[log] invalid error type: '%s'\n", argv[i] );
+                return -1;
+            }
+        }
+        else if( !strcasecmp( argv[i], "--error-interval" ) )
+            p->error_interval = parse_integer( argv[++i] );
+        else if( !strcasecmp( argv[i], "--seed" ) )
+            p->seed = (uint32_t)strtoul( argv[++i], NULL, 0 );
+        else
+        {
+            mapi_log( LOG_LV0, "[log] invalid paramter: '%s'\n", argv[i] );
+            return -1;
+        }
+        ++i;
+    }
+    if( i < argc )
+        p->output = strdup( argv[i] );
+    return 0;
+}
+
+static int correct_parameter( param_t *p )
+{
+    if( !p->output )
+    {
+        mapi_log( LOG_LV0, "[log] output file is not specified.\n" );
+        return -1;
+    }
+    if( p->packet_size != 188 && p->packet_size != 192 && p->packet_size != 204 )
+    {
+        mapi_log( LOG_LV0, "[log] invalid packet size: %u\n", p->packet_size );
+        return -1;
+    }
+    if( p->service_num < 1 || p->service_num > SERVICE_MAX_NUM )
+    {
+        mapi_log( LOG_LV0, "[log] invalid number of services: %u\n", p->service_num );
+        return -1;
+    }
+    uint32_t pid_max = p->pid_base + SERVICE_PID_STEP * p->service_num;
+    if( p->pid_base <= MPEGTS_PID_ISDB_RESERVED_MAX || pid_max >= 0x1FFF )
+    {
+        mapi_log( LOG_LV0, "[log] invalid base PID: 0x%04X\n", p->pid_base );
+        return -1;
+    }
+    if( p->gop_size < 1 || p->gop_size > 1024 || p->ref_distance < 1 || p->ref_distance > p->gop_size )
+    {
+        mapi_log( LOG_LV0, "[log] invalid GOP structure: %u,%u\n", p->gop_size, p->ref_distance );
+        return -1;
+    }
+    if( p->open_gop && p->ref_distance == 1 )
+        p->open_gop = 0;
+    if( p->video_bitrate < 100 )
+        p->video_bitrate = 100;
+    else if( p->video_bitrate > 100000 )
+        p->video_bitrate = 100000;
+    if( p->psi_interval < 1 )
+        p->psi_interval = 1;
+    if( p->error_interval < 1 )
+        p->error_interval = 1;
+    if( p->duration < 1 )
+        p->duration = 1;
+    return 0;
+}
+
+/* xorshift64*, the output depends on the seed only. */
+static uint64_t gen_rand( uint64_t *state )
+{
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+/* the range of 0x10-0xFE never makes the start code and the audio sync word. */
+static void gen_filler( generator_t *gen, uint8_t *buf, uint32_t size )
+{
+    uint32_t i = 0;
+    while( i < size )
+    {
+        uint64_t r = gen_rand( &(gen->rand_state) );
+        for( int j = 0; j < 4 && i < size; ++j, r >>= 16 )
+            buf[i++] = 0x10 + (uint8_t)(((r & 0xFFFF) * 0xEF) >> 16);
+    }
+}
+
+typedef struct {
+    uint8_t    *buf;
+    uint32_t    bit_pos;
+} bit_writer_t;
+
+static void bw_put( bit_writer_t *bw, uint32_t value, int bits )
+{
+    for( int i = bits - 1; i >= 0; --i )
+    {
+        uint8_t *p = &(bw->buf[bw->bit_pos >> 3]);
+        if( !(bw->bit_pos & 7) )
+            *p = 0;
+        *p |= ((value >> i) & 1) << (7 - (bw->bit_pos & 7));
+        ++ bw->bit_pos;
+    }
+}
+
+static uint32_t bw_size( bit_writer_t *bw )
+{
+    return (bw->bit_pos + 7) >> 3;
+}
+
+static uint32_t put_start_code( uint8_t *buf, uint8_t code )
+{
+    buf[0] = 0x00;
+    buf[1] = 0x00;
+    buf[2] = 0x01;
+    buf[3] = code;
+    return 4;
+}
+
+static uint32_t put_sequence_header( generator_t *gen, uint8_t *buf )
+{
+    uint32_t size = put_start_code( buf, 0xB3 );
+    bit_writer_t bw = { buf + size, 0 };
+    bw_put( &bw, 720, 12 );                                 /* horizontal_size_value        */
+    bw_put( &bw, 480, 12 );                                 /* vertical_size_value          */
+    bw_put( &bw, 2, 4 );                                    /* aspect_ratio_information     */
+    bw_put( &bw, 4, 4 );                                    /* frame_rate_code : 29.97      */
+    bw_put( &bw, gen->p->video_bitrate * 1000 / 400, 18 );  /* bit_rate_value               */
+    bw_put( &bw, 1, 1 );                                    /* marker_bit                   */
+    bw_put( &bw, 112, 10 );                                 /* vbv_buffer_size_value        */
+    bw_put( &bw, 0, 3 );                                    /* constrained, no matrices     */
+    size += bw_size( &bw );
+    size += put_start_code( buf + size, 0xB5 );
+    bw = (bit_writer_t){ buf + size, 0 };
+    bw_put( &bw, 1, 4 );                                    /* sequence_extension           */
+    bw_put( &bw, 0x48, 8 );                                 /* Main Profile @ Main Level    */
+    bw_put( &bw, 0, 1 );                                    /* progressive_sequence         */
+    bw_put( &bw, 1, 2 );                                    /* chroma_format : 4:2:0        */
+    bw_put( &bw, 0, 16 );                                   /* size and bit_rate extension  */
+    bw_put( &bw, 1, 1 );                                    /* marker_bit                   */
+    bw_put( &bw, 0, 16 );                                   /* vbv, low_delay, frame_rate   */
+    return size + bw_size( &bw );
+}
+
+static uint32_t put_gop_header( uint8_t *buf, int64_t frame_number, int closed_gop )
+{
+    uint32_t size = put_start_code( buf, 0xB8 );
+    int64_t seconds = frame_number / 30;
+    bit_writer_t bw = { buf + size, 0 };
+    bw_put( &bw, 0, 1 );                                    /* drop_frame_flag              */
+    bw_put( &bw, (seconds / 3600) % 24, 5 );
+    bw_put( &bw, (seconds / 60) % 60, 6 );
+    bw_put( &bw, 1, 1 );                                    /* marker_bit                   */
+    bw_put( &bw, seconds % 60, 6 );
+    bw_put( &bw, frame_number % 30, 6 );
+    bw_put( &bw, closed_gop, 1 );
+    bw_put( &bw, 0, 1 );                                    /* broken_link                  */
+    bw_put( &bw, 0, 5 );
+    return size + bw_size( &bw );
+}
+
+static uint32_t put_picture_header( uint8_t *buf, coded_picture_t *picture )
+{
+    uint32_t size = put_start_code( buf, 0x00 );
+    uint8_t  type = picture->picture_coding_type;
+    bit_writer_t bw = { buf + size, 0 };
+    bw_put( &bw, picture->temporal_reference, 10 );
+    bw_put( &bw, type, 3 );
+    bw_put( &bw, 0xFFFF, 16 );                              /* vbv_delay                    */
+    if( type == MPEG_VIDEO_P_FRAME || type == MPEG_VIDEO_B_FRAME )
+        bw_put( &bw, 7, 4 );                                /* full_pel, forward_f_code     */
+    if( type == MPEG_VIDEO_B_FRAME )
+        bw_put( &bw, 7, 4 );                                /* full_pel, backward_f_code    */
+    bw_put( &bw, 0, 1 );                                    /* extra_bit_picture            */
+    size += bw_size( &bw );
+    size += put_start_code( buf + size, 0xB5 );
+    bw = (bit_writer_t){ buf + size, 0 };
+    bw_put( &bw, 8, 4 );                                    /* picture_coding_extension     */
+    bw_put( &bw, (type != MPEG_VIDEO_I_FRAME) ? 1 : 0xF, 4 );
+    bw_put( &bw, (type != MPEG_VIDEO_I_FRAME) ? 1 : 0xF, 4 );
+    bw_put( &bw, (type == MPEG_VIDEO_B_FRAME) ? 1 : 0xF, 4 );
+    bw_put( &bw, (type == MPEG_VIDEO_B_FRAME) ? 1 : 0xF, 4 );
+    bw_put( &bw, 0, 2 );                                    /* intra_dc_precision           */
+    bw_put( &bw, 3, 2 );                                    /* picture_structure : frame    */
+    bw_put( &bw, 1, 1 );                                    /* top_field_first              */
+    bw_put( &bw, 1, 1 );                                    /* frame_pred_frame_dct         */
+    bw_put( &bw, 0, 5 );
+    bw_put( &bw, 1, 1 );                                    /* chroma_420_type              */
+    bw_put( &bw, 0, 2 );                                    /* progressive_frame, composite */
+    return size + bw_size( &bw );
+}
+
+static uint32_t put_timestamp( uint8_t *buf, uint8_t prefix, int64_t timestamp )
+{
+    buf[0] = (prefix << 4) | (((timestamp >> 30) & 0x07) << 1) | 0x01;
+    buf[1] =  (timestamp >> 22) & 0xFF;
+    buf[2] = (((timestamp >> 15) & 0x7F) << 1) | 0x01;
+    buf[3] =  (timestamp >>  7) & 0xFF;
+    buf[4] = ((timestamp & 0x7F) << 1) | 0x01;
+    return 5;
+}
+
+static int reserve_pes( generator_t *gen, uint32_t size )
+{
+    if( size <= gen->pes_size )
+        return 0;
+    uint8_t *tmp = (uint8_t *)realloc( gen->pes, size );
+    if( !tmp )
+        return -1;
+    gen->pes      = tmp;
+    gen->pes_size = size;
+    return 0;
+}
+
+/* the payload has to be placed at 'PES_HEADER_MAX_SIZE' of the buffer. */
+#define PES_HEADER_MAX_SIZE             (19)
+
+static uint8_t *build_pes( uint8_t *buf, uint32_t *size, uint8_t stream_id, int64_t pts, int64_t dts )
+{
+    uint8_t  header[PES_HEADER_MAX_SIZE];
+    uint32_t header_size = 9;
+    header_size += put_timestamp( &(header[header_size]), (pts != dts) ? 0x03 : 0x02, pts );
+    if( pts != dts )
+        header_size += put_timestamp( &(header[header_size]), 0x01, dts );
+    uint32_t packet_length = *size + header_size - 6;
+    if( packet_length > 0xFFFF || stream_id == VIDEO_STREAM_ID )
+        packet_length = 0;
+    put_start_code( header, stream_id );
+    header[4] = (packet_length >> 8) & 0xFF;
+    header[5] =  packet_length       & 0xFF;
+    header[6] = 0x80;                                       /* '10', not scrambled          */
+    header[7] = (pts != dts) ? 0xC0 : 0x80;                 /* PTS_DTS_flags                */
+    header[8] = header_size - 9;
+    uint8_t *pes = buf + PES_HEADER_MAX_SIZE - header_size;
+    memcpy( pes, header, header_size );
+    *size += header_size;
+    return pes;
+}
+
+static ts_packet_t *get_packet( generator_t *gen )
+{
+    if( gen->packet_num >= gen->packet_size )
+    {
+        uint32_t packet_size = gen->packet_size ? gen->packet_size * 2 : 1024;
+        ts_packet_t *tmp = (ts_packet_t *)realloc( gen->packet, sizeof(ts_packet_t) * packet_size );
+        if( !tmp )
+            return NULL;
+        gen->packet      = tmp;
+        gen->packet_size = packet_size;
+    }
+    ts_packet_t *packet = &(gen->packet[gen->packet_num ++]);
+    packet->pcr        = 0;
+    packet->crc_offset = 0;
+    return packet;
+}
+
+static int put_packets( generator_t *gen, pid_ctx_t *pid_ctx, uint8_t *data, uint32_t size, int pcr )
+{
+    int unit_start = 1;
+    while( size )
+    {
+        ts_packet_t *packet = get_packet( gen );
+        if( !packet )
+            return -1;
+        uint8_t *p = packet->data;
+        uint32_t adaptation_size = 0;
+        if( pcr && unit_start )
+        {
+            adaptation_size = TS_PCR_ADAPTATION_SIZE;
+            packet->pcr     = 1;
+        }
+        uint32_t payload_size = TS_PACKET_SIZE - TS_PACKET_HEADER_SIZE - adaptation_size;
+        if( size < payload_size )
+        {
+            /* stuffing by the adaptation field. */
+            adaptation_size += payload_size - size;
+            payload_size     = size;
+        }
+        p[0] = TS_PACKET_SYNC_BYTE;
+        p[1] = (unit_start << 6) | ((pid_ctx->pid >> 8) & 0x1F);
+        p[2] = pid_ctx->pid & 0xFF;
+        p[3] = ((adaptation_size ? 0x03 : 0x01) << 4) | pid_ctx->continuity_counter;
+        pid_ctx->continuity_counter = (pid_ctx->continuity_counter + 1) & 0x0F;
+        p += TS_PACKET_HEADER_SIZE;
+        if( adaptation_size )
+        {
+            p[0] = adaptation_size - 1;
+            if( adaptation_size > 1 )
+            {
+                p[1] = packet->pcr ? 0x10 : 0x00;
+                memset( &(p[2]), 0xFF, adaptation_size - 2 );
+            }
+            p += adaptation_size;
+        }
+        memcpy( p, data, payload_size );
+        data      += payload_size;
+        size      -= payload_size;
+        unit_start = 0;
+    }
+    return 0;
+}
+
+static int put_section( generator_t *gen, pid_ctx_t *pid_ctx, uint8_t *section, uint32_t size )
+{
+    uint8_t payload[SECTION_MAX_SIZE + 1];
+    payload[0] = 0x00;                                      /* pointer_field                */
+    memcpy( &(payload[1]), section, size );
+    if( put_packets( gen, pid_ctx, payload, size + 1, 0 ) )
+        return -1;
+    /* the section always fits in a packet, and ends with CRC32. */
+    gen->packet[gen->packet_num - 1].crc_offset = TS_PACKET_SIZE - 1;
+    return 0;
+}
+
+static uint32_t finish_section( uint8_t *section, uint32_t size )
+{
+    /* section_length covers after the field, including CRC32. */
+    uint32_t section_length = size - 3 + CRC32_SIZE;
+    section[1] = 0xB0 | ((section_length >> 8) & 0x0F);
+    section[2] = section_length & 0xFF;
+    uint32_t crc32 = calc_crc32( section, size );
+    section[size    ] = (crc32 >> 24) & 0xFF;
+    section[size + 1] = (crc32 >> 16) & 0xFF;
+    section[size + 2] = (crc32 >>  8) & 0xFF;
+    section[size + 3] =  crc32        & 0xFF;
+    return size + CRC32_SIZE;
+}
+
+static uint32_t put_section_header( uint8_t *section, mpegts_psi_section_table_id table_id, uint16_t id_number )
+{
+    section[0] = table_id;
+    section[3] = (id_number >> 8) & 0xFF;
+    section[4] =  id_number       & 0xFF;
+    section[5] = 0xC1;                                      /* version 0, current           */
+    section[6] = 0x00;                                      /* section_number               */
+    section[7] = 0x00;                                      /* last_section_number          */
+    return 8;
+}
+
+static void setup_psi( generator_t *gen )
+{
+    param_t *p = gen->p;
+    /* PAT. */
+    uint8_t *pat = gen->pat_section;
+    uint32_t pat_size = put_section_header( pat, PSI_TABLE_ID_PAT, p->transport_stream_id );
+    for( int i = 0; i < p->service_num; ++i )
+    {
+        uint16_t program_number = i + 1;
+        uint16_t pmt_pid        = gen->service[i].pmt.pid;
+        pat[pat_size++] = (program_number >> 8) & 0xFF;
+        pat[pat_size++] =  program_number       & 0xFF;
+        pat[pat_size++] = 0xE0 | ((pmt_pid >> 8) & 0x1F);
+        pat[pat_size++] =  pmt_pid              & 0xFF;
+    }
+    gen->pat_section_size = finish_section( pat, pat_size );
+    /* PMT. */
+    for( int i = 0; i < p->service_num; ++i )
+    {
+        service_ctx_t *service = &(gen->service[i]);
+        uint8_t *pmt = service->pmt_section;
+        uint32_t pmt_size = put_section_header( pmt, PSI_TABLE_ID_PMT, i + 1 );
+        uint16_t pcr_pid  = service->video.pid;
+        pmt[pmt_size++] = 0xE0 | ((pcr_pid >> 8) & 0x1F);
+        pmt[pmt_size++] =  pcr_pid              & 0xFF;
+        pmt[pmt_size++] = 0xF0;                             /* program_info_length          */
+        pmt[pmt_size++] = 0x00;
+        for( uint32_t j = 0; j <= p->audio_num; ++j )
+        {
+            uint8_t  stream_type = j ? audio_codec_list[p->audio_codec[j - 1]].stream_type : STREAM_VIDEO_MPEG2;
+            uint16_t pid         = j ? service->audio[j - 1].pid : service->video.pid;
+            pmt[pmt_size++] = stream_type;
+            pmt[pmt_size++] = 0xE0 | ((pid >> 8) & 0x1F);
+            pmt[pmt_size++] =  pid              & 0xFF;
+            pmt[pmt_size++] = 0xF0;                         /* ES_info_length               */
+            pmt[pmt_size++] = 0x00;
+        }
+        service->pmt_section_size = finish_section( pmt, pmt_size );
+    }
+}
+
+static void setup_gop( generator_t *gen )
+{
+    param_t         *p   = gen->p;
+    coded_picture_t *gop = gen->gop;
+    uint32_t n = 0;
+    uint32_t anchor = 0;
+    /* the leading B pictures refer the previous GOP. */
+    if( p->open_gop )
+    {
+        anchor = p->ref_distance - 1;
+        gop[n++] = (coded_picture_t){ anchor, MPEG_VIDEO_I_FRAME };
+        for( uint32_t b = 0; b < anchor; ++b )
+            gop[n++] = (coded_picture_t){ b, MPEG_VIDEO_B_FRAME };
+    }
+    else
+        gop[n++] = (coded_picture_t){ 0, MPEG_VIDEO_I_FRAME };
+    while( anchor < p->gop_size - 1 )
+    {
+        uint32_t next = anchor + p->ref_distance;
+        if( next > p->gop_size - 1 )
+            next = p->gop_size - 1;
+        gop[n++] = (coded_picture_t){ next, MPEG_VIDEO_P_FRAME };
+        for( uint32_t b = anchor + 1; b < next; ++b )
+            gop[n++] = (coded_picture_t){ b, MPEG_VIDEO_B_FRAME };
+        anchor = next;
+    }
+    /* the size ratio of I:P:B is 6:3:1. */
+    uint32_t weight = 0;
+    for( uint32_t i = 0; i < p->gop_size; ++i )
+        weight += (gop[i].picture_coding_type == MPEG_VIDEO_I_FRAME) ? 6
+                : (gop[i].picture_coding_type == MPEG_VIDEO_P_FRAME) ? 3 : 1;
+    uint64_t gop_bytes = (uint64_t)p->video_bitrate * 1000 / 8 * VIDEO_FRAME_DURATION * p->gop_size / TS_TIMESTAMP_BASE;
+    gen->unit_size = gop_bytes / weight;
+}
+
+static int put_video_frame( generator_t *gen, service_ctx_t *service, int64_t frame_number )
+{
+    param_t *p = gen->p;
+    uint32_t gop_index = frame_number % p->gop_size;
+    int64_t  gop_start = frame_number - gop_index;
+    coded_picture_t *picture = &(gen->gop[gop_index]);
+    uint32_t weight = (picture->picture_coding_type == MPEG_VIDEO_I_FRAME) ? 6
+                    : (picture->picture_coding_type == MPEG_VIDEO_P_FRAME) ? 3 : 1;
+    /* +-10% from the average size. */
+    uint32_t data_size = gen->unit_size * weight;
+    data_size = data_size * 9 / 10 + gen_rand( &(gen->rand_state) ) % (data_size / 5 + 1);
+    if( reserve_pes( gen, PES_HEADER_MAX_SIZE + 256 + data_size ) )
+        return -1;
+    uint8_t *es   = gen->pes + PES_HEADER_MAX_SIZE;
+    uint32_t size = 0;
+    if( !gop_index )
+    {
+        size += put_sequence_header( gen, es + size );
+        size += put_gop_header( es + size, frame_number, !p->open_gop || !frame_number );
+    }
+    size += put_picture_header( es + size, picture );
+    size += put_start_code( es + size, 0x01 );              /* slice                        */
+    gen_filler( gen, es + size, data_size );
+    size += data_size;
+    int64_t dts = VIDEO_START_TIMESTAMP + frame_number * VIDEO_FRAME_DURATION;
+    int64_t pts = VIDEO_START_TIMESTAMP + (gop_start + picture->temporal_reference + 1) * VIDEO_FRAME_DURATION;
+    uint8_t *pes = build_pes( gen->pes, &size, VIDEO_STREAM_ID, pts & MPEG_TIMESTAMP_MAX_VALUE, dts & MPEG_TIMESTAMP_MAX_VALUE );
+    return put_packets( gen, &(service->video), pes, size, 1 );
+}
+
+static int put_audio_frames( generator_t *gen, service_ctx_t *service, int64_t end_pts )
+{
+    param_t *p = gen->p;
+    for( uint32_t i = 0; i < p->audio_num; ++i )
+    {
+        audio_codec_type codec = p->audio_codec[i];
+        uint32_t frame_size = audio_codec_list[codec].frame_size;
+        if( reserve_pes( gen, PES_HEADER_MAX_SIZE + frame_size ) )
+            return -1;
+        while( service->audio_pts[i] < end_pts )
+        {
+            uint8_t *es   = gen->pes + PES_HEADER_MAX_SIZE;
+            uint32_t size = audio_codec_list[codec].header_size;
+            memcpy( es, audio_codec_list[codec].header, size );
+            gen_filler( gen, es + size, frame_size - size );
+            size = frame_size;
+            int64_t pts = service->audio_pts[i] & MPEG_TIMESTAMP_MAX_VALUE;
+            uint8_t *pes = build_pes( gen->pes, &size, audio_codec_list[codec].stream_id, pts, pts );
+            if( put_packets( gen, &(service->audio[i]), pes, size, 0 ) )
+                return -1;
+            service->audio_pts[i] += audio_codec_list[codec].frame_duration;
+            ++ gen->audio_frames;
+        }
+    }
+    return 0;
+}
+
+static void inject_error( generator_t *gen, ts_packet_t *packet, int *drop )
+{
+    param_t *p = gen->p;
+    if( gen->crc_error && packet->crc_offset )
+    {
+        packet->data[packet->crc_offset] ^= 0xFF;
+        gen->crc_error = 0;
+    }
+    if( gen->output_packets < gen->next_error )
+        return;
+    gen->next_error = gen->output_packets + p->error_interval / 2 + 1
+                    + gen_rand( &(gen->error_state) ) % p->error_interval;
+    /* rotate the specified types. */
+    inject_error_type type = INJECT_ERROR_NONE;
+    while( !(p->error_type & type) )
+    {
+        type = inject_error_list[gen->error_index].type;
+        gen->error_index = (gen->error_index + 1) % 4;
+    }
+    switch( type )
+    {
+        case INJECT_ERROR_CONTINUITY :
+            *drop = 1;
+            break;
+        case INJECT_ERROR_SYNC_BYTE :
+            packet->data[0] ^= 0xFF;
+            break;
+        case INJECT_ERROR_TRANSPORT :
+            packet->data[1] |= 0x80;
+            break;
+        case INJECT_ERROR_CRC :
+            gen->crc_error = 1;
+            break;
+        default :
+            break;
+    }
+    ++ gen->errors;
+}
+
+static int flush_packets( generator_t *gen, int64_t start_time, int64_t duration )
+{
+    param_t *p = gen->p;
+    /* the packets are spread evenly in the duration. */
+    for( uint32_t i = 0; i < gen->packet_num; ++i )
+    {
+        ts_packet_t *packet = &(gen->packet[i]);
+        int64_t pcr = start_time + duration * i / gen->packet_num;
+        if( packet->pcr )
+        {
+            int64_t  pcr_base = (pcr / TS_PCR_EXTENSION_SCALE) & MPEG_TIMESTAMP_MAX_VALUE;
+            uint32_t pcr_ext  =  pcr % TS_PCR_EXTENSION_SCALE;
+            uint8_t *af = &(packet->data[TS_PACKET_HEADER_SIZE + 2]);
+            af[0] = (pcr_base >> 25) & 0xFF;
+            af[1] = (pcr_base >> 17) & 0xFF;
+            af[2] = (pcr_base >>  9) & 0xFF;
+            af[3] = (pcr_base >>  1) & 0xFF;
+            af[4] = ((pcr_base & 0x01) << 7) | 0x7E | ((pcr_ext >> 8) & 0x01);
+            af[5] = pcr_ext & 0xFF;
+        }
+        int drop = 0;
+        if( p->error_type )
+            inject_error( gen, packet, &drop );
+        ++ gen->output_packets;
+        if( drop )
+            continue;
+        if( p->packet_size == 192 )
+        {
+            /* TP_extra_header : copy_permission_indicator and arrival_time_stamp. */
+            uint32_t ats = pcr & 0x3FFFFFFF;
+            uint8_t header[4] = { (ats >> 24) & 0xFF, (ats >> 16) & 0xFF, (ats >> 8) & 0xFF, ats & 0xFF };
+            fwrite( header, 1, 4, gen->fp );
+        }
+        fwrite( packet->data, 1, TS_PACKET_SIZE, gen->fp );
+        if( p->packet_size == 204 )
+        {
+            static const uint8_t parity[16] = { 0 };
+            fwrite( parity, 1, 16, gen->fp );
+        }
+        gen->output_size += p->packet_size;
+    }
+    gen->packet_num = 0;
+    return ferror( gen->fp ) ? -1 : 0;
+}
+
+static int generate_ts( param_t *p )
+{
+    int result = -1;
+    generator_t gen = { 0 };
+    gen.p           = p;
+    gen.rand_state  = 0x9E3779B97F4A7C15ULL ^ p->seed;
+    gen.error_state = 0xD1B54A32D192ED03ULL ^ p->seed;
+    gen.next_error  = p->error_interval;
+    gen.pat.pid     = TS_PID_PAT;
+    for( int i = 0; i < p->service_num; ++i )
+    {
+        service_ctx_t *service = &(gen.service[i]);
+        uint16_t base = p->pid_base + SERVICE_PID_STEP * i;
+        service->pmt.pid   = base;
+        service->video.pid = base + SERVICE_VIDEO_PID_OFFSET;
+        for( uint32_t j = 0; j < p->audio_num; ++j )
+        {
+            service->audio[j].pid = base + SERVICE_AUDIO_PID_OFFSET + j;
+            service->audio_pts[j] = VIDEO_START_TIMESTAMP;
+        }
+    }
+    gen.gop = (coded_picture_t *)malloc( sizeof(coded_picture_t) * p->gop_size );
+    if( !gen.gop )
+        goto end_generate;
+    setup_gop( &gen );
+    setup_psi( &gen );
+    gen.fp = mapi_fopen( p->output, "wb" );
+    if( !gen.fp )
+    {
+        mapi_log( LOG_LV0, "[log] failed to open the output: %s\n", p->output );
+        goto end_generate;
+    }
+    setvbuf( gen.fp, NULL, _IOFBF, WRITE_BUFFER_SIZE );
+    int64_t end_frames = p->duration * TS_TIMESTAMP_BASE / VIDEO_FRAME_DURATION;
+    int64_t end_size   = p->file_size * 1024 * 1024;
+    int64_t next_psi   = 0;
+    for( int64_t frame_number = 0; ; ++frame_number )
+    {
+        /* finish at the GOP boundary. */
+        if( !(frame_number % p->gop_size)
+         && (end_size ? (gen.output_size >= end_size) : (frame_number >= end_frames)) )
+            break;
+        int64_t dts = VIDEO_START_TIMESTAMP + frame_number * VIDEO_FRAME_DURATION;
+        if( dts >= next_psi )
+        {
+            if( put_section( &gen, &(gen.pat), gen.pat_section, gen.pat_section_size ) )
+                goto end_generate;
+            for( int i = 0; i < p->service_num; ++i )
+                if( put_section( &gen, &(gen.service[i].pmt), gen.service[i].pmt_section, gen.service[i].pmt_section_size ) )
+                    goto end_generate;
+            next_psi = dts + (int64_t)p->psi_interval * TS_TIMESTAMP_BASE / 1000;
+        }
+        for( int i = 0; i < p->service_num; ++i )
+        {
+            if( put_video_frame( &gen, &(gen.service[i]), frame_number )
+             || put_audio_frames( &gen, &(gen.service[i]), dts + VIDEO_FRAME_DURATION ) )
+                goto end_generate;
+            ++ gen.video_frames;
+        }
+        if( flush_packets( &gen, (dts - VIDEO_DECODE_DELAY) * TS_PCR_EXTENSION_SCALE, VIDEO_FRAME_DURATION * TS_PCR_EXTENSION_SCALE ) )
+        {
+            mapi_log( LOG_LV0, "[log] failed to write the output.\n" );
+            goto end_generate;
+        }
+        if( !(frame_number % 300) )
+            mapi_log( LOG_LV_PROGRESS, " [generate] %" PRId64 " Byte\r", gen.output_size );
+    }
+    mapi_log( LOG_LV_PROGRESS, " [generate] %" PRId64 " Byte\n", gen.output_size );
+    mapi_log( LOG_LV0, "[log] output: %s\n"
+                       "  packets: %" PRIu64 "  video frames: %" PRId64 "  audio frames: %" PRId64 "  errors: %" PRId64 "\n"
+                     , p->output, gen.output_packets, gen.video_frames, gen.audio_frames, gen.errors );
+    result = 0;
+end_generate:
+    if( gen.fp && fclose( gen.fp ) )
+        result = -1;
+    if( gen.packet )
+        free( gen.packet );
+    if( gen.pes )
+        free( gen.pes );
+    if( gen.gop )
+        free( gen.gop );
+    return result;
+}
+
+static int check_commandline( int argc, char *argv[] )
+{
+    for( int i = 0; i < argc; ++i )
+        if( !strcasecmp( argv[i], "--version" ) || !strcasecmp( argv[i], "-v" ) )
+        {
+            print_version();
+            return 1;
+        }
+    if( argc < 2 )
+    {
+        print_help();
+        return 1;
+    }
+    return 0;
+}
+
+int main( int argc, char *argv[] )
+{
+    if( check_commandline( argc, argv ) )
+        return 0;
+    int conv_args = mapi_convert_args_to_utf8( &argc, &argv );
+    if( conv_args < 0 )
+        return -1;
+    int result = -1;
+    param_t param;
+    if( !init_parameter( &param )
+     && !parse_commandline( argc, argv, &param )
+     && !correct_parameter( &param ) )
+        result = generate_ts( &param );
+    cleanup_parameter( &param );
+    if( conv_args > 0 )
+        free( argv );
+    return result;
+}
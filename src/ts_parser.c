@@ -101,6 +101,11 @@ typedef struct {
     int64_t                 frm_limit;
     char                   *split_suffix;
     int                     update_psi;
+    int                     packet_stats;
+    int                     perf_stats;
+    char                   *bitrate_output;
+    uint32_t                bitrate_interval;
+    char                   *trace_output;
 } param_t;
 
 static const struct {
@@ -121,6 +126,8 @@ static const struct {
 
 #define PARSE_VIDEO_PTS_LIMIT                   (30)
 
+#define TS_PACKET_SIZE                          (188)
+
 static void print_version( void )
 {
     const char *thread = thread_get_model_name();
@@ -188,6 +195,14 @@ static void print_help( void )
         "                                   - 3 : 1st Video frame\n"
         "                                   (default: [V+A: 2] [A only: 3])\n"
         "       --pcr                   Parse pcr only.\n"
+        "       --packet-stats          Output the packet statistics of the parsing.\n"
+        "       --stats                 Output the performance counters of reading and writing.\n"
+        "       --bitrate <string>      Output the bitrate of each PID over time.\n"
+        "                                   - '*.json' : JSON, others : CSV\n"
+        "       --bitrate-interval <integer>\n"
+        "                               Specify time interval of the bitrate in msec.\n"
+        "                                   (default: 1000)\n"
+        "       --trace <string>        Output the spans of the major phases as Chrome trace JSON.\n"
         "       --gop-list              Make GOP list for murdoc cutter.\n"
         "       --gop-limit             Specify limit of GOP number in stream parsing.\n"
         "       --frame-limit           Specify limit of frame number in stream parsing.\n"
@@ -338,6 +353,7 @@ static int init_parameter( param_t *p )
     p->wrap_around_check_v = TIMESTAMP_WRAP_AROUND_CHECK_VALUE;
     p->delay_type          = MPEG_READER_DEALY_VIDEO_GOP_TR_ORDER;
     p->logfile             = stderr;
+    p->bitrate_interval    = 1000;
     return 0;
 }
 
@@ -345,6 +361,10 @@ static void cleanup_parameter( param_t *p )
 {
     if( p->split_suffix )
         free( p->split_suffix );
+    if( p->bitrate_output )
+        free( p->bitrate_output );
+    if( p->trace_output )
+        free( p->trace_output );
     if( p->logfile && p->logfile != stderr )
         fclose( p->logfile );
     if( p->service_id_list )
@@ -543,6 +563,28 @@ static int parse_commandline( int argc, char **argv, int index, param_t *p )
         }
         else if( !strcasecmp( argv[i], "--pcr" ) )
             p->output_stream = OUTPUT_STREAM_NONE_PCR_ONLY;
+        else if( !strcasecmp( argv[i], "--packet-stats" ) )
+            p->packet_stats = 1;
+        else if( !strcasecmp( argv[i], "--stats" ) )
+            p->perf_stats = 1;
+        else if( !strcasecmp( argv[i], "--bitrate" ) )
+        {
+            if( p->bitrate_output )
+                free( p->bitrate_output );
+            p->bitrate_output = strdup( argv[++i] );
+        }
+        else if( !strcasecmp( argv[i], "--trace" ) )
+        {
+            if( p->trace_output )
+                free( p->trace_output );
+            p->trace_output = strdup( argv[++i] );
+        }
+        else if( !strcasecmp( argv[i], "--bitrate-interval" ) )
+        {
+            int interval = atoi( argv[++i] );
+            if( interval > 0 )
+                p->bitrate_interval = interval;
+        }
         else if( !strcasecmp( argv[i], "--gop-list" ) )
         {
             p->output_mode = OUTPUT_MAKE_GOP_LIST;
@@ -657,11 +699,21 @@ fail:
     return -1;
 }
 
+static file_write_stats_t dumper_stats;
+
 static void dumper_close( void **fw_ctx )
 {
     if( !fw_ctx || !(*fw_ctx) )
         return;
     file_writer.close( *fw_ctx );
+    /* sum up the counters of the closed files. */
+    file_write_stats_t stats;
+    if( !file_writer.stats( *fw_ctx, &stats ) )
+    {
+        __atomic_add_fetch( &(dumper_stats.write_bytes), stats.write_bytes, __ATOMIC_RELAXED );
+        __atomic_add_fetch( &(dumper_stats.write_calls), stats.write_calls, __ATOMIC_RELAXED );
+        __atomic_add_fetch( &(dumper_stats.seek_calls ), stats.seek_calls , __ATOMIC_RELAXED );
+    }
     file_writer.release( fw_ctx );
 }
 
@@ -694,6 +746,123 @@ static void output_line( FILE* fp, const char *format, ... )
 #define output_line fprintf
 #endif
 
+#define PROGRESS_REPORT_INTERVAL    (100)
+#define PROGRESS_REPORT_SLICE       (20)
+
+typedef struct {
+    const char     *stream_name;
+    uint8_t         stream_number;
+    uint32_t        count;
+    uint64_t        total_size;
+    int64_t         position;
+} progress_entry_t;
+
+typedef struct {
+    void               *thread;
+    void               *api_info;
+    int64_t             file_size;
+    progress_entry_t   *entry;
+    uint16_t            entry_num;
+    uint32_t            quit;
+} progress_reporter_t;
+
+static inline void progress_update( progress_entry_t *entry, uint32_t count, uint64_t total_size, int64_t position )
+{
+    /* the workers only store the counters, the reporter renders them. */
+    if( !entry )
+        return;
+    __atomic_store_n( &(entry->count)     , count     , __ATOMIC_RELAXED );
+    __atomic_store_n( &(entry->total_size), total_size, __ATOMIC_RELAXED );
+    __atomic_store_n( &(entry->position)  , position  , __ATOMIC_RELAXED );
+}
+
+static void progress_render( progress_reporter_t *reporter )
+{
+    if( !reporter->entry_num )
+    {
+        /* the sample list creation in the library. */
+        progress_info_t progress;
+        if( mpeg_api_get_progress( reporter->api_info, &progress ) || !progress.active )
+            return;
+        mapi_log( LOG_LV_PROGRESS, "[parse_stream] %14" PRId64 "/%-14" PRId64 "\r", progress.position, progress.total );
+        return;
+    }
+    int64_t  file_size  = reporter->file_size > 0 ? reporter->file_size : 1;
+    uint64_t total_size = 0;
+    int64_t  position   = INT64_MAX;
+    for( uint16_t i = 0; i < reporter->entry_num; ++i )
+    {
+        progress_entry_t *entry = &(reporter->entry[i]);
+        int64_t entry_position = __atomic_load_n( &(entry->position), __ATOMIC_RELAXED );
+        total_size += __atomic_load_n( &(entry->total_size), __ATOMIC_RELAXED );
+        if( position > entry_position )
+            position = entry_position;
+    }
+    if( reporter->entry_num == 1 )
+    {
+        progress_entry_t *entry = reporter->entry;
+        mapi_log( LOG_LV_PROGRESS, " %s Stream[%3u] [%8u]  total: %14" PRIu64 " Byte ...[%5.2f%%]\r"
+                                 , entry->stream_name, entry->stream_number
+                                 , __atomic_load_n( &(entry->count), __ATOMIC_RELAXED )
+                                 , total_size, (double)(position * 100.0 / file_size) );
+    }
+    else
+        /* the slowest stream decides the percentage. */
+        mapi_log( LOG_LV_PROGRESS, " %3u Streams  total: %14" PRIu64 " Byte ...[%5.2f%%]\r"
+                                 , reporter->entry_num, total_size, (double)(position * 100.0 / file_size) );
+}
+
+static thread_func_ret progress_report( void *args )
+{
+    progress_reporter_t *reporter = (progress_reporter_t *)args;
+    uint32_t elapsed = 0;
+    while( !__atomic_load_n( &(reporter->quit), __ATOMIC_ACQUIRE ) )
+    {
+        thread_sleep( PROGRESS_REPORT_SLICE );
+        elapsed += PROGRESS_REPORT_SLICE;
+        if( elapsed < PROGRESS_REPORT_INTERVAL )
+            continue;
+        progress_render( reporter );
+        elapsed = 0;
+    }
+    return (thread_func_ret)(0);
+}
+
+static void progress_reporter_start
+(
+    progress_reporter_t        *reporter,
+    void                       *info,
+    int64_t                     file_size,
+    progress_entry_t           *entry,
+    uint16_t                    entry_num
+)
+{
+    reporter->api_info  = info;
+    reporter->file_size = file_size;
+    reporter->entry     = entry;
+    reporter->entry_num = entry_num;
+    reporter->quit      = 0;
+    reporter->thread    = thread_create( progress_report, reporter );
+}
+
+static void progress_reporter_stop( progress_reporter_t *reporter )
+{
+    if( !reporter->thread )
+        return;
+    __atomic_store_n( &(reporter->quit), 1, __ATOMIC_RELEASE );
+    thread_wait_end( reporter->thread, NULL );
+    reporter->thread = NULL;
+}
+
+static int create_sample_list( void *info )
+{
+    progress_reporter_t reporter;
+    progress_reporter_start( &reporter, info, 0, NULL, 0 );
+    int result = mpeg_api_create_sample_list( info );
+    progress_reporter_stop( &reporter );
+    return result;
+}
+
 static void make_gop_list
 (
     param_t                    *p,
@@ -900,7 +1069,7 @@ static void make_sample_gop_list
     int32_t                     sid_info_num
 )
 {
-    if( !mpeg_api_create_sample_list( info ) )
+    if( !create_sample_list( info ) )
         make_gop_list( p, info, stream_info, video_stream_num, 1, sid_info, sid_info_num );
 }
 
@@ -1040,7 +1209,7 @@ static void dump_sample_info
     uint8_t                     audio_stream_num
 )
 {
-    if( mpeg_api_create_sample_list( info ) )
+    if( create_sample_list( info ) )
         return;
     dump_va_info( p, info, stream_info, video_stream_num, audio_stream_num, USE_MAPI_SAMPLE_LIST );
 }
@@ -1340,9 +1509,45 @@ typedef struct {
     uint8_t                 stream_number;
     uint32_t                sample_num;
     uint32_t                start_number;
-    int64_t                 file_size;
+    progress_entry_t       *entry;
 } demux_param_t;
 
+static int demux_sample_spans
+(
+    void                       *info,
+    mpeg_sample_type            sample_type,
+    uint8_t                     stream_number,
+    uint32_t                    sample_number,
+    get_sample_data_mode        get_mode,
+    void                       *fw_ctx,
+    uint32_t                   *data_size
+)
+{
+    *data_size = 0;
+    /* output the data in reader cache. */
+    sample_span_t *spans    = NULL;
+    uint32_t       span_num = 0;
+    if( !mpeg_api_get_sample_spans( info, sample_type, stream_number, sample_number, &spans, &span_num, get_mode ) )
+    {
+        for( uint32_t i = 0; i < span_num; ++i )
+        {
+            dumper_fwrite( fw_ctx, spans[i].data, spans[i].size, NULL );
+            *data_size += spans[i].size;
+        }
+        return 0;
+    }
+    /* fallback: the sample could not be mapped. */
+    uint8_t *buffer = NULL;
+    if( mpeg_api_get_sample_data( info, sample_type, stream_number, sample_number, &buffer, data_size, get_mode ) )
+        return -1;
+    if( buffer && *data_size )
+    {
+        dumper_fwrite( fw_ctx, buffer, *data_size, NULL );
+        mpeg_api_free_sample_buffer( info, &buffer );
+    }
+    return 0;
+}
+
 static thread_func_ret demux_sample( void *args )
 {
     demux_param_t *param = (demux_param_t *)args;
@@ -1356,30 +1561,23 @@ static thread_func_ret demux_sample( void *args )
     uint8_t               stream_number = param->stream_number;
     uint32_t              num           = param->sample_num;
     uint32_t              start         = param->start_number;
-    int64_t               file_size     = param->file_size;
     /* demux */
+    mapi_trace_begin( "demux_sample" );
     uint64_t total_size = 0;
     mapi_log( LOG_LV_PROGRESS, " %s Stream[%3u] [demux] start - sample_num:%u  start_num:%u\n"
                              , stream_name, stream_number, num, start );
     for( uint32_t i = start; i < num; ++i )
     {
-        uint8_t  *buffer    = NULL;
-        uint32_t  data_size = 0;
-        if( mpeg_api_get_sample_data( info, get_type, stream_number, i, &buffer, &data_size, mode ) )
+        uint32_t data_size = 0;
+        if( demux_sample_spans( info, get_type, stream_number, i, mode, fw_ctx, &data_size ) )
             break;
-        else if( buffer && data_size )
-        {
-            dumper_fwrite( fw_ctx, buffer, data_size, NULL );
-            mpeg_api_free_sample_buffer( info, &buffer );
-            total_size += data_size;
-        }
-        int64_t progress = mpeg_api_get_sample_position( info, get_type, stream_number );
-        mapi_log( LOG_LV_PROGRESS, " %s Stream[%3u] [%8u]  total: %14" PRIu64 " Byte ...[%5.2f%%]\r"
-                                 , stream_name, stream_number, i, total_size, (double)(progress * 100.0 / file_size) );
+        total_size += data_size;
+        progress_update( param->entry, i, total_size, mpeg_api_get_sample_position( info, get_type, stream_number ) );
     }
     mapi_log( LOG_LV_PROGRESS, "                                                                              \r" );
     mapi_log( LOG_LV_PROGRESS, " %s Stream[%3u] [demux] end - output: %" PRIu64 " Byte\n"
                              , stream_name, stream_number, total_size );
+    mapi_trace_end();
     return (thread_func_ret)(0);
 }
 
@@ -1394,7 +1592,7 @@ static void demux_sample_data
 {
     int                  get_index = p->output_mode - OUTPUT_GET_SAMPLE_RAW;
     get_sample_data_mode get_mode  = get_sample_list[get_index].get_mode;
-    if( mpeg_api_create_sample_list( info ) )
+    if( create_sample_list( info ) )
         return;
     /* prepare file. */
     void *video[video_stream_num + 1], *audio[audio_stream_num + 1];
@@ -1408,8 +1606,11 @@ static void demux_sample_data
         demux_param_t *param = (demux_param_t *)malloc( sizeof(demux_param_t) * output_stream_num );
         if( param )
         {
+            void *pool = thread_pool_get_shared();
             void *demux_thread[output_stream_num];
             memset( demux_thread, 0, sizeof(void *) * output_stream_num );
+            progress_entry_t entry[output_stream_num];
+            memset( entry, 0, sizeof(progress_entry_t) * output_stream_num );
             uint16_t thread_index = 0;
             /* video. */
             for( uint8_t i = 0; i < video_stream_num; ++i )
@@ -1433,8 +1634,12 @@ static void demux_sample_data
                     param[thread_index].stream_number = i;
                     param[thread_index].sample_num    = mpeg_api_get_sample_num( info, SAMPLE_TYPE_VIDEO, i );
                     param[thread_index].start_number  = start_number;
-                    param[thread_index].file_size     = p->file_size;
-                    demux_thread[thread_index] = thread_create( demux_sample, &param[thread_index] );
+                    param[thread_index].entry         = &(entry[thread_index]);
+                    entry[thread_index].stream_name   = param[thread_index].stream_name;
+                    entry[thread_index].stream_number = i;
+                    demux_thread[thread_index] = thread_pool_submit( pool, demux_sample, &param[thread_index] );
+                    if( !demux_thread[thread_index] )
+                        demux_sample( &param[thread_index] );
                     ++thread_index;
                 }
             }
@@ -1451,15 +1656,22 @@ static void demux_sample_data
                     param[thread_index].stream_number = i;
                     param[thread_index].sample_num    = mpeg_api_get_sample_num( info, SAMPLE_TYPE_AUDIO, i );
                     param[thread_index].start_number  = 0;
-                    param[thread_index].file_size     = p->file_size;
-                    demux_thread[thread_index] = thread_create( demux_sample, &param[thread_index] );
+                    param[thread_index].entry         = &(entry[thread_index]);
+                    entry[thread_index].stream_name   = param[thread_index].stream_name;
+                    entry[thread_index].stream_number = i;
+                    demux_thread[thread_index] = thread_pool_submit( pool, demux_sample, &param[thread_index] );
+                    if( !demux_thread[thread_index] )
+                        demux_sample( &param[thread_index] );
                     ++thread_index;
                 }
             }
             /* wait demux end. */
+            progress_reporter_t reporter;
+            progress_reporter_start( &reporter, info, p->file_size, entry, thread_index );
             if( thread_index )
                 for( uint16_t i = 0; i < thread_index; ++i )
-                    thread_wait_end( demux_thread[i], NULL );
+                    thread_future_wait( demux_thread[i], NULL );
+            progress_reporter_stop( &reporter );
             free( param );
         }
         /* close output file. */
@@ -1480,6 +1692,9 @@ static void demux_sample_data
                 uint64_t total_size = 0;
                 uint32_t sample_num = mpeg_api_get_sample_num( info, SAMPLE_TYPE_VIDEO, i );
                 mapi_log( LOG_LV_PROGRESS, " Video Stream[%3u] [demux] start - sample_num:%u\n", i, sample_num );
+                progress_entry_t    entry = { "Video", i, 0, 0, 0 };
+                progress_reporter_t reporter;
+                progress_reporter_start( &reporter, info, p->file_size, &entry, 1 );
                 for( uint32_t j = 0; j < sample_num; ++j )
                 {
                     while( 1 )
@@ -1490,20 +1705,13 @@ static void demux_sample_data
                             break;
                         ++j;
                     }
-                    uint8_t  *buffer    = NULL;
-                    uint32_t  data_size = 0;
-                    if( mpeg_api_get_sample_data( info, SAMPLE_TYPE_VIDEO, i, j, &buffer, &data_size, get_mode ) )
+                    uint32_t data_size = 0;
+                    if( demux_sample_spans( info, SAMPLE_TYPE_VIDEO, i, j, get_mode, video[i], &data_size ) )
                         break;
-                    if( buffer && data_size )
-                    {
-                        dumper_fwrite( video[i], buffer, data_size, NULL );
-                        mpeg_api_free_sample_buffer( info, &buffer );
-                        total_size += data_size;
-                    }
-                    int64_t progress = mpeg_api_get_sample_position( info, SAMPLE_TYPE_VIDEO, i );
-                    mapi_log( LOG_LV_PROGRESS, " [%8u]  size: %10u  total: %14" PRIu64 " Byte ...[%5.2f%%]\r"
-                                            , j, data_size, total_size, (double)(progress * 100.0 / p->file_size) );
+                    total_size += data_size;
+                    progress_update( &entry, j, total_size, mpeg_api_get_sample_position( info, SAMPLE_TYPE_VIDEO, i ) );
                 }
+                progress_reporter_stop( &reporter );
                 dumper_close( &(video[i]) );
                 mapi_log( LOG_LV_PROGRESS, "                                                                              \r" );
                 mapi_log( LOG_LV_PROGRESS, " Video Stream[%3u] [demux] end - output: %" PRIu64 " Byte\n", i, total_size );
@@ -1516,22 +1724,18 @@ static void demux_sample_data
                 uint64_t total_size = 0;
                 uint32_t sample_num = mpeg_api_get_sample_num( info, SAMPLE_TYPE_AUDIO, i );
                 mapi_log( LOG_LV_PROGRESS, " Audio Stream[%3u] [demux] start - sample_num:%u\n", i, sample_num );
+                progress_entry_t    entry = { "Audio", i, 0, 0, 0 };
+                progress_reporter_t reporter;
+                progress_reporter_start( &reporter, info, p->file_size, &entry, 1 );
                 for( uint32_t j = 0; j < sample_num; ++j )
                 {
-                    uint8_t  *buffer    = NULL;
-                    uint32_t  data_size = 0;
-                    if( mpeg_api_get_sample_data( info, SAMPLE_TYPE_AUDIO, i, j, &buffer, &data_size, get_mode ) )
+                    uint32_t data_size = 0;
+                    if( demux_sample_spans( info, SAMPLE_TYPE_AUDIO, i, j, get_mode, audio[i], &data_size ) )
                         break;
-                    if( buffer && data_size )
-                    {
-                        dumper_fwrite( audio[i], buffer, data_size, NULL );
-                        mpeg_api_free_sample_buffer( info, &buffer );
-                        total_size += data_size;
-                    }
-                    int64_t progress = mpeg_api_get_sample_position( info, SAMPLE_TYPE_AUDIO, i );
-                    mapi_log( LOG_LV_PROGRESS, " [%8u]  size: %10u  total: %14" PRIu64 " Byte ...[%5.2f%%]\r"
-                                            , j, data_size, total_size, (double)(progress * 100.0 / p->file_size) );
+                    total_size += data_size;
+                    progress_update( &entry, j, total_size, mpeg_api_get_sample_position( info, SAMPLE_TYPE_AUDIO, i ) );
                 }
+                progress_reporter_stop( &reporter );
                 dumper_close( &(audio[i]) );
                 mapi_log( LOG_LV_PROGRESS, "                                                                              \r" );
                 mapi_log( LOG_LV_PROGRESS, " Audio Stream[%3u] [demux] end - output: %" PRIu64 " Byte\n", i, total_size );
@@ -1552,8 +1756,8 @@ static thread_func_ret demux_stream( void *args )
     void                 *fw_ctx        = param->fw_ctx;
     char                 *stream_name   = param->stream_name;
     uint8_t               stream_number = param->stream_number;
-    int64_t               file_size     = param->file_size;
     /* demux */
+    mapi_trace_begin( "demux_stream" );
     uint64_t total_size = 0;
     mapi_log( LOG_LV_PROGRESS, " %s Stream[%3u] [demux] start\n", stream_name, stream_number );
     for( uint32_t i = 0; ; ++i )
@@ -1568,13 +1772,12 @@ static thread_func_ret demux_stream( void *args )
             mpeg_api_free_sample_buffer( info, &buffer );
             total_size += data_size;
         }
-        int64_t progress = mpeg_api_get_sample_position( info, get_type, stream_number );
-        mapi_log( LOG_LV_PROGRESS, " %s Stream[%3u] [%8u]  total: %14" PRIu64 " Byte ...[%5.2f%%]\r"
-                                 , stream_name, stream_number, i, total_size, (double)(progress * 100.0 / file_size) );
+        progress_update( param->entry, i, total_size, mpeg_api_get_sample_position( info, get_type, stream_number ) );
     }
     mapi_log( LOG_LV_PROGRESS, "                                                                              \r" );
     mapi_log( LOG_LV_PROGRESS, " %s Stream[%3u] [demux] end - output: %" PRIu64 " Byte\n"
                              , stream_name, stream_number, total_size );
+    mapi_trace_end();
     return (thread_func_ret)(0);
 }
 
@@ -1601,8 +1804,11 @@ static void demux_stream_data
         demux_param_t *param = (demux_param_t *)malloc( sizeof(demux_param_t) * output_stream_num );
         if( param )
         {
+            void *pool = thread_pool_get_shared();
             void *demux_thread[output_stream_num];
             memset( demux_thread, 0, sizeof(void *) * output_stream_num );
+            progress_entry_t entry[output_stream_num];
+            memset( entry, 0, sizeof(progress_entry_t) * output_stream_num );
             uint16_t thread_index = 0;
             /* video. */
             for( uint8_t i = 0; i < video_stream_num; ++i )
@@ -1628,8 +1834,12 @@ static void demux_stream_data
                     param[thread_index].stream_number = i;
                     param[thread_index].sample_num    = 0;
                     param[thread_index].start_number  = 0;
-                    param[thread_index].file_size     = p->file_size;
-                    demux_thread[thread_index] = thread_create( demux_stream, &param[thread_index] );
+                    param[thread_index].entry         = &(entry[thread_index]);
+                    entry[thread_index].stream_name   = param[thread_index].stream_name;
+                    entry[thread_index].stream_number = i;
+                    demux_thread[thread_index] = thread_pool_submit( pool, demux_stream, &param[thread_index] );
+                    if( !demux_thread[thread_index] )
+                        demux_stream( &param[thread_index] );
                     ++thread_index;
                 }
             }
@@ -1646,15 +1856,22 @@ static void demux_stream_data
                     param[thread_index].stream_number = i;
                     param[thread_index].sample_num    = 0;
                     param[thread_index].start_number  = 0;
-                    param[thread_index].file_size     = p->file_size;
-                    demux_thread[thread_index] = thread_create( demux_stream, &param[thread_index] );
+                    param[thread_index].entry         = &(entry[thread_index]);
+                    entry[thread_index].stream_name   = param[thread_index].stream_name;
+                    entry[thread_index].stream_number = i;
+                    demux_thread[thread_index] = thread_pool_submit( pool, demux_stream, &param[thread_index] );
+                    if( !demux_thread[thread_index] )
+                        demux_stream( &param[thread_index] );
                     ++thread_index;
                 }
             }
             /* wait demux end. */
+            progress_reporter_t reporter;
+            progress_reporter_start( &reporter, info, p->file_size, entry, thread_index );
             if( thread_index )
                 for( uint16_t i = 0; i < thread_index; ++i )
-                    thread_wait_end( demux_thread[i], NULL );
+                    thread_future_wait( demux_thread[i], NULL );
+            progress_reporter_stop( &reporter );
             free( param );
         }
         /* close output file. */
@@ -1674,6 +1891,9 @@ static void demux_stream_data
             {
                 uint64_t total_size = 0;
                 mapi_log( LOG_LV_PROGRESS, " Video Stream[%3u] [demux] start\n", i );
+                progress_entry_t    entry = { "Video", i, 0, 0, 0 };
+                progress_reporter_t reporter;
+                progress_reporter_start( &reporter, info, p->file_size, &entry, 1 );
                 while( 1 )
                 {
                     if( mpeg_api_get_video_frame( info, i, stream_info ) )
@@ -1697,10 +1917,9 @@ static void demux_stream_data
                         mpeg_api_free_sample_buffer( info, &buffer );
                         total_size += data_size;
                     }
-                    int64_t progress = mpeg_api_get_sample_position( info, SAMPLE_TYPE_VIDEO, i );
-                    mapi_log( LOG_LV_PROGRESS, " [%8u]  size: %10u  total: %14" PRIu64 " Byte ...[%5.2f%%]\r"
-                                             , j, data_size, total_size, (double)(progress * 100.0 / p->file_size) );
+                    progress_update( &entry, j, total_size, mpeg_api_get_sample_position( info, SAMPLE_TYPE_VIDEO, i ) );
                 }
+                progress_reporter_stop( &reporter );
                 dumper_close( &(video[i]) );
                 mapi_log( LOG_LV_PROGRESS, "                                                                              \r" );
                 mapi_log( LOG_LV_PROGRESS, " Video Stream[%3u] [demux] end - output: %" PRIu64 " Byte\n", i, total_size );
@@ -1712,6 +1931,9 @@ static void demux_stream_data
             {
                 uint64_t total_size = 0;
                 mapi_log( LOG_LV_PROGRESS, " Audio Stream[%3u] [demux] start\n", i );
+                progress_entry_t    entry = { "Audio", i, 0, 0, 0 };
+                progress_reporter_t reporter;
+                progress_reporter_start( &reporter, info, p->file_size, &entry, 1 );
                 for( uint32_t j = 0; ; ++j )
                 {
                     uint8_t  *buffer    = NULL;
@@ -1724,10 +1946,9 @@ static void demux_stream_data
                         mpeg_api_free_sample_buffer( info, &buffer );
                         total_size += data_size;
                     }
-                    int64_t progress = mpeg_api_get_sample_position( info, SAMPLE_TYPE_AUDIO, i );
-                    mapi_log( LOG_LV_PROGRESS, " [%8u]  size: %10u  total: %14" PRIu64 " Byte ...[%5.2f%%]\r"
-                                            , j, data_size, total_size, (double)(progress * 100.0 / p->file_size) );
+                    progress_update( &entry, j, total_size, mpeg_api_get_sample_position( info, SAMPLE_TYPE_AUDIO, i ) );
                 }
+                progress_reporter_stop( &reporter );
                 dumper_close( &(audio[i]) );
                 mapi_log( LOG_LV_PROGRESS, "                                                                              \r" );
                 mapi_log( LOG_LV_PROGRESS, " Audio Stream[%3u] [demux] end - output: %" PRIu64 " Byte\n", i, total_size );
@@ -1743,8 +1964,7 @@ typedef struct {
     uint8_t         stream_number;
     uint32_t        count;
     int64_t         total_size;
-    int64_t         file_size;
-    int             percent;
+    progress_entry_t *entry;
 } demux_cb_param_t;
 
 static void demux_cb_func( void *cb_params, void *cb_ret )
@@ -1758,14 +1978,7 @@ static void demux_cb_func( void *cb_params, void *cb_ret )
     /* output. */
     dumper_fwrite( param->fw_ctx, buffer, read_size, NULL );
     param->total_size += read_size;
-    int percent = progress * 10000 / param->file_size;
-    if( (percent - param->percent) > 0 )
-    {
-        mapi_log( LOG_LV_PROGRESS, " %s Stream[%3u] [%8u]  total: %14" PRIu64 " Byte ...[%5.2f%%]\r"
-                                 , param->stream_name, param->stream_number, param->count
-                                 , (uint64_t)param->total_size, percent / 100.0 );
-        param->percent = percent;
-    }
+    progress_update( param->entry, param->count, (uint64_t)param->total_size, progress );
     ++ param->count;
 }
 
@@ -1780,11 +1993,11 @@ static thread_func_ret demux_all( void *args )
     void                 *fw_ctx        = param->fw_ctx;
     char                 *stream_name   = param->stream_name;
     uint8_t               stream_number = param->stream_number;
-    int64_t               file_size     = param->file_size;
     /* demux */
+    mapi_trace_begin( "demux_all" );
     mapi_log( LOG_LV_PROGRESS, "                                                                              \r"
                                " %s Stream[%3u] [demux] start\n", stream_name, stream_number );
-    demux_cb_param_t     cb_params = { fw_ctx, stream_name, stream_number, 0, 0, file_size, 0 };
+    demux_cb_param_t     cb_params = { fw_ctx, stream_name, stream_number, 0, 0, param->entry };
     get_stream_data_cb_t cb        = { demux_cb_func, &cb_params };
     mpeg_api_get_stream_all( info, get_type, stream_number, mode, &cb );
     /* finish. */
@@ -1792,6 +2005,7 @@ static thread_func_ret demux_all( void *args )
     mapi_log( LOG_LV_PROGRESS, "                                                                              \r"
                                " %s Stream[%3u] [demux] end - output: %" PRIu64 " Byte\n"
                              , stream_name, stream_number, total_size );
+    mapi_trace_end();
     return (thread_func_ret)(0);
 }
 
@@ -1818,8 +2032,11 @@ static void demux_stream_all
         demux_param_t *param = (demux_param_t *)malloc( sizeof(demux_param_t) * output_stream_num );
         if( param )
         {
+            void *pool = thread_pool_get_shared();
             void *demux_thread[output_stream_num];
             memset( demux_thread, 0, sizeof(void *) * output_stream_num );
+            progress_entry_t entry[output_stream_num];
+            memset( entry, 0, sizeof(progress_entry_t) * output_stream_num );
             uint16_t thread_index = 0;
             /* video. */
             for( uint8_t i = 0; i < video_stream_num; ++i )
@@ -1845,8 +2062,12 @@ static void demux_stream_all
                     param[thread_index].stream_number = i;
                     param[thread_index].sample_num    = 0;
                     param[thread_index].start_number  = 0;
-                    param[thread_index].file_size     = p->file_size;
-                    demux_thread[thread_index] = thread_create( demux_all, &param[thread_index] );
+                    param[thread_index].entry         = &(entry[thread_index]);
+                    entry[thread_index].stream_name   = param[thread_index].stream_name;
+                    entry[thread_index].stream_number = i;
+                    demux_thread[thread_index] = thread_pool_submit( pool, demux_all, &param[thread_index] );
+                    if( !demux_thread[thread_index] )
+                        demux_all( &param[thread_index] );
                     ++thread_index;
                 }
             }
@@ -1863,15 +2084,22 @@ static void demux_stream_all
                     param[thread_index].stream_number = i;
                     param[thread_index].sample_num    = 0;
                     param[thread_index].start_number  = 0;
-                    param[thread_index].file_size     = p->file_size;
-                    demux_thread[thread_index] = thread_create( demux_all, &param[thread_index] );
+                    param[thread_index].entry         = &(entry[thread_index]);
+                    entry[thread_index].stream_name   = param[thread_index].stream_name;
+                    entry[thread_index].stream_number = i;
+                    demux_thread[thread_index] = thread_pool_submit( pool, demux_all, &param[thread_index] );
+                    if( !demux_thread[thread_index] )
+                        demux_all( &param[thread_index] );
                     ++thread_index;
                 }
             }
             /* wait demux end. */
+            progress_reporter_t reporter;
+            progress_reporter_start( &reporter, info, p->file_size, entry, thread_index );
             if( thread_index )
                 for( uint16_t i = 0; i < thread_index; ++i )
-                    thread_wait_end( demux_thread[i], NULL );
+                    thread_future_wait( demux_thread[i], NULL );
+            progress_reporter_stop( &reporter );
             free( param );
         }
         /* close output file. */
@@ -1890,6 +2118,9 @@ static void demux_stream_all
             if( video[i] )
             {
                 mapi_log( LOG_LV_PROGRESS, " Video Stream[%3u] [demux] start\n", i );
+                progress_entry_t    entry = { "Video", i, 0, 0, 0 };
+                progress_reporter_t reporter;
+                progress_reporter_start( &reporter, info, p->file_size, &entry, 1 );
                 while( 1 )
                 {
                     if( mpeg_api_get_video_frame( info, i, stream_info ) )
@@ -1901,9 +2132,10 @@ static void demux_stream_all
                         break;
                     }
                 }
-                demux_cb_param_t     cb_params = { video[i], "Video", i, 0, 0, p->file_size, 0 };
+                demux_cb_param_t     cb_params = { video[i], "Video", i, 0, 0, &entry };
                 get_stream_data_cb_t cb        = { demux_cb_func, &cb_params };
                 mpeg_api_get_stream_all( info, SAMPLE_TYPE_VIDEO, i, get_mode, &cb );
+                progress_reporter_stop( &reporter );
                 uint64_t total_size = (uint64_t)cb_params.total_size;
                 dumper_close( &(video[i]) );
                 mapi_log( LOG_LV_PROGRESS, "                                                                              \r" );
@@ -1915,9 +2147,13 @@ static void demux_stream_all
             if( audio[i] )
             {
                 mapi_log( LOG_LV_PROGRESS, " Audio Stream[%3u] [demux] start\n", i );
-                demux_cb_param_t     cb_params = { audio[i], "Audio", i, 0, 0, p->file_size, 0 };
+                progress_entry_t    entry = { "Audio", i, 0, 0, 0 };
+                progress_reporter_t reporter;
+                progress_reporter_start( &reporter, info, p->file_size, &entry, 1 );
+                demux_cb_param_t     cb_params = { audio[i], "Audio", i, 0, 0, &entry };
                 get_stream_data_cb_t cb        = { demux_cb_func, &cb_params };
                 mpeg_api_get_stream_all( info, SAMPLE_TYPE_AUDIO, i, get_mode, &cb );
+                progress_reporter_stop( &reporter );
                 uint64_t total_size = (uint64_t)cb_params.total_size;
                 dumper_close( &(audio[i]) );
                 mapi_log( LOG_LV_PROGRESS, "                                                                              \r" );
@@ -1932,7 +2168,8 @@ typedef struct {
     demux_cb_param_t   *v_cb_param;
     demux_cb_param_t   *a_cb_param;
     uint32_t            count;
-    int64_t             file_size;
+    int64_t             total_size;
+    progress_entry_t   *entry;
 } demux_all_cb_param_t;
 
 static void demux_all_cb_func( void *cb_params, void *cb_ret )
@@ -1987,15 +2224,10 @@ static void demux_all_cb_func( void *cb_params, void *cb_ret )
                                      , stream_name, stream_number, cb_p->count, -valid_size );
         total_size = 0;
     }
-    int percent = progress * 10000 / param->file_size;
-    if( (percent - cb_p->percent) > 0 )
-    {
-        mapi_log( LOG_LV_PROGRESS, " %s Stream[%3u] [%8u]  total: %14" PRIu64 " Byte ...[%5.2f%%]\r"
-                                 , stream_name, stream_number, cb_p->count, (uint64_t)total_size, percent / 100.0 );
-        cb_p->percent = percent;
-    }
     cb_p->total_size += valid_size;
     ++ cb_p->count;
+    param->total_size += valid_size;
+    progress_update( param->entry, param->count, (uint64_t)param->total_size, progress );
     ++ param->count;
 }
 
@@ -2058,9 +2290,13 @@ static void demux_stream_all_in_st
             v_cb_params[i].fw_ctx = video[i];
         for( uint8_t i = 0; i < audio_stream_num; ++i )
             a_cb_params[i].fw_ctx = audio[i];
-        demux_all_cb_param_t cb_params = { v_cb_params, a_cb_params, 0, p->file_size };
+        progress_entry_t     entry     = { output_stream_name[stream_name_index], 0, 0, 0, 0 };
+        demux_all_cb_param_t cb_params = { v_cb_params, a_cb_params, 0, 0, &entry };
         get_stream_data_cb_t cb        = { demux_all_cb_func, (void *)&cb_params };
+        progress_reporter_t  reporter;
+        progress_reporter_start( &reporter, info, p->file_size, &entry, 1 );
         mpeg_api_get_all_stream_data( info, get_mode, p->output_stream, p->update_psi, &cb );
+        progress_reporter_stop( &reporter );
         mapi_log( LOG_LV_PROGRESS, "                                                                              \r" );
         for( uint8_t i = 0; i < video_stream_num; ++i )
         {
@@ -2089,8 +2325,6 @@ typedef struct {
     uint8_t         stream_number;
     uint32_t        count;
     int64_t         total_size;
-    int64_t         file_size;
-    int             percent;
 } split_cb_param_t;
 
 typedef struct {
@@ -2101,7 +2335,7 @@ typedef struct {
     split_cb_param_t   *p_cb_param;
     uint32_t            count;
     int64_t             total_size;
-    int64_t             file_size;
+    progress_entry_t   *entry;
     void              **fw_ctx;
     const char         *stream_name;
     service_id_info_t  *sid_info;
@@ -2188,16 +2422,10 @@ static void split_all_cb_func( void *cb_params, void *cb_ret )
     }
     if( param->sid_info_num > 1 && service_id && index_start )      /* PAT on multi service: [0] only. */
         return;
-    int percent = progress * 10000 / param->file_size;
-    if( (percent - cb_p->percent) > 0 )
-    {
-        mapi_log( LOG_LV_PROGRESS, " %s Stream[%3u] [%8u]  total: %14" PRIu64 " Byte ...[%5.2f%%]  \r"
-                                 , param->stream_name, stream_number, cb_p->count, (uint64_t)total_size, percent / 100.0 );
-        cb_p->percent = percent;
-    }
     cb_p->total_size += valid_size;
     ++ cb_p->count;
     param->total_size += valid_size;
+    progress_update( param->entry, param->count, (uint64_t)param->total_size, progress );
     ++ param->count;
 }
 
@@ -2311,9 +2539,13 @@ static void split_stream_all
         memset( a_cb_params, 0, sizeof(split_cb_param_t) * (audio_stream_num   + 1) );
         memset( c_cb_params, 0, sizeof(split_cb_param_t) * (caption_stream_num + 1) );
         memset( d_cb_params, 0, sizeof(split_cb_param_t) * (dsmcc_stream_num   + 1) );
-        split_all_cb_param_t cb_params = { v_cb_params, a_cb_params, c_cb_params, d_cb_params, &p_cb_param, 0, 0, p->file_size, split_file, output_stream_name[stream_name_index], sid_info, sid_info_num };
+        progress_entry_t     entry     = { output_stream_name[stream_name_index], 0, 0, 0, 0 };
+        split_all_cb_param_t cb_params = { v_cb_params, a_cb_params, c_cb_params, d_cb_params, &p_cb_param, 0, 0, &entry, split_file, output_stream_name[stream_name_index], sid_info, sid_info_num };
         get_stream_data_cb_t cb        = { split_all_cb_func, (void *)&cb_params };
+        progress_reporter_t  reporter;
+        progress_reporter_start( &reporter, info, p->file_size, &entry, 1 );
         mpeg_api_get_all_stream_data( info, get_mode, p->output_stream, p->update_psi, &cb );
+        progress_reporter_stop( &reporter );
         mapi_log( LOG_LV_PROGRESS, "                                                                              \r" );
         if( p->output_stream & OUTPUT_STREAM_VIDEO )
             for( uint8_t i = 0; i < video_stream_num; ++i )
@@ -2354,6 +2586,108 @@ static void split_stream_all
         free( dump_name_list );
 }
 
+static void output_packet_stats( void *info )
+{
+    packet_stats_t stats;
+    if( mpeg_api_get_packet_stats( info, &stats ) )
+        return;
+    mapi_log( LOG_LV_OUTPUT, "[log] packet statistics\n"
+                             "  packets: %" PRId64 "  <position: %" PRId64 " - %" PRId64 ">\n"
+                             "  cc error: %u  tei error: %u\n"
+                             "  pat error: %u  [max %" PRId64 "ms]  pmt error: %u  [max %" PRId64 "ms]\n"
+                             "  pcr repetition error: %u  discontinuity error: %u  [max %" PRId64 "ms]\n"
+                           , stats.packet_num, stats.start_position, stats.end_position
+                           , stats.cc_error_num, stats.tei_error_num
+                           , stats.pat_error_num, stats.pat_interval_max / 27000
+                           , stats.pmt_error_num, stats.pmt_interval_max / 27000
+                           , stats.pcr_repetition_error_num, stats.pcr_discontinuity_error_num
+                           , stats.pcr_interval_max / 27000 );
+    for( uint16_t i = 0; i < stats.pid_stats_num; ++i )
+    {
+        pid_packet_stats_t *pid = &(stats.pid_stats[i]);
+        mapi_log( LOG_LV_OUTPUT, "  -> pid: 0x%04X  packets: %10u  cc: %u  tei: %u  start: %u [max %" PRId64 "ms]"
+                               , pid->program_id, pid->packet_num, pid->cc_error_num, pid->tei_error_num
+                               , pid->section_num, pid->section_interval_max / 27000 );
+        if( pid->pcr_num )
+            mapi_log( LOG_LV_OUTPUT, "  pcr: %u [max %" PRId64 "ms]  repetition: %u  discontinuity: %u"
+                                   , pid->pcr_num, pid->pcr_interval_max / 27000
+                                   , pid->pcr_repetition_error_num, pid->pcr_discontinuity_error_num );
+        mapi_log( LOG_LV_OUTPUT, "\n" );
+    }
+}
+
+static void output_perf_stats( void *info )
+{
+    perf_stats_t stats;
+    if( mpeg_api_get_stats( info, &stats ) )
+        return;
+    mapi_log( LOG_LV_OUTPUT, "[log] performance counters\n"
+                             "  read: %" PRIu64 " Byte  calls: %" PRIu64 "  seeks: %" PRIu64 "\n"
+                             "  cache hits: %" PRIu64 "  misses: %" PRIu64 "\n"
+                             "  packets scanned: %" PRIu64 "  delivered: %" PRIu64 "  pes: %" PRIu64 "\n"
+                             "  sample allocs: %" PRIu64 "\n"
+                             "  write: %" PRIu64 " Byte  calls: %" PRIu64 "  seeks: %" PRIu64 "\n"
+                           , stats.read_bytes, stats.read_calls, stats.seek_calls
+                           , stats.cache_hits, stats.cache_misses
+                           , stats.packets_scanned, stats.packets_delivered, stats.pes_assembled
+                           , stats.sample_allocs
+                           , __atomic_load_n( &(dumper_stats.write_bytes), __ATOMIC_RELAXED )
+                           , __atomic_load_n( &(dumper_stats.write_calls), __ATOMIC_RELAXED )
+                           , __atomic_load_n( &(dumper_stats.seek_calls ), __ATOMIC_RELAXED ) );
+}
+
+static void output_bitrate_histogram( param_t *p, void *info )
+{
+    bitrate_histogram_t histogram;
+    if( mpeg_api_scan_bitrate( info, p->service_id, p->bitrate_interval, &histogram ) )
+    {
+        mapi_log( LOG_LV0, "[log] bitrate scan failed.\n" );
+        return;
+    }
+    FILE *fp = mapi_fopen( p->bitrate_output, "wt" );
+    if( !fp )
+        return;
+    /* bps of the 188 bytes packets. */
+    uint64_t bits_per_packet = TS_PACKET_SIZE * 8 * 1000;
+    uint32_t interval        = p->bitrate_interval;
+    size_t   name_length     = strlen( p->bitrate_output );
+    if( name_length > 5 && !strcasecmp( &(p->bitrate_output[name_length - 5]), ".json" ) )
+    {
+        fprintf( fp, "{\"time_base\":\"%s\",\"pcr_pid\":%u,\"interval_ms\":%u,\"bucket_num\":%u,\"packets\":%" PRId64 ",\"pids\":["
+                   , histogram.arrival_time_base ? "tts" : "pcr", histogram.pcr_program_id
+                   , interval, histogram.bucket_num, histogram.packet_num );
+        for( uint16_t i = 0; i < histogram.pid_num; ++i )
+        {
+            pid_bitrate_histogram_t *pid = &(histogram.pid[i]);
+            fprintf( fp, "%s\n{\"pid\":%u,\"packets\":%u,\"bps\":[", i ? "," : "", pid->program_id, pid->packet_num );
+            for( uint32_t j = 0; j < histogram.bucket_num; ++j )
+                fprintf( fp, "%s%" PRIu64, j ? "," : "", pid->bucket[j] * bits_per_packet / interval );
+            fprintf( fp, "]}" );
+        }
+        fprintf( fp, "]}\n" );
+    }
+    else
+    {
+        fprintf( fp, "time_ms,total" );
+        for( uint16_t i = 0; i < histogram.pid_num; ++i )
+            fprintf( fp, ",0x%04X", histogram.pid[i].program_id );
+        fprintf( fp, "\n" );
+        for( uint32_t j = 0; j < histogram.bucket_num; ++j )
+        {
+            uint64_t total = 0;
+            for( uint16_t i = 0; i < histogram.pid_num; ++i )
+                total += histogram.pid[i].bucket[j];
+            fprintf( fp, "%" PRIu64 ",%" PRIu64, (uint64_t)j * interval, total * bits_per_packet / interval );
+            for( uint16_t i = 0; i < histogram.pid_num; ++i )
+                fprintf( fp, ",%" PRIu64, histogram.pid[i].bucket[j] * bits_per_packet / interval );
+            fprintf( fp, "\n" );
+        }
+    }
+    fclose( fp );
+    mapi_log( LOG_LV_OUTPUT, "[log] bitrate: %u buckets of %ums, %u pids  -> %s\n"
+                           , histogram.bucket_num, interval, histogram.pid_num, p->bitrate_output );
+}
+
 static void parse_mpeg( param_t *p )
 {
     if( !p || !p->input )
@@ -2469,6 +2803,24 @@ static void parse_mpeg( param_t *p )
                                            , duration / 3600000, duration / 60000, duration / 1000 % 60
                                            , duration % 1000 );
                 }
+                if( p->output_stream != OUTPUT_STREAM_NONE_PCR_ONLY )
+                    continue;
+                /* scan all PCR. */
+                pcr_scan_data_t  *pcr_data;
+                uint32_t          pcr_data_num;
+                pcr_scan_stats_t  stats;
+                if( mpeg_api_scan_pcr( info, sid_info[i].service_id, &pcr_data, &pcr_data_num, &stats ) )
+                    continue;
+                mapi_log( LOG_LV_OUTPUT, "      pcr num: %10u  discontinuity: %u  repetition error: %u\n"
+                                         "     interval: %10" PRId64 "  - %" PRId64 " [us]\n"
+                                         "      bitrate: %10.0f  [bps]\n"
+                                         "       jitter: %10.0f  [ns] (rms: %.0f)\n"
+                                       , stats.pcr_num, stats.discontinuity_num, stats.repetition_error_num
+                                       , stats.min_interval / 27, stats.max_interval / 27
+                                       , stats.bitrate
+                                       , stats.jitter_max, stats.jitter_rms );
+                if( pcr_data[0].arrival_time != (int64_t)MPEG_TIMESTAMP_INVALID_VALUE )
+                    mapi_log( LOG_LV_OUTPUT, "        drift: %+10.3f  [ppm]\n", stats.drift );
             }
         }
         if( p->output_stream == OUTPUT_STREAM_NONE_PCR_ONLY )
@@ -2573,6 +2925,12 @@ static void parse_mpeg( param_t *p )
     else
         mapi_log( LOG_LV0, "[log] MPEG no read.\n" );
 end_parse:
+    if( p->packet_stats )
+        output_packet_stats( info );
+    if( p->perf_stats )
+        output_perf_stats( info );
+    if( p->bitrate_output )
+        output_bitrate_histogram( p, info );
     if( stream_info )
         free( stream_info );
     mpeg_api_release_info( info );
@@ -2612,7 +2970,12 @@ int main( int argc, char *argv[] )
         if( i < 0 )
             break;
         if( !correct_parameter( &param ) )
+        {
+            if( param.trace_output && mpeg_api_trace_open( param.trace_output ) )
+                mapi_log( LOG_LV0, "[log] failed to open the trace file: %s\n", param.trace_output );
             parse_mpeg( &param );
+            mpeg_api_trace_close();
+        }
         cleanup_parameter( &param );
     }
     if( conv_args > 0 )